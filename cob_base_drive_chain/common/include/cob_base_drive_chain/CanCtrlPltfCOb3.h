@@ -56,6 +56,12 @@ public:
 	 */
 	~CanCtrlPltfCOb3();
 
+	/**
+	 * Uses the given CAN interface instead of the one selected in CanCtrl.ini (e.g. a simulated bus).
+	 * Has to be called before initPltf(). The platform takes ownership of the interface.
+	 */
+	void setCanItf(CanItf* pCanItf);
+
 
 	//--------------------------------- Hardware Specification
 
@@ -124,6 +130,15 @@ public:
 	 */
 	int setVelGearRadS(int iCanIdent, double dVelGearRadS);
 
+	/**
+	 * Sends the velocities of all can nodes as one batch.
+	 * The commands are sent back to back and followed by a single SYNC and heartbeat,
+	 * so position and velocity of all drives are sampled at the same instant.
+	 * Status is requested, too.
+	 * @param vdVelGearRadS joint-velocities in radian per second, indexed by can node
+	 */
+	int setVelGearRadS(const std::vector<double>& vdVelGearRadS);
+
 	/**
 	 * Sends torques to the can node.
 	 * Status is requested, too.
@@ -163,6 +178,13 @@ public:
 	 */
 	int getGearPosVelRadS(int iCanIdent, double* pdAngleGearRad, double* pdVelGearRadS);
 
+	/**
+	 * Gets position and velocity of all can nodes from one evaluation of the can-buffer.
+	 * @param vdAngleGearRad joint-positions in radian, indexed by can node
+	 * @param vdVelGearRadS joint-velocities in radian per second, indexed by can node
+	 */
+	int getGearPosVelRadS(std::vector<double>& vdAngleGearRad, std::vector<double>& vdVelGearRadS);
+
 	/**
 	 * Gets the delta joint-angle since the last call and the velocity.
 	 * @param iCanIdent choose a can node
@@ -195,6 +217,8 @@ public:
 	 * @param iFlag To keep the interface slight, use iParam to command the recorder:
 	 * 0: Configure the Recorder to record the sources Main Speed(1), Main position(2), Active current(10), Speed command(16). With iParam = iRecordingGap you specify every which time quantum (4*90usec) a new data point (of 1024 points in total) is recorded;
 	 * 1: Query Upload of recorded source (1=Main Speed, 2=Main position, 10=Active Current, 16=Speed command) with iParam and log data to file sParam = file prefix. Filename is extended with _MotorNumber_RecordedSource.log
+	 * 2: Select the format of the log files with iParam (0=text .log, 1=binary .bin, 2=both)
+	 * 3: Like 0, but the recorders of all motors start together with the next velocity command, so that their recordings can be aligned by logElmoRecordings()
 	 * 99: Abort and clear current SDO readout process
 	 * 100: Request status of readout. Gives back 0 if all transmissions have finished and no CAN polling is needed anymore.
 	 * @return -1: Unknown flag set; 0: Success; 1: Recorder hasn't been configured yet; 2: data collection still in progress
@@ -202,6 +226,29 @@ public:
 	*/
 	int ElmoRecordings(int iFlag, int iParam, std::string sString);
 
+	/**
+	 * Limits the bus load of SDO uploads (e.g. the readout of the ElmoRecorder) of all motors.
+	 * The motors hold back the acknowledges that release further segments, processSDOTransfers() sends them
+	 * as long as the number of released segments fits into the budget of the cycle.
+	 * @param iSegmentsPerCycle number of segments per call of processSDOTransfers(), 0 disables the limit
+	 */
+	void setSDOSegmentsPerCycle(int iSegmentsPerCycle);
+
+	/**
+	 * Sends the held back SDO acknowledges of the motors in turn within the budget set by setSDOSegmentsPerCycle().
+	 * Has to be called once per control cycle while the limit is enabled.
+	 */
+	void processSDOTransfers();
+
+	/**
+	 * Writes the last readout of all motors into one file (sFilename + "all.log").
+	 * Every line holds the time and the value of each motor at this time. The recordings are aligned by their start
+	 * (see ElmoRecordings() flag 3) and linearly interpolated onto the time base of the motor that started first.
+	 * Values outside of a recording and motors without a successful readout of their current recording are written as nan.
+	 * @return 0: Success, 1: no readout available, 2: the file couldn't be written
+	 */
+	int logElmoRecordings(std::string sFilename);
+
 	//--------------------------------- Commands for other nodes
 
 
@@ -410,6 +457,11 @@ protected:
 	int m_iNumMotors;
 	int m_iNumDrives;
 
+	// SDO rate limit
+	int m_iSDOSegmentsPerCycle;
+	int m_iSDOSegmentCredits;
+	unsigned int m_iSDONextMotor;
+
 	// Motor-Controllers
 /*	CanDriveItf* m_pW1DriveMotor;
 	CanDriveItf* m_pW1SteerMotor;
@@ -17,7 +17,9 @@
 
 // general includes
 #include <math.h>
+#include <stdio.h>
 #include <unistd.h>
+#include <algorithm>
 
 // Headers provided by other cob-packages
 #include <cob_generic_can/CanESD.h>
@@ -75,6 +77,10 @@ CanCtrlPltfCOb3::CanCtrlPltfCOb3(std::string iniDirectory)
 	if(m_iNumMotors == 8)
 		m_viMotorID[7] = CANNODE_WHEEL4STEERMOTOR;
 
+	m_iSDOSegmentsPerCycle = 0;
+	m_iSDOSegmentCredits = 0;
+	m_iSDONextMotor = 0;
+
 	// ------------- parameters
 	m_Param.dCanTimeout = 7;
 
@@ -203,6 +209,17 @@ CanCtrlPltfCOb3::~CanCtrlPltfCOb3()
 
 }
 
+//-----------------------------------------------
+void CanCtrlPltfCOb3::setCanItf(CanItf* pCanItf)
+{
+	if (m_pCanCtrl != NULL)
+	{
+		delete m_pCanCtrl;
+	}
+
+	m_pCanCtrl = pCanItf;
+}
+
 //-----------------------------------------------
 void CanCtrlPltfCOb3::readConfiguration()
 {
@@ -249,7 +266,11 @@ void CanCtrlPltfCOb3::readConfiguration()
 
 	// read Configuration of the Can-Network (CanCtrl.ini)
 	m_IniFile.GetKeyInt("TypeCan", "Can", &iTypeCan, true);
-	if (iTypeCan == 0)
+	if (m_pCanCtrl != NULL)
+	{
+		std::cout << "Uses the CAN interface set by setCanItf()" << std::endl;
+	}
+	else if (iTypeCan == 0)
 	{
 		sComposed = sIniDirectory;
 		sComposed += "CanCtrl.ini";
@@ -909,7 +930,7 @@ bool CanCtrlPltfCOb3::initPltf()
 
 	// Homing is done on a wheel-module base (steering and driving needs to be synchronized)
 	// copy Motor-Pointer into Steer/Drive vector for more insight
-	for(int i=0; i<=m_iNumMotors; i+=2)
+	for(int i=0; i<m_iNumMotors; i+=2)
 		vpDriveMotor.push_back(m_vpMotor[i]);
 //	vpDriveMotor.push_back(m_vpMotor[2]);
 //	vpDriveMotor.push_back(m_vpMotor[4]);
@@ -1312,6 +1333,45 @@ int CanCtrlPltfCOb3::setVelGearRadS(int iCanIdent, double dVelGearRadS)
 	return 0;
 }
 
+//-----------------------------------------------
+int CanCtrlPltfCOb3::setVelGearRadS(const std::vector<double>& vdVelGearRadS)
+{
+	CanMsg msg;
+	double dVelGearRadS;
+
+	m_Mutex.lock();
+
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+	{
+		if((m_viMotorID[i] < 0) || (m_viMotorID[i] >= (int)vdVelGearRadS.size()))
+			continue;
+
+		// If an error was detected and processed in isPltfErr() -> stop motor driving
+		if (m_bWatchdogErr == true)
+			dVelGearRadS = 0;
+		else
+			dVelGearRadS = vdVelGearRadS[m_viMotorID[i]];
+
+		m_vpMotor[i]->setGearVelRadSNoSync(dVelGearRadS);
+	}
+
+	// one SYNC requests pos and vel of all drives (TPDO1)
+	msg.m_iID  = 0x80;
+	msg.m_iLen = 0;
+	msg.set(0,0,0,0,0,0,0,0);
+	m_pCanCtrl->transmitMsg(msg);
+
+	// one heartbeat keeps the watchdog of all drives inactive
+	msg.m_iID  = 0x700;
+	msg.m_iLen = 5;
+	msg.set(0x00,0,0,0,0,0,0,0);
+	m_pCanCtrl->transmitMsg(msg);
+
+	m_Mutex.unlock();
+
+	return 0;
+}
+
 //-----------------------------------------------
 int CanCtrlPltfCOb3::requestMotPosVel(int iCanIdent)
 {
@@ -1364,6 +1424,28 @@ int CanCtrlPltfCOb3::getGearPosVelRadS(int iCanIdent, double* pdAngleGearRad, do
 	return 0;
 }
 
+//-----------------------------------------------
+int CanCtrlPltfCOb3::getGearPosVelRadS(std::vector<double>& vdAngleGearRad, std::vector<double>& vdVelGearRadS)
+{
+	// init default outputs
+	std::fill(vdAngleGearRad.begin(), vdAngleGearRad.end(), 0.0);
+	std::fill(vdVelGearRadS.begin(), vdVelGearRadS.end(), 0.0);
+
+	m_Mutex.lock();
+
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+	{
+		if((m_viMotorID[i] < 0) || (m_viMotorID[i] >= (int)vdAngleGearRad.size()) || (m_viMotorID[i] >= (int)vdVelGearRadS.size()))
+			continue;
+
+		m_vpMotor[i]->getGearPosVelRadS(&vdAngleGearRad[m_viMotorID[i]], &vdVelGearRadS[m_viMotorID[i]]);
+	}
+
+	m_Mutex.unlock();
+
+	return 0;
+}
+
 //-----------------------------------------------
 int CanCtrlPltfCOb3::getGearDeltaPosVelRadS(int iCanIdent, double* pdAngleGearRad,
 										   double* pdVelGearRadS)
@@ -1472,6 +1554,18 @@ int CanCtrlPltfCOb3::ElmoRecordings(int iFlag, int iParam, std::string sString)
 			}
 			return bRet;
 
+		case 2: //Flag = 2 means select the format of the log files
+			for(unsigned int i = 0; i < m_vpMotor.size(); i++) {
+				m_vpMotor[i]->setRecorder(3, iParam);
+			}
+			return 0;
+
+		case 3: //Flag = 3 means configure the recorders to start with the next velocity command
+			for(unsigned int i = 0; i < m_vpMotor.size(); i++) {
+				m_vpMotor[i]->setRecorder(4, iParam);
+			}
+			return 0;
+
 		case 99:
 			for(unsigned int i = 0; i < m_vpMotor.size(); i++) {
 				m_vpMotor[i]->setRecorder(99, 0); //Stop any ongoing SDO transfer and clear corresponding data.
@@ -1488,3 +1582,148 @@ int CanCtrlPltfCOb3::ElmoRecordings(int iFlag, int iParam, std::string sString)
 			return -1;
 	}
 }
+
+//-----------------------------------------------
+void CanCtrlPltfCOb3::setSDOSegmentsPerCycle(int iSegmentsPerCycle)
+{
+	m_Mutex.lock();
+
+	m_iSDOSegmentsPerCycle = std::max(iSegmentsPerCycle, 0);
+	m_iSDOSegmentCredits = 0;
+
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+	{
+		if(m_vpMotor[i] != NULL)
+			m_vpMotor[i]->setSDOThrottle(m_iSDOSegmentsPerCycle > 0);
+	}
+
+	m_Mutex.unlock();
+}
+
+//-----------------------------------------------
+void CanCtrlPltfCOb3::processSDOTransfers()
+{
+	unsigned int iMotor;
+	int iSegments;
+	bool bPending = false;
+
+	m_Mutex.lock();
+
+	if(m_iSDOSegmentsPerCycle == 0)
+	{
+		m_Mutex.unlock();
+		return;
+	}
+
+	m_iSDOSegmentCredits += m_iSDOSegmentsPerCycle;
+
+	// round robin, a motor whose acknowledge releases more segments than left waits for the next cycle(s)
+	// without being overtaken, so every transfer proceeds
+	for(unsigned int n = 0; n < m_vpMotor.size(); n++)
+	{
+		iMotor = (m_iSDONextMotor + n) % m_vpMotor.size();
+		if(m_vpMotor[iMotor] == NULL)
+			continue;
+
+		iSegments = m_vpMotor[iMotor]->getPendingSDOAckSegments();
+		if(iSegments == 0)
+			continue;
+
+		bPending = true;
+		if(iSegments > m_iSDOSegmentCredits)
+			break;
+
+		m_iSDOSegmentCredits -= iSegments;
+		m_vpMotor[iMotor]->sendPendingSDOAck();
+		m_iSDONextMotor = (iMotor + 1) % m_vpMotor.size();
+	}
+
+	// don't save up credits while there is nothing to send, that would allow a burst later on
+	if(!bPending)
+		m_iSDOSegmentCredits = std::min(m_iSDOSegmentCredits, m_iSDOSegmentsPerCycle);
+
+	m_Mutex.unlock();
+}
+
+//-----------------------------------------------
+int CanCtrlPltfCOb3::logElmoRecordings(std::string sFilename)
+{
+	std::vector<std::vector<float> > vvfValues(m_vpMotor.size());
+	std::vector<float> vfStepSec(m_vpMotor.size(), 0);
+	std::vector<double> vdOffsetS(m_vpMotor.size(), 0);
+	std::vector<TimeStamp> vTrigger(m_vpMotor.size());
+	std::vector<bool> vbValid(m_vpMotor.size(), false);
+	int iFirst = -1;
+	double dStepSec = 0;
+	double dEndS = 0;
+	double dPos;
+	int iIdx;
+
+	m_Mutex.lock();
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+	{
+		if(m_vpMotor[i] == NULL)
+			continue;
+		vbValid[i] = m_vpMotor[i]->getRecordedData(vvfValues[i], &vfStepSec[i], &vTrigger[i]);
+		vbValid[i] = vbValid[i] && (vfStepSec[i] > 0) && !vvfValues[i].empty();
+		if(vbValid[i] && ((iFirst < 0) || (vTrigger[i] < vTrigger[iFirst])))
+			iFirst = i;
+	}
+	m_Mutex.unlock();
+
+	if(iFirst < 0)
+		return 1;
+
+	// offsets of the recordings relative to the one that started first
+	dStepSec = vfStepSec[iFirst];
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+	{
+		if(!vbValid[i])
+			continue;
+		vdOffsetS[i] = vTrigger[i] - vTrigger[iFirst];
+		dEndS = std::max(dEndS, vdOffsetS[i] + vfStepSec[i] * (vvfValues[i].size() - 1));
+		dStepSec = std::min(dStepSec, (double)vfStepSec[i]);
+	}
+
+	std::string sPath = sFilename + "all.log";
+	FILE* pFile = fopen(sPath.c_str(), "w");
+	if(pFile == NULL)
+	{
+		std::cout << "Error while writing file: " << sPath << " Maybe the selected folder does'nt exist." << std::endl;
+		return 2;
+	}
+
+	fprintf(pFile, "# time");
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+		fprintf(pFile, " motor%d", i);
+	fprintf(pFile, "\n# start offset");
+	for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+		fprintf(pFile, " %e", vdOffsetS[i]);
+	fprintf(pFile, "\n");
+
+	for(int k = 0; k * dStepSec <= dEndS + 1e-9; k++)
+	{
+		fprintf(pFile, "%e", k * dStepSec);
+		for(unsigned int i = 0; i < m_vpMotor.size(); i++)
+		{
+			if(!vbValid[i])
+			{
+				fprintf(pFile, " nan");
+				continue;
+			}
+
+			dPos = (k * dStepSec - vdOffsetS[i]) / vfStepSec[i];
+			iIdx = (int)floor(dPos);
+			if((dPos < -1e-6) || (iIdx > (int)vvfValues[i].size() - 1))
+				fprintf(pFile, " nan");
+			else if((iIdx < 0) || (iIdx == (int)vvfValues[i].size() - 1))
+				fprintf(pFile, " %e", vvfValues[i][std::max(iIdx, 0)]);
+			else
+				fprintf(pFile, " %e", vvfValues[i][iIdx] + (dPos - iIdx) * (vvfValues[i][iIdx + 1] - vvfValues[i][iIdx]));
+		}
+		fprintf(pFile, "\n");
+	}
+	fclose(pFile);
+
+	return 0;
+}
@@ -0,0 +1,892 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs the complete base pipeline (UndercarriageCtrlGeom -> CanCtrlPltfCOb3 -> odometry) in the order of
+// cob_base_controller against a simulated CAN bus and measures per cycle
+// - the CPU time of the thread,
+// - the number of heap allocations,
+// - the latency from setting the twist command to the SYNC that closes the batch of velocity commands.
+// The simulated drives advance by a fixed period at every SYNC, so odometry and commands only depend on
+// the input and are compared as checksum. The twist commands (and optionally the joint states) can be
+// replayed from a recording, see printUsage().
+//
+// The benchmark fails (exit code 1) if a threshold is exceeded or if the results deviate from a baseline
+// saved by an earlier run.
+
+#include <cob_base_drive_chain/CanCtrlPltfCOb3.h>
+#include <cob_undercarriage_ctrl/UndercarriageCtrlGeom.h>
+#include <cob_undercarriage_ctrl/OdometryIntegrator.h>
+#include <cob_utilities/CycleStats.h>
+#include <cob_utilities/MathSup.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------
+// allocation counting: every global new is counted while g_bCountAllocs is set
+
+#if __cplusplus >= 201103L
+#define NEW_THROW_SPEC
+#define DELETE_THROW_SPEC noexcept
+#else
+#define NEW_THROW_SPEC throw(std::bad_alloc)
+#define DELETE_THROW_SPEC throw()
+#endif
+
+static bool g_bCountAllocs = false;
+static unsigned long g_ulNumAllocs = 0;
+
+void* operator new(std::size_t size) NEW_THROW_SPEC
+{
+	if(g_bCountAllocs)
+		g_ulNumAllocs++;
+
+	void* p = malloc(size > 0 ? size : 1);
+	if(p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+// the replacement pairs malloc with free, gcc doesn't see that operator new is replaced as well
+#if defined(__GNUC__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) DELETE_THROW_SPEC
+{
+	free(p);
+}
+#if defined(__GNUC__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+
+//-----------------------------------------------
+// simulated platform: 4 wheels, every wheel has a drive and a steer motor (order of CanCtrlPltfCOb3)
+
+static const int c_iNumWheels = 4;
+static const int c_iNumMotors = 8;
+static const double c_dCyclePeriodS = 0.01;
+static const int c_iNodeID[c_iNumMotors] = {2, 1, 4, 3, 8, 7, 6, 5};
+static const int c_iSign[c_iNumMotors] = {1, -1, 1, -1, -1, -1, -1, -1};
+static const char* c_pcMotorName[c_iNumMotors] = {"W1Drive", "W1Steer", "W2Drive", "W2Steer",
+	"W3Drive", "W3Steer", "W4Drive", "W4Steer"};
+static const int c_iEncIncrPerRevMot = 4096;
+static const double c_dGearRatioDrive = 37.0;
+static const double c_dGearRatioSteer = 64.0;
+static const double c_dWheelPosMM[c_iNumWheels][2] = {{243, 243}, {-243, 243}, {-243, -243}, {243, -243}};
+
+// encoder increments per radian of the joint of motor iMotor (VelMeasFrqHz = 1, so velocities are in incr/s)
+static double getIncrPerRad(int iMotor)
+{
+	double dGearRatio = (iMotor % 2 == 1) ? c_dGearRatioSteer : c_dGearRatioDrive;
+	return c_iEncIncrPerRevMot * dGearRatio / MathSup::TWO_PI;
+}
+
+//-----------------------------------------------
+/**
+ * CAN bus with simulated Harmonica drives.
+ * The drives answer the binary interpreter, SDO downloads and SYNC like the real drives, but without delay.
+ * Every SYNC advances the drives by a fixed period. Messages are kept in a fixed ring buffer,
+ * so the bus doesn't allocate memory after construction.
+ */
+class SimulatedCanBus : public CanItf
+{
+public:
+	enum
+	{
+		MAX_DRIVES = 8,
+		QUEUE_LEN = 1024
+	};
+
+	SimulatedCanBus(double dSyncPeriodS);
+
+	/// Adds a drive with the given CANopen node id, returns its index.
+	int addDrive(int iNodeID);
+
+	/// Reports the given motor position and velocity on the next SYNC instead of the simulated state.
+	void setMeasurement(int iDrive, int iPosIncr, int iVelIncrPeriod);
+
+	/// Time of the last SYNC transmitted (CLOCK_MONOTONIC in ns).
+	long long getLastSyncNS() const { return m_llLastSyncNS; }
+
+	/// Number of messages dropped because the receive queue was full.
+	unsigned long getNumDropped() const { return m_ulNumDropped; }
+
+	bool init_ret() { return true; }
+	void init() { }
+	bool transmitMsg(CanMsg CMsg, bool bBlocking = true);
+	bool receiveMsg(CanMsg* pCMsg);
+	bool receiveMsgRetry(CanMsg* pCMsg, int /*iNrOfRetry*/) { return receiveMsg(pCMsg); }
+	bool receiveMsgTimeout(CanMsg* pCMsg, int /*nMicroSecTimeout*/) { return receiveMsg(pCMsg); }
+	bool isObjectMode() { return false; }
+
+private:
+	struct SimDrive
+	{
+		int iNodeID;
+		bool bMotorOn;
+		bool bHomingArmed;
+		int iHomingPosIncr;
+		int iVelCmdIncrPeriod;
+		int iVelIncrPeriod;
+		double dPosIncr;
+		bool bMeasurementSet;
+		int iMeasPosIncr;
+		int iMeasVelIncrPeriod;
+	};
+
+	/// Queues an answer with 8 bytes: iByte0..3 followed by iData (little endian).
+	void pushMsg(int iID, int iByte0, int iByte1, int iByte2, int iByte3, int iData);
+	void answerInterpreter(SimDrive& drive, CanMsg& msg);
+	void answerSDO(SimDrive& drive, CanMsg& msg);
+	void sync();
+
+	double m_dSyncPeriodS;
+	SimDrive m_Drive[MAX_DRIVES];
+	int m_iNumDrives;
+	int m_iDriveOfNode[128];
+
+	CanMsg m_Queue[QUEUE_LEN];
+	int m_iQueueHead;
+	int m_iQueueSize;
+	unsigned long m_ulNumDropped;
+	long long m_llLastSyncNS;
+};
+
+//-----------------------------------------------
+SimulatedCanBus::SimulatedCanBus(double dSyncPeriodS)
+{
+	setCanItfType(CAN_DUMMY);
+
+	m_dSyncPeriodS = dSyncPeriodS;
+	m_iNumDrives = 0;
+	for(int i = 0; i < 128; i++)
+		m_iDriveOfNode[i] = -1;
+
+	m_iQueueHead = 0;
+	m_iQueueSize = 0;
+	m_ulNumDropped = 0;
+	m_llLastSyncNS = 0;
+}
+
+//-----------------------------------------------
+int SimulatedCanBus::addDrive(int iNodeID)
+{
+	if((m_iNumDrives >= MAX_DRIVES) || (iNodeID < 1) || (iNodeID > 127))
+		return -1;
+
+	SimDrive& drive = m_Drive[m_iNumDrives];
+	drive.iNodeID = iNodeID;
+	drive.bMotorOn = false;
+	drive.bHomingArmed = false;
+	drive.iHomingPosIncr = 0;
+	drive.iVelCmdIncrPeriod = 0;
+	drive.iVelIncrPeriod = 0;
+	drive.dPosIncr = 0;
+	drive.bMeasurementSet = false;
+	drive.iMeasPosIncr = 0;
+	drive.iMeasVelIncrPeriod = 0;
+
+	m_iDriveOfNode[iNodeID] = m_iNumDrives;
+	return m_iNumDrives++;
+}
+
+//-----------------------------------------------
+void SimulatedCanBus::setMeasurement(int iDrive, int iPosIncr, int iVelIncrPeriod)
+{
+	m_Drive[iDrive].bMeasurementSet = true;
+	m_Drive[iDrive].iMeasPosIncr = iPosIncr;
+	m_Drive[iDrive].iMeasVelIncrPeriod = iVelIncrPeriod;
+}
+
+//-----------------------------------------------
+bool SimulatedCanBus::transmitMsg(CanMsg CMsg, bool /*bBlocking*/)
+{
+	int iNode = CMsg.m_iID & 0x7F;
+	int iFunction = CMsg.m_iID & ~0x7F;
+
+	if(CMsg.m_iID == 0x80)
+	{
+		m_llLastSyncNS = CycleStats::nowNS();
+		sync();
+	}
+	else if((iFunction == 0x300) && (m_iDriveOfNode[iNode] >= 0))
+		answerInterpreter(m_Drive[m_iDriveOfNode[iNode]], CMsg);
+	else if((iFunction == 0x600) && (m_iDriveOfNode[iNode] >= 0))
+		answerSDO(m_Drive[m_iDriveOfNode[iNode]], CMsg);
+
+	// NMT and heartbeat are not answered
+	return true;
+}
+
+//-----------------------------------------------
+bool SimulatedCanBus::receiveMsg(CanMsg* pCMsg)
+{
+	if(m_iQueueSize == 0)
+		return false;
+
+	*pCMsg = m_Queue[m_iQueueHead];
+	m_iQueueHead = (m_iQueueHead + 1) % QUEUE_LEN;
+	m_iQueueSize--;
+	return true;
+}
+
+//-----------------------------------------------
+void SimulatedCanBus::pushMsg(int iID, int iByte0, int iByte1, int iByte2, int iByte3, int iData)
+{
+	if(m_iQueueSize >= QUEUE_LEN)
+	{
+		m_ulNumDropped++;
+		return;
+	}
+
+	CanMsg& msg = m_Queue[(m_iQueueHead + m_iQueueSize) % QUEUE_LEN];
+	msg.m_iID = iID;
+	msg.m_iLen = 8;
+	msg.set(iByte0, iByte1, iByte2, iByte3, iData, iData >> 8, iData >> 16, iData >> 24);
+	m_iQueueSize++;
+}
+
+//-----------------------------------------------
+void SimulatedCanBus::answerInterpreter(SimDrive& drive, CanMsg& msg)
+{
+	char cCmd1 = msg.getAt(0);
+	char cCmd2 = msg.getAt(1);
+	int iIndex = msg.getAt(2) | ((msg.getAt(3) & 0x3F) << 8);
+	int iData = (msg.getAt(7) << 24) | (msg.getAt(6) << 16) | (msg.getAt(5) << 8) | msg.getAt(4);
+	int iAnswer = 0;
+
+	if(msg.m_iLen == 8)
+	{
+		// set command: executed and echoed
+		if((cCmd1 == 'M') && (cCmd2 == 'O'))
+			drive.bMotorOn = (iData != 0);
+		else if((cCmd1 == 'J') && (cCmd2 == 'V'))
+			drive.iVelCmdIncrPeriod = iData;
+		else if((cCmd1 == 'P') && (cCmd2 == 'X'))
+			drive.dPosIncr = iData;
+		else if((cCmd1 == 'H') && (cCmd2 == 'M') && (iIndex == 1))
+			drive.bHomingArmed = (iData != 0);
+		else if((cCmd1 == 'H') && (cCmd2 == 'M') && (iIndex == 2))
+			drive.iHomingPosIncr = iData;
+
+		iAnswer = iData;
+	}
+	else
+	{
+		// execute command or query
+		if((cCmd1 == 'B') && (cCmd2 == 'G'))
+		{
+			drive.iVelIncrPeriod = drive.bMotorOn ? drive.iVelCmdIncrPeriod : 0;
+		}
+		else if((cCmd1 == 'S') && (cCmd2 == 'R'))
+		{
+			// bit 4: motor on
+			iAnswer = drive.bMotorOn ? 0x10 : 0x00;
+		}
+		else if((cCmd1 == 'P') && (cCmd2 == 'X'))
+		{
+			iAnswer = (int)drive.dPosIncr;
+		}
+		else if((cCmd1 == 'H') && (cCmd2 == 'M') && (iIndex == 1))
+		{
+			// the homing switch is reached at the first query after arming
+			if(drive.bHomingArmed)
+				drive.dPosIncr = drive.iHomingPosIncr;
+			drive.bHomingArmed = false;
+		}
+	}
+
+	pushMsg(0x280 + drive.iNodeID, cCmd1, cCmd2, iIndex, iIndex >> 8, iAnswer);
+}
+
+//-----------------------------------------------
+void SimulatedCanBus::answerSDO(SimDrive& drive, CanMsg& msg)
+{
+	int iIndex = msg.getAt(1) | (msg.getAt(2) << 8);
+	int iSubIndex = msg.getAt(3);
+
+	if((msg.getAt(0) & 0xE0) == 0x20)
+	{
+		// download confirmation
+		pushMsg(0x580 + drive.iNodeID, 0x60, iIndex, iIndex >> 8, iSubIndex, 0);
+	}
+	else if((msg.getAt(0) & 0xE0) == 0x40)
+	{
+		// expedited upload of 4 bytes, every object reads 0
+		pushMsg(0x580 + drive.iNodeID, 0x43, iIndex, iIndex >> 8, iSubIndex, 0);
+	}
+}
+
+//-----------------------------------------------
+void SimulatedCanBus::sync()
+{
+	for(int i = 0; i < m_iNumDrives; i++)
+	{
+		SimDrive& drive = m_Drive[i];
+		int iPosIncr, iVelIncrPeriod;
+
+		if(!drive.bMotorOn)
+			drive.iVelIncrPeriod = 0;
+		drive.dPosIncr += drive.iVelIncrPeriod * m_dSyncPeriodS;
+
+		iPosIncr = (int)floor(drive.dPosIncr + 0.5);
+		iVelIncrPeriod = drive.iVelIncrPeriod;
+		if(drive.bMeasurementSet)
+		{
+			iPosIncr = drive.iMeasPosIncr;
+			iVelIncrPeriod = drive.iMeasVelIncrPeriod;
+			drive.bMeasurementSet = false;
+		}
+
+		// TPDO1: position and velocity
+		pushMsg(0x180 + drive.iNodeID, iPosIncr, iPosIncr >> 8, iPosIncr >> 16, iPosIncr >> 24, iVelIncrPeriod);
+	}
+}
+
+//-----------------------------------------------
+// configuration of the simulated platform
+
+static bool writeIniFiles(const std::string& sIniDirectory)
+{
+	FILE* f;
+
+	f = fopen((sIniDirectory + "Platform.ini").c_str(), "w");
+	if(f == NULL)
+		return false;
+	fprintf(f, "[Config]\nNumberOfMotors=%d\nNumberOfWheels=%d\nGenericBufferLen=100\n", c_iNumMotors, c_iNumWheels);
+	for(int i = 0; i < c_iNumWheels; i++)
+		fprintf(f, "Wheel%dDriveMotor=1\nWheel%dSteerMotor=1\n", i + 1, i + 1);
+	fprintf(f, "\n[Geom]\nRadiusWheel=73\nDistSteerAxisToDriveWheelCenter=15\nDistWheels=486\n");
+	for(int i = 0; i < c_iNumWheels; i++)
+		fprintf(f, "Wheel%dXPos=%.1f\nWheel%dYPos=%.1f\n", i + 1, c_dWheelPosMM[i][0], i + 1, c_dWheelPosMM[i][1]);
+	fprintf(f, "\n[DrivePrms]\nMaxDriveRate=20.0\nMaxSteerRate=10.0\nHomingVelocityRadS=-1.0\n");
+	for(int i = 0; i < c_iNumWheels; i++)
+		fprintf(f, "Wheel%dSteerDriveCoupling=0.0\nWheel%dNeutralPosition=0.0\n", i + 1, i + 1);
+	fprintf(f, "\n[Thread]\nThrUCarrCycleTimeS=%.3f\n", c_dCyclePeriodS);
+	fclose(f);
+
+	f = fopen((sIniDirectory + "MotionCtrl.ini").c_str(), "w");
+	if(f == NULL)
+		return false;
+	fprintf(f, "[SteerCtrl]\nSpring=10.0\nDamp=2.5\nVirtMass=0.1\nDPhiMax=12.0\nDDPhiMax=100.0\n");
+	fclose(f);
+
+	f = fopen((sIniDirectory + "CanCtrl.ini").c_str(), "w");
+	if(f == NULL)
+		return false;
+	// no hardware interface, the simulated bus is set by setCanItf()
+	fprintf(f, "[TypeCan]\nCan=%d\n\n[CanOpenIDs]\n", CANITFTYPE_CAN_DUMMY);
+	for(int i = 0; i < c_iNumMotors; i++)
+	{
+		const char* pcName = c_pcMotorName[i];
+		int iNode = c_iNodeID[i];
+		fprintf(f, "TxPDO1_%s=%d\nTxPDO2_%s=%d\nRxPDO2_%s=%d\nTxSDO_%s=%d\nRxSDO_%s=%d\n",
+			pcName, 0x180 + iNode, pcName, 0x280 + iNode, pcName, 0x300 + iNode, pcName, 0x580 + iNode, pcName, 0x600 + iNode);
+	}
+	for(int i = 0; i < c_iNumMotors; i++)
+	{
+		bool bSteer = (i % 2 == 1);
+		fprintf(f, "\n[%s%d]\nEncIncrPerRevMot=%d\nVelMeasFrqHz=1.0\nBeltRatio=1.0\nGearRatio=%.1f\nSign=%d\n"
+			"VelMaxEncIncrS=1000000.0\nAccIncrS=1000000.0\nDecIncrS=1000000.0\nEncOffsetIncr=0\nIsSteering=%s\n"
+			"CurrentToTorque=1.0\nCurrMax=10.0\nHomingDigIn=19\n",
+			bSteer ? "Steer" : "Drive", i / 2 + 1, c_iEncIncrPerRevMot, bSteer ? c_dGearRatioSteer : c_dGearRatioDrive,
+			c_iSign[i], bSteer ? "true" : "false");
+	}
+	fprintf(f, "\n[US]\nScaleToMM=1.0\n");
+	fclose(f);
+
+	return true;
+}
+
+static void removeIniFiles(const std::string& sIniDirectory)
+{
+	unlink((sIniDirectory + "Platform.ini").c_str());
+	unlink((sIniDirectory + "MotionCtrl.ini").c_str());
+	unlink((sIniDirectory + "CanCtrl.ini").c_str());
+	rmdir(sIniDirectory.c_str());
+}
+
+//-----------------------------------------------
+// input of one cycle: twist command and optionally the joint states measured at the SYNC before the cycle
+
+struct ReplayStep
+{
+	double dStampS;
+	double dVelXMS, dVelYMS, dRotRadS;
+	bool bHasJointStates;
+	double dPosRad[c_iNumMotors];
+	double dVelRadS[c_iNumMotors];
+};
+
+// reads lines "t vx vy w [pos vel]", pos and vel are given for all motors or none, '#' starts a comment
+static bool readReplay(const std::string& sFilename, std::vector<ReplayStep>& vSteps)
+{
+	std::ifstream file(sFilename.c_str());
+	std::string sLine;
+	int iLine = 0;
+
+	if(!file.is_open())
+	{
+		std::cout << "Can't open replay file " << sFilename << std::endl;
+		return false;
+	}
+
+	while(std::getline(file, sLine))
+	{
+		ReplayStep step;
+		int iNumJoints = 0;
+
+		iLine++;
+		if(sLine.find('#') != std::string::npos)
+			sLine.erase(sLine.find('#'));
+		std::istringstream line(sLine);
+		if(!(line >> step.dStampS))
+			continue;
+		if(!(line >> step.dVelXMS >> step.dVelYMS >> step.dRotRadS))
+		{
+			std::cout << sFilename << ":" << iLine << ": expected t vx vy w" << std::endl;
+			return false;
+		}
+		while((iNumJoints < c_iNumMotors) && (line >> step.dPosRad[iNumJoints] >> step.dVelRadS[iNumJoints]))
+			iNumJoints++;
+		if((iNumJoints != 0) && (iNumJoints != c_iNumMotors))
+		{
+			std::cout << sFilename << ":" << iLine << ": expected position and velocity of " << c_iNumMotors
+				<< " motors" << std::endl;
+			return false;
+		}
+		if(!vSteps.empty() && (step.dStampS <= vSteps.back().dStampS))
+		{
+			std::cout << sFilename << ":" << iLine << ": time stamps have to increase" << std::endl;
+			return false;
+		}
+		step.bHasJointStates = (iNumJoints == c_iNumMotors);
+		vSteps.push_back(step);
+	}
+
+	if(vSteps.empty())
+	{
+		std::cout << "Replay file " << sFilename << " contains no cycle" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// slowly varying twist with a standstill every 4000 cycles
+static void createProfile(int iCycles, std::vector<ReplayStep>& vSteps)
+{
+	vSteps.resize(iCycles);
+	for(int k = 0; k < iCycles; k++)
+	{
+		ReplayStep& step = vSteps[k];
+		bool bStop = (k % 4000) >= 3800;
+
+		step.dStampS = k * c_dCyclePeriodS;
+		step.dVelXMS = bStop ? 0.0 : 0.4 * sin(MathSup::TWO_PI * k / 2000.0);
+		step.dVelYMS = bStop ? 0.0 : 0.2 * sin(MathSup::TWO_PI * k / 3000.0);
+		step.dRotRadS = bStop ? 0.0 : 0.3 * sin(MathSup::TWO_PI * k / 5000.0);
+		step.bHasJointStates = false;
+	}
+}
+
+//-----------------------------------------------
+// statistics
+
+static long long threadCpuNS()
+{
+	::timespec ts;
+	::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct Summary
+{
+	double dMean;
+	double dMedian;
+	double dP99;
+	double dMax;
+};
+
+static Summary summarize(std::vector<double> vdSamples)
+{
+	Summary summary;
+	double dSum = 0;
+
+	std::sort(vdSamples.begin(), vdSamples.end());
+	for(unsigned int i = 0; i < vdSamples.size(); i++)
+		dSum += vdSamples[i];
+	summary.dMean = dSum / vdSamples.size();
+	summary.dMedian = vdSamples[(vdSamples.size() - 1) / 2];
+	summary.dP99 = vdSamples[(vdSamples.size() - 1) * 99 / 100];
+	summary.dMax = vdSamples.back();
+	return summary;
+}
+
+static bool readBaseline(const std::string& sFilename, std::map<std::string, double>& baseline)
+{
+	std::ifstream file(sFilename.c_str());
+	std::string sKey;
+	double dValue;
+
+	if(!file.is_open())
+		return false;
+	while(file >> sKey >> dValue)
+		baseline[sKey] = dValue;
+	return true;
+}
+
+static bool writeBaseline(const std::string& sFilename, const std::map<std::string, double>& results)
+{
+	FILE* f = fopen(sFilename.c_str(), "w");
+	if(f == NULL)
+		return false;
+	for(std::map<std::string, double>::const_iterator it = results.begin(); it != results.end(); ++it)
+		fprintf(f, "%s %.17g\n", it->first.c_str(), it->second);
+	fclose(f);
+	return true;
+}
+
+// returns false if the value exceeds the limit
+static bool checkLimit(const char* pcName, double dValue, double dLimit)
+{
+	if(dValue <= dLimit)
+		return true;
+	std::cout << "REGRESSION: " << pcName << " " << dValue << " exceeds " << dLimit << std::endl;
+	return false;
+}
+
+static void printUsage()
+{
+	std::cout << "Usage: base_pipeline_benchmark [options]\n"
+		"  --cycles N            number of control cycles (default 10000, or the length of the replay)\n"
+		"  --replay FILE         replays the lines \"t vx vy w [pos vel]\" of FILE, one line per cycle;\n"
+		"                        t in s, twist in m/s and rad/s, optionally position (rad) and velocity (rad/s)\n"
+		"                        of all 8 joints (drive and steer of every wheel) measured at t\n"
+		"  --max-cpu-us X        fails if the 99th percentile of the CPU time per cycle exceeds X us\n"
+		"  --max-latency-us X    fails if the 99th percentile of the command latency exceeds X us\n"
+		"  --max-allocs N        fails if a cycle allocates memory more than N times\n"
+		"  --baseline FILE       fails if the mean or median times are worse than the baseline by more than\n"
+		"                        the tolerance, or if the checksum differs\n"
+		"  --tolerance F         relative tolerance of times compared to the baseline (default 0.25)\n"
+		"  --slack-us X          absolute tolerance added to the relative one, so that times of a few us\n"
+		"                        don't fail on scheduling noise (default 2)\n"
+		"  --save-baseline FILE  saves the results as baseline" << std::endl;
+}
+
+//-----------------------------------------------
+int main(int argc, char** argv)
+{
+	int iCycles = 0;
+	std::string sReplayFile, sBaselineFile, sSaveBaselineFile;
+	double dMaxCpuUS = -1, dMaxLatencyUS = -1, dTolerance = 0.25, dSlackUS = 2.0;
+	long lMaxAllocs = -1;
+
+	for(int i = 1; i < argc; i++)
+	{
+		std::string sArg = argv[i];
+		if(i + 1 >= argc)
+		{
+			printUsage();
+			return 2;
+		}
+		if(sArg == "--cycles")
+			iCycles = atoi(argv[++i]);
+		else if(sArg == "--replay")
+			sReplayFile = argv[++i];
+		else if(sArg == "--max-cpu-us")
+			dMaxCpuUS = atof(argv[++i]);
+		else if(sArg == "--max-latency-us")
+			dMaxLatencyUS = atof(argv[++i]);
+		else if(sArg == "--max-allocs")
+			lMaxAllocs = atol(argv[++i]);
+		else if(sArg == "--baseline")
+			sBaselineFile = argv[++i];
+		else if(sArg == "--tolerance")
+			dTolerance = atof(argv[++i]);
+		else if(sArg == "--slack-us")
+			dSlackUS = atof(argv[++i]);
+		else if(sArg == "--save-baseline")
+			sSaveBaselineFile = argv[++i];
+		else
+		{
+			printUsage();
+			return 2;
+		}
+	}
+
+	// input
+	std::vector<ReplayStep> vSteps;
+	if(!sReplayFile.empty())
+	{
+		if(!readReplay(sReplayFile, vSteps))
+			return 2;
+		if(iCycles <= 0)
+			iCycles = vSteps.size();
+	}
+	else
+	{
+		if(iCycles <= 0)
+			iCycles = 10000;
+		createProfile(iCycles, vSteps);
+	}
+	int iNumSteps = vSteps.size();
+	double dReplayPeriodS = vSteps.back().dStampS - vSteps.front().dStampS + c_dCyclePeriodS;
+
+	// configuration
+	char cIniDirectory[] = "/tmp/base_pipeline_benchmarkXXXXXX";
+	if(mkdtemp(cIniDirectory) == NULL)
+	{
+		std::cout << "Can't create directory for the configuration" << std::endl;
+		return 2;
+	}
+	std::string sIniDirectory = std::string(cIniDirectory) + "/";
+	if(!writeIniFiles(sIniDirectory))
+	{
+		std::cout << "Can't write configuration to " << sIniDirectory << std::endl;
+		removeIniFiles(sIniDirectory);
+		return 2;
+	}
+
+	// pipeline
+	SimulatedCanBus* pBus = new SimulatedCanBus(c_dCyclePeriodS);
+	for(int i = 0; i < c_iNumMotors; i++)
+		pBus->addDrive(c_iNodeID[i]);
+
+	CanCtrlPltfCOb3 Pltf(sIniDirectory);
+	Pltf.setCanItf(pBus);
+	UndercarriageCtrlGeom UndercarriageCtrl(sIniDirectory);
+	OdometryIntegrator Odometry;
+
+	// initialization including homing is not measured
+	bool bInitOk = Pltf.initPltf();
+	UndercarriageCtrl.InitUndercarriageCtrl();
+	removeIniFiles(sIniDirectory);
+	if(!bInitOk)
+	{
+		std::cout << "Initialization of the platform failed" << std::endl;
+		return 2;
+	}
+
+	std::vector<double> vdAngGearRad(c_iNumMotors, 0.0), vdVelGearRad(c_iNumMotors, 0.0);
+	std::vector<double> vdVelCmdGearRadS(c_iNumMotors, 0.0);
+	std::vector<double> vdDriveAngRad(c_iNumWheels, 0.0), vdDriveVelRadS(c_iNumWheels, 0.0);
+	std::vector<double> vdSteerAngRad(c_iNumWheels, 0.0), vdSteerVelRadS(c_iNumWheels, 0.0);
+	std::vector<double> vdDriveVelCmdRadS(c_iNumWheels, 0.0), vdSteerVelCmdRadS(c_iNumWheels, 0.0);
+	std::vector<double> vdSteerAngCmdRad(c_iNumWheels, 0.0);
+	std::vector<double> vdCpuUS(iCycles), vdWallUS(iCycles), vdLatencyUS(iCycles), vdAllocs(iCycles);
+	double dChecksum = 0;
+
+	// the first SYNC samples the drives for the first cycle
+	if(vSteps[0].bHasJointStates)
+		for(int i = 0; i < c_iNumMotors; i++)
+			pBus->setMeasurement(i, (int)floor(c_iSign[i] * vSteps[0].dPosRad[i] * getIncrPerRad(i) + 0.5),
+				(int)(c_iSign[i] * vSteps[0].dVelRadS[i] * getIncrPerRad(i)));
+	Pltf.setVelGearRadS(vdVelCmdGearRadS);
+
+	g_bCountAllocs = true;
+	for(int k = 0; k < iCycles; k++)
+	{
+		const ReplayStep& step = vSteps[k % iNumSteps];
+		const ReplayStep& nextStep = vSteps[(k + 1) % iNumSteps];
+		double dStampS = step.dStampS + (k / iNumSteps) * dReplayPeriodS;
+		double dDeltaXMM, dDeltaYMM, dDeltaThetaRad, dVelXMMS, dVelYMMS, dRotRadS, dDummy1, dDummy2;
+		double dVelCov[9];
+		bool bPltfError;
+
+		// joint states sampled by the SYNC at the end of this cycle
+		if(nextStep.bHasJointStates)
+			for(int i = 0; i < c_iNumMotors; i++)
+				pBus->setMeasurement(i, (int)floor(c_iSign[i] * nextStep.dPosRad[i] * getIncrPerRad(i) + 0.5),
+					(int)(c_iSign[i] * nextStep.dVelRadS[i] * getIncrPerRad(i)));
+
+		long long llStartCpuNS = threadCpuNS();
+		long long llStartNS = CycleStats::nowNS();
+		unsigned long ulStartAllocs = g_ulNumAllocs;
+
+		// twist command (controller expects mm/s)
+		UndercarriageCtrl.SetDesiredPltfVelocity(step.dVelXMS * 1000.0, step.dVelYMS * 1000.0, step.dRotRadS, 0.0);
+
+		// read CAN snapshot
+		Pltf.evalCanBuffer();
+		Pltf.getGearPosVelRadS(vdAngGearRad, vdVelGearRad);
+		for(int i = 0; i < c_iNumMotors; i++)
+		{
+			if(i % 2 == 1)
+			{
+				MathSup::normalizePi(vdAngGearRad[i]);
+				vdSteerAngRad[i / 2] = vdAngGearRad[i];
+				vdSteerVelRadS[i / 2] = vdVelGearRad[i];
+			}
+			else
+			{
+				vdDriveAngRad[i / 2] = vdAngGearRad[i];
+				vdDriveVelRadS[i / 2] = vdVelGearRad[i];
+			}
+		}
+		UndercarriageCtrl.SetActualWheelValues(vdDriveVelRadS, vdSteerVelRadS, vdDriveAngRad, vdSteerAngRad);
+
+		// odometry
+		UndercarriageCtrl.GetActualPltfVelocity(dDeltaXMM, dDeltaYMM, dDeltaThetaRad, dDummy1,
+			dVelXMMS, dVelYMMS, dRotRadS, dDummy2);
+		UndercarriageCtrl.GetActualPltfVelocityCov(dVelCov);
+		for(int r = 0; r < 3; r++)
+			for(int c = 0; c < 3; c++)
+			{
+				if (r < 2) dVelCov[3*r+c] /= 1000.0;
+				if (c < 2) dVelCov[3*r+c] /= 1000.0;
+			}
+		Odometry.update(dStampS, dVelXMMS / 1000.0, dVelYMMS / 1000.0, dRotRadS, dVelCov);
+
+		// control step
+		bPltfError = Pltf.isPltfError();
+		UndercarriageCtrl.GetNewCtrlStateSteerDriveSetValues(vdDriveVelCmdRadS, vdSteerVelCmdRadS, vdSteerAngCmdRad,
+			dVelXMMS, dVelYMMS, dRotRadS, dDummy1);
+		for(int i = 0; i < c_iNumMotors; i++)
+		{
+			if(bPltfError)
+				vdVelCmdGearRadS[i] = 0.0;
+			else if(i % 2 == 1)
+				vdVelCmdGearRadS[i] = vdSteerVelCmdRadS[i / 2];
+			else
+				vdVelCmdGearRadS[i] = vdDriveVelCmdRadS[i / 2];
+			MathSup::limit(&vdVelCmdGearRadS[i], (i % 2 == 1) ? 10.0 : 20.0);
+		}
+
+		// batched transmit
+		Pltf.setVelGearRadS(vdVelCmdGearRadS);
+
+		vdCpuUS[k] = (threadCpuNS() - llStartCpuNS) / 1000.0;
+		vdWallUS[k] = (CycleStats::nowNS() - llStartNS) / 1000.0;
+		vdLatencyUS[k] = (pBus->getLastSyncNS() - llStartNS) / 1000.0;
+		vdAllocs[k] = g_ulNumAllocs - ulStartAllocs;
+
+		for(int i = 0; i < c_iNumMotors; i++)
+			dChecksum += vdVelCmdGearRadS[i] * c_dCyclePeriodS;
+	}
+	g_bCountAllocs = false;
+
+	// results
+	double dXM, dYM, dThetaRad;
+	Odometry.getPose(dXM, dYM, dThetaRad);
+	dChecksum += dXM + dYM + dThetaRad;
+
+	Summary cpu = summarize(vdCpuUS);
+	Summary wall = summarize(vdWallUS);
+	Summary latency = summarize(vdLatencyUS);
+	Summary allocs = summarize(vdAllocs);
+
+	CycleStats Stats;
+	int iStageCpu = Stats.addStage("cpu time", (dMaxCpuUS > 0) ? dMaxCpuUS * 1e-6 : 0.0);
+	int iStageWall = Stats.addStage("wall time", 0.0);
+	int iStageLatency = Stats.addStage("command latency", (dMaxLatencyUS > 0) ? dMaxLatencyUS * 1e-6 : 0.0);
+	for(int k = 0; k < iCycles; k++)
+	{
+		Stats.record(iStageCpu, (long long)(vdCpuUS[k] * 1000.0));
+		Stats.record(iStageWall, (long long)(vdWallUS[k] * 1000.0));
+		Stats.record(iStageLatency, (long long)(vdLatencyUS[k] * 1000.0));
+	}
+
+	char cBuf[1024];
+	std::cout << std::endl << Stats.dump();
+	snprintf(cBuf, sizeof(cBuf), "%d cycles of %d motors%s\n"
+		"cpu time per cycle: mean %.2fus, median %.2fus, p99 %.2fus, max %.2fus\n"
+		"wall time per cycle: mean %.2fus, median %.2fus, p99 %.2fus, max %.2fus\n"
+		"command latency: mean %.2fus, median %.2fus, p99 %.2fus, max %.2fus\n"
+		"allocations per cycle: mean %.2f, max %.0f\n"
+		"odometry: x %.6fm, y %.6fm, theta %.6frad (checksum %.12g)\n",
+		iCycles, c_iNumMotors, sReplayFile.empty() ? "" : (" replayed from " + sReplayFile).c_str(),
+		cpu.dMean, cpu.dMedian, cpu.dP99, cpu.dMax, wall.dMean, wall.dMedian, wall.dP99, wall.dMax,
+		latency.dMean, latency.dMedian, latency.dP99, latency.dMax, allocs.dMean, allocs.dMax,
+		dXM, dYM, dThetaRad, dChecksum);
+	std::cout << cBuf;
+	if(pBus->getNumDropped() > 0)
+		std::cout << "Simulated bus dropped " << pBus->getNumDropped() << " messages" << std::endl;
+
+	std::map<std::string, double> results;
+	results["cycles"] = iCycles;
+	results["cpu_mean_us"] = cpu.dMean;
+	results["cpu_median_us"] = cpu.dMedian;
+	results["cpu_p99_us"] = cpu.dP99;
+	results["latency_median_us"] = latency.dMedian;
+	results["latency_p99_us"] = latency.dP99;
+	results["allocs_max"] = allocs.dMax;
+	results["checksum"] = dChecksum;
+
+	// regression checks
+	bool bOk = true;
+	if(dMaxCpuUS > 0)
+		bOk &= checkLimit("cpu time p99 [us]", cpu.dP99, dMaxCpuUS);
+	if(dMaxLatencyUS > 0)
+		bOk &= checkLimit("command latency p99 [us]", latency.dP99, dMaxLatencyUS);
+	if(lMaxAllocs >= 0)
+		bOk &= checkLimit("allocations per cycle", allocs.dMax, lMaxAllocs);
+
+	if(!sBaselineFile.empty())
+	{
+		std::map<std::string, double> baseline;
+		if(!readBaseline(sBaselineFile, baseline))
+		{
+			std::cout << "Can't read baseline " << sBaselineFile << std::endl;
+			return 2;
+		}
+		if(baseline["cycles"] != iCycles)
+		{
+			std::cout << "Baseline was recorded with " << baseline["cycles"] << " cycles" << std::endl;
+			return 2;
+		}
+		// the tails of us-level times depend on the scheduler, only the typical times are compared,
+		// p99 is left to the absolute limits
+		if(baseline.count("cpu_median_us") == 0 || baseline.count("latency_median_us") == 0)
+		{
+			std::cout << "Baseline " << sBaselineFile << " has no median times, please save it again" << std::endl;
+			return 2;
+		}
+		bOk &= checkLimit("cpu time mean [us]", cpu.dMean, baseline["cpu_mean_us"] * (1.0 + dTolerance) + dSlackUS);
+		bOk &= checkLimit("cpu time median [us]", cpu.dMedian, baseline["cpu_median_us"] * (1.0 + dTolerance) + dSlackUS);
+		bOk &= checkLimit("command latency median [us]", latency.dMedian,
+			baseline["latency_median_us"] * (1.0 + dTolerance) + dSlackUS);
+		bOk &= checkLimit("allocations per cycle", allocs.dMax, baseline["allocs_max"]);
+		if(fabs(dChecksum - baseline["checksum"]) > 1e-9 * (1.0 + fabs(baseline["checksum"])))
+		{
+			snprintf(cBuf, sizeof(cBuf), "REGRESSION: checksum %.17g differs from baseline %.17g\n",
+				dChecksum, baseline["checksum"]);
+			std::cout << cBuf;
+			bOk = false;
+		}
+	}
+
+	if(!sSaveBaselineFile.empty() && !writeBaseline(sSaveBaselineFile, results))
+	{
+		std::cout << "Can't write baseline " << sSaveBaselineFile << std::endl;
+		return 2;
+	}
+
+	return bOk ? 0 : 1;
+}
@@ -0,0 +1,739 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+//##################
+//#### includes ####
+
+// standard includes
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+
+// ROS includes
+#include <ros/ros.h>
+
+// ROS message includes
+#include <sensor_msgs/JointState.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <control_msgs/JointTrajectoryControllerState.h>
+#include <geometry_msgs/Twist.h>
+#include <nav_msgs/Odometry.h>
+#include <tf/transform_broadcaster.h>
+#include <cob_msgs/EmergencyStopState.h>
+
+// ROS service includes
+#include <std_srvs/Trigger.h>
+
+// external includes
+#include <cob_base_drive_chain/CanCtrlPltfCOb3.h>
+#include <cob_undercarriage_ctrl/UndercarriageCtrlGeom.h>
+#include <cob_undercarriage_ctrl/OdometryIntegrator.h>
+#include <cob_utilities/IniFile.h>
+#include <cob_utilities/MathSup.h>
+#include <cob_utilities/CycleStats.h>
+
+//####################
+//#### node class ####
+/**
+* This node runs the undercarriage controller and the base drive chain in one process.
+* Instead of exchanging joint commands and joint states via topics, every cycle is executed in a fixed order:
+* read the CAN snapshot -> odometry -> control step -> batched transmit of all velocity commands.
+* The joint states, joint commands and the controller state are still published, but only for monitoring.
+*/
+class NodeClass
+{
+	public:
+		// create a handle for this node, initialize node
+		ros::NodeHandle n;
+
+		// topics to publish (monitoring)
+		ros::Publisher topicPub_JointState;
+		ros::Publisher topicPub_ControllerState;
+		ros::Publisher topicPub_JointCommand;
+		ros::Publisher topicPub_Odometry;
+		ros::Publisher topicPub_Diagnostic;
+		ros::Publisher topicPub_DiagnosticGlobal_;
+		tf::TransformBroadcaster m_TfBroadcastOdometry;
+
+		/**
+		* Timer to publish global diagnostic messages
+		*/
+		ros::Timer glDiagnostics_timer;
+
+		// topics to subscribe, callback is called for new messages arriving
+		ros::Subscriber topicSub_TwistCmd;
+		ros::Subscriber topicSub_EMStopState;
+
+		// service servers
+		ros::ServiceServer srvServer_Init;
+		ros::ServiceServer srvServer_Recover;
+		ros::ServiceServer srvServer_Shutdown;
+		ros::ServiceServer srvServer_DumpCycleStats;
+
+		// global variables
+		CanCtrlPltfCOb3 *m_CanCtrlPltf;
+		UndercarriageCtrlGeom *m_UndercarriageCtrl;
+		OdometryIntegrator m_Odometry;
+
+		bool m_bisInitialized;
+		bool m_bEMStopActive;
+		bool m_bPltfError;
+		bool m_bCtrlHalted;
+		int m_iNumMotors;
+		int m_iNumDrives;
+
+		struct ParamType
+		{
+			double dMaxDriveRateRadpS;
+			double dMaxSteerRateRadpS;
+
+			std::vector<double> vdWheelNtrlPosRad;
+		};
+		ParamType m_Param;
+
+		std::string sIniDirectory;
+		bool m_bBroadcastTf;
+		double m_dCycleRateHz;
+		double m_dTimeout;
+		double m_dMaxVelTrans;
+		double m_dMaxVelRot;
+		int m_iWatchdog;
+
+		// time of the SYNC of the last cycle (the measurements read in this cycle were sampled at that instant)
+		ros::Time m_SyncStamp;
+
+		// joint names in order of the motors: 2*i drive and 2*i+1 steer motor of wheel i
+		std::vector<std::string> m_vsJointNames;
+
+		// preallocated messages and buffers (indexed by motor)
+		sensor_msgs::JointState m_JointState;
+		control_msgs::JointTrajectoryControllerState m_ControllerState;
+		control_msgs::JointTrajectoryControllerState m_JointCommand;
+		std::vector<double> m_vdAngGearRad, m_vdVelGearRad, m_vdVelCmdGearRadS;
+
+		// preallocated buffers (indexed by wheel)
+		std::vector<double> m_vdDriveAngRad, m_vdDriveVelRadS, m_vdSteerAngRad, m_vdSteerVelRadS;
+		std::vector<double> m_vdDriveVelCmdRadS, m_vdSteerVelCmdRadS, m_vdSteerAngCmdRad;
+
+		// timing of the control cycle (enabled by parameter cycle_stats)
+		CycleStats m_CycleStats;
+		int m_iStageCycle, m_iStageRead, m_iStageOdometry, m_iStageCtrl, m_iStageTransmit, m_iStageMonitoring;
+
+		// Constructor
+		NodeClass()
+		{
+			/// Parameters are set within the launch file
+			if (n.hasParam("IniDirectory"))
+			{
+				n.getParam("IniDirectory", sIniDirectory);
+				ROS_INFO("IniDirectory loaded from Parameter-Server is: %s", sIniDirectory.c_str());
+			}
+			else
+			{
+				sIniDirectory = "Platform/IniFiles/";
+				ROS_WARN("IniDirectory not found on Parameter-Server, using default value: %s", sIniDirectory.c_str());
+			}
+
+			n.param<double>("cycle_rate", m_dCycleRateHz, 100.0);
+			n.param<double>("timeout", m_dTimeout, 1.0);
+			n.param<double>("max_trans_velocity", m_dMaxVelTrans, 1.1);
+			n.param<double>("max_rot_velocity", m_dMaxVelRot, 1.8);
+			n.param<bool>("broadcast_tf", m_bBroadcastTf, true);
+			if(m_dCycleRateHz <= 0.0)
+			{
+				ROS_WARN("Parameter cycle_rate has to be positive. Using default: 100Hz");
+				m_dCycleRateHz = 100.0;
+			}
+			if(m_dTimeout < 1.0 / m_dCycleRateHz)
+			{
+				ROS_WARN("Specified timeout < cycle time. Setting timeout to cycle time = %fs", 1.0 / m_dCycleRateHz);
+				m_dTimeout = 1.0 / m_dCycleRateHz;
+			}
+
+			// period of the cycle and duration of its stages, budgets are used to count overruns
+			bool bCycleStats;
+			n.param<bool>("cycle_stats", bCycleStats, false);
+			m_iStageCycle = m_CycleStats.addStage("cycle period", 1.1 / m_dCycleRateHz);
+			m_iStageRead = m_CycleStats.addStage("read CAN snapshot", 0.0005);
+			m_iStageOdometry = m_CycleStats.addStage("odometry", 0.0002);
+			m_iStageCtrl = m_CycleStats.addStage("control step", 0.0002);
+			m_iStageTransmit = m_CycleStats.addStage("batched transmit", 0.0005);
+			m_iStageMonitoring = m_CycleStats.addStage("monitoring", 0.001);
+			m_CycleStats.setEnabled(bCycleStats);
+
+			IniFile iniFile;
+			iniFile.SetFileName(sIniDirectory + "Platform.ini", "PltfHardwareCoB3.h");
+			iniFile.GetKeyInt("Config", "NumberOfMotors", &m_iNumMotors, true);
+			iniFile.GetKeyInt("Config", "NumberOfWheels", &m_iNumDrives, true);
+			if(m_iNumMotors < 2 || m_iNumMotors > 8) {
+				m_iNumMotors = 8;
+				m_iNumDrives = 4;
+			}
+
+			m_CanCtrlPltf = new CanCtrlPltfCOb3(sIniDirectory);
+			m_UndercarriageCtrl = new UndercarriageCtrlGeom(sIniDirectory);
+			if(m_UndercarriageCtrl->GetNumberOfDrives() != m_iNumDrives)
+			{
+				ROS_WARN("Undercarriage controller handles %d wheels but %d wheels are configured for the drive chain",
+					m_UndercarriageCtrl->GetNumberOfDrives(), m_iNumDrives);
+				m_iNumDrives = std::min(m_iNumDrives, m_UndercarriageCtrl->GetNumberOfDrives());
+			}
+
+			// joint names can be configured, default to the names of the Care-O-bot base
+			if(n.hasParam("joint_names"))
+			{
+				n.getParam("joint_names", m_vsJointNames);
+			}
+			if((int)m_vsJointNames.size() != m_iNumMotors)
+			{
+				if(!m_vsJointNames.empty())
+					ROS_WARN("Parameter joint_names has %d entries but %d motors are configured. Using default names", (int)m_vsJointNames.size(), m_iNumMotors);
+				m_vsJointNames.assign(c_cDefaultBaseJointNames, c_cDefaultBaseJointNames + c_iNumDefaultBaseJoints);
+				m_vsJointNames.resize(m_iNumMotors);
+			}
+
+			// preallocate messages, the names are only set once
+			m_JointState.name = m_vsJointNames;
+			m_JointState.position.assign(m_iNumMotors, 0.0);
+			m_JointState.velocity.assign(m_iNumMotors, 0.0);
+			m_JointState.effort.assign(m_iNumMotors, 0.0);
+			m_ControllerState.joint_names = m_vsJointNames;
+			m_ControllerState.actual.positions.assign(m_iNumMotors, 0.0);
+			m_ControllerState.actual.velocities.assign(m_iNumMotors, 0.0);
+			m_JointCommand.joint_names = m_vsJointNames;
+			m_JointCommand.desired.positions.assign(m_iNumMotors, 0.0);
+			m_JointCommand.desired.velocities.assign(m_iNumMotors, 0.0);
+			m_vdAngGearRad.assign(m_iNumMotors, 0.0);
+			m_vdVelGearRad.assign(m_iNumMotors, 0.0);
+			m_vdVelCmdGearRadS.assign(m_iNumMotors, 0.0);
+
+			m_vdDriveAngRad.assign(m_iNumDrives, 0.0);
+			m_vdDriveVelRadS.assign(m_iNumDrives, 0.0);
+			m_vdSteerAngRad.assign(m_iNumDrives, 0.0);
+			m_vdSteerVelRadS.assign(m_iNumDrives, 0.0);
+			m_vdDriveVelCmdRadS.assign(m_iNumDrives, 0.0);
+			m_vdSteerVelCmdRadS.assign(m_iNumDrives, 0.0);
+			m_vdSteerAngCmdRad.assign(m_iNumDrives, 0.0);
+
+			// implementation of topics
+			// published topics (monitoring only, the control loop does not use them)
+			topicPub_JointState = n.advertise<sensor_msgs::JointState>("/joint_states", 1);
+			topicPub_ControllerState = n.advertise<control_msgs::JointTrajectoryControllerState>("state", 1);
+			topicPub_JointCommand = n.advertise<control_msgs::JointTrajectoryControllerState>("joint_command", 1);
+			topicPub_Odometry = n.advertise<nav_msgs::Odometry>("odometry", 1);
+			topicPub_Diagnostic = n.advertise<diagnostic_msgs::DiagnosticStatus>("diagnostic", 1);
+			topicPub_DiagnosticGlobal_ = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+
+			// subscribed topics
+			topicSub_TwistCmd = n.subscribe("command", 1, &NodeClass::topicCallback_TwistCmd, this);
+			topicSub_EMStopState = n.subscribe("/emergency_stop_state", 1, &NodeClass::topicCallback_EMStop, this);
+
+			// implementation of service servers
+			srvServer_Init = n.advertiseService("init", &NodeClass::srvCallback_Init, this);
+			srvServer_Recover = n.advertiseService("recover", &NodeClass::srvCallback_Recover, this);
+			srvServer_Shutdown = n.advertiseService("shutdown", &NodeClass::srvCallback_Shutdown, this);
+			srvServer_DumpCycleStats = n.advertiseService("dump_cycle_stats", &NodeClass::srvCallback_DumpCycleStats, this);
+
+			//Timer for publishing global diagnostics
+			glDiagnostics_timer = n.createTimer(ros::Duration(1), &NodeClass::publish_globalDiagnostics, this);
+
+			// initialization of variables
+			m_bisInitialized = false;
+			m_bEMStopActive = false;
+			m_bPltfError = false;
+			m_bCtrlHalted = true;
+			m_iWatchdog = 0;
+
+			// the controller does not depend on the hardware, so it is initialized right away
+			m_UndercarriageCtrl->InitUndercarriageCtrl();
+			m_UndercarriageCtrl->setEMStopActive(true);
+		}
+
+		// Destructor
+		~NodeClass()
+		{
+			m_CanCtrlPltf->shutdownPltf();
+			delete m_CanCtrlPltf;
+			delete m_UndercarriageCtrl;
+		}
+
+		// topic callback functions
+		// function will be called when a new message arrives on a topic
+		void topicCallback_TwistCmd(const geometry_msgs::Twist::ConstPtr& msg)
+		{
+			m_iWatchdog = 0;
+
+			// check for NaN value in Twist message
+			if(isnan(msg->linear.x) || isnan(msg->linear.y) || isnan(msg->angular.z))
+			{
+				ROS_FATAL("Received NaN-value in Twist message. Stopping the robot.");
+				m_UndercarriageCtrl->SetDesiredPltfVelocity(0.0, 0.0, 0.0, 0.0);
+				return;
+			}
+
+			if((fabs(msg->linear.x) > m_dMaxVelTrans) || (fabs(msg->linear.y) > m_dMaxVelTrans) || (fabs(msg->angular.z) > m_dMaxVelRot))
+			{
+				ROS_DEBUG("Received velocity command [%3.5f, %3.5f, %3.5f] exceeds the allowed velocities, stopping the robot",
+					msg->linear.x, msg->linear.y, msg->angular.z);
+				m_UndercarriageCtrl->SetDesiredPltfVelocity(0.0, 0.0, 0.0, 0.0);
+				return;
+			}
+
+			if(m_bCtrlHalted)
+			{
+				m_UndercarriageCtrl->SetDesiredPltfVelocity(0.0, 0.0, 0.0, 0.0);
+				ROS_DEBUG("Forced platform-velocity cmds to zero");
+				return;
+			}
+
+			// controller expects velocities in mm/s
+			m_UndercarriageCtrl->SetDesiredPltfVelocity(msg->linear.x * 1000.0, msg->linear.y * 1000.0, msg->angular.z, 0.0);
+		}
+
+		void topicCallback_EMStop(const cob_msgs::EmergencyStopState::ConstPtr& msg)
+		{
+			m_bEMStopActive = (msg->emergency_state != msg->EMFREE);
+			updateCtrlHalted();
+		}
+
+		// service callback functions
+		// function will be called when a service is querried
+
+		// Init Can-Configuration
+		bool srvCallback_Init(std_srvs::Trigger::Request &req,
+							  std_srvs::Trigger::Response &res )
+		{
+			ROS_DEBUG("Service callback init");
+			if(m_bisInitialized == false)
+			{
+				m_bisInitialized = initDrives();
+				res.success = m_bisInitialized;
+				if(m_bisInitialized)
+				{
+					ROS_INFO("base initialized");
+					m_SyncStamp = ros::Time();
+					updateCtrlHalted();
+				}
+				else
+				{
+					res.message = "initialization of base failed";
+					ROS_ERROR("Initializing base failed");
+				}
+			}
+			else
+			{
+				ROS_WARN("...base already initialized...");
+				res.success = true;
+				res.message = "platform already initialized";
+			}
+			return true;
+		}
+
+		// reset Can-Configuration
+		bool srvCallback_Recover(std_srvs::Trigger::Request &req,
+									 std_srvs::Trigger::Response &res )
+		{
+			if(m_bisInitialized)
+			{
+				ROS_DEBUG("Service callback recover");
+				res.success = m_CanCtrlPltf->resetPltf();
+				if (res.success) {
+					ROS_INFO("base resetted");
+				} else {
+					res.message = "reset of base failed";
+					ROS_WARN("Resetting base failed");
+				}
+			}
+			else
+			{
+				ROS_WARN("Base not yet initialized.");
+				res.success = false;
+				res.message = "Base not yet initialized.";
+			}
+			return true;
+		}
+
+		// shutdown Drivers and Can-Node
+		bool srvCallback_Shutdown(std_srvs::Trigger::Request &req,
+									 std_srvs::Trigger::Response &res )
+		{
+			ROS_DEBUG("Service callback shutdown");
+			res.success = m_CanCtrlPltf->shutdownPltf();
+			if (res.success)
+				ROS_INFO("Drives shut down");
+			else
+				ROS_INFO("Shutdown of Drives FAILED");
+
+			return true;
+		}
+
+		// returns the timing statistics of the control cycle
+		bool srvCallback_DumpCycleStats(std_srvs::Trigger::Request &req,
+									 std_srvs::Trigger::Response &res )
+		{
+			res.success = m_CycleStats.dumpMessage(res.message);
+			if(res.success)
+				ROS_INFO_STREAM("Timing statistics of the control cycle:\n" << res.message);
+			return true;
+		}
+
+		void publish_globalDiagnostics(const ros::TimerEvent& event)
+		{
+			//publish global diagnostic messages
+			diagnostic_msgs::DiagnosticArray diagnostics_gl;
+			diagnostics_gl.header.stamp = ros::Time::now();
+			diagnostics_gl.status.resize(m_CycleStats.isEnabled() ? 2 : 1);
+			diagnostics_gl.status[0].name = ros::this_node::getName();
+			if(m_bisInitialized && m_bPltfError)
+			{
+				diagnostics_gl.status[0].level = 2;
+				diagnostics_gl.status[0].message = "Base not initialized or in error";
+			}
+			else if(m_bisInitialized)
+			{
+				diagnostics_gl.status[0].level = 0;
+				diagnostics_gl.status[0].message = "base_controller initialized and running";
+			}
+			else
+			{
+				diagnostics_gl.status[0].level = 1;
+				diagnostics_gl.status[0].message = "base_controller not initialized";
+			}
+			if(m_CycleStats.isEnabled())
+			{
+				diagnostics_gl.status[1].name = ros::this_node::getName() + ": cycle times";
+				m_CycleStats.fillDiagnosticStatus("control cycle", diagnostics_gl.status[1]);
+			}
+			topicPub_DiagnosticGlobal_.publish(diagnostics_gl);
+		}
+
+		// other function declarations
+		bool initDrives();
+		// halts the controller as long as the platform is not initialized, in error or the EM-stop is active
+		void updateCtrlHalted();
+		// executes one cycle: read CAN snapshot -> odometry -> control step -> batched CAN transmit
+		void cycle();
+		// reads the measurements of all drives (evaluated once per cycle)
+		void readDrives();
+		// integrates and publishes odometry for the measurements sampled at stamp
+		void updateOdometry(const ros::Time& stamp);
+		// calculates the velocity command of every motor
+		void calcCtrlStep();
+		// publishes joint states, joint commands and controller state for monitoring
+		void publishMonitoring(const ros::Time& stamp);
+};
+
+//#######################
+//#### main programm ####
+int main(int argc, char** argv)
+{
+	// initialize ROS, spezify name of node
+	ros::init(argc, argv, "base_controller");
+
+	NodeClass nodeClass;
+
+	// one loop executes the complete control cycle, callbacks are only processed in between
+	ros::Rate loop_rate(nodeClass.m_dCycleRateHz);
+
+	while(nodeClass.n.ok())
+	{
+		nodeClass.m_CycleStats.tick(nodeClass.m_iStageCycle);
+		nodeClass.cycle();
+
+		loop_rate.sleep();
+		ros::spinOnce();
+	}
+
+	return 0;
+}
+
+//##################################
+//#### function implementations ####
+bool NodeClass::initDrives()
+{
+	ROS_INFO("Initializing Base Controller");
+
+	// init member vectors
+	m_Param.vdWheelNtrlPosRad.assign(m_iNumDrives, 0.0);
+
+	IniFile iniFile;
+	iniFile.SetFileName(sIniDirectory + "Platform.ini", "PltfHardwareCoB3.h");
+
+	// get max Joint-Velocities (in rad/s) for Steer- and Drive-Joint
+	iniFile.GetKeyDouble("DrivePrms", "MaxDriveRate", &m_Param.dMaxDriveRateRadpS, true);
+	iniFile.GetKeyDouble("DrivePrms", "MaxSteerRate", &m_Param.dMaxSteerRateRadpS, true);
+
+	// get Offset from Zero-Position of Steering and convert Degree-Value from ini-File into Radian
+	for(int i = 0; i < m_iNumDrives; i++)
+	{
+		char cKey[32];
+		sprintf(cKey, "Wheel%dNeutralPosition", i + 1);
+		iniFile.GetKeyDouble("DrivePrms", cKey, &m_Param.vdWheelNtrlPosRad[i], true);
+		m_Param.vdWheelNtrlPosRad[i] = MathSup::convDegToRad(m_Param.vdWheelNtrlPosRad[i]);
+	}
+
+	ROS_INFO("Initializing CanCtrlItf");
+	bool bRet = m_CanCtrlPltf->initPltf();
+	ROS_INFO("Initializing done");
+
+	return bRet;
+}
+
+void NodeClass::updateCtrlHalted()
+{
+	bool bHalt = !m_bisInitialized || m_bPltfError || m_bEMStopActive;
+
+	if(bHalt && !m_bCtrlHalted)
+	{
+		ROS_DEBUG("Base controller halted");
+		m_UndercarriageCtrl->SetDesiredPltfVelocity(0.0, 0.0, 0.0, 0.0);
+		m_UndercarriageCtrl->setEMStopActive(true);
+	}
+	else if(!bHalt && m_bCtrlHalted)
+	{
+		ROS_DEBUG("Base controller released");
+		m_UndercarriageCtrl->SetDesiredPltfVelocity(0.0, 0.0, 0.0, 0.0);
+		m_UndercarriageCtrl->setEMStopActive(false);
+	}
+	m_bCtrlHalted = bHalt;
+}
+
+void NodeClass::cycle()
+{
+	ros::Time stamp;
+
+	if(m_bisInitialized == false)
+	{
+		// as long as the drives are not initialized only the monitoring is published
+		publishMonitoring(ros::Time::now());
+		return;
+	}
+
+	// read CAN snapshot: the answers to the SYNC of the last cycle
+	m_CycleStats.begin(m_iStageRead);
+	readDrives();
+	m_CycleStats.end(m_iStageRead);
+	stamp = m_SyncStamp;
+	if(stamp.isZero())
+		stamp = ros::Time::now();
+
+	m_CycleStats.begin(m_iStageOdometry);
+	updateOdometry(stamp);
+	m_CycleStats.end(m_iStageOdometry);
+
+	m_CycleStats.begin(m_iStageCtrl);
+	m_bPltfError = m_CanCtrlPltf->isPltfError();
+	updateCtrlHalted();
+	calcCtrlStep();
+	m_CycleStats.end(m_iStageCtrl);
+
+	// batched transmit, the SYNC at the end samples all drives for the next cycle
+	m_CycleStats.begin(m_iStageTransmit);
+	m_SyncStamp = ros::Time::now();
+	m_CanCtrlPltf->setVelGearRadS(m_vdVelCmdGearRadS);
+	m_CycleStats.end(m_iStageTransmit);
+
+	m_CycleStats.begin(m_iStageMonitoring);
+	publishMonitoring(stamp);
+	m_CycleStats.end(m_iStageMonitoring);
+}
+
+void NodeClass::readDrives()
+{
+	int iWheel;
+
+	m_CanCtrlPltf->evalCanBuffer();
+	m_CanCtrlPltf->getGearPosVelRadS(m_vdAngGearRad, m_vdVelGearRad);
+
+	for(int i = 0; i < m_iNumMotors; i++)
+	{
+		iWheel = i / 2;
+		if(iWheel >= m_iNumDrives)
+			continue;
+
+		if(i % 2 == 1)
+		{
+			// correct for initial offset of steering angle (arbitrary homing position)
+			m_vdAngGearRad[i] += m_Param.vdWheelNtrlPosRad[iWheel];
+			MathSup::normalizePi(m_vdAngGearRad[i]);
+
+			m_vdSteerAngRad[iWheel] = m_vdAngGearRad[i];
+			m_vdSteerVelRadS[iWheel] = m_vdVelGearRad[i];
+		}
+		else
+		{
+			m_vdDriveAngRad[iWheel] = m_vdAngGearRad[i];
+			m_vdDriveVelRadS[iWheel] = m_vdVelGearRad[i];
+		}
+	}
+
+	m_UndercarriageCtrl->SetActualWheelValues(m_vdDriveVelRadS, m_vdSteerVelRadS, m_vdDriveAngRad, m_vdSteerAngRad);
+}
+
+void NodeClass::updateOdometry(const ros::Time& stamp)
+{
+	double dDeltaXMM, dDeltaYMM, dDeltaThetaRad, dVelXMS, dVelYMS, dRotRadS;
+	double dDummy1, dDummy2;
+	double dVelCov[9], dPoseCov[9];
+	double dXM, dYM, dThetaRad;
+
+	// Get resulting Pltf Velocities from Ctrl-Class (result of forward kinematics, in mm)
+	m_UndercarriageCtrl->GetActualPltfVelocity(dDeltaXMM, dDeltaYMM, dDeltaThetaRad, dDummy1,
+		dVelXMS, dVelYMS, dRotRadS, dDummy2);
+	m_UndercarriageCtrl->GetActualPltfVelocityCov(dVelCov);
+
+	// convert variables to SI-Units
+	dVelXMS = dVelXMS / 1000.0;
+	dVelYMS = dVelYMS / 1000.0;
+	for(int r = 0; r < 3; r++)
+		for(int c = 0; c < 3; c++)
+		{
+			if (r < 2) dVelCov[3*r+c] /= 1000.0;
+			if (c < 2) dVelCov[3*r+c] /= 1000.0;
+		}
+
+	if(!m_Odometry.update(stamp.toSec(), dVelXMS, dVelYMS, dRotRadS, dVelCov))
+	{
+		ROS_DEBUG("Measurement not newer than last one, odometry not integrated");
+	}
+	m_Odometry.getPose(dXM, dYM, dThetaRad);
+	m_Odometry.getPoseCov(dPoseCov);
+
+	geometry_msgs::Quaternion odom_quat = tf::createQuaternionMsgFromYaw(dThetaRad);
+
+	if(m_bBroadcastTf)
+	{
+		geometry_msgs::TransformStamped odom_tf;
+		odom_tf.header.stamp = stamp;
+		odom_tf.header.frame_id = "/odom_combined";
+		odom_tf.child_frame_id = "/base_footprint";
+		odom_tf.transform.translation.x = dXM;
+		odom_tf.transform.translation.y = dYM;
+		odom_tf.transform.translation.z = 0.0;
+		odom_tf.transform.rotation = odom_quat;
+		m_TfBroadcastOdometry.sendTransform(odom_tf);
+	}
+
+	nav_msgs::Odometry odom_top;
+	odom_top.header.stamp = stamp;
+	odom_top.header.frame_id = "/odom_combined";
+	odom_top.child_frame_id = "/base_footprint";
+	odom_top.pose.pose.position.x = dXM;
+	odom_top.pose.pose.position.y = dYM;
+	odom_top.pose.pose.position.z = 0.0;
+	odom_top.pose.pose.orientation = odom_quat;
+	odom_top.twist.twist.linear.x = dVelXMS;
+	odom_top.twist.twist.linear.y = dVelYMS;
+	odom_top.twist.twist.angular.z = dRotRadS;
+
+	// covariances: (x, y, yaw) are mapped to the indices (0, 1, 5) of the 6x6 matrices
+	const int iDof[3] = {0, 1, 5};
+	for(int i = 0; i < 6; i++)
+	{
+		odom_top.pose.covariance[i*6+i] = 0.1;
+		odom_top.twist.covariance[i*6+i] = 0.1;
+	}
+	for(int r = 0; r < 3; r++)
+		for(int c = 0; c < 3; c++)
+		{
+			odom_top.pose.covariance[iDof[r]*6+iDof[c]] = dPoseCov[3*r+c];
+			odom_top.twist.covariance[iDof[r]*6+iDof[c]] = dVelCov[3*r+c];
+		}
+
+	topicPub_Odometry.publish(odom_top);
+}
+
+void NodeClass::calcCtrlStep()
+{
+	double dVelXMMS, dVelYMMS, dRotRadS, dDummy;
+	double dMaxRate;
+	int iWheel;
+	bool bTimeout;
+
+	m_iWatchdog++;
+	bTimeout = (m_iWatchdog >= (int)floor(m_dTimeout * m_dCycleRateHz));
+
+	m_UndercarriageCtrl->GetNewCtrlStateSteerDriveSetValues(m_vdDriveVelCmdRadS, m_vdSteerVelCmdRadS, m_vdSteerAngCmdRad,
+		dVelXMMS, dVelYMMS, dRotRadS, dDummy);
+
+	for(int i = 0; i < m_iNumMotors; i++)
+	{
+		iWheel = i / 2;
+		if(bTimeout || m_bCtrlHalted || iWheel >= m_iNumDrives)
+		{
+			m_vdVelCmdGearRadS[i] = 0.0;
+			m_JointCommand.desired.positions[i] = 0.0;
+		}
+		else if(i % 2 == 1)
+		{
+			m_vdVelCmdGearRadS[i] = m_vdSteerVelCmdRadS[iWheel];
+			m_JointCommand.desired.positions[i] = m_vdSteerAngCmdRad[iWheel];
+		}
+		else
+		{
+			m_vdVelCmdGearRadS[i] = m_vdDriveVelCmdRadS[iWheel];
+			m_JointCommand.desired.positions[i] = 0.0;
+		}
+
+		// check if velocities lie inside allowed boundaries
+		dMaxRate = (i % 2 == 1) ? m_Param.dMaxSteerRateRadpS : m_Param.dMaxDriveRateRadpS;
+		MathSup::limit(&m_vdVelCmdGearRadS[i], dMaxRate);
+		m_JointCommand.desired.velocities[i] = m_vdVelCmdGearRadS[i];
+	}
+}
+
+void NodeClass::publishMonitoring(const ros::Time& stamp)
+{
+	diagnostic_msgs::DiagnosticStatus diagnostics;
+
+	m_JointState.header.stamp = stamp;
+	m_ControllerState.header.stamp = stamp;
+	for(int i = 0; i < m_iNumMotors; i++)
+	{
+		m_JointState.position[i] = m_bisInitialized ? m_vdAngGearRad[i] : 0.0;
+		m_JointState.velocity[i] = m_bisInitialized ? m_vdVelGearRad[i] : 0.0;
+		m_ControllerState.actual.positions[i] = m_JointState.position[i];
+		m_ControllerState.actual.velocities[i] = m_JointState.velocity[i];
+	}
+	topicPub_JointState.publish(m_JointState);
+	topicPub_ControllerState.publish(m_ControllerState);
+
+	if(m_bisInitialized)
+	{
+		m_JointCommand.header.stamp = m_SyncStamp;
+		topicPub_JointCommand.publish(m_JointCommand);
+	}
+
+	diagnostics.name = "drive-chain can node";
+	if(m_bisInitialized && m_bPltfError)
+	{
+		diagnostics.level = 2;
+		diagnostics.message = "one or more drives are in Error mode";
+	}
+	else if(m_bisInitialized)
+	{
+		diagnostics.level = 0;
+		diagnostics.message = "drives operating normal";
+	}
+	else
+	{
+		diagnostics.level = 1;
+		diagnostics.message = "drives are initializing";
+	}
+	topicPub_Diagnostic.publish(diagnostics);
+}
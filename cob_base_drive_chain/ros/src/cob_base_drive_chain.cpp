@@ -19,7 +19,7 @@
 //#### includes ####
 
 // standard includes
-//--
+#include <stdio.h>
 
 // ROS includes
 #include <ros/ros.h>
@@ -42,6 +42,8 @@
 #include <cob_base_drive_chain/CanCtrlPltfCOb3.h>
 #include <cob_utilities/IniFile.h>
 #include <cob_utilities/MathSup.h>
+#include <cob_utilities/JointNameMap.h>
+#include <cob_utilities/CycleStats.h>
 
 //####################
 //#### node class ####
@@ -102,6 +104,7 @@ class NodeClass
 		* Service requests cob_base_drive_chain::ElmoRecorderSetup. It is used to configure the Elmo Recorder to record predefined sources.
 		* Parameters are:
 		* int64 recordinggap #Specify every which time quantum (4*90usec) a new data point (of 1024 points in total) is recorded. the recording process starts immediately.
+		* int64 trigger #0: start immediately, 1: start the recorders of all motors with the next velocity command
 		*/
 		ros::ServiceServer srvServer_ElmoRecorderConfig;
 
@@ -118,25 +121,28 @@ class NodeClass
 		* string fileprefix
 		* #Enter the path+file-prefix for the logfile (of an existing directory!)
 		* #The file-prefix is extended with _MotorNumber_RecordedSource.log
+		*
+		* The recordings of all motors are read out concurrently in the background (limited to elmo_readout_segments_per_cycle
+		* SDO segments per cycle) and finally written time aligned into one file with the extension all.log.
 		*/
 		ros::ServiceServer srvServer_ElmoRecorderReadout;
 
+		/**
+		* Service requests std_srvs::Trigger and returns the timing statistics of the control loop as message.
+		*/
+		ros::ServiceServer srvServer_DumpCycleStats;
+
 
 		// global variables
 		// generate can-node handle
 #ifdef __SIM__
-		ros::Publisher br_steer_pub;
-		ros::Publisher bl_steer_pub;
-		ros::Publisher fr_steer_pub;
-		ros::Publisher fl_steer_pub;
-		ros::Publisher br_caster_pub;
-		ros::Publisher bl_caster_pub;
-		ros::Publisher fr_caster_pub;
-		ros::Publisher fl_caster_pub;
+		// command publisher of every motor (same order as the joint names)
+		std::vector<ros::Publisher> m_vGazeboCmdPub;
 
 		std::vector<double> m_gazeboPos;
 		std::vector<double> m_gazeboVel;
 		ros::Time m_gazeboStamp;
+		JointNameMap m_GazeboStateMap;
 
 		ros::Subscriber topicSub_GazeboJointStates;
 #else
@@ -158,6 +164,22 @@ class NodeClass
 		std::string sIniDirectory;
 		bool m_bPubEffort;
 		bool m_bReadoutElmo;
+		int m_iElmoSegmentsPerCycle;
+		std::string m_sElmoFilePrefix;
+
+		// joint names in order of the motors: 2*i drive and 2*i+1 steer motor of wheel i
+		std::vector<std::string> m_vsJointNames;
+		JointNameMap m_JointCmdMap;
+
+		// preallocated messages and buffers
+		sensor_msgs::JointState m_JointStateCmd;
+		sensor_msgs::JointState m_JointState;
+		control_msgs::JointTrajectoryControllerState m_ControllerState;
+		std::vector<double> m_vdAngGearRad, m_vdVelGearRad, m_vdEffortGearNM;
+
+		// timing of the control loop (enabled by parameter cycle_stats)
+		CycleStats m_CycleStats;
+		int m_iStageCycle, m_iStagePublish, m_iStageEvalCan, m_iStageSetVel;
 
 		// Constructor
 		NodeClass()
@@ -178,6 +200,19 @@ class NodeClass
 			n.param<bool>("PublishEffort", m_bPubEffort, false);
 			if(m_bPubEffort) ROS_INFO("You have choosen to publish effort of motors, that charges capacity of CAN");
 
+			// bus load of the readout of the Elmo recorders, 0 for no limit
+			n.param<int>("elmo_readout_segments_per_cycle", m_iElmoSegmentsPerCycle, 16);
+
+			// period of the loop (100Hz) and duration of the stages, budgets are used to count overruns
+			bool bCycleStats;
+			n.param<bool>("cycle_stats", bCycleStats, false);
+			m_iStageCycle = m_CycleStats.addStage("cycle period", 0.011);
+			m_iStagePublish = m_CycleStats.addStage("publish_JointStates", 0.002);
+			m_iStageEvalCan = m_CycleStats.addStage("evalCanBuffer", 0.001);
+			m_iStageSetVel = m_CycleStats.addStage("setVelGearRadS", 0.001);
+			m_CycleStats.setEnabled(bCycleStats);
+			if(bCycleStats) ROS_INFO("Timing statistics of the control loop are recorded");
+
 
 			IniFile iniFile;
 			iniFile.SetFileName(sIniDirectory + "Platform.ini", "PltfHardwareCoB3.h");
@@ -190,15 +225,46 @@ class NodeClass
 				m_iNumDrives = 4;
 			}
 
+			// joint names can be configured, default to the names of the Care-O-bot base
+			if(n.hasParam("joint_names"))
+			{
+				n.getParam("joint_names", m_vsJointNames);
+			}
+			if((int)m_vsJointNames.size() != m_iNumMotors)
+			{
+				if(!m_vsJointNames.empty())
+					ROS_WARN("Parameter joint_names has %d entries but %d motors are configured. Using default names", (int)m_vsJointNames.size(), m_iNumMotors);
+				m_vsJointNames.assign(c_cDefaultBaseJointNames, c_cDefaultBaseJointNames + c_iNumDefaultBaseJoints);
+				m_vsJointNames.resize(m_iNumMotors);
+			}
+			m_JointCmdMap.setNames(m_vsJointNames);
+
+			// preallocate messages, the names are only set once
+			m_JointStateCmd.position.resize(m_iNumMotors);
+			m_JointStateCmd.velocity.resize(m_iNumMotors);
+			m_JointStateCmd.effort.resize(m_iNumMotors);
+			m_JointState.name = m_vsJointNames;
+			m_JointState.position.assign(m_iNumMotors, 0.0);
+			m_JointState.velocity.assign(m_iNumMotors, 0.0);
+			m_JointState.effort.assign(m_iNumMotors, 0.0);
+			m_ControllerState.joint_names = m_vsJointNames;
+			m_ControllerState.actual.positions.assign(m_iNumMotors, 0.0);
+			m_ControllerState.actual.velocities.assign(m_iNumMotors, 0.0);
+			m_vdAngGearRad.assign(m_iNumMotors, 0.0);
+			m_vdVelGearRad.assign(m_iNumMotors, 0.0);
+			m_vdEffortGearNM.assign(m_iNumMotors, 0.0);
+
 #ifdef __SIM__
-			bl_caster_pub = n.advertise<std_msgs::Float64>("/base_bl_caster_r_wheel_controller/command", 1);
-			br_caster_pub = n.advertise<std_msgs::Float64>("/base_br_caster_r_wheel_controller/command", 1);
-			fl_caster_pub = n.advertise<std_msgs::Float64>("/base_fl_caster_r_wheel_controller/command", 1);
-			fr_caster_pub = n.advertise<std_msgs::Float64>("/base_fr_caster_r_wheel_controller/command", 1);
-			bl_steer_pub = n.advertise<std_msgs::Float64>("/base_bl_caster_rotation_controller/command", 1);
-			br_steer_pub = n.advertise<std_msgs::Float64>("/base_br_caster_rotation_controller/command", 1);
-			fl_steer_pub = n.advertise<std_msgs::Float64>("/base_fl_caster_rotation_controller/command", 1);
-			fr_steer_pub = n.advertise<std_msgs::Float64>("/base_fr_caster_rotation_controller/command", 1);
+			// e.g. fl_caster_r_wheel_joint -> /base_fl_caster_r_wheel_controller/command
+			m_vGazeboCmdPub.resize(m_iNumMotors);
+			for(int i = 0; i < m_iNumMotors; i++)
+			{
+				std::string sController = m_vsJointNames[i];
+				if((sController.size() > 6) && (sController.compare(sController.size() - 6, 6, "_joint") == 0))
+					sController.erase(sController.size() - 6);
+				m_vGazeboCmdPub[i] = n.advertise<std_msgs::Float64>("/base_" + sController + "_controller/command", 1);
+			}
+			m_GazeboStateMap.setNames(m_vsJointNames);
 
 			topicSub_GazeboJointStates = n.subscribe("/joint_states", 1, &NodeClass::gazebo_joint_states_Callback, this);
 
@@ -226,6 +292,7 @@ class NodeClass
 
 			srvServer_Recover = n.advertiseService("recover", &NodeClass::srvCallback_Recover, this);
 			srvServer_Shutdown = n.advertiseService("shutdown", &NodeClass::srvCallback_Shutdown, this);
+			srvServer_DumpCycleStats = n.advertiseService("dump_cycle_stats", &NodeClass::srvCallback_DumpCycleStats, this);
 
 		        //Timer for publishing global diagnostics
 		        glDiagnostics_timer = n.createTimer(ros::Duration(1), &NodeClass::publish_globalDiagnostics, this);
@@ -258,75 +325,32 @@ class NodeClass
 			if(m_bisInitialized == true)
 			{
 				ROS_DEBUG("Topic Callback joint_command - Sending Commands to drives (initialized)");
-				sensor_msgs::JointState JointStateCmd;
-				JointStateCmd.position.resize(m_iNumMotors);
-				JointStateCmd.velocity.resize(m_iNumMotors);
-				JointStateCmd.effort.resize(m_iNumMotors);
+				sensor_msgs::JointState& JointStateCmd = m_JointStateCmd;
+				bool bResolved;
 
-				for(unsigned int i = 0; i < msg->joint_names.size(); i++)
+				for(int i = 0; i < m_iNumMotors; i++)
 				{
-					// associate inputs to according steer and drive joints
-					// ToDo: specify this globally (Prms-File or config-File or via msg-def.)
-					// check if velocities lie inside allowed boundaries
+					JointStateCmd.position[i] = 0.0;
+					JointStateCmd.velocity[i] = 0.0;
+				}
 
-					//DRIVES
-					if(msg->joint_names[i] ==  "fl_caster_r_wheel_joint")
-					{
-							JointStateCmd.position[0] = msg->desired.positions[i];
-							JointStateCmd.velocity[0] = msg->desired.velocities[i];
-							//JointStateCmd.effort[0] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=2 && msg->joint_names[i] ==  "bl_caster_r_wheel_joint")
-					{
-							JointStateCmd.position[2] = msg->desired.positions[i];
-							JointStateCmd.velocity[2] = msg->desired.velocities[i];
-							//JointStateCmd.effort[2] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=3 && msg->joint_names[i] ==  "br_caster_r_wheel_joint")
-					{
-							JointStateCmd.position[4] = msg->desired.positions[i];
-							JointStateCmd.velocity[4] = msg->desired.velocities[i];
-							//JointStateCmd.effort[4] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=4 && msg->joint_names[i] ==  "fr_caster_r_wheel_joint")
-					{
-							JointStateCmd.position[6] = msg->desired.positions[i];
-							JointStateCmd.velocity[6] = msg->desired.velocities[i];
-							//JointStateCmd.effort[6] = msg->effort[i];
-					}
-					//STEERS
-					else if(msg->joint_names[i] ==  "fl_caster_rotation_joint")
-					{
-							JointStateCmd.position[1] = msg->desired.positions[i];
-							JointStateCmd.velocity[1] = msg->desired.velocities[i];
-							//JointStateCmd.effort[1] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=2 && msg->joint_names[i] ==  "bl_caster_rotation_joint")
-					{
-							JointStateCmd.position[3] = msg->desired.positions[i];
-							JointStateCmd.velocity[3] = msg->desired.velocities[i];
-							//JointStateCmd.effort[3] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=3 && msg->joint_names[i] ==  "br_caster_rotation_joint")
-					{
-							JointStateCmd.position[5] = msg->desired.positions[i];
-							JointStateCmd.velocity[5] = msg->desired.velocities[i];
-							//JointStateCmd.effort[5] = msg->effort[i];
-					}
-					else if(m_iNumDrives>=4 && msg->joint_names[i] ==  "fr_caster_rotation_joint")
-					{
-							JointStateCmd.position[7] = msg->desired.positions[i];
-							JointStateCmd.velocity[7] = msg->desired.velocities[i];
-							//JointStateCmd.effort[7] = msg->effort[i];
-					}
-					else
+				// associate inputs to according steer and drive joints (names are only searched if the list changed)
+				const std::vector<int>& viSlots = m_JointCmdMap.resolve(msg->joint_names, &bResolved);
+				for(unsigned int i = 0; i < viSlots.size(); i++)
+				{
+					if(viSlots[i] < 0)
 					{
-						ROS_ERROR("Unkown joint name %s", (msg->joint_names[i]).c_str());
+						if(bResolved)
+							ROS_ERROR("Unkown joint name %s", (msg->joint_names[i]).c_str());
+						continue;
 					}
+					JointStateCmd.position[viSlots[i]] = msg->desired.positions[i];
+					JointStateCmd.velocity[viSlots[i]] = msg->desired.velocities[i];
 				}
 
 
 				// check if velocities lie inside allowed boundaries
+				CycleStats::Scope scopeSetVel(m_CycleStats, m_iStageSetVel);
 				for(int i = 0; i < m_iNumMotors; i++)
 				{
 #ifdef __SIM__
@@ -360,23 +384,7 @@ class NodeClass
 					ROS_DEBUG("Send velocity data to gazebo");
 					std_msgs::Float64 fl;
 					fl.data = JointStateCmd.velocity[i];
-					if(msg->joint_names[i] == "fl_caster_r_wheel_joint")
-						fl_caster_pub.publish(fl);
-					if(msg->joint_names[i] == "fr_caster_r_wheel_joint")
-						fr_caster_pub.publish(fl);
-					if(msg->joint_names[i] == "bl_caster_r_wheel_joint")
-						bl_caster_pub.publish(fl);
-					if(msg->joint_names[i] == "br_caster_r_wheel_joint")
-						br_caster_pub.publish(fl);
-
-					if(msg->joint_names[i] == "fl_caster_rotation_joint")
-						fl_steer_pub.publish(fl);
-					if(msg->joint_names[i] == "fr_caster_rotation_joint")
-						fr_steer_pub.publish(fl);
-					if(msg->joint_names[i] == "bl_caster_rotation_joint")
-						bl_steer_pub.publish(fl);
-					if(msg->joint_names[i] == "br_caster_rotation_joint")
-						br_steer_pub.publish(fl);
+					m_vGazeboCmdPub[i].publish(fl);
 					ROS_DEBUG("Successfully sent velicities to gazebo");
 #else
 					ROS_DEBUG("Send velocity data to drives");
@@ -436,9 +444,12 @@ class NodeClass
 				res.success = true;
 #else
 				m_CanCtrlPltf->evalCanBuffer();
-				res.success = m_CanCtrlPltf->ElmoRecordings(0, req.recordinggap, "");
+				res.success = m_CanCtrlPltf->ElmoRecordings((req.trigger == 1) ? 3 : 0, req.recordinggap, "");
 #endif
-				res.message = "Successfully configured all motors for instant record";
+				if(req.trigger == 1)
+					res.message = "Successfully configured all motors to record from the next velocity command on";
+				else
+					res.message = "Successfully configured all motors for instant record";
 			}
 
 			return true;
@@ -451,12 +462,14 @@ class NodeClass
 				res.success = true;
 #else
 				m_CanCtrlPltf->evalCanBuffer();
+				m_CanCtrlPltf->ElmoRecordings(2, req.logformat, "");
 				res.success = m_CanCtrlPltf->ElmoRecordings(1, req.subindex, req.fileprefix);
 #endif
 				if(res.success == 0) {
 					res.message = "Successfully requested reading out of Recorded data";
+					m_sElmoFilePrefix = req.fileprefix;
 					m_bReadoutElmo = true;
-					ROS_WARN("CPU consuming evalCanBuffer used for ElmoReadout activated");
+					ROS_INFO("Readout of Elmo recorders started");
 				} else if(res.success == 1) res.message = "Recorder hasn't been configured well yet";
 				else if(res.success == 2) res.message = "A previous transmission is still in progress";
 			}
@@ -512,23 +525,30 @@ class NodeClass
 			return true;
 		}
 
+		// returns the timing statistics of the control loop
+		bool srvCallback_DumpCycleStats(std_srvs::Trigger::Request &req,
+									 std_srvs::Trigger::Response &res )
+		{
+			res.success = m_CycleStats.dumpMessage(res.message);
+			if(res.success)
+				ROS_INFO_STREAM("Timing statistics of the control loop:\n" << res.message);
+			return true;
+		}
+
 		//publish JointStates cyclical instead of service callback
 		bool publish_JointStates()
 		{
+			CycleStats::Scope scopePublish(m_CycleStats, m_iStagePublish);
 			// init local variables
-			int j, k;
+			int j;
 			bool bIsError;
-			std::vector<double> vdAngGearRad, vdVelGearRad, vdEffortGearNM;
-
-			// set default values
-			vdAngGearRad.resize(m_iNumMotors, 0);
-			vdVelGearRad.resize(m_iNumMotors, 0);
-			vdEffortGearNM.resize(m_iNumMotors, 0);
 
-			// create temporary (local) JointState/Diagnostics Data-Container
-			sensor_msgs::JointState jointstate;
+			// create temporary (local) Diagnostics Data-Container
 			diagnostic_msgs::DiagnosticStatus diagnostics;
-			control_msgs::JointTrajectoryControllerState controller_state;
+
+			// JointState and ControllerState are preallocated (incl. joint names)
+			sensor_msgs::JointState& jointstate = m_JointState;
+			control_msgs::JointTrajectoryControllerState& controller_state = m_ControllerState;
 
 			// get time stamp for header
 #ifdef __SIM__
@@ -539,20 +559,11 @@ class NodeClass
 			controller_state.header.stamp = jointstate.header.stamp;
 #endif
 
-			// assign right size to JointState
-			//jointstate.name.resize(m_iNumMotors);
-			jointstate.position.assign(m_iNumMotors, 0.0);
-			jointstate.velocity.assign(m_iNumMotors, 0.0);
-			jointstate.effort.assign(m_iNumMotors, 0.0);
-
 			if(m_bisInitialized == false)
 			{
 				// as long as system is not initialized
 				bIsError = false;
 
-				j = 0;
-				k = 0;
-
 				// set data to jointstate
 				for(int i = 0; i<m_iNumMotors; i++)
 				{
@@ -560,16 +571,6 @@ class NodeClass
 					jointstate.velocity[i] = 0.0;
 					jointstate.effort[i] = 0.0;
 				}
-				jointstate.name.push_back("fl_caster_r_wheel_joint");
-				jointstate.name.push_back("fl_caster_rotation_joint");
-				jointstate.name.push_back("bl_caster_r_wheel_joint");
-				jointstate.name.push_back("bl_caster_rotation_joint");
-				jointstate.name.push_back("br_caster_r_wheel_joint");
-				jointstate.name.push_back("br_caster_rotation_joint");
-				jointstate.name.push_back("fr_caster_r_wheel_joint");
-				jointstate.name.push_back("fr_caster_rotation_joint");
-				jointstate.name.resize(m_iNumMotors);
-
 			}
 			else
 			{
@@ -579,38 +580,39 @@ class NodeClass
 
 #else
 				ROS_DEBUG("Read CAN-Buffer");
+				m_CycleStats.begin(m_iStageEvalCan);
 				m_CanCtrlPltf->evalCanBuffer();
+				m_CycleStats.end(m_iStageEvalCan);
 				ROS_DEBUG("Successfully read CAN-Buffer");
 #endif
-				j = 0;
-				k = 0;
-				for(int i = 0; i<m_iNumMotors; i++)
-				{
+				//Get motor torque
+				if(m_bPubEffort) {
+					for(int i=0; i<m_iNumMotors; i++)
+					{
 #ifdef __SIM__
-					vdAngGearRad[i] = m_gazeboPos[i];
-					vdVelGearRad[i] = m_gazeboVel[i];
+						//m_vdEffortGearNM[i] = m_gazeboEff[i];
 #else
-					m_CanCtrlPltf->getGearPosVelRadS(i,  &vdAngGearRad[i], &vdVelGearRad[i]);
+						m_CanCtrlPltf->getMotorTorque(i, &m_vdEffortGearNM[i]); //(int iCanIdent, double* pdTorqueNm)
 #endif
+					}
+				}
 
-					//Get motor torque
-					if(m_bPubEffort) {
-						for(int i=0; i<m_iNumMotors; i++)
-						{
+				j = 0;
+				for(int i = 0; i<m_iNumMotors; i++)
+				{
 #ifdef __SIM__
-							//vdEffortGearNM[i] = m_gazeboEff[i];
+					m_vdAngGearRad[i] = m_gazeboPos[i];
+					m_vdVelGearRad[i] = m_gazeboVel[i];
 #else
-							m_CanCtrlPltf->getMotorTorque(i, &vdEffortGearNM[i]); //(int iCanIdent, double* pdTorqueNm)
+					m_CanCtrlPltf->getGearPosVelRadS(i,  &m_vdAngGearRad[i], &m_vdVelGearRad[i]);
 #endif
-						}
-					}
 
    					// if a steering motor was read -> correct for offset
    					if( i == 1 || i == 3 || i == 5 || i == 7) // ToDo: specify this via the config-files
 					{
 						// correct for initial offset of steering angle (arbitrary homing position)
-						vdAngGearRad[i] += m_Param.vdWheelNtrlPosRad[j];
-						MathSup::normalizePi(vdAngGearRad[i]);
+						m_vdAngGearRad[i] += m_Param.vdWheelNtrlPosRad[j];
+						MathSup::normalizePi(m_vdAngGearRad[i]);
 						j = j+1;
 					}
 				}
@@ -618,26 +620,17 @@ class NodeClass
 				// set data to jointstate
 				for(int i = 0; i<m_iNumMotors; i++)
 				{
-					jointstate.position[i] = vdAngGearRad[i];
-					jointstate.velocity[i] = vdVelGearRad[i];
-					jointstate.effort[i] = vdEffortGearNM[i];
+					jointstate.position[i] = m_vdAngGearRad[i];
+					jointstate.velocity[i] = m_vdVelGearRad[i];
+					jointstate.effort[i] = m_vdEffortGearNM[i];
 				}
-
-				jointstate.name.push_back("fl_caster_r_wheel_joint");
-				jointstate.name.push_back("fl_caster_rotation_joint");
-				jointstate.name.push_back("bl_caster_r_wheel_joint");
-				jointstate.name.push_back("bl_caster_rotation_joint");
-				jointstate.name.push_back("br_caster_r_wheel_joint");
-				jointstate.name.push_back("br_caster_rotation_joint");
-				jointstate.name.push_back("fr_caster_r_wheel_joint");
-				jointstate.name.push_back("fr_caster_rotation_joint");
-				jointstate.name.resize(m_iNumMotors);
-
 			}
 
-			controller_state.joint_names = jointstate.name;
-			controller_state.actual.positions = jointstate.position;
-			controller_state.actual.velocities = jointstate.velocity;
+			for(int i = 0; i<m_iNumMotors; i++)
+			{
+				controller_state.actual.positions[i] = jointstate.position[i];
+				controller_state.actual.velocities[i] = jointstate.velocity[i];
+			}
 
 			// publish jointstate message
 #ifdef __SIM__
@@ -696,7 +689,7 @@ class NodeClass
 		  //publish global diagnostic messages
                   diagnostic_msgs::DiagnosticArray diagnostics_gl;
                   diagnostics_gl.header.stamp = ros::Time::now();
-                  diagnostics_gl.status.resize(1);
+                  diagnostics_gl.status.resize(m_CycleStats.isEnabled() ? 2 : 1);
                   // set data to diagnostics
 #ifdef __SIM__
                   if (false)
@@ -724,6 +717,11 @@ class NodeClass
                       diagnostics_gl.status[0].message = "base_drive_chain not initialized";
                     }
                   }
+                  if (m_CycleStats.isEnabled())
+                  {
+                    diagnostics_gl.status[1].name = ros::this_node::getName() + ": cycle times";
+                    m_CycleStats.fillDiagnosticStatus("control loop", diagnostics_gl.status[1]);
+                  }
                   // publish diagnostic message
                   topicPub_DiagnosticGlobal_.publish(diagnostics_gl);
 		}
@@ -733,43 +731,14 @@ class NodeClass
 
 #ifdef __SIM__
 		void gazebo_joint_states_Callback(const sensor_msgs::JointState::ConstPtr& msg) {
-			for (unsigned int i=0; i<msg->name.size(); i++) {
-				//Drives
-				if(msg->name[i] == "fl_caster_r_wheel_joint") {
-					m_gazeboPos[0] = msg->position[i];
-					m_gazeboVel[0] = msg->velocity[i];
+			const std::vector<int>& viSlots = m_GazeboStateMap.resolve(msg->name);
+			for (unsigned int i=0; i<viSlots.size(); i++) {
+				if(viSlots[i] < 0)
+					continue;
+				m_gazeboPos[viSlots[i]] = msg->position[i];
+				m_gazeboVel[viSlots[i]] = msg->velocity[i];
+				if(viSlots[i] == 0)
 					m_gazeboStamp = msg->header.stamp;
-				}
-				else if(msg->name[i] == "bl_caster_r_wheel_joint") {
-					m_gazeboPos[2] = msg->position[i];
-					m_gazeboVel[2] = msg->velocity[i];
-				}
-				else if(msg->name[i] == "br_caster_r_wheel_joint") {
-					m_gazeboPos[4] = msg->position[i];
-					m_gazeboVel[4] = msg->velocity[i];
-				}
-				else if(msg->name[i] == "fr_caster_r_wheel_joint") {
-					m_gazeboPos[6] = msg->position[i];
-					m_gazeboVel[6] = msg->velocity[i];
-				}
-
-				//Steers
-				else if(msg->name[i] == "fl_caster_rotation_joint") {
-					m_gazeboPos[1] = msg->position[i];
-					m_gazeboVel[1] = msg->velocity[i];
-				}
-				else if(msg->name[i] == "bl_caster_rotation_joint") {
-					m_gazeboPos[3] = msg->position[i];
-					m_gazeboVel[3] = msg->velocity[i];
-				}
-				else if(msg->name[i] == "br_caster_rotation_joint") {
-					m_gazeboPos[5] = msg->position[i];
-					m_gazeboVel[5] = msg->velocity[i];
-				}
-				else if(msg->name[i] == "fr_caster_rotation_joint") {
-					m_gazeboPos[7] = msg->position[i];
-					m_gazeboVel[7] = msg->velocity[i];
-				}
 			}
 		}
 #else
@@ -791,23 +760,28 @@ int main(int argc, char** argv)
 
 	while(nodeClass.n.ok())
 	{
+		nodeClass.m_CycleStats.tick(nodeClass.m_iStageCycle);
+
+		nodeClass.publish_JointStates();
+
 #ifdef __SIM__
 
 #else
-		//Read-out of CAN buffer is only necessary during read-out of Elmo Recorder
-		if( nodeClass.m_bReadoutElmo )
+		// the answers of the readout of the Elmo recorders are evaluated with the CAN buffer in publish_JointStates,
+		// here the next segments are requested within the bus load limit
+		if(nodeClass.m_bisInitialized)
+			nodeClass.m_CanCtrlPltf->processSDOTransfers();
+
+		if( nodeClass.m_bReadoutElmo && (nodeClass.m_CanCtrlPltf->ElmoRecordings(100, 0, "") == 0) )
 		{
-			if(nodeClass.m_bisInitialized) nodeClass.m_CanCtrlPltf->evalCanBuffer();
-			if(nodeClass.m_CanCtrlPltf->ElmoRecordings(100, 0, "") == 0)
-			{
-				nodeClass.m_bReadoutElmo = false;
-				ROS_INFO("CPU consuming evalCanBuffer used for ElmoReadout deactivated");
-			}
+			nodeClass.m_bReadoutElmo = false;
+			if(nodeClass.m_CanCtrlPltf->logElmoRecordings(nodeClass.m_sElmoFilePrefix) == 0)
+				ROS_INFO("Readout of Elmo recorders finished, aligned data written to %sall.log", nodeClass.m_sElmoFilePrefix.c_str());
+			else
+				ROS_WARN("Readout of Elmo recorders finished without data of any motor");
 		}
 #endif
 
-		nodeClass.publish_JointStates();
-
 		loop_rate.sleep();
 		ros::spinOnce();
 	}
@@ -870,6 +844,7 @@ bool NodeClass::initDrives()
 	bTemp1 = true;
 #else
 	bTemp1 =  m_CanCtrlPltf->initPltf();
+	m_CanCtrlPltf->setSDOSegmentsPerCycle(m_iElmoSegmentsPerCycle);
 #endif
 	// debug log
 	ROS_INFO("Initializing done");
@@ -28,11 +28,15 @@
 
 #ifdef __LINUX__
 	#include "cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_camera_sensors/ColorConversion.h"
 #else
 	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/ColorConversion.h"
 #endif
 
 #include <cstdlib>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 #ifdef _WIN32
 	#include <fgcamera.h>
@@ -96,7 +100,6 @@ class __DLL_LIBCAMERASENSORS__ AVTPikeCam : public AbstractColorCamera
 		static AVTPikeCamDeleter m_Deleter; ///< Cleans up stuff that has to done only once independent
 											///< of the number of cameras from this type
 #ifdef __LINUX__
-		dc1394video_frame_t* m_Frame;
 		dc1394_t* m_IEEE1394Info;	///< Hold information about IEEE1394 nodes, connected cameras and camera properties
 		dc1394camera_list_t* m_IEEE1394Cameras;	///< List holds all available firewire cameras
 		dc1394camera_t* m_cam; 		///< Opened camera instance.
@@ -112,8 +115,75 @@ class __DLL_LIBCAMERASENSORS__ AVTPikeCam : public AbstractColorCamera
 		CFGCamera m_cam;			///< The camera object for AVT FireGrab (part of AVT FirePackage)
 		FGNODEINFO m_nodeInfo[5];	///< Array holds information about all detected firewire nodes
 		UINT32 m_NodeCnt;			///< Number of detected IEEE1394 nodes
-		FGFRAME m_Frame; ///< The acquired latest frame from the camera
 #endif
+
+		int m_ImageWidth;			///< Image width, cached on <code>Open</code> and on changes of video mode or resolution
+		int m_ImageHeight;			///< Image height, cached on <code>Open</code> and on changes of video mode or resolution
+		bool m_RawBayer;			///< Camera transmits 8 bit Bayer raw data (COLOR_RAW8), debayered on the host
+		t_BayerPattern m_BayerPattern;	///< Color filter of the camera, used for raw data
+		boost::atomic<bool> m_RGBOutput;	///< Images are returned in RGB instead of BGR order, fixed while open
+
+		boost::thread m_DebayerThread;	///< Worker, that debayers the lower half of raw images
+		boost::mutex m_DebayerMutex;
+		boost::condition_variable m_DebayerCondition;
+		const unsigned char* m_DebayerSrc;	///< Raw image of the pending job, 0 if there is no job
+		unsigned char* m_DebayerDst;		///< Destination image of the pending job
+		bool m_DebayerBGR;			///< Channel order of the pending job
+		bool m_DebayerStop;			///< Tells the worker to terminate
+
+		/// Reads image size and color coding from the camera and updates the cached values.
+		/// @return Return code
+		unsigned long UpdateImageFormat();
+
+		/// Converts an acquired frame into a packed 8 bit BGR (or RGB) image.
+		/// @param src The frame data
+		/// @param srcBytes Size of the frame data in bytes
+		/// @param dst The destination image of size <code>m_ImageWidth</code> x <code>m_ImageHeight</code>
+		/// @return Return code
+		unsigned long ConvertFrame(const unsigned char* src, size_t srcBytes, unsigned char* dst);
+
+		/// Main loop of the debayer worker.
+		void DebayerThread();
+
+		/// A converted image of the capture thread.
+		struct t_CapturedFrame
+		{
+			std::vector<unsigned char> m_Image;	///< Packed 8 bit BGR (or RGB) image
+			double m_Timestamp;			///< Capture time in seconds since epoch
+			unsigned long m_FrameNumber;	///< Consecutive number of the captured frame, 0 if empty
+		};
+
+		enum
+		{
+			FRAME_INDEX_MASK = 0x3,	///< Buffer index within <code>m_LatestFrame</code>
+			FRAME_NEW = 0x4			///< Flag of <code>m_LatestFrame</code>, set if the buffer has not been read yet
+		};
+
+		/// Triple buffer between capture thread and <code>GetColorImage</code>.
+		/// The capture thread writes <code>m_CapturedFrames[m_WriteFrame]</code>, the reader owns
+		/// <code>m_CapturedFrames[m_ReadFrame]</code>, the remaining buffer holds the latest frame.
+		/// Buffers are handed over by atomically exchanging their index with <code>m_LatestFrame</code>.
+		t_CapturedFrame m_CapturedFrames[3];
+		boost::atomic<unsigned int> m_LatestFrame;	///< Index of the latest frame, optionally with <code>FRAME_NEW</code>
+		unsigned int m_WriteFrame;		///< Owned by the capture thread
+		unsigned long m_CapturedFrameCount;	///< Number of frames published by the capture thread
+		unsigned int m_ReadFrame;		///< Owned by <code>GetColorImage</code>
+		unsigned long m_LastFrameNumber;	///< Frame number of the last image returned by <code>GetColorImage</code>
+
+		boost::thread m_CaptureThread;	///< Keeps the DMA ring buffer drained
+		boost::atomic<bool> m_CaptureStop;	///< Tells the capture thread to terminate
+		boost::atomic<bool> m_CaptureFailed;	///< Set by the capture thread, if the camera stopped delivering frames
+		boost::mutex m_ReadMutex;		///< Serializes concurrent <code>GetColorImage</code> calls
+		boost::mutex m_FrameMutex;		///< Only used to let readers sleep until a new frame arrives
+		boost::condition_variable m_FrameCondition;
+
+		/// Main loop of the capture thread.
+		/// Dequeues all pending frames, returns all but the newest one to the DMA ring buffer
+		/// immediately and converts the newest one into the latest frame buffer.
+		void CaptureThread();
+
+		/// Converts a dequeued frame into the write buffer and publishes it as latest frame.
+		void PublishFrame(const unsigned char* src, size_t srcBytes, double timestamp);
 		/// Parses the XML configuration file, that holds the camera settings
 		/// @param filename The file name and path of the configuration file
 		/// @param cameraIndex The index of the camera within the configuration file
@@ -142,6 +212,12 @@ class __DLL_LIBCAMERASENSORS__ AVTPikeCam : public AbstractColorCamera
 		unsigned long Open();
 		unsigned long Close();
 
+		/// Returns an image of the capture thread, that continuously drains the DMA ring buffer.
+		/// @param colorImageData Destination of the packed 8 bit BGR (or RGB) image
+		/// @param getLatestFrame If true, the newest captured image is returned immediately,
+		///		   the call only waits, if no image has been captured yet. If false, the call waits
+		///		   for an image, that has not been returned before.
+		/// @return Return code
 		unsigned long GetColorImage(char* colorImageData, bool getLatestFrame);
 		unsigned long GetColorImage(cv::Mat* colorImage, bool getLatestFrame);
 
@@ -175,6 +251,22 @@ class __DLL_LIBCAMERASENSORS__ AVTPikeCam : public AbstractColorCamera
 		// Camera specific functions
 		//*******************************************************************************
 
+		/// Selects the channel order of the returned images, has to be called before <code>Open</code>.
+		/// RGB output saves the channel swap of RGB8 data, the consumer has to
+		/// treat the images as <code>rgb8</code> encoded.
+		/// @param rgb Return RGB images if true, BGR images (default) otherwise
+		/// @return Return code, fails if the camera is already open
+		unsigned long SetRGBOutput(bool rgb);
+		bool GetRGBOutput() const {return m_RGBOutput;}
+
+		/// Capture time of the image returned by the last <code>GetColorImage</code> call.
+		/// @return Seconds since epoch
+		double GetFrameTimestamp() const {return m_CapturedFrames[m_ReadFrame].m_Timestamp;}
+
+		/// Consecutive number of the image returned by the last <code>GetColorImage</code> call.
+		/// Gaps indicate frames, that have been replaced by newer ones before they were read.
+		unsigned long GetFrameNumber() const {return m_LastFrameNumber;}
+
 };
 
 /// Creates, intializes and returns a smart pointer object for the camera.
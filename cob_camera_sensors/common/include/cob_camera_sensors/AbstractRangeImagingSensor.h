@@ -28,9 +28,11 @@
 #ifdef __LINUX__
 	#include "cob_vision_utils/CameraSensorDefines.h"
 	#include "cob_vision_utils/CameraSensorTypes.h"
+	#include "cob_camera_sensors/ToFCalibration.h"
 #else
 	#include "cob_common/cob_vision_utils/common/include/cob_vision_utils/CameraSensorDefines.h"
 	#include "cob_common/cob_vision_utils/common/include/cob_vision_utils/CameraSensorTypes.h"
+	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/ToFCalibration.h"
 #endif
 
 #include <opencv/cv.h>
@@ -165,10 +167,12 @@ public:
 	/// Intrinsics are read from the configuration file by the camera toolbox.
 	/// Intrinsics are needed to calculat range values
 	/// based on own calibration.
+	/// Also builds the ray and remap tables of <code>m_Calibration</code>
+	/// for the image size reported by <code>GetProperty</code>.
 	/// @param intrinsicMatrix The intrinsic matrix
-	/// @param undistortMapX undistortMapX The undistortion map for x direction
-	/// @param undistortMapY undistortMapY The undistortion map for y direction
-	/// @return return code
+	/// @param undistortMapX undistortMapX The undistortion map for x direction, may be empty
+	/// @param undistortMapY undistortMapY The undistortion map for y direction, may be empty
+	/// @return return code, <code>RET_FAILED</code> if the intrinsics are invalid
 	virtual unsigned long SetIntrinsics(cv::Mat& intrinsicMatrix,
 		cv::Mat& undistortMapX, cv::Mat& undistortMapY);
 
@@ -199,6 +203,13 @@ protected:
 	cv::Mat m_undistortMapX;		///< The output array of x coordinates for the undistortion map
 	cv::Mat m_undistortMapY;		///< The output array of Y coordinates for the undistortion map
 
+	ToFCalibration m_Calibration;	///< Coefficient, ray and remap tables of the MATLAB calibration
+
+	/// Builds the coefficient table of <code>m_Calibration</code>.
+	/// @param coeffs The z-calibration matrices a0 ... a6 (CV_64FC1, one entry per pixel).
+	/// @return Return code
+	unsigned long SetCalibrationCoefficients(const cv::Mat* coeffs);
+
 private:
 
 	/// Load general SR31 parameters and previously determined calibration parameters.
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/// @file ColorConversion.h
+/// Conversion of the raw pixel formats of color cameras to packed 8 bit BGR or RGB images.
+
+#ifndef __IPA_COLORCONVERSION_H__
+#define __IPA_COLORCONVERSION_H__
+
+#include <stddef.h>
+
+namespace ipa_CameraSensors {
+
+/// Color filter arrays of Bayer sensors, named after the colors of the
+/// first two pixels of the first and the second row.
+enum t_BayerPattern
+{
+	BAYER_RGGB = 0,
+	BAYER_GBRG,
+	BAYER_GRBG,
+	BAYER_BGGR
+};
+
+/// Copies packed 3 channel 8 bit pixels and swaps the first and the third channel (RGB <-> BGR).
+/// Uses a <code>pshufb</code> kernel if compiled with SSSE3 or AVX2.
+/// @param src Source pixels.
+/// @param dst Destination pixels, must not overlap with <code>src</code>.
+/// @param pixels Number of pixels.
+void SwapRedBlue(const unsigned char* src, unsigned char* dst, size_t pixels);
+
+/// Bilinear demosaicing of the rows [rowBegin, rowEnd) of an 8 bit Bayer image.
+/// The borders are mirrored, rows can be converted independently (i.e. by several threads).
+/// @param src Continuous Bayer image, at least 2x2 pixels.
+/// @param dst Continuous packed 3 channel destination image of the same size.
+/// @param pattern Color filter of the sensor.
+/// @param bgr Write BGR if true, RGB otherwise.
+void DebayerRows(const unsigned char* src, unsigned char* dst, int width, int height,
+	t_BayerPattern pattern, bool bgr, int rowBegin, int rowEnd);
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_COLORCONVERSION_H__
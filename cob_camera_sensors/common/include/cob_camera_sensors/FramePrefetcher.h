@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/// @file FramePrefetcher.h
+/// Background loading of the image files of the virtual cameras.
+
+#ifndef __IPA_FRAMEPREFETCHER_H__
+#define __IPA_FRAMEPREFETCHER_H__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <opencv/cv.h>
+
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace ipa_CameraSensors {
+
+/// @ingroup VirtualCameraDriver
+/// Loads the frames following the one that is currently replayed on a worker thread.
+/// Frames are cached in <code>depth</code> slots, frame <code>i</code> goes to slot
+/// <code>i % depth</code>. Every request schedules the next <code>depth-1</code> frames,
+/// so a sequential replay only waits for the disk, if loading is slower than replaying.
+class FramePrefetcher
+{
+public:
+
+	/// Loads the images of a frame, called on the worker thread.
+	/// The content of the vector is up to the loader, empty images are allowed.
+	/// @return False, if the frame could not be loaded.
+	typedef boost::function<bool (int frame, std::vector<cv::Mat>& images)> t_Loader;
+
+	FramePrefetcher();
+	~FramePrefetcher();
+
+	/// Starts the worker thread.
+	/// @param loader Loads one frame.
+	/// @param numberOfFrames Frame numbers wrap around at this value.
+	/// @param depth Number of cached frames.
+	void Start(const t_Loader& loader, int numberOfFrames, int depth=4);
+
+	/// Stops the worker thread and releases the cached frames.
+	void Stop();
+
+	bool IsRunning() const {return m_Thread.joinable();}
+
+	/// Returns the images of a frame and schedules the following frames.
+	/// Waits, if the frame is not loaded yet.
+	/// @param images Shallow copies of the cached images, they stay valid after the slot is reused.
+	/// @return False, if the loader failed.
+	bool GetFrame(int frame, std::vector<cv::Mat>& images);
+
+	/// Loads an image file of the virtual cameras depending on its extension.
+	/// <code>.bin</code> files are read with <code>ipa_Utils::LoadMat</code>, <code>.xml</code>
+	/// files with <code>cvLoad</code> and all others with <code>cv::imread</code>.
+	/// @param imreadFlags Flags for <code>cv::imread</code>.
+	/// @return False, if the file could not be read.
+	static bool LoadImageFile(const std::string& filename, cv::Mat& image, int imreadFlags=-1);
+
+private:
+
+	enum t_SlotState
+	{
+		SLOT_EMPTY = 0,
+		SLOT_QUEUED,
+		SLOT_LOADING,
+		SLOT_READY,
+		SLOT_FAILED
+	};
+
+	struct t_Slot
+	{
+		int m_Frame;
+		t_SlotState m_State;
+		std::vector<cv::Mat> m_Images;
+	};
+
+	/// Assigns a frame to its slot and queues it, unless the slot is loading another frame.
+	/// Must be called with m_Mutex locked.
+	void Schedule(int frame, bool urgent);
+
+	/// Worker thread.
+	void Run();
+
+	t_Loader m_Loader;
+	int m_NumberOfFrames;
+	std::vector<t_Slot> m_Slots;
+	std::deque<int> m_Queue;	///< Frames to load, entries of reassigned slots are skipped
+	bool m_Stop;
+
+	boost::thread m_Thread;
+	boost::mutex m_Mutex;
+	boost::condition_variable m_QueueCondition;	///< Signals new entries in m_Queue
+	boost::condition_variable m_SlotCondition;	///< Signals loaded slots
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_FRAMEPREFETCHER_H__
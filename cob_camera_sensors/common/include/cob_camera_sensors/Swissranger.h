@@ -133,6 +133,8 @@ private:
 	float m_Y[SWISSRANGER_COLUMNS * SWISSRANGER_ROWS];
 	float m_Z[SWISSRANGER_COLUMNS * SWISSRANGER_ROWS];
 
+	std::vector<float> m_CalibratedZ; ///< Calibrated (distorted) z values of the last frame, reused between frames
+
 	bool m_CoeffsInitialized; ///< True, when m_CoeffsAx have been initialized
 	bool m_GrayImageAcquireCalled; ///< Is false, when acquiring gray image has not been called, yet
 
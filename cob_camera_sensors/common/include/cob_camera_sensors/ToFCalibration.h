@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/// @file ToFCalibration.h
+/// Lookup tables and row kernels for the MATLAB calibration of range imaging sensors.
+
+#ifndef __IPA_TOFCALIBRATION_H__
+#define __IPA_TOFCALIBRATION_H__
+
+#include <stddef.h>
+#include <vector>
+
+namespace ipa_CameraSensors {
+
+/// @ingroup RangeCameraDriver
+/// Precomputed MATLAB calibration of a range imaging sensor.
+/// The per pixel z-calibration polynomials are stored as one interleaved float array:
+/// pixels are grouped into blocks of <code>LANES</code> consecutive pixels (row major)
+/// and every block holds its coefficients ordered by coefficient, then by pixel, so
+/// one vector load fetches the same coefficient of all pixels of a block.
+/// The raw value is scaled to [0,1] before the polynomial is evaluated (the coefficients
+/// are rescaled accordingly), which keeps the single precision evaluation well conditioned.
+/// The intrinsics are stored as per column and per row ray factors (u-cx)/fx and (v-cy)/fy,
+/// the undistortion map as source offsets and bilinear weights of every destination pixel.
+/// Does not depend on OpenCV, the conversion from <code>cv::Mat</code> is up to the sensor.
+class ToFCalibration
+{
+public:
+
+	enum
+	{
+		NUM_COEFFS = 7,	///< Coefficients a0 ... a6 of the 6 degree polynomial
+		LANES = 8		///< Pixels per coefficient block (one AVX or two SSE registers)
+	};
+
+	ToFCalibration();
+
+	/// Builds the coefficient table.
+	/// @param width Image width.
+	/// @param height Image height.
+	/// @param coeffs Row major double matrices of a0 ... a6 (a0 first).
+	/// @param steps Row strides of the matrices in bytes.
+	/// @param zRawMax Upper limit of the raw values, used to scale the raw values to [0,1].
+	/// @return False, if the parameters are invalid.
+	bool SetCoefficients(int width, int height, const double* const coeffs[NUM_COEFFS],
+		const size_t steps[NUM_COEFFS], double zRawMax = 65535.0);
+
+	/// Builds the ray tables.
+	/// @return False, if fx or fy is 0 or the size is invalid.
+	bool SetIntrinsics(int width, int height, double fx, double fy, double cx, double cy);
+
+	/// Builds the remap table from an undistortion map with absolute source coordinates
+	/// (as used by <code>cv::remap</code> with <code>INTER_LINEAR</code> and a constant border of 0).
+	/// @param mapX Row major x coordinates, stride <code>stepX</code> bytes.
+	/// @param mapY Row major y coordinates, stride <code>stepY</code> bytes.
+	/// @return False, if the size is invalid.
+	bool SetUndistortMap(int width, int height, const float* mapX, size_t stepX, const float* mapY, size_t stepY);
+
+	/// Removes the undistortion map, afterwards the remap functions copy the source image.
+	void ClearUndistortMap();
+
+	bool HasCoefficients() const {return !m_Coeffs.empty();}
+	bool HasIntrinsics() const {return !m_RayX.empty();}
+	bool HasUndistortMap() const {return !m_RemapOffset.empty();}
+
+	int GetCoeffsWidth() const {return m_CoeffsWidth;}
+	int GetCoeffsHeight() const {return m_CoeffsHeight;}
+	int GetWidth() const {return (int)m_RayX.size();}
+	int GetHeight() const {return (int)m_RayY.size();}
+
+	/// Ray factors (u-cx)/fx of all columns.
+	const float* GetRayX() const {return &m_RayX[0];}
+	/// Ray factors (v-cy)/fy of all rows.
+	const float* GetRayY() const {return &m_RayY[0];}
+
+	/// Calibrated z value (in meters) of a single pixel.
+	float GetCalibratedZ(int u, int v, float zRaw) const;
+
+	/// x and y (in meters) of the undistorted pixel (u,v) with the given z value.
+	void GetCalibratedXY(int u, int v, float z, float& x, float& y) const
+	{
+		x = z * m_RayX[u];
+		y = z * m_RayY[v];
+	}
+
+	/// Calibrates the raw values of one row.
+	/// @param row Row index.
+	/// @param zRaw The raw values of the row.
+	/// @param z Output of the calibrated z values of the row.
+	void CalibrateZRow(int row, const unsigned short* zRaw, float* z) const;
+
+	/// Calibrates the raw values of the whole (continuous) image.
+	void CalibrateZ(const unsigned short* zRaw, float* z) const;
+
+	/// Undistorts one row of a continuous source image.
+	/// @param row Index of the destination row.
+	/// @param src Continuous source image of the size of the undistortion map.
+	/// @param dst Output of the destination row.
+	void UndistortRow(int row, const float* src, float* dst) const;
+	void UndistortRow(int row, const unsigned short* src, float* dst) const;
+
+	/// Undistorts one row of a continuous z image and computes its cartesian coordinates.
+	/// Replaces remapping the z image followed by a per pixel back projection.
+	/// @param row Index of the destination row.
+	/// @param z Continuous (distorted) z image.
+	/// @param xyz Output of the x,y,z triples of the destination row.
+	void ComputeCartesianRow(int row, const float* z, float* xyz) const;
+
+private:
+
+	/// Evaluates the polynomials of the pixels [begin, end) of the image.
+	void CalibrateZRange(int begin, int end, const unsigned short* zRaw, float* z) const;
+
+	/// Evaluates the polynomials of the pixels [begin, end) of one block.
+	void CalibrateZScalar(int begin, int end, const unsigned short* zRaw, float* z) const;
+
+	int m_CoeffsWidth;
+	int m_CoeffsHeight;
+	float m_ZRawScale;					///< 1/zRawMax
+	std::vector<float> m_Coeffs;		///< Interleaved coefficients, see class description
+
+	std::vector<float> m_RayX;			///< (u-cx)/fx of every column
+	std::vector<float> m_RayY;			///< (v-cy)/fy of every row
+
+	int m_MapWidth;
+	int m_MapHeight;
+	std::vector<int> m_RemapOffset;		///< Source pixel index of the 4 neighbours of every destination pixel
+	std::vector<float> m_RemapWeight;	///< Bilinear weights of the 4 neighbours, 0 for neighbours outside the image
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_TOFCALIBRATION_H__
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/// @file ToFFilter.h
+/// Post-processing of the point clouds of range imaging sensors.
+
+#ifndef __IPA_TOFFILTER_H__
+#define __IPA_TOFFILTER_H__
+
+#include <stddef.h>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace ipa_CameraSensors {
+
+/// @ingroup RangeCameraDriver
+/// Removes unreliable points of xyz images in place, invalid points are set to (0,0,0).
+/// The image is split into horizontal tiles, one per thread. The point tests of all stages
+/// run fused in one pass over the tile, which only marks points. The marked points are
+/// removed after all tiles have been tested, so every test sees the unfiltered neighbours.
+/// The temporal median runs before the tests.
+/// Does not depend on OpenCV.
+class ToFFilter
+{
+public:
+
+	/// Filter stages, combined as bit mask.
+	enum t_Stage
+	{
+		STAGE_AMPLITUDE = 1,		///< Removes points with an amplitude outside [lower, upper]
+		STAGE_TEAR_OFF_EDGES = 2,	///< Removes points on surfaces almost parallel to the view ray
+		STAGE_FLYING_PIXELS = 4,	///< Removes points with too few close neighbours
+		STAGE_TEMPORAL_MEDIAN = 8	///< Replaces points by the point with the median z of the last frames
+	};
+
+	struct t_Parameters
+	{
+		unsigned int m_Stages;			///< Enabled stages, see <code>t_Stage</code>
+		float m_LowerAmplitude;			///< Lower amplitude threshold
+		float m_UpperAmplitude;			///< Upper amplitude threshold
+		float m_TearOffPiFraction;		///< Points are removed, if the angle between view ray and the vector
+										///< to a 4-neighbour is below pi/fraction or above pi - pi/fraction
+		float m_FlyingMaxDistance;		///< Neighbours closer than this distance (in meters) are close
+		int m_FlyingMinNeighbours;		///< Points with fewer close 8-neighbours are removed
+		int m_MedianLength;				///< Number of frames of the temporal median (at most <code>MAX_MEDIAN_LENGTH</code>)
+	};
+
+	enum
+	{
+		MAX_MEDIAN_LENGTH = 9
+	};
+
+	ToFFilter();
+	~ToFFilter();
+
+	/// Sets the parameters, a changed median length resets the history.
+	void SetParameters(const t_Parameters& parameters);
+	const t_Parameters& GetParameters() const {return m_Parameters;}
+
+	/// Sets the number of threads, including the calling thread.
+	/// Values below 1 use the number of cores.
+	void SetNumberOfThreads(int threads);
+	int GetNumberOfThreads() const {return m_NumberOfThreads;}
+
+	/// Filters an xyz image in place.
+	/// @param xyz x,y,z triples, row stride <code>xyzStep</code> bytes.
+	/// @param amplitude Amplitude image, row stride <code>amplitudeStep</code> bytes. May be 0,
+	///        if the amplitude stage is disabled.
+	void Apply(int width, int height, float* xyz, size_t xyzStep, const float* amplitude, size_t amplitudeStep);
+
+	/// Forgets the frames of the temporal median.
+	void ResetHistory();
+
+private:
+
+	/// Filters the tile of one thread, the phases are separated by barriers.
+	void RunTile(int tile);
+
+	/// Temporal median of the rows [rowBegin, rowEnd).
+	void MedianRows(int rowBegin, int rowEnd);
+
+	/// Marks the points of the rows [rowBegin, rowEnd), that fail any test.
+	void MarkRows(int rowBegin, int rowEnd);
+
+	/// Sets the marked points of the rows [rowBegin, rowEnd) to 0.
+	void RemoveRows(int rowBegin, int rowEnd);
+
+	/// Worker thread of a tile.
+	/// @param generation Value of m_Generation at the start of the thread.
+	void WorkerThread(int tile, unsigned long generation);
+
+	void StopWorkers();
+
+	t_Parameters m_Parameters;
+	float m_TearOffCos2;		///< Squared cosine of pi/fraction
+
+	/// The frame being filtered
+	int m_Width;
+	int m_Height;
+	float* m_Xyz;
+	size_t m_XyzStep;
+	const float* m_Amplitude;
+	size_t m_AmplitudeStep;
+
+	std::vector<unsigned char> m_Mask;	///< Points to remove
+
+	std::vector<float> m_History;		///< The last m_MedianLength xyz images, continuous
+	int m_HistoryFrames;				///< Number of valid frames in m_History
+	int m_HistoryIndex;					///< Slot of the next frame
+
+	int m_NumberOfThreads;
+	boost::scoped_ptr<boost::thread_group> m_Workers;	///< Threads of the tiles 1 ... m_NumberOfThreads-1
+	boost::scoped_ptr<boost::barrier> m_Barrier;
+	boost::mutex m_WorkerMutex;
+	boost::condition_variable m_WorkerCondition;
+	unsigned long m_Generation;			///< Incremented for every frame, wakes the workers
+	bool m_Stop;
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_TOFFILTER_H__
@@ -26,8 +26,12 @@
 #include "StdAfx.h"
 #ifdef __LINUX__
 	#include "cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_camera_sensors/FramePrefetcher.h"
+	#include "cob_camera_sensors/VirtualRecording.h"
 #else
 	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractColorCamera.h"
+	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/FramePrefetcher.h"
+	#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/VirtualRecording.h"
 #endif
 
 #include <cstdlib>
@@ -38,6 +42,8 @@ namespace ipa_CameraSensors {
 /// The class offers an interface to a virtual color camera, that is equivalent
 /// to the interface of a real color camera.
 /// However, pictures are read from a directory instead of the camera.
+/// If the directory contains a packed recording <code>ColorCam_[cameraIndex].vrec</code> (see <code>VirtualRecording</code>),
+/// it is memory-mapped and replaces the image files. Otherwise the image files are loaded ahead by a <code>FramePrefetcher</code>.
 class __DLL_LIBCAMERASENSORS__ VirtualColorCam : public AbstractColorCamera
 {
 	private:
@@ -49,6 +55,9 @@ class __DLL_LIBCAMERASENSORS__ VirtualColorCam : public AbstractColorCamera
 
 		std::vector<std::string> m_ColorImageFileNames;
 
+		VirtualRecording m_Recording; ///< Packed recording, replaces the image files if open
+		FramePrefetcher m_Prefetcher; ///< Loads the image files ahead
+
 		unsigned int m_ImageCounter; ///< Holds the index of the image that is extracted during the next call of <code>AcquireImages</code>
 
 		/// Parses the XML configuration file, that holds the camera settings
@@ -60,6 +69,9 @@ class __DLL_LIBCAMERASENSORS__ VirtualColorCam : public AbstractColorCamera
 
 		unsigned long SetParameters(){return RET_OK;};
 
+		/// Loader of the prefetcher.
+		bool LoadImageFile(int frame, std::vector<cv::Mat>& images);
+
 	public:
 
 		VirtualColorCam ();
@@ -27,8 +27,12 @@
 
 #ifdef __LINUX__
 	#include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include <cob_camera_sensors/FramePrefetcher.h>
+	#include <cob_camera_sensors/VirtualRecording.h>
 #else
 	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/AbstractRangeImagingSensor.h>
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/FramePrefetcher.h>
+	#include <cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/VirtualRecording.h>
 #endif
 
 #include <stdio.h>
@@ -36,6 +40,7 @@
 #include <assert.h>
 #include <sstream>
 
+#include <boost/atomic.hpp>
 #include <boost/filesystem.hpp>
 
 namespace ipa_CameraSensors {
@@ -47,6 +52,8 @@ static const int SWISSRANGER_ROWS = 144;
 /// Interface class to virtual range camera like Swissranger 3000/4000.
 /// The class offers an interface to a virtual range camera, that is equal to the interface of a real range camera.
 /// However, pictures are read from a directory instead of the camera.
+/// If the directory contains a packed recording <code>RangeCam_[cameraIndex].vrec</code> (see <code>VirtualRecording</code>),
+/// it is memory-mapped and replaces the image files. Otherwise the image files are loaded ahead by a <code>FramePrefetcher</code>.
 class __DLL_LIBCAMERASENSORS__ VirtualRangeCam : public AbstractRangeImagingSensor
 {
 public:
@@ -106,6 +113,26 @@ private:
 	/// @param ext Is empty if no extension was found before, otherwise it contains the found extension.
 	inline void FindSourceImageFormat(std::map<std::string, int>::iterator& itCounter, std::string& ext);
 
+	/// Opens the packed recording and checks, that it holds the channels required by the calibration method.
+	/// @return Return code
+	unsigned long OpenRecording(const std::string& filename);
+
+	/// Channel of the gray image type.
+	/// Intensity images are taken from the other intensity channel, if the requested one is not available.
+	VirtualRecording::t_Channel GetGrayChannel(ipa_CameraSensors::t_ToFGrayImageType grayImageType);
+
+	/// Returns true, if the recording or the image files contain the channel.
+	bool HasChannel(VirtualRecording::t_Channel channel);
+
+	/// Provides the source images of a frame, either mapped from the recording or from the prefetcher.
+	/// @param channelMask Bit (1 << channel) set for every requested channel.
+	/// @param images Images indexed by channel, the mapped images must not be written.
+	/// @return Return code
+	unsigned long LoadFrame(int frame, unsigned int channelMask, std::vector<cv::Mat>& images);
+
+	/// Loader of the prefetcher, loads the image files of the channels in <code>m_PrefetchChannels</code>.
+	bool LoadImageFiles(int frame, std::vector<cv::Mat>& images);
+
 	unsigned long GetCalibratedZMatlab(int u, int v, float zRaw, float& zCalibrated);
 	unsigned long GetCalibratedXYMatlab(int u, int v, float z, float& x, float& y);
 
@@ -133,10 +160,11 @@ private:
 	std::string m_CameraDataDirectory; ///< Directory where the image data resides
 	int m_CameraIndex; ///< Index of the specified camera. Important, when several cameras of the same type are present
 
-	std::vector<std::string> m_AmplitudeImageFileNames;
-	std::vector<std::string> m_IntensityImageFileNames;
-	std::vector<std::string> m_RangeImageFileNames ;
-	std::vector<std::string> m_CoordinateImageFileNames ;
+	std::vector<std::string> m_ImageFileNames[VirtualRecording::NUM_CHANNELS]; ///< Sorted image files of each channel
+
+	VirtualRecording m_Recording; ///< Packed recording, replaces the image files if open
+	FramePrefetcher m_Prefetcher; ///< Loads the image files ahead
+	boost::atomic<unsigned int> m_PrefetchChannels; ///< Channels requested so far, bit (1 << channel)
 
 	int m_ImageWidth;  ///< Image width
 	int m_ImageHeight; ///< Image height
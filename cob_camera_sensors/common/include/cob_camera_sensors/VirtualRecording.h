@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/// @file VirtualRecording.h
+/// Packed recording format of the virtual cameras.
+
+#ifndef __IPA_VIRTUALRECORDING_H__
+#define __IPA_VIRTUALRECORDING_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace ipa_CameraSensors {
+
+/// @ingroup VirtualCameraDriver
+/// Read access to a packed recording of a virtual camera.
+/// A recording is a single file with a header, followed by frames of fixed size.
+/// Every frame holds the images of all recorded channels, row major without padding,
+/// in native byte order. The header is padded to <code>HEADER_SIZE</code> bytes and the
+/// frame size to a multiple of 64 bytes, so the mapped images are page and cache line aligned.
+/// On Linux the file is memory-mapped, elsewhere it is read into memory.
+class VirtualRecording
+{
+public:
+
+	/// The images of a frame.
+	enum t_Channel
+	{
+		CHANNEL_RANGE_32F1 = 0,		///< RangeCamRange_32F1
+		CHANNEL_AMPLITUDE_32F1,		///< RangeCamAmplitude_32F1
+		CHANNEL_INTENSITY_32F1,		///< RangeCamIntensity_32F1
+		CHANNEL_INTENSITY_8U3,		///< RangeCamIntensity_8U3
+		CHANNEL_COORDINATE_32F3,	///< RangeCamCoordinate_32F3
+		CHANNEL_COLOR_8U3,			///< ColorCamRGB_8U3 (BGR order)
+		NUM_CHANNELS
+	};
+
+	enum
+	{
+		HEADER_SIZE = 4096,		///< Offset of the first frame
+		VERSION = 1
+	};
+
+	/// File header, followed by padding up to <code>HEADER_SIZE</code>.
+	struct t_Header
+	{
+		char m_Magic[8];				///< "IPAVREC" with terminating 0
+		unsigned int m_Version;
+		unsigned int m_Width;
+		unsigned int m_Height;
+		unsigned int m_NumberOfFrames;
+		unsigned int m_ChannelMask;		///< Bit (1 << channel) is set for every recorded channel
+		unsigned int m_FrameSize;		///< Distance of consecutive frames in bytes
+		unsigned int m_ChannelOffsets[NUM_CHANNELS];	///< Offsets of the channels within a frame
+	};
+
+	VirtualRecording();
+	~VirtualRecording();
+
+	/// Opens a recording.
+	/// @return False, if the file does not exist or is no valid recording.
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const {return m_Data != 0;}
+
+	int GetWidth() const {return (int)m_Header.m_Width;}
+	int GetHeight() const {return (int)m_Header.m_Height;}
+	int GetNumberOfFrames() const {return (int)m_Header.m_NumberOfFrames;}
+	bool HasChannel(t_Channel channel) const {return (m_Header.m_ChannelMask & (1u << channel)) != 0;}
+
+	/// Image of one channel of a frame.
+	/// @return Pointer to the continuous image, 0 if the channel is not recorded.
+	const void* GetImage(int frame, t_Channel channel) const;
+
+	/// Asks the operating system to read a frame ahead (no-op, if the file is not mapped).
+	void Prefetch(int frame) const;
+
+	/// Size of one pixel of a channel in bytes.
+	static size_t GetBytesPerPixel(t_Channel channel);
+
+private:
+
+	t_Header m_Header;
+	const unsigned char* m_Data;	///< Begin of the mapped file or of m_Buffer
+	size_t m_Size;					///< Size of the file in bytes
+	bool m_Mapped;					///< m_Data is mapped, otherwise it points into m_Buffer
+	std::vector<unsigned char> m_Buffer;
+};
+
+/// @ingroup VirtualCameraDriver
+/// Writes packed recordings, see <code>VirtualRecording</code>.
+class VirtualRecordingWriter
+{
+public:
+
+	VirtualRecordingWriter();
+	~VirtualRecordingWriter();
+
+	/// Creates a recording.
+	/// @param channelMask Bit (1 << channel) set for every channel to record.
+	/// @return False, if the file can not be created or the parameters are invalid.
+	bool Open(const std::string& filename, int width, int height, unsigned int channelMask);
+
+	/// Appends a frame.
+	/// @param images Continuous images of all recorded channels, indexed by channel.
+	/// @return False on write errors.
+	bool AddFrame(const void* const images[VirtualRecording::NUM_CHANNELS]);
+
+	/// Writes the number of frames into the header and closes the file.
+	/// @return False on write errors.
+	bool Close();
+
+	int GetNumberOfFrames() const {return (int)m_Header.m_NumberOfFrames;}
+
+private:
+
+	VirtualRecording::t_Header m_Header;
+	FILE* m_File;
+	std::vector<unsigned char> m_Frame;	///< Frame buffer including padding
+};
+
+} // end namespace ipa_CameraSensors
+#endif // __IPA_VIRTUALRECORDING_H__
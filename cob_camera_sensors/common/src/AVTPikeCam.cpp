@@ -26,6 +26,12 @@
 #endif
 
 #include <iostream>
+#include <string.h>
+
+#ifdef __LINUX__
+#include <errno.h>
+#include <sys/select.h>
+#endif
 
 using namespace std;
 using namespace ipa_CameraSensors;
@@ -44,14 +50,28 @@ AVTPikeCam::AVTPikeCam()
 	m_open = false;
 	m_BufferSize = 3;
 
+	m_ImageWidth = 0;
+	m_ImageHeight = 0;
+	m_RawBayer = false;
+	m_BayerPattern = BAYER_RGGB;
+	m_RGBOutput = false;
+	m_DebayerSrc = 0;
+	m_DebayerDst = 0;
+	m_DebayerBGR = true;
+	m_DebayerStop = false;
+
+	m_LatestFrame = 0;
+	m_WriteFrame = 1;
+	m_ReadFrame = 2;
+	m_CapturedFrameCount = 0;
+	m_LastFrameNumber = 0;
+	m_CaptureStop = false;
+	m_CaptureFailed = false;
+
 #ifdef __LINUX__
 	m_cam = 0;
 	m_IEEE1394Cameras = 0;
 	m_IEEE1394Info = 0;
-	m_Frame = 0;
-#endif
-#ifndef __LINUX__
-	m_Frame.pData = 0;
 #endif
 
 }
@@ -325,6 +345,32 @@ unsigned long AVTPikeCam::Open()
 	}
 
 #endif
+	// Cache image size and color coding, they are needed for every acquired image
+	if (UpdateImageFormat() & RET_FAILED)
+	{
+		std::cerr << "ERROR - AVTPikeCam::Open:" << std::endl;
+		std::cerr << "\t ... Could not read image format" << std::endl;
+		return RET_FAILED;
+	}
+
+	m_DebayerStop = false;
+	m_DebayerThread = boost::thread(boost::bind(&AVTPikeCam::DebayerThread, this));
+
+	// Start draining the DMA ring buffer
+	for (int i=0; i<3; i++)
+	{
+		m_CapturedFrames[i].m_FrameNumber = 0;
+		m_CapturedFrames[i].m_Timestamp = 0;
+	}
+	m_LatestFrame = 0;
+	m_WriteFrame = 1;
+	m_ReadFrame = 2;
+	m_CapturedFrameCount = 0;
+	m_LastFrameNumber = 0;
+	m_CaptureStop = false;
+	m_CaptureFailed = false;
+	m_CaptureThread = boost::thread(boost::bind(&AVTPikeCam::CaptureThread, this));
+
 	std::cout << "**************************************************" << std::endl;
 	std::cout << "AVTPikeCam::Open: AVT Pike 145C camera device OPEN" << std::endl;
 	std::cout << "**************************************************" << std::endl << std::endl;
@@ -349,6 +395,17 @@ unsigned long AVTPikeCam::Close()
 		return (RET_OK);
 	}
 
+	// Stop the capture thread before the DMA ring buffer is released
+	m_CaptureStop = true;
+	m_CaptureThread.join();
+
+	{
+		boost::mutex::scoped_lock lock(m_DebayerMutex);
+		m_DebayerStop = true;
+	}
+	m_DebayerCondition.notify_all();
+	m_DebayerThread.join();
+
 #ifdef __LINUX__
 	if (m_cam != 0)
 	{
@@ -410,7 +467,6 @@ unsigned long AVTPikeCam::SetPropertyDefaults()
 unsigned long AVTPikeCam::GetProperty(t_cameraProperty* cameraProperty)
 {
 #ifdef __LINUX__
-	dc1394error_t err;
 	switch (cameraProperty->propertyID)
 	{
 		case PROP_DMA_BUFFER_SIZE:
@@ -420,28 +476,10 @@ unsigned long AVTPikeCam::GetProperty(t_cameraProperty* cameraProperty)
 		case PROP_CAMERA_RESOLUTION:
 			if (isOpen())
 			{
-				uint32_t imageWidth = -1;
-				uint32_t imageHeight = -1;
-				dc1394video_mode_t videoMode;
-				err=dc1394_video_get_mode(m_cam, &videoMode);
-				if (err!=DC1394_SUCCESS)
-				{
-					std::cerr << "ERROR - AVTPikeCam::GetProperty:" << std::endl;
-					std::cerr << "\t ... Failed to get video mode." << std::endl;
-					std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
-					return RET_FAILED;
-				}
-
-				err = dc1394_get_image_size_from_video_mode(m_cam, videoMode, &imageWidth, &imageHeight);
-				if (err!=DC1394_SUCCESS)
-				{
-					std::cerr << "ERROR - AVTPikeCam::GetProperty:" << std::endl;
-					std::cerr << "\t ... Failed to get image size." << std::endl;
-					std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
-					return RET_FAILED;
-				}
-				cameraProperty->cameraResolution.xResolution = (int) imageWidth;
-				cameraProperty->cameraResolution.yResolution = (int) imageHeight;
+				// Cached on Open and on changes of video mode or resolution
+				cameraProperty->cameraResolution.xResolution = m_ImageWidth;
+				cameraProperty->cameraResolution.yResolution = m_ImageHeight;
+				cameraProperty->propertyType = TYPE_CAMERA_RESOLUTION;
 			}
 			else
 			{
@@ -464,7 +502,6 @@ unsigned long AVTPikeCam::GetProperty(t_cameraProperty* cameraProperty)
 	return RET_OK;
 #endif
 #ifndef __LINUX__
-	UINT32 err;
 	switch (cameraProperty->propertyID)
 	{
 		case PROP_BRIGHTNESS:
@@ -494,25 +531,10 @@ unsigned long AVTPikeCam::GetProperty(t_cameraProperty* cameraProperty)
 		case PROP_CAMERA_RESOLUTION:
 			if (isOpen())
 			{
-				UINT32 x;
-				UINT32 y;
-
-				err = m_cam.GetParameter(FGP_XSIZE, &x);
-				if(err!=FCE_NOERROR)
-				{
-					std::cerr << "ERROR - AVTPikeCam::GetProperty:" << std::endl;
-					std::cerr << "\t ... Could not read image width ( error " << err << " )" << std::endl;
-					return RET_FAILED;
-				}
-				m_cam.GetParameter(FGP_YSIZE, &y);
-				if(err!=FCE_NOERROR)
-				{
-					std::cerr << "ERROR - AVTPikeCam::GetProperty:" << std::endl;
-					std::cerr << "\t ...  Could not read image height ( error " << err << " )" << std::endl;
-					return RET_FAILED;
-				}
-				cameraProperty->cameraResolution.xResolution = x;
-				cameraProperty->cameraResolution.yResolution = y;
+				// Cached on Open and on changes of video mode or resolution
+				cameraProperty->cameraResolution.xResolution = m_ImageWidth;
+				cameraProperty->cameraResolution.yResolution = m_ImageHeight;
+				cameraProperty->propertyType = TYPE_CAMERA_RESOLUTION;
 			}
 			else
 			{
@@ -559,183 +581,366 @@ unsigned long AVTPikeCam::GetColorImage(char* colorImageData, bool getLatestFram
 		std::cerr << "\t ... Color camera not open." << std::endl;
 		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
 	}
-#ifdef __LINUX__
 
-	dc1394error_t err;
+	boost::mutex::scoped_lock readLock(m_ReadMutex);
+	while (true)
+	{
+		// Take over the latest frame, if the capture thread published a new one
+		if (m_LatestFrame.load() & FRAME_NEW)
+		{
+			m_ReadFrame = m_LatestFrame.exchange(m_ReadFrame) & FRAME_INDEX_MASK;
+		}
+
+		t_CapturedFrame& frame = m_CapturedFrames[m_ReadFrame];
+		if (frame.m_FrameNumber != 0 &&
+			frame.m_Image.size() == 3*(size_t)m_ImageWidth*m_ImageHeight &&
+			(getLatestFrame || frame.m_FrameNumber != m_LastFrameNumber))
+		{
+			memcpy(colorImageData, &frame.m_Image[0], frame.m_Image.size());
+			m_LastFrameNumber = frame.m_FrameNumber;
+			return RET_OK;
+		}
+
+		if (m_CaptureFailed || m_CaptureStop)
+		{
+			std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
+			std::cerr << "\t ... Image acquisition stopped." << std::endl;
+			return RET_FAILED;
+		}
 
-	if (m_Frame)
+		// Sleep until the capture thread publishes the next frame. Like the
+		// former blocking dequeue, there is no timeout (i.e. for triggered cameras).
+		boost::mutex::scoped_lock lock(m_FrameMutex);
+		if ((m_LatestFrame.load() & FRAME_NEW) == 0)
+		{
+			m_FrameCondition.timed_wait(lock, boost::posix_time::seconds(1));
+		}
+	}
+}
+
+unsigned long AVTPikeCam::GetColorImage(cv::Mat* colorImage, bool getLatestFrame)
+{
+	if (!isOpen())
 	{
-		// Release the buffer from previous function call
-		err=dc1394_capture_enqueue(m_cam, m_Frame);
-		if (err!=DC1394_SUCCESS)
+		std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
+		std::cerr << "\t ... Color camera not open." << std::endl;
+		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+	}
+
+	CV_Assert(colorImage != 0);
+
+	// Create color image, if necessary
+	colorImage->create(m_ImageHeight, m_ImageWidth, CV_8UC3);
+	return GetColorImage(colorImage->ptr<char>(0), getLatestFrame);
+}
+
+unsigned long AVTPikeCam::SetRGBOutput(bool rgb)
+{
+	if (isOpen())
+	{
+		std::cerr << "ERROR - AVTPikeCam::SetRGBOutput:" << std::endl;
+		std::cerr << "\t ... The channel order can not be changed while the camera is open." << std::endl;
+		return RET_FAILED;
+	}
+
+	m_RGBOutput = rgb;
+	return RET_OK;
+}
+
+unsigned long AVTPikeCam::ConvertFrame(const unsigned char* src, size_t srcBytes, unsigned char* dst)
+{
+	size_t pixels = (size_t)m_ImageWidth*m_ImageHeight;
+	// Both halves of a frame have to use the same channel order
+	bool bgr = !m_RGBOutput;
+
+	if (m_RawBayer)
+	{
+		if (srcBytes < pixels || m_ImageWidth < 2 || m_ImageHeight < 2)
 		{
-			std::cerr << "AVTPikeCam::GetColorImage:" << std::endl;
-			std::cerr << "\t ... 'dc1394_capture_enqueue' failed." << std::endl;
-			std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
+			std::cerr << "ERROR - AVTPikeCam::ConvertFrame:" << std::endl;
+			std::cerr << "\t ... Frame of " << srcBytes << " bytes does not match the image size" << std::endl;
 			return RET_FAILED;
 		}
+
+		// The worker debayers the lower half while the calling thread debayers the upper half
+		{
+			boost::mutex::scoped_lock lock(m_DebayerMutex);
+			m_DebayerSrc = src;
+			m_DebayerDst = dst;
+			m_DebayerBGR = bgr;
+		}
+		m_DebayerCondition.notify_all();
+
+		DebayerRows(src, dst, m_ImageWidth, m_ImageHeight, m_BayerPattern, bgr, 0, m_ImageHeight/2);
+
+		boost::mutex::scoped_lock lock(m_DebayerMutex);
+		while (m_DebayerSrc != 0)
+		{
+			m_DebayerCondition.wait(lock);
+		}
+		return RET_OK;
+	}
+
+	if (srcBytes < 3*pixels)
+	{
+		std::cerr << "ERROR - AVTPikeCam::ConvertFrame:" << std::endl;
+		std::cerr << "\t ... Frame of " << srcBytes << " bytes does not match the image size" << std::endl;
+		return RET_FAILED;
 	}
 
-	//std::cout << "INFO - AVTPikeCam::GetColorImage:" << std::endl;
-	//std::cout << "\t ... Flushing DMA" << std::endl;
+	// The camera delivers RGB
+	if (!bgr)
+	{
+		memcpy(dst, src, 3*pixels);
+	}
+	else
+	{
+		SwapRedBlue(src, dst, pixels);
+	}
+	return RET_OK;
+}
 
-	if (getLatestFrame)
+void AVTPikeCam::DebayerThread()
+{
+	boost::mutex::scoped_lock lock(m_DebayerMutex);
+	while (true)
 	{
-		// Flush the DMA ring buffer
-		do
+		while (m_DebayerSrc == 0 && !m_DebayerStop)
 		{
-			m_Frame = 0;
-			err=dc1394_capture_dequeue(m_cam, DC1394_CAPTURE_POLICY_POLL, &m_Frame);
+			m_DebayerCondition.wait(lock);
+		}
+		if (m_DebayerStop)
+		{
+			return;
+		}
+
+		const unsigned char* src = m_DebayerSrc;
+		unsigned char* dst = m_DebayerDst;
+		bool bgr = m_DebayerBGR;
+		lock.unlock();
+		DebayerRows(src, dst, m_ImageWidth, m_ImageHeight, m_BayerPattern, bgr, m_ImageHeight/2, m_ImageHeight);
+		lock.lock();
+
+		m_DebayerSrc = 0;
+		m_DebayerCondition.notify_all();
+	}
+}
+
+void AVTPikeCam::CaptureThread()
+{
+#ifdef __LINUX__
+	int fileDescriptor = dc1394_capture_get_fileno(m_cam);
+
+	while (!m_CaptureStop)
+	{
+		// Wait for the DMA ring buffer, but check for termination regularly
+		fd_set fileDescriptors;
+		FD_ZERO(&fileDescriptors);
+		FD_SET(fileDescriptor, &fileDescriptors);
+		timeval timeout = {0, 100000};
+		int ready = select(fileDescriptor+1, &fileDescriptors, 0, 0, &timeout);
+		if (ready < 0 && errno != EINTR)
+		{
+			std::cerr << "ERROR - AVTPikeCam::CaptureThread:" << std::endl;
+			std::cerr << "\t ... Waiting for the DMA ring buffer failed." << std::endl;
+			m_CaptureFailed = true;
+			break;
+		}
+		if (ready <= 0)
+		{
+			continue;
+		}
+
+		// Drain the ring buffer, older frames are returned immediately
+		dc1394video_frame_t* newestFrame = 0;
+		while (true)
+		{
+			dc1394video_frame_t* frame = 0;
+			dc1394error_t err = dc1394_capture_dequeue(m_cam, DC1394_CAPTURE_POLICY_POLL, &frame);
 			if (err!=DC1394_SUCCESS)
 			{
-				std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
+				std::cerr << "ERROR - AVTPikeCam::CaptureThread:" << std::endl;
 				std::cerr << "\t ... 'dc1394_capture_dequeue' failed." << std::endl;
 				std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
-				return RET_FAILED;
+				m_CaptureFailed = true;
+				break;
 			}
-
-			if (m_Frame == 0)
+			if (frame == 0)
 			{
 				break;
 			}
-
-			err=dc1394_capture_enqueue(m_cam, m_Frame);
-			if (err!=DC1394_SUCCESS)
+			if (newestFrame != 0)
 			{
-				std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
-				std::cerr << "\t ... 'dc1394_capture_enqueue' failed." << std::endl;
-				std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
-				return RET_FAILED;
+				dc1394_capture_enqueue(m_cam, newestFrame);
 			}
+			newestFrame = frame;
 		}
-		while (true);
-	}
 
-	//std::cout << "INFO - AVTPikeCam::GetColorImage:" << std::endl;
-	//std::cout << "\t ... Waiting for images" << std::endl;
+		if (newestFrame != 0)
+		{
+			// Timestamp is the system time in microseconds, when the frame was filled
+			PublishFrame(newestFrame->image, newestFrame->image_bytes, newestFrame->timestamp*1e-6);
+			dc1394_capture_enqueue(m_cam, newestFrame);
+		}
+		if (m_CaptureFailed)
+		{
+			break;
+		}
+	}
+#else
+	const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
 
-	// Capture
-	err=dc1394_capture_dequeue(m_cam, DC1394_CAPTURE_POLICY_WAIT, &m_Frame);
-	if (err!=DC1394_SUCCESS)
+	while (!m_CaptureStop)
 	{
-		std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
-		std::cerr << "\t ... 'dc1394_capture_dequeue' failed." << std::endl;
-		std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
-		return RET_FAILED;
+		// Wait for the next frame, but check for termination regularly
+		FGFRAME frame;
+		if (m_cam.GetFrame(&frame, 100) != FCE_NOERROR)
+		{
+			continue;
+		}
+		double timestamp = (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()*1e-6;
+
+		// Drain the ring buffer, older frames are returned immediately
+		FGFRAME nextFrame;
+		while (m_cam.GetFrame(&nextFrame, 0) == FCE_NOERROR)
+		{
+			m_cam.PutFrame(&frame);
+			frame = nextFrame;
+			timestamp = (boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()*1e-6;
+		}
+
+		PublishFrame(frame.pData, frame.Length, timestamp);
+		m_cam.PutFrame(&frame);
 	}
-	unsigned char * src = (unsigned char *)m_Frame->image;
-	unsigned char * dst = (unsigned char *)colorImageData;
+#endif
 
-	// Convert RGB to BGR
-	int width;
-	int height;
-	ipa_CameraSensors::t_cameraProperty cameraProperty;
-	cameraProperty.propertyID = PROP_CAMERA_RESOLUTION;
-	if (GetProperty(&cameraProperty) & RET_FAILED) return RET_FAILED;
-	width = cameraProperty.cameraResolution.xResolution;
-	height = cameraProperty.cameraResolution.yResolution;
+	// Wake up waiting readers
+	{
+		boost::mutex::scoped_lock lock(m_FrameMutex);
+	}
+	m_FrameCondition.notify_all();
+}
 
-	for (int i=0;i<width*height*3;i+=6)
+void AVTPikeCam::PublishFrame(const unsigned char* src, size_t srcBytes, double timestamp)
+{
+	t_CapturedFrame& frame = m_CapturedFrames[m_WriteFrame];
+	frame.m_Image.resize(3*(size_t)m_ImageWidth*m_ImageHeight);
+	if (frame.m_Image.empty() || (ConvertFrame(src, srcBytes, &frame.m_Image[0]) & RET_FAILED))
 	{
-		dst[i]   = src[i+2];
-		dst[i+1] = src[i+1];
-		dst[i+2] = src[i];
-		dst[i+3] = src[i+5];
-		dst[i+4] = src[i+4];
-		dst[i+5] = src[i+3];
+		return;
 	}
+	frame.m_Timestamp = timestamp;
+	frame.m_FrameNumber = ++m_CapturedFrameCount;
 
-	return RET_OK;
+	// Lock-free hand over, the previous latest frame becomes the next write buffer
+	m_WriteFrame = m_LatestFrame.exchange(m_WriteFrame | FRAME_NEW) & FRAME_INDEX_MASK;
 
-#else
+	// Taking the mutex guarantees, that a reader is either waiting or sees the new frame
+	{
+		boost::mutex::scoped_lock lock(m_FrameMutex);
+	}
+	m_FrameCondition.notify_all();
+}
 
-	UINT32 err;
+unsigned long AVTPikeCam::UpdateImageFormat()
+{
+#ifdef __LINUX__
+	dc1394error_t err;
+	dc1394video_mode_t videoMode;
+	err=dc1394_video_get_mode(m_cam, &videoMode);
+	if (err!=DC1394_SUCCESS)
+	{
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Failed to get video mode." << std::endl;
+		std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
+		return RET_FAILED;
+	}
 
-	// Release previously acquired m_Frame
-	if (m_Frame.pData != 0)
+	uint32_t imageWidth = 0;
+	uint32_t imageHeight = 0;
+	err = dc1394_get_image_size_from_video_mode(m_cam, videoMode, &imageWidth, &imageHeight);
+	if (err!=DC1394_SUCCESS)
 	{
-		// Return m_Frame to module
-		err=m_cam.PutFrame(&m_Frame);
-		if(err!=FCE_NOERROR)
-		{
-			std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
-			std::cerr << "\t ... Could not release image buffer ( error " << err << " )" << std::endl;
-			return RET_FAILED;
-		}
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Failed to get image size." << std::endl;
+		std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
+		return RET_FAILED;
 	}
 
-	if (getLatestFrame)
+	dc1394color_coding_t colorCoding;
+	err = dc1394_get_color_coding_from_video_mode(m_cam, videoMode, &colorCoding);
+	if (err!=DC1394_SUCCESS)
 	{
-		// One shot mode
-		// Reset image buffer to guarantee, that the latest images are returned
-		err = m_cam.DiscardFrames();
-		if(err!=FCE_NOERROR)
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Failed to get color coding." << std::endl;
+		std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
+		return RET_FAILED;
+	}
+
+	m_RawBayer = (colorCoding == DC1394_COLOR_CODING_RAW8);
+	if (m_RawBayer)
+	{
+		dc1394color_filter_t colorFilter;
+		err = dc1394_format7_get_color_filter(m_cam, videoMode, &colorFilter);
+		if (err!=DC1394_SUCCESS)
 		{
-			std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
-			std::cerr << "\t ... Could not reset image buffers ( error " << err << " )" << std::endl;
+			std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+			std::cerr << "\t ... Failed to get color filter." << std::endl;
+			std::cerr << "\t ... " << dc1394_error_get_string(err) << std::endl;
 			return RET_FAILED;
 		}
+		switch (colorFilter)
+		{
+			case DC1394_COLOR_FILTER_GBRG: m_BayerPattern = BAYER_GBRG; break;
+			case DC1394_COLOR_FILTER_GRBG: m_BayerPattern = BAYER_GRBG; break;
+			case DC1394_COLOR_FILTER_BGGR: m_BayerPattern = BAYER_BGGR; break;
+			default: m_BayerPattern = BAYER_RGGB; break;
+		}
+	}
+	else if (colorCoding != DC1394_COLOR_CODING_RGB8)
+	{
+		std::cout << "WARNING - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cout << "\t ... Only the color modes COLOR_RGB8 and COLOR_RAW8 are converted" << std::endl;
 	}
 
+	m_ImageWidth = (int) imageWidth;
+	m_ImageHeight = (int) imageHeight;
+#else
+	UINT32 err;
+	UINT32 x;
+	UINT32 y;
+	UINT32 imageFormat;
 
-	// Blocking-Wait for the next m_Frame
-	err = m_cam.GetFrame(&m_Frame);
+	err = m_cam.GetParameter(FGP_XSIZE, &x);
 	if(err!=FCE_NOERROR)
 	{
-		std::cerr << "AVTPikeCam::GetColorImage:" << std::endl;
-		std::cerr << "\t ... Could not acquire image ( error " << err << " )" << std::endl;
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Could not read image width ( error " << err << " )" << std::endl;
 		return RET_FAILED;
 	}
-
-	unsigned char * src = (unsigned char *)m_Frame.pData;
-	unsigned char * dst = (unsigned char *)colorImageData;
-
-	// Convert RGB to BGR
-	int width;
-	int height;
-	ipa_CameraSensors::t_cameraProperty cameraProperty;
-	cameraProperty.propertyID = PROP_CAMERA_RESOLUTION;
-	if (GetProperty(&cameraProperty) & RET_FAILED) return RET_FAILED;
-	width = cameraProperty.cameraResolution.xResolution;
-	height = cameraProperty.cameraResolution.yResolution;
-
-	for (int i=0; i<width*height*3; i+=6)
+	err = m_cam.GetParameter(FGP_YSIZE, &y);
+	if(err!=FCE_NOERROR)
 	{
-		dst[i]   = src[i+2];
-		dst[i+1] = src[i+1];
-		dst[i+2] = src[i];
-		dst[i+3] = src[i+5];
-		dst[i+4] = src[i+4];
-		dst[i+5] = src[i+3];
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Could not read image height ( error " << err << " )" << std::endl;
+		return RET_FAILED;
 	}
-
-	return RET_OK;
-
-#endif
-}
-
-unsigned long AVTPikeCam::GetColorImage(cv::Mat* colorImage, bool getLatestFrame)
-{
-	if (!isOpen())
+	err = m_cam.GetParameter(FGP_IMAGEFORMAT, &imageFormat);
+	if(err!=FCE_NOERROR)
 	{
-		std::cerr << "ERROR - AVTPikeCam::GetColorImage:" << std::endl;
-		std::cerr << "\t ... Color camera not open." << std::endl;
-		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
+		std::cerr << "ERROR - AVTPikeCam::UpdateImageFormat:" << std::endl;
+		std::cerr << "\t ... Could not read image format ( error " << err << " )" << std::endl;
+		return RET_FAILED;
 	}
 
-	CV_Assert(colorImage != 0);
-
-	int width;
-	int height;
-	ipa_CameraSensors::t_cameraProperty cameraProperty;
-	cameraProperty.propertyID = PROP_CAMERA_RESOLUTION;
-	if (GetProperty(&cameraProperty) & RET_FAILED) return RET_FAILED;
-	width = cameraProperty.cameraResolution.xResolution;
-	height = cameraProperty.cameraResolution.yResolution;
+	// FireGrab does not report the color filter, RGGB is assumed
+	m_RawBayer = (IMGCOL(imageFormat) == CM_RAW8);
+	m_BayerPattern = BAYER_RGGB;
 
-	// Create color image, if necessary
-	colorImage->create(height, width, CV_8UC3);
-	return GetColorImage(colorImage->ptr<char>(0), getLatestFrame);
+	m_ImageWidth = (int) x;
+	m_ImageHeight = (int) y;
+#endif
+	return RET_OK;
 }
 
 unsigned long AVTPikeCam::PrintCameraInformation()
@@ -2700,6 +2905,14 @@ unsigned long AVTPikeCam::SetProperty(t_cameraProperty* cameraProperty)
 			break;
 	}
 
+	// Keep the cached image format up to date. While opening, Open reads it after
+	// all parameters have been set.
+	if (isOpen() &&
+		(cameraProperty->propertyID == PROP_VIDEO_ALL || cameraProperty->propertyID == PROP_RESOLUTION))
+	{
+		return UpdateImageFormat();
+	}
+
 	return RET_OK;
 }
 
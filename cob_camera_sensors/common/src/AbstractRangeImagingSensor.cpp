@@ -38,6 +38,69 @@ unsigned long AbstractRangeImagingSensor::SetIntrinsics(cv::Mat& intrinsicMatrix
 	m_undistortMapX = undistortMapX.clone();
 	m_undistortMapY = undistortMapY.clone();
 
+	// Remap and ray tables for the row kernels of AcquireImages
+	cv::Mat mapX = m_undistortMapX;
+	cv::Mat mapY = m_undistortMapY;
+	if (!mapX.empty() && mapX.type() != CV_32FC1)
+	{
+		cv::convertMaps(m_undistortMapX, m_undistortMapY, mapX, mapY, CV_32FC1);
+	}
+
+	// The image size is taken from the sensor, the undistortion map is optional
+	int width = mapX.cols;
+	int height = mapX.rows;
+	t_cameraProperty cameraProperty;
+	cameraProperty.propertyID = PROP_CAMERA_RESOLUTION;
+	if (!(GetProperty(&cameraProperty) & RET_FAILED))
+	{
+		width = cameraProperty.cameraResolution.xResolution;
+		height = cameraProperty.cameraResolution.yResolution;
+	}
+
+	m_Calibration.ClearUndistortMap();
+	if (!mapX.empty() && (mapX.cols != width || mapX.rows != height || !m_Calibration.SetUndistortMap(width, height,
+		mapX.ptr<float>(0), mapX.step, mapY.ptr<float>(0), mapY.step)))
+	{
+		std::cerr << "WARNING - AbstractRangeImagingSensor::SetIntrinsics:" << std::endl;
+		std::cerr << "\t ... Undistortion map doesn't match the image size, images are not undistorted." << std::endl;
+	}
+
+	if (m_intrinsicMatrix.empty() || !m_Calibration.SetIntrinsics(width, height,
+		m_intrinsicMatrix.at<double>(0, 0), m_intrinsicMatrix.at<double>(1, 1),
+		m_intrinsicMatrix.at<double>(0, 2), m_intrinsicMatrix.at<double>(1, 2)))
+	{
+		std::cerr << "ERROR - AbstractRangeImagingSensor::SetIntrinsics:" << std::endl;
+		std::cerr << "\t ... Invalid intrinsics (fx or fy is 0) or unknown image size." << std::endl;
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+unsigned long AbstractRangeImagingSensor::SetCalibrationCoefficients(const cv::Mat* coeffs)
+{
+	const double* data[ToFCalibration::NUM_COEFFS];
+	size_t steps[ToFCalibration::NUM_COEFFS];
+
+	for (int k=0; k<ToFCalibration::NUM_COEFFS; k++)
+	{
+		if (coeffs[k].type() != CV_64FC1 || coeffs[k].size() != coeffs[0].size())
+		{
+			std::cerr << "ERROR - AbstractRangeImagingSensor::SetCalibrationCoefficients:" << std::endl;
+			std::cerr << "\t ... Coefficients a" << k << " are not a double matrix of the size of a0." << std::endl;
+			return RET_FAILED;
+		}
+		data[k] = coeffs[k].ptr<double>(0);
+		steps[k] = coeffs[k].step;
+	}
+
+	if (!m_Calibration.SetCoefficients(coeffs[0].cols, coeffs[0].rows, data, steps))
+	{
+		std::cerr << "ERROR - AbstractRangeImagingSensor::SetCalibrationCoefficients:" << std::endl;
+		std::cerr << "\t ... Invalid coefficient matrices." << std::endl;
+		return RET_FAILED;
+	}
+
 	return RET_OK;
 }
 
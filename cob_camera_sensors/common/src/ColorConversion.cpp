@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSSE3__)
+	#include <tmmintrin.h>
+#endif
+
+#ifdef __LINUX__
+#include "cob_camera_sensors/ColorConversion.h"
+#else
+#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/ColorConversion.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+void ipa_CameraSensors::SwapRedBlue(const unsigned char* src, unsigned char* dst, size_t pixels)
+{
+	size_t bytes = 3*pixels;
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	// 8 pixels per iteration: the dwords are spread so that every lane holds 4 complete
+	// pixels, swapped within the lanes and packed again. The last 8 bytes of each store
+	// are garbage and get overwritten by the next iteration or the scalar tail.
+	const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+	const __m256i swap = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1,
+		2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1);
+	const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+	for (; i+32 <= bytes; i+=24)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+		v = _mm256_permutevar8x32_epi32(v, spread);
+		v = _mm256_shuffle_epi8(v, swap);
+		v = _mm256_permutevar8x32_epi32(v, pack);
+		_mm256_storeu_si256((__m256i*)(dst + i), v);
+	}
+#elif defined(__SSSE3__)
+	// 5 pixels per iteration, the 16th byte of each store gets overwritten by the
+	// next iteration or the scalar tail
+	const __m128i swap = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+	for (; i+16 <= bytes; i+=15)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_shuffle_epi8(v, swap));
+	}
+#endif
+
+	for (; i<bytes; i+=3)
+	{
+		dst[i]   = src[i+2];
+		dst[i+1] = src[i+1];
+		dst[i+2] = src[i];
+	}
+}
+
+void ipa_CameraSensors::DebayerRows(const unsigned char* src, unsigned char* dst, int width, int height,
+	t_BayerPattern pattern, bool bgr, int rowBegin, int rowEnd)
+{
+	// Colors of the 2x2 cells of the patterns: 0 = red, 1 = green, 2 = blue
+	static const int cellColors[4][4] = {{0, 1, 1, 2}, {1, 2, 0, 1}, {1, 0, 2, 1}, {2, 1, 1, 0}};
+	const int* cell = cellColors[pattern];
+	int iRed = bgr ? 2 : 0;
+	int iBlue = bgr ? 0 : 2;
+
+	for (int y=rowBegin; y<rowEnd; y++)
+	{
+		// Mirroring keeps the color of the neighbours at the borders
+		const unsigned char* up = src + (y > 0 ? y-1 : 1)*width;
+		const unsigned char* mid = src + y*width;
+		const unsigned char* down = src + (y < height-1 ? y+1 : height-2)*width;
+		const int* rowColors = cell + 2*(y & 1);
+		unsigned char* out = dst + 3*y*width;
+
+		for (int x=0; x<width; x++)
+		{
+			int l = x > 0 ? x-1 : 1;
+			int r = x < width-1 ? x+1 : width-2;
+			int color = rowColors[x & 1];
+			unsigned char* p = out + 3*x;
+
+			if (color == 1)
+			{
+				// Green pixel, red and blue are either the horizontal or the vertical neighbours
+				unsigned char horizontal = (unsigned char)((mid[l] + mid[r] + 1) >> 1);
+				unsigned char vertical = (unsigned char)((up[x] + down[x] + 1) >> 1);
+				bool redRow = rowColors[(x+1) & 1] == 0;
+				p[1] = mid[x];
+				p[iRed] = redRow ? horizontal : vertical;
+				p[iBlue] = redRow ? vertical : horizontal;
+			}
+			else
+			{
+				// Red or blue pixel, green is cross-wise, the opposite color diagonal
+				unsigned char cross = (unsigned char)((up[x] + down[x] + mid[l] + mid[r] + 2) >> 2);
+				unsigned char diagonal = (unsigned char)((up[l] + up[r] + down[l] + down[r] + 2) >> 2);
+				p[1] = cross;
+				p[color == 0 ? iRed : iBlue] = mid[x];
+				p[color == 0 ? iBlue : iRed] = diagonal;
+			}
+		}
+	}
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifdef __LINUX__
+#include "cob_camera_sensors/FramePrefetcher.h"
+#include "cob_vision_utils/VisionUtils.h"
+#else
+#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/FramePrefetcher.h"
+#include "cob_common/cob_vision_utils/common/include/cob_vision_utils/VisionUtils.h"
+#endif
+
+#include <algorithm>
+#include <iostream>
+
+#include <opencv/highgui.h>
+#include <boost/bind.hpp>
+
+using namespace ipa_CameraSensors;
+
+FramePrefetcher::FramePrefetcher()
+{
+	m_NumberOfFrames = 0;
+	m_Stop = false;
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+	Stop();
+}
+
+void FramePrefetcher::Start(const t_Loader& loader, int numberOfFrames, int depth)
+{
+	Stop();
+
+	m_Loader = loader;
+	m_NumberOfFrames = numberOfFrames;
+	m_Slots.resize(std::max(1, std::min(depth, numberOfFrames)));
+	for (unsigned int i=0; i<m_Slots.size(); i++)
+	{
+		m_Slots[i].m_Frame = -1;
+		m_Slots[i].m_State = SLOT_EMPTY;
+	}
+	m_Stop = false;
+	m_Thread = boost::thread(boost::bind(&FramePrefetcher::Run, this));
+}
+
+void FramePrefetcher::Stop()
+{
+	if (!m_Thread.joinable())
+	{
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_QueueCondition.notify_all();
+	m_Thread.join();
+
+	m_Queue.clear();
+	m_Slots.clear();
+}
+
+void FramePrefetcher::Schedule(int frame, bool urgent)
+{
+	t_Slot& slot = m_Slots[frame % m_Slots.size()];
+	if (slot.m_State == SLOT_LOADING || (slot.m_Frame == frame && slot.m_State != SLOT_QUEUED))
+	{
+		return;
+	}
+
+	if (slot.m_Frame != frame || slot.m_State != SLOT_QUEUED)
+	{
+		slot.m_Frame = frame;
+		slot.m_State = SLOT_QUEUED;
+		slot.m_Images.clear();
+	}
+	else if (!urgent)
+	{
+		// Already queued
+		return;
+	}
+
+	if (urgent) m_Queue.push_front(frame);
+	else m_Queue.push_back(frame);
+	m_QueueCondition.notify_one();
+}
+
+bool FramePrefetcher::GetFrame(int frame, std::vector<cv::Mat>& images)
+{
+	images.clear();
+	if (!m_Thread.joinable() || frame < 0 || frame >= m_NumberOfFrames)
+	{
+		return false;
+	}
+
+	boost::mutex::scoped_lock lock(m_Mutex);
+
+	// A miss (first frame or a jump) moves the frame to the front of the queue
+	t_Slot& slot = m_Slots[frame % m_Slots.size()];
+	while (slot.m_Frame != frame || slot.m_State == SLOT_QUEUED || slot.m_State == SLOT_LOADING)
+	{
+		if (slot.m_State != SLOT_LOADING)
+		{
+			Schedule(frame, true);
+		}
+		m_SlotCondition.wait(lock);
+	}
+
+	bool ok = slot.m_State == SLOT_READY;
+	images = slot.m_Images;
+
+	for (int i=1; i<(int)m_Slots.size(); i++)
+	{
+		int next = (frame + i) % m_NumberOfFrames;
+		if (next % m_Slots.size() == frame % m_Slots.size())
+		{
+			// Wrapped around onto the current slot
+			break;
+		}
+		Schedule(next, false);
+	}
+
+	return ok;
+}
+
+void FramePrefetcher::Run()
+{
+	boost::mutex::scoped_lock lock(m_Mutex);
+	while (true)
+	{
+		while (m_Queue.empty() && !m_Stop)
+		{
+			m_QueueCondition.wait(lock);
+		}
+		if (m_Stop)
+		{
+			break;
+		}
+
+		int frame = m_Queue.front();
+		m_Queue.pop_front();
+		t_Slot& slot = m_Slots[frame % m_Slots.size()];
+		if (slot.m_Frame != frame || slot.m_State != SLOT_QUEUED)
+		{
+			continue;
+		}
+		slot.m_State = SLOT_LOADING;
+
+		// Readers keep shallow copies of the old images, so load into fresh matrices
+		std::vector<cv::Mat> images;
+		lock.unlock();
+		bool ok = m_Loader(frame, images);
+		lock.lock();
+
+		slot.m_Images.swap(images);
+		slot.m_State = ok ? SLOT_READY : SLOT_FAILED;
+		m_SlotCondition.notify_all();
+	}
+}
+
+bool FramePrefetcher::LoadImageFile(const std::string& filename, cv::Mat& image, int imreadFlags)
+{
+	std::string ext = filename.size() >= 4 ? filename.substr(filename.size() - 4) : "";
+	if (ext == ".bin")
+	{
+		if (ipa_Utils::LoadMat(image, filename) & ipa_Utils::RET_FAILED)
+		{
+			image.release();
+		}
+	}
+	else if (ext == ".xml")
+	{
+		IplImage* iplImage = (IplImage*) cvLoad(filename.c_str(), 0);
+		if (iplImage)
+		{
+			image = cv::Mat(iplImage).clone();
+			cvReleaseImage(&iplImage);
+		}
+		else
+		{
+			image.release();
+		}
+	}
+	else
+	{
+		image = cv::imread(filename, imreadFlags);
+	}
+
+	if (image.empty())
+	{
+		std::cerr << "ERROR - FramePrefetcher::LoadImageFile:" << std::endl;
+		std::cerr << "\t ... Could not load '" << filename << "'" << std::endl;
+		return false;
+	}
+	return true;
+}
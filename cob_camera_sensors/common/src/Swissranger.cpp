@@ -217,6 +217,16 @@ unsigned long Swissranger::Init(std::string directory, int cameraIndex)
 			m_CoeffsA6 = c_mat;
 			cvReleaseMat(&c_mat);
 		}
+
+		if (m_CoeffsInitialized)
+		{
+			cv::Mat coeffs[ToFCalibration::NUM_COEFFS] = {m_CoeffsA0, m_CoeffsA1, m_CoeffsA2,
+				m_CoeffsA3, m_CoeffsA4, m_CoeffsA5, m_CoeffsA6};
+			if (SetCalibrationCoefficients(coeffs) & RET_FAILED)
+			{
+				m_CoeffsInitialized = false;
+			}
+		}
 	}
 
 	// set init flag
@@ -725,25 +735,29 @@ unsigned long Swissranger::AcquireImages(int widthStepRange, int widthStepGray,
 		int imageStep = -1;
 		float* f_ptr = 0;
 
-		// put data in corresponding IPLImage structures
-		for(unsigned int row=0; row<(unsigned int)height; row++)
+		if (undistort)
 		{
-			imageStep = row*width;
-			f_ptr = (float*)(rangeImageData + row*widthStepRange);
-
-			for (unsigned int col=0; col<(unsigned int)width; col++)
+			// Remap directly from the camera buffer
+			assert (m_Calibration.HasUndistortMap());
+			for(unsigned int row=0; row<(unsigned int)height; row++)
 			{
-				f_ptr[col] = (float)(pixels[imageStep + col]);
+				f_ptr = (float*)(rangeImageData + row*widthStepRange);
+				m_Calibration.UndistortRow(row, pixels, f_ptr);
 			}
 		}
-
-		if (undistort)
+		else
 		{
-			cv::Mat undistortedData(height, width, CV_32FC(1), (float*) rangeImageData);
-			cv::Mat distortedData;
+			// put data in corresponding IPLImage structures
+			for(unsigned int row=0; row<(unsigned int)height; row++)
+			{
+				imageStep = row*width;
+				f_ptr = (float*)(rangeImageData + row*widthStepRange);
 
-			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+				for (unsigned int col=0; col<(unsigned int)width; col++)
+				{
+					f_ptr[col] = (float)(pixels[imageStep + col]);
+				}
+			}
 		}
 
 	} // End if (rangeImage)
@@ -767,24 +781,28 @@ unsigned long Swissranger::AcquireImages(int widthStepRange, int widthStepGray,
 		int imageStep = 0;
 		float* f_ptr = 0;
 
-		for(unsigned int row=0; row<(unsigned int)height-1; row++)
+		if (undistort)
 		{
-			imageStep = imageSize+row*width;
-			f_ptr = (float*)(grayImageData + row*widthStepGray);
-
-			for (unsigned int col=0; col<(unsigned int)width-1; col++)
+			// Remap directly from the camera buffer
+			assert (m_Calibration.HasUndistortMap());
+			for(unsigned int row=0; row<(unsigned int)height; row++)
 			{
-				f_ptr[col] = (float)(pixels[imageStep+col]);
+				f_ptr = (float*)(grayImageData + row*widthStepGray);
+				m_Calibration.UndistortRow(row, pixels + imageSize, f_ptr);
 			}
 		}
-
-		if (undistort)
+		else
 		{
-			cv::Mat undistortedData( height, width, CV_32FC1, (float*) grayImageData);
-			cv::Mat distortedData;
+			for(unsigned int row=0; row<(unsigned int)height; row++)
+			{
+				imageStep = imageSize+row*width;
+				f_ptr = (float*)(grayImageData + row*widthStepGray);
 
-			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+				for (unsigned int col=0; col<(unsigned int)width; col++)
+				{
+					f_ptr[col] = (float)(pixels[imageStep+col]);
+				}
+			}
 		}
 
 	}
@@ -796,64 +814,32 @@ unsigned long Swissranger::AcquireImages(int widthStepRange, int widthStepGray,
 	{
 		float x = -1;
 		float y = -1;
-		float zRaw = -1;
-		float* zCalibratedPtr = 0;
 		float zCalibrated = -1;
 		float* f_ptr = 0;
 
+		if (m_CalibrationMethod==MATLAB || m_CalibrationMethod==MATLAB_NO_Z)
+		{
+			if (!m_Calibration.HasIntrinsics() || m_Calibration.GetWidth() != width || m_Calibration.GetHeight() != height)
+			{
+				std::cerr << "ERROR - Swissranger::AcquireImages: \n";
+				std::cerr << "\t ... Intrinsics not set or not matching the image size.\n";
+				return RET_FAILED;
+			}
+		}
+
 		if(m_CalibrationMethod==MATLAB)
 		{
-			if (m_CoeffsInitialized)
+			if (m_CoeffsInitialized && m_Calibration.GetCoeffsWidth() == width && m_Calibration.GetCoeffsHeight() == height)
 			{
 				// Calculate calibrated z values (in meter) based on 6 degree polynomial approximation
-				cv::Mat distortedData( height, width, CV_32FC1 );
-				for(unsigned int row=0; row<(unsigned int)height; row++)
-				{
-					f_ptr = distortedData.ptr<float>(row);
-					for (unsigned int col=0; col<(unsigned int)width; col++)
-					{
-						zRaw = (float)(pixels[width*row + col]);
-						GetCalibratedZMatlab(col, row, zRaw, zCalibrated);
-						f_ptr[col] = zCalibrated;
-					}
-				}
-				/*IplImage dummy;
-				IplImage *z = cvGetImage(distortedData, &dummy);
-				IplImage *image = cvCreateImage(cvGetSize(z), IPL_DEPTH_8U, 3);
-				ipa_Utils::ConvertToShowImage(z, image, 1);
-				cvNamedWindow("Z");
-				cvShowImage("Z", image);
-				cvWaitKey();
-				*/
-
-				// Undistort
-				cv::Mat undistortedData;
-	 			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-				cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
-
-				/*IplImage dummy;
-				IplImage* z = cvGetImage(undistortedData, &dummy);
-				IplImage* image = cvCreateImage(cvGetSize(z), IPL_DEPTH_8U, 3);
-				ipa_utils::ConvertToShowImage(z, image, 1);
-				cvNamedWindow("Z");
-				cvShowImage("Z", image);
-				cvWaitKey();*/
-
-				// Calculate X and Y based on instrinsic rotation and translation
+				m_CalibratedZ.resize(width*height);
+				m_Calibration.CalibrateZ(pixels, &m_CalibratedZ[0]);
+
+				// Undistort and calculate X and Y based on instrinsic rotation and translation
 				for(unsigned int row=0; row<(unsigned int)height; row++)
 				{
-					zCalibratedPtr = undistortedData.ptr<float>(row);
 					f_ptr = (float*)(cartesianImageData + row*widthStepCartesian);
-
-					for (unsigned int col=0; col<(unsigned int)width; col++)
-					{
-						int colTimes3 = 3*col;
-						GetCalibratedXYMatlab(col, row, zCalibratedPtr[col], x, y);
-
-						f_ptr[colTimes3] = x;
-						f_ptr[colTimes3 + 1] = y;
-						f_ptr[colTimes3 + 2] = zCalibratedPtr[col];
-					}
+					m_Calibration.ComputeCartesianRow(row, &m_CalibratedZ[0], f_ptr);
 				}
 			}
 			else
@@ -867,38 +853,12 @@ unsigned long Swissranger::AcquireImages(int widthStepRange, int widthStepGray,
 		else if(m_CalibrationMethod==MATLAB_NO_Z)
 		{
 			SR_CoordTrfFlt(m_SRCam, m_X, m_Y, m_Z, sizeof(float), sizeof(float), sizeof(float));
-			// Calculate calibrated z values (in meter) based on 6 degree polynomial approximation
-			cv::Mat distortedData( height, width, CV_32FC1 );
-			for(unsigned int row=0; row<(unsigned int)height; row++)
-			{
-				f_ptr = distortedData.ptr<float>(row);
-				for (unsigned int col=0; col<(unsigned int)width; col++)
-				{
-					GetCalibratedZSwissranger(col, row, width, zCalibrated);
-					f_ptr[col] = zCalibrated;
-				}
-			}
 
-			// Undistort
-			cv::Mat undistortedData;
- 			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(distortedData, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
-
-			// Calculate X and Y based on instrinsic rotation and translation
+			// Undistort z and calculate X and Y based on instrinsic rotation and translation
 			for(unsigned int row=0; row<(unsigned int)height; row++)
 			{
-				zCalibratedPtr = undistortedData.ptr<float>(row);
 				f_ptr = (float*)(cartesianImageData + row*widthStepCartesian);
-
-				for (unsigned int col=0; col<(unsigned int)width; col++)
-				{
-					int colTimes3 = 3*col;
-					GetCalibratedXYMatlab(col, row, zCalibratedPtr[col], x, y);
-
-					f_ptr[colTimes3] = x;
-					f_ptr[colTimes3 + 1] = y;
-					f_ptr[colTimes3 + 2] = zCalibratedPtr[col];
-				}
+				m_Calibration.ComputeCartesianRow(row, m_Z, f_ptr);
 			}
 		}
 		else if(m_CalibrationMethod==NATIVE)
@@ -940,11 +900,13 @@ unsigned long Swissranger::SaveParameters(const char* filename)
 unsigned long Swissranger::GetCalibratedZMatlab(int u, int v, float zRaw, float& zCalibrated)
 {
 
-	double c[7] = {m_CoeffsA0.at<double>(v,u), m_CoeffsA1.at<double>(v,u), m_CoeffsA2.at<double>(v,u),
-		m_CoeffsA3.at<double>(v,u), m_CoeffsA4.at<double>(v,u), m_CoeffsA5.at<double>(v,u), m_CoeffsA6.at<double>(v,u)};
-	double y = 0;
-	ipa_Utils::EvaluatePolynomial((double) zRaw, 6, &c[0], &y);
-	zCalibrated = (float) y;
+	if (!m_Calibration.HasCoefficients())
+	{
+		std::cerr << "ERROR - Swissranger::GetCalibratedZMatlab:" << std::endl;
+		std::cerr << "\t ... Coefficients not initialized.\n";
+		return RET_FAILED;
+	}
+	zCalibrated = m_Calibration.GetCalibratedZ(u, v, zRaw);
 
 	return RET_OK;
 }
@@ -960,39 +922,14 @@ unsigned long Swissranger::GetCalibratedZSwissranger(int u, int v, int width, fl
 // u and v are assumed to be distorted coordinates
 unsigned long Swissranger::GetCalibratedXYMatlab(int u, int v, float z, float& x, float& y)
 {
-	// Conversion form m to mm
-	z *= 1000;
-
-	// Use intrinsic camera parameters
-	double fx, fy, cx, cy;
-
-	fx = m_intrinsicMatrix.at<double>(0, 0);
-	fy = m_intrinsicMatrix.at<double>(1, 1);
-
-	cx = m_intrinsicMatrix.at<double>(0, 2);
-	cy = m_intrinsicMatrix.at<double>(1, 2);
-
-	// Fundamental equation: u = (fx*x)/z + cx
-	if (fx == 0)
+	// Ray tables are only built for valid intrinsics (fx and fy not 0)
+	if (!m_Calibration.HasIntrinsics())
 	{
 		std::cerr << "ERROR - Swissranger::GetCalibratedXYZ:" << std::endl;
-		std::cerr << "\t ... fx is 0.\n";
+		std::cerr << "\t ... Intrinsics not set or fx or fy is 0.\n";
 		return RET_FAILED;
 	}
-	x = (float) (z*(u-cx)/fx) ;
-
-	// Fundamental equation: v = (fy*y)/z + cy
-	if (fy == 0)
-	{
-		std::cerr << "ERROR - Swissranger::GetCalibratedXYZ:" << std::endl;
-		std::cerr << "\t ... fy is 0.\n";
-		return RET_FAILED;
-	}
-	y = (float) (z*(v-cy)/fy);
-
-	// Conversion from mm to m
-	x /= 1000;
-	y /= 1000;
+	m_Calibration.GetCalibratedXY(u, v, z, x, y);
 
 	return RET_OK;
 }
@@ -0,0 +1,367 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include <assert.h>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+#ifdef __LINUX__
+#include "cob_camera_sensors/ToFCalibration.h"
+#else
+#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/ToFCalibration.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+namespace
+{
+	/// Bilinear remap of one destination row with the precomputed offsets and weights.
+	template <typename T>
+	void RemapRow(int width, const int* offset, const float* weight, const T* src, float* dst)
+	{
+		for (int col=0; col<width; col++)
+		{
+			dst[col] = weight[0]*(float)src[offset[0]] + weight[1]*(float)src[offset[1]] +
+				weight[2]*(float)src[offset[2]] + weight[3]*(float)src[offset[3]];
+			offset += 4;
+			weight += 4;
+		}
+	}
+}
+
+ToFCalibration::ToFCalibration()
+{
+	m_CoeffsWidth = 0;
+	m_CoeffsHeight = 0;
+	m_ZRawScale = 1;
+	m_MapWidth = 0;
+	m_MapHeight = 0;
+}
+
+bool ToFCalibration::SetCoefficients(int width, int height, const double* const coeffs[NUM_COEFFS],
+	const size_t steps[NUM_COEFFS], double zRawMax)
+{
+	m_Coeffs.clear();
+	m_CoeffsWidth = 0;
+	m_CoeffsHeight = 0;
+
+	if (width <= 0 || height <= 0 || zRawMax <= 0)
+	{
+		return false;
+	}
+	for (int k=0; k<NUM_COEFFS; k++)
+	{
+		if (coeffs[k] == 0)
+		{
+			return false;
+		}
+	}
+
+	// p(zRaw) = sum a_k*zRaw^k = sum (a_k*zRawMax^k)*t^k with t = zRaw/zRawMax
+	double scale[NUM_COEFFS];
+	scale[0] = 1;
+	for (int k=1; k<NUM_COEFFS; k++)
+	{
+		scale[k] = scale[k-1]*zRawMax;
+	}
+
+	int numPixels = width*height;
+	int numBlocks = (numPixels + LANES - 1)/LANES;
+	m_Coeffs.assign(numBlocks*NUM_COEFFS*LANES, 0.f);
+
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			int i = row*width + col;
+			float* block = &m_Coeffs[(i/LANES)*NUM_COEFFS*LANES] + i%LANES;
+			for (int k=0; k<NUM_COEFFS; k++)
+			{
+				const double* c = (const double*)((const char*)coeffs[k] + row*steps[k]);
+				block[k*LANES] = (float)(c[col]*scale[k]);
+			}
+		}
+	}
+
+	m_CoeffsWidth = width;
+	m_CoeffsHeight = height;
+	m_ZRawScale = (float)(1.0/zRawMax);
+
+	return true;
+}
+
+bool ToFCalibration::SetIntrinsics(int width, int height, double fx, double fy, double cx, double cy)
+{
+	m_RayX.clear();
+	m_RayY.clear();
+
+	if (width <= 0 || height <= 0 || fx == 0 || fy == 0)
+	{
+		return false;
+	}
+
+	// Fundamental equations: u = (fx*x)/z + cx and v = (fy*y)/z + cy
+	m_RayX.resize(width);
+	for (int u=0; u<width; u++)
+	{
+		m_RayX[u] = (float)((u - cx)/fx);
+	}
+	m_RayY.resize(height);
+	for (int v=0; v<height; v++)
+	{
+		m_RayY[v] = (float)((v - cy)/fy);
+	}
+
+	return true;
+}
+
+bool ToFCalibration::SetUndistortMap(int width, int height, const float* mapX, size_t stepX, const float* mapY, size_t stepY)
+{
+	ClearUndistortMap();
+
+	if (width <= 0 || height <= 0 || mapX == 0 || mapY == 0)
+	{
+		return false;
+	}
+
+	m_RemapOffset.assign(4*width*height, 0);
+	m_RemapWeight.assign(4*width*height, 0.f);
+
+	for (int row=0; row<height; row++)
+	{
+		const float* mx = (const float*)((const char*)mapX + row*stepX);
+		const float* my = (const float*)((const char*)mapY + row*stepY);
+
+		for (int col=0; col<width; col++)
+		{
+			int* offset = &m_RemapOffset[4*(row*width + col)];
+			float* weight = &m_RemapWeight[4*(row*width + col)];
+			float sx = mx[col];
+			float sy = my[col];
+
+			// Also rejects NaN. Pixels without any neighbour inside the image stay 0.
+			if (!(sx > -1.f && sx < (float)width && sy > -1.f && sy < (float)height))
+			{
+				continue;
+			}
+
+			int x0 = (int)floorf(sx);
+			int y0 = (int)floorf(sy);
+			float ax = sx - x0;
+			float ay = sy - y0;
+			float w[4] = {(1-ax)*(1-ay), ax*(1-ay), (1-ax)*ay, ax*ay};
+
+			for (int n=0; n<4; n++)
+			{
+				int x = x0 + (n & 1);
+				int y = y0 + (n >> 1);
+				if (x >= 0 && x < width && y >= 0 && y < height)
+				{
+					offset[n] = y*width + x;
+					weight[n] = w[n];
+				}
+			}
+		}
+	}
+
+	m_MapWidth = width;
+	m_MapHeight = height;
+
+	return true;
+}
+
+void ToFCalibration::ClearUndistortMap()
+{
+	m_RemapOffset.clear();
+	m_RemapWeight.clear();
+	m_MapWidth = 0;
+	m_MapHeight = 0;
+}
+
+float ToFCalibration::GetCalibratedZ(int u, int v, float zRaw) const
+{
+	assert(HasCoefficients());
+
+	int i = v*m_CoeffsWidth + u;
+	const float* c = &m_Coeffs[(i/LANES)*NUM_COEFFS*LANES] + i%LANES;
+	float t = zRaw*m_ZRawScale;
+
+	// Horner scheme
+	float y = c[(NUM_COEFFS-1)*LANES];
+	for (int k=NUM_COEFFS-2; k>=0; k--)
+	{
+		y = y*t + c[k*LANES];
+	}
+	return y;
+}
+
+void ToFCalibration::CalibrateZRow(int row, const unsigned short* zRaw, float* z) const
+{
+	assert(HasCoefficients() && row >= 0 && row < m_CoeffsHeight);
+
+	CalibrateZRange(row*m_CoeffsWidth, (row+1)*m_CoeffsWidth, zRaw, z);
+}
+
+void ToFCalibration::CalibrateZ(const unsigned short* zRaw, float* z) const
+{
+	assert(HasCoefficients());
+
+	CalibrateZRange(0, m_CoeffsWidth*m_CoeffsHeight, zRaw, z);
+}
+
+void ToFCalibration::CalibrateZRange(int begin, int end, const unsigned short* zRaw, float* z) const
+{
+	// zRaw and z point to pixel begin
+	int i = begin;
+
+	// Leading pixels up to the next block
+	int headEnd = ((begin + LANES - 1)/LANES)*LANES;
+	if (headEnd > end)
+	{
+		headEnd = end;
+	}
+	CalibrateZScalar(i, headEnd, zRaw, z);
+	i = headEnd;
+
+#if defined(__AVX__)
+	const __m256 scale = _mm256_set1_ps(m_ZRawScale);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + LANES <= end; i += LANES)
+	{
+		const float* c = &m_Coeffs[(i/LANES)*NUM_COEFFS*LANES];
+		__m128i raw = _mm_loadu_si128((const __m128i*)(zRaw + (i - begin)));
+		__m256i raw32 = _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(raw, zero)),
+			_mm_unpackhi_epi16(raw, zero), 1);
+		__m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(raw32), scale);
+
+		__m256 y = _mm256_loadu_ps(c + (NUM_COEFFS-1)*LANES);
+		for (int k=NUM_COEFFS-2; k>=0; k--)
+		{
+			y = _mm256_add_ps(_mm256_mul_ps(y, t), _mm256_loadu_ps(c + k*LANES));
+		}
+		_mm256_storeu_ps(z + (i - begin), y);
+	}
+#elif defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(m_ZRawScale);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + LANES <= end; i += LANES)
+	{
+		const float* c = &m_Coeffs[(i/LANES)*NUM_COEFFS*LANES];
+		__m128i raw = _mm_loadu_si128((const __m128i*)(zRaw + (i - begin)));
+		__m128 tLo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero)), scale);
+		__m128 tHi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero)), scale);
+
+		__m128 yLo = _mm_loadu_ps(c + (NUM_COEFFS-1)*LANES);
+		__m128 yHi = _mm_loadu_ps(c + (NUM_COEFFS-1)*LANES + 4);
+		for (int k=NUM_COEFFS-2; k>=0; k--)
+		{
+			yLo = _mm_add_ps(_mm_mul_ps(yLo, tLo), _mm_loadu_ps(c + k*LANES));
+			yHi = _mm_add_ps(_mm_mul_ps(yHi, tHi), _mm_loadu_ps(c + k*LANES + 4));
+		}
+		_mm_storeu_ps(z + (i - begin), yLo);
+		_mm_storeu_ps(z + (i - begin) + 4, yHi);
+	}
+#else
+	for (; i + LANES <= end; i += LANES)
+	{
+		CalibrateZScalar(i, i + LANES, zRaw + (i - begin), z + (i - begin));
+	}
+#endif
+
+	// Remaining pixels of the last block
+	CalibrateZScalar(i, end, zRaw + (i - begin), z + (i - begin));
+}
+
+void ToFCalibration::CalibrateZScalar(int begin, int end, const unsigned short* zRaw, float* z) const
+{
+	for (int i=begin; i<end; i++)
+	{
+		const float* c = &m_Coeffs[(i/LANES)*NUM_COEFFS*LANES] + i%LANES;
+		float t = zRaw[i - begin]*m_ZRawScale;
+
+		float y = c[(NUM_COEFFS-1)*LANES];
+		for (int k=NUM_COEFFS-2; k>=0; k--)
+		{
+			y = y*t + c[k*LANES];
+		}
+		z[i - begin] = y;
+	}
+}
+
+void ToFCalibration::UndistortRow(int row, const float* src, float* dst) const
+{
+	if (!HasUndistortMap())
+	{
+		// No map, the image width is unknown
+		assert(false);
+		return;
+	}
+	RemapRow(m_MapWidth, &m_RemapOffset[4*row*m_MapWidth], &m_RemapWeight[4*row*m_MapWidth], src, dst);
+}
+
+void ToFCalibration::UndistortRow(int row, const unsigned short* src, float* dst) const
+{
+	if (!HasUndistortMap())
+	{
+		assert(false);
+		return;
+	}
+	RemapRow(m_MapWidth, &m_RemapOffset[4*row*m_MapWidth], &m_RemapWeight[4*row*m_MapWidth], src, dst);
+}
+
+void ToFCalibration::ComputeCartesianRow(int row, const float* z, float* xyz) const
+{
+	assert(HasIntrinsics());
+
+	int width = GetWidth();
+	float rayY = m_RayY[row];
+	const float* rayX = &m_RayX[0];
+
+	if (HasUndistortMap())
+	{
+		assert(m_MapWidth == width);
+		const int* offset = &m_RemapOffset[4*row*width];
+		const float* weight = &m_RemapWeight[4*row*width];
+		for (int col=0; col<width; col++)
+		{
+			float zUndistorted = weight[0]*z[offset[0]] + weight[1]*z[offset[1]] +
+				weight[2]*z[offset[2]] + weight[3]*z[offset[3]];
+			xyz[0] = zUndistorted*rayX[col];
+			xyz[1] = zUndistorted*rayY;
+			xyz[2] = zUndistorted;
+			offset += 4;
+			weight += 4;
+			xyz += 3;
+		}
+	}
+	else
+	{
+		const float* zRow = z + row*width;
+		for (int col=0; col<width; col++)
+		{
+			xyz[0] = zRow[col]*rayX[col];
+			xyz[1] = zRow[col]*rayY;
+			xyz[2] = zRow[col];
+			xyz += 3;
+		}
+	}
+}
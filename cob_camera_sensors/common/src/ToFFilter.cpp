@@ -0,0 +1,350 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+#ifdef __LINUX__
+#include "cob_camera_sensors/ToFFilter.h"
+#else
+#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/ToFFilter.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+ToFFilter::ToFFilter()
+{
+	m_Parameters.m_Stages = 0;
+	m_Parameters.m_LowerAmplitude = 0;
+	m_Parameters.m_UpperAmplitude = 0;
+	m_Parameters.m_TearOffPiFraction = 6;
+	m_Parameters.m_FlyingMaxDistance = 0.05f;
+	m_Parameters.m_FlyingMinNeighbours = 2;
+	m_Parameters.m_MedianLength = 3;
+	SetParameters(m_Parameters);
+
+	m_Width = 0;
+	m_Height = 0;
+	m_Xyz = 0;
+	m_XyzStep = 0;
+	m_Amplitude = 0;
+	m_AmplitudeStep = 0;
+
+	m_HistoryFrames = 0;
+	m_HistoryIndex = 0;
+
+	m_NumberOfThreads = 1;
+	m_Barrier.reset(new boost::barrier(1));
+	m_Generation = 0;
+	m_Stop = false;
+}
+
+ToFFilter::~ToFFilter()
+{
+	StopWorkers();
+}
+
+void ToFFilter::SetParameters(const t_Parameters& parameters)
+{
+	if (parameters.m_MedianLength != m_Parameters.m_MedianLength)
+	{
+		ResetHistory();
+	}
+	m_Parameters = parameters;
+	m_Parameters.m_MedianLength = std::max(1, std::min((int)MAX_MEDIAN_LENGTH, parameters.m_MedianLength));
+
+	// Fractions up to 2 would remove every point
+	if (m_Parameters.m_TearOffPiFraction <= 2)
+	{
+		m_Parameters.m_Stages &= ~STAGE_TEAR_OFF_EDGES;
+	}
+	float cosine = cosf(3.14159265f/std::max(m_Parameters.m_TearOffPiFraction, 2.0f));
+	m_TearOffCos2 = cosine*cosine;
+}
+
+void ToFFilter::SetNumberOfThreads(int threads)
+{
+	if (threads < 1)
+	{
+		threads = std::max(1, (int)boost::thread::hardware_concurrency());
+	}
+	if (threads == m_NumberOfThreads)
+	{
+		return;
+	}
+
+	StopWorkers();
+	m_NumberOfThreads = threads;
+	m_Barrier.reset(new boost::barrier(threads));
+	m_Workers.reset(new boost::thread_group());
+	for (int tile=1; tile<threads; tile++)
+	{
+		m_Workers->create_thread(boost::bind(&ToFFilter::WorkerThread, this, tile, m_Generation));
+	}
+}
+
+void ToFFilter::StopWorkers()
+{
+	{
+		boost::mutex::scoped_lock lock(m_WorkerMutex);
+		m_Stop = true;
+	}
+	m_WorkerCondition.notify_all();
+	if (m_Workers)
+	{
+		m_Workers->join_all();
+		m_Workers.reset();
+	}
+	m_Stop = false;
+}
+
+void ToFFilter::ResetHistory()
+{
+	m_History.clear();
+	m_HistoryFrames = 0;
+	m_HistoryIndex = 0;
+}
+
+void ToFFilter::Apply(int width, int height, float* xyz, size_t xyzStep, const float* amplitude, size_t amplitudeStep)
+{
+	if (width <= 0 || height <= 0 || xyz == 0)
+	{
+		return;
+	}
+	if ((m_Parameters.m_Stages & STAGE_AMPLITUDE) && amplitude == 0)
+	{
+		return;
+	}
+
+	if (width != m_Width || height != m_Height)
+	{
+		ResetHistory();
+	}
+	m_Width = width;
+	m_Height = height;
+	m_Xyz = xyz;
+	m_XyzStep = xyzStep;
+	m_Amplitude = amplitude;
+	m_AmplitudeStep = amplitudeStep;
+	m_Mask.resize((size_t)width*height);
+
+	if (m_Parameters.m_Stages & STAGE_TEMPORAL_MEDIAN)
+	{
+		size_t frameSize = 3*(size_t)width*height;
+		if (m_History.size() != m_Parameters.m_MedianLength*frameSize)
+		{
+			ResetHistory();
+			m_History.resize(m_Parameters.m_MedianLength*frameSize);
+		}
+		// The tiles store the current frame in slot m_HistoryIndex
+		m_HistoryFrames = std::min(m_HistoryFrames + 1, m_Parameters.m_MedianLength);
+	}
+
+	if (m_NumberOfThreads > 1)
+	{
+		boost::mutex::scoped_lock lock(m_WorkerMutex);
+		m_Generation++;
+		m_WorkerCondition.notify_all();
+	}
+	RunTile(0);
+
+	if (m_Parameters.m_Stages & STAGE_TEMPORAL_MEDIAN)
+	{
+		m_HistoryIndex = (m_HistoryIndex + 1) % m_Parameters.m_MedianLength;
+	}
+}
+
+void ToFFilter::WorkerThread(int tile, unsigned long generation)
+{
+	while (true)
+	{
+		{
+			boost::mutex::scoped_lock lock(m_WorkerMutex);
+			while (m_Generation == generation && !m_Stop)
+			{
+				m_WorkerCondition.wait(lock);
+			}
+			if (m_Stop)
+			{
+				return;
+			}
+			generation = m_Generation;
+		}
+		RunTile(tile);
+	}
+}
+
+void ToFFilter::RunTile(int tile)
+{
+	int rowBegin = (int)((long)tile*m_Height/m_NumberOfThreads);
+	int rowEnd = (int)((long)(tile + 1)*m_Height/m_NumberOfThreads);
+
+	if (m_Parameters.m_Stages & STAGE_TEMPORAL_MEDIAN)
+	{
+		MedianRows(rowBegin, rowEnd);
+		m_Barrier->wait();
+	}
+
+	if (m_Parameters.m_Stages & (STAGE_AMPLITUDE | STAGE_TEAR_OFF_EDGES | STAGE_FLYING_PIXELS))
+	{
+		MarkRows(rowBegin, rowEnd);
+		// The tests read the neighbouring rows of the other tiles
+		m_Barrier->wait();
+		RemoveRows(rowBegin, rowEnd);
+	}
+
+	// Apply returns, when all tiles are done
+	m_Barrier->wait();
+}
+
+void ToFFilter::MedianRows(int rowBegin, int rowEnd)
+{
+	size_t frameSize = 3*(size_t)m_Width*m_Height;
+	int frames = m_HistoryFrames;
+
+	for (int row=rowBegin; row<rowEnd; row++)
+	{
+		float* xyz = (float*)((char*)m_Xyz + row*m_XyzStep);
+		size_t rowOffset = 3*(size_t)row*m_Width;
+		memcpy(&m_History[m_HistoryIndex*frameSize + rowOffset], xyz, 3*m_Width*sizeof(float));
+
+		for (int col=0; col<m_Width; col++)
+		{
+			// Insertion sort of the history by z
+			float z[MAX_MEDIAN_LENGTH];
+			int index[MAX_MEDIAN_LENGTH];
+			for (int i=0; i<frames; i++)
+			{
+				float value = m_History[i*frameSize + rowOffset + 3*col + 2];
+				int j = i;
+				for (; j>0 && z[j-1] > value; j--)
+				{
+					z[j] = z[j-1];
+					index[j] = index[j-1];
+				}
+				z[j] = value;
+				index[j] = i;
+			}
+
+			// Keeps x and y consistent with z
+			const float* median = &m_History[index[(frames - 1)/2]*frameSize + rowOffset + 3*col];
+			xyz[3*col] = median[0];
+			xyz[3*col + 1] = median[1];
+			xyz[3*col + 2] = median[2];
+		}
+	}
+}
+
+void ToFFilter::MarkRows(int rowBegin, int rowEnd)
+{
+	bool amplitudeStage = (m_Parameters.m_Stages & STAGE_AMPLITUDE) != 0;
+	bool tearOffStage = (m_Parameters.m_Stages & STAGE_TEAR_OFF_EDGES) != 0;
+	bool flyingStage = (m_Parameters.m_Stages & STAGE_FLYING_PIXELS) != 0;
+	float lower = m_Parameters.m_LowerAmplitude;
+	float upper = m_Parameters.m_UpperAmplitude;
+	float cos2 = m_TearOffCos2;
+	float maxDistance2 = m_Parameters.m_FlyingMaxDistance*m_Parameters.m_FlyingMaxDistance;
+	int minNeighbours = m_Parameters.m_FlyingMinNeighbours;
+
+	for (int row=rowBegin; row<rowEnd; row++)
+	{
+		const float* rows[3];
+		rows[0] = row > 0 ? (const float*)((const char*)m_Xyz + (row - 1)*m_XyzStep) : 0;
+		rows[1] = (const float*)((const char*)m_Xyz + row*m_XyzStep);
+		rows[2] = row < m_Height - 1 ? (const float*)((const char*)m_Xyz + (row + 1)*m_XyzStep) : 0;
+		const float* amplitude = amplitudeStage ? (const float*)((const char*)m_Amplitude + row*m_AmplitudeStep) : 0;
+		unsigned char* mask = &m_Mask[(size_t)row*m_Width];
+
+		for (int col=0; col<m_Width; col++)
+		{
+			const float* p = rows[1] + 3*col;
+			bool remove = amplitudeStage && (amplitude[col] < lower || amplitude[col] > upper);
+
+			if (!remove && tearOffStage && p[2] != 0)
+			{
+				// |cos| of the angle between the view ray p and the vector to the neighbour
+				// above cos(pi/fraction) means the angle is below pi/fraction or above pi - pi/fraction
+				const float* neighbours[4] = {col > 0 ? p - 3 : 0, col < m_Width - 1 ? p + 3 : 0,
+					rows[0] ? rows[0] + 3*col : 0, rows[2] ? rows[2] + 3*col : 0};
+				float p2 = p[0]*p[0] + p[1]*p[1] + p[2]*p[2];
+				for (int n=0; n<4 && !remove; n++)
+				{
+					const float* q = neighbours[n];
+					if (q == 0 || q[2] == 0)
+					{
+						continue;
+					}
+					float vx = q[0] - p[0];
+					float vy = q[1] - p[1];
+					float vz = q[2] - p[2];
+					float dot = p[0]*vx + p[1]*vy + p[2]*vz;
+					remove = dot*dot > cos2*p2*(vx*vx + vy*vy + vz*vz);
+				}
+			}
+
+			if (!remove && flyingStage && p[2] != 0)
+			{
+				int close = 0;
+				int available = 0;
+				for (int r=0; r<3; r++)
+				{
+					if (rows[r] == 0)
+					{
+						continue;
+					}
+					for (int c=std::max(col - 1, 0); c<=std::min(col + 1, m_Width - 1); c++)
+					{
+						if (r == 1 && c == col)
+						{
+							continue;
+						}
+						const float* q = rows[r] + 3*c;
+						float dx = q[0] - p[0];
+						float dy = q[1] - p[1];
+						float dz = q[2] - p[2];
+						available++;
+						close += (q[2] != 0 && dx*dx + dy*dy + dz*dz <= maxDistance2) ? 1 : 0;
+					}
+				}
+				remove = close < std::min(minNeighbours, available);
+			}
+
+			mask[col] = remove ? 1 : 0;
+		}
+	}
+}
+
+void ToFFilter::RemoveRows(int rowBegin, int rowEnd)
+{
+	for (int row=rowBegin; row<rowEnd; row++)
+	{
+		float* xyz = (float*)((char*)m_Xyz + row*m_XyzStep);
+		const unsigned char* mask = &m_Mask[(size_t)row*m_Width];
+		for (int col=0; col<m_Width; col++)
+		{
+			if (mask[col])
+			{
+				xyz[3*col] = 0;
+				xyz[3*col + 1] = 0;
+				xyz[3*col + 2] = 0;
+			}
+		}
+	}
+}
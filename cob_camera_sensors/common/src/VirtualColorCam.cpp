@@ -27,6 +27,7 @@
 
 #include <opencv/highgui.h>
 #include <iostream>
+#include <boost/bind.hpp>
 
 namespace fs = boost::filesystem;
 using namespace ipa_CameraSensors;
@@ -105,6 +106,8 @@ unsigned long VirtualColorCam::Open()
 
 	m_ImageWidth = -1;
 	m_ImageHeight = -1;
+	m_ImageCounter = 0;
+	m_ColorImageFileNames.clear();
 
 	// Create absolute filename and check if directory exists
 	fs::path absoluteDirectoryName( m_CameraDataDirectory );
@@ -116,8 +119,25 @@ unsigned long VirtualColorCam::Open()
 	}
 
 	int colorImageCounter = 0;
+	// A packed recording replaces the image files
+	fs::path recordingFileName = absoluteDirectoryName / ("ColorCam_" + sCameraIndex + ".vrec");
+	if ( fs::exists( recordingFileName ) )
+	{
+		if (!m_Recording.Open(recordingFileName.string()) || !m_Recording.HasChannel(VirtualRecording::CHANNEL_COLOR_8U3))
+		{
+			std::cerr << "ERROR - VirtualColorCam::Open:" << std::endl;
+			std::cerr << "\t ... Could not open color recording '" << recordingFileName.string() << "'" << std::endl;
+			m_Recording.Close();
+			return (ipa_CameraSensors::RET_FAILED | ipa_CameraSensors::RET_FAILED_OPEN_FILE);
+		}
+		m_ImageWidth = m_Recording.GetWidth();
+		m_ImageHeight = m_Recording.GetHeight();
+		colorImageCounter = m_Recording.GetNumberOfFrames();
+		std::cout << "INFO - VirtualColorCam::Open:" << std::endl;
+		std::cout << "\t ... Mapped '" << colorImageCounter << "' color images from '" << recordingFileName.string() << "'" << std::endl;
+	}
 	// Extract all image filenames from the directory
-	if ( fs::is_directory( absoluteDirectoryName ) )
+	else if ( fs::is_directory( absoluteDirectoryName ) )
 	{
 		std::cout << "INFO - VirtualColorCam::Open:" << std::endl;
 		std::cout << "\t ... Parsing directory '" << absoluteDirectoryName.directory_string() << "'" << std::endl;;
@@ -174,9 +194,15 @@ unsigned long VirtualColorCam::Open()
 		std::cerr << "\t ... Could not detect any color images" << std::endl;
 		std::cerr << "\t ... from the specified directory. Check directory" << std::endl;
 		std::cerr << "\t ... and filenames (i.e. ColorCamRGB_8U3_*_*.jpg)." << std::endl;
+		m_Recording.Close();
 		return ipa_CameraSensors::RET_FAILED;
 	}
 
+	if (!m_Recording.IsOpen())
+	{
+		m_Prefetcher.Start(boost::bind(&VirtualColorCam::LoadImageFile, this, _1, _2), colorImageCounter);
+	}
+
 	std::cout << "*******************************************************" << std::endl;
 	std::cout << "VirtualColorCam::Open: Virtual color camera device OPEN" << std::endl;
 	std::cout << "*******************************************************" << std::endl << std::endl;
@@ -188,7 +214,17 @@ unsigned long VirtualColorCam::Open()
 
 int VirtualColorCam::GetNumberOfImages()
 {
-	return (int)std::min(0.0f, (float)m_ColorImageFileNames.size());
+	if (m_Recording.IsOpen())
+	{
+		return m_Recording.GetNumberOfFrames();
+	}
+	return (int)m_ColorImageFileNames.size();
+}
+
+bool VirtualColorCam::LoadImageFile(int frame, std::vector<cv::Mat>& images)
+{
+	images.resize(1);
+	return FramePrefetcher::LoadImageFile(m_ColorImageFileNames[frame], images[0], CV_LOAD_IMAGE_COLOR);
 }
 
 unsigned long VirtualColorCam::SaveParameters(const char* filename)
@@ -210,6 +246,9 @@ unsigned long VirtualColorCam::Close()
 		return RET_OK;
 	}
 
+	m_Prefetcher.Stop();
+	m_Recording.Close();
+
 	m_open = false;
 	return RET_OK;
 }
@@ -279,23 +318,38 @@ unsigned long VirtualColorCam::GetColorImage(char* colorImageData, bool getLates
 		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
 	}
 
-	IplImage* colorImage = (IplImage*) cvLoadImage(m_ColorImageFileNames[m_ImageCounter].c_str(), CV_LOAD_IMAGE_COLOR);
-
-	for(int row=0; row<m_ImageHeight; row++)
+	cv::Mat colorImage;
+	if (m_Recording.IsOpen())
 	{
-		for (int col=0; col<m_ImageWidth; col++)
+		colorImage = cv::Mat(m_ImageHeight, m_ImageWidth, CV_8UC3,
+			const_cast<void*>(m_Recording.GetImage(m_ImageCounter, VirtualRecording::CHANNEL_COLOR_8U3)));
+		m_Recording.Prefetch((m_ImageCounter + 1) % m_Recording.GetNumberOfFrames());
+	}
+	else
+	{
+		std::vector<cv::Mat> images;
+		if (m_Prefetcher.GetFrame(m_ImageCounter, images))
 		{
-			char* f_color_ptr = &((char*) (colorImage->imageData + row*colorImage->widthStep))[col*3];
-			((char*) (colorImageData + row*colorImage->widthStep))[col*3 + 0] = f_color_ptr[0];
-			((char*) (colorImageData + row*colorImage->widthStep))[col*3 + 1] = f_color_ptr[1];
-			((char*) (colorImageData + row*colorImage->widthStep))[col*3 + 2] = f_color_ptr[2];
+			colorImage = images[0];
 		}
 	}
 
-	cvReleaseImage(&colorImage);
+	if (colorImage.empty() || colorImage.rows != m_ImageHeight || colorImage.cols != m_ImageWidth || colorImage.type() != CV_8UC3)
+	{
+		std::cerr << "ERROR - VirtualColorCam::GetColorImage:" << std::endl;
+		std::cerr << "\t ... Could not load color image " << m_ImageCounter << " of size " << m_ImageWidth << "x" << m_ImageHeight << "." << std::endl;
+		return RET_FAILED;
+	}
+
+	// The destination is continuous
+	size_t rowSize = 3*m_ImageWidth;
+	for(int row=0; row<m_ImageHeight; row++)
+	{
+		memcpy(colorImageData + row*rowSize, colorImage.ptr(row), rowSize);
+	}
 
 	m_ImageCounter++;
-	if (m_ImageCounter >= m_ColorImageFileNames.size())
+	if (m_ImageCounter >= (unsigned int)GetNumberOfImages())
 	{
 		// Reset image counter
 		m_ImageCounter = 0;
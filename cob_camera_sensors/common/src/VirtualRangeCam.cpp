@@ -28,10 +28,39 @@
 #endif
 
 #include <opencv/highgui.h>
+#include <boost/bind.hpp>
 
 namespace fs = boost::filesystem;
 using namespace ipa_CameraSensors;
 
+namespace
+{
+	/// OpenCV type of the images of a channel.
+	int GetImageType(VirtualRecording::t_Channel channel)
+	{
+		switch (channel)
+		{
+			case VirtualRecording::CHANNEL_INTENSITY_8U3:
+			case VirtualRecording::CHANNEL_COLOR_8U3:
+				return CV_8UC3;
+			case VirtualRecording::CHANNEL_COORDINATE_32F3:
+				return CV_32FC3;
+			default:
+				return CV_32FC1;
+		}
+	}
+
+	/// Copies the rows of a continuous source image to a strided destination.
+	void CopyImage(const cv::Mat& src, char* dst, int dstStep)
+	{
+		size_t rowSize = src.cols*src.elemSize();
+		for (int row=0; row<src.rows; row++)
+		{
+			memcpy(dst + row*dstStep, src.ptr(row), rowSize);
+		}
+	}
+}
+
 __DLL_LIBCAMERASENSORS__ AbstractRangeImagingSensorPtr ipa_CameraSensors::CreateRangeImagingSensor_VirtualCam()
 {
 	return AbstractRangeImagingSensorPtr(new VirtualRangeCam());
@@ -45,6 +74,7 @@ VirtualRangeCam::VirtualRangeCam()
 	m_BufferSize = 1;
 
 	m_ImageCounter = 0;
+	m_PrefetchChannels = 0;
 }
 
 
@@ -191,6 +221,16 @@ unsigned long VirtualRangeCam::Init(std::string directory, int cameraIndex)
 			m_CoeffsA6 = c_mat;
 			cvReleaseMat(&c_mat);
 		}
+
+		if (m_CoeffsInitialized)
+		{
+			cv::Mat coeffs[ToFCalibration::NUM_COEFFS] = {m_CoeffsA0, m_CoeffsA1, m_CoeffsA2,
+				m_CoeffsA3, m_CoeffsA4, m_CoeffsA5, m_CoeffsA6};
+			if (SetCalibrationCoefficients(coeffs) & RET_FAILED)
+			{
+				m_CoeffsInitialized = false;
+			}
+		}
 	}
 
 	m_CameraIndex = cameraIndex;
@@ -259,6 +299,11 @@ unsigned long VirtualRangeCam::Open()
 
 	m_ImageWidth = -1;
 	m_ImageHeight = -1;
+	m_ImageCounter = 0;
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		m_ImageFileNames[channel].clear();
+	}
 
 	// Create absolute filename and check if directory exists
 	fs::path absoluteDirectoryName( m_CameraDataDirectory );
@@ -269,6 +314,9 @@ unsigned long VirtualRangeCam::Open()
 		return (ipa_CameraSensors::RET_FAILED | ipa_CameraSensors::RET_FAILED_OPEN_FILE);
 	}
 
+	// A packed recording replaces the image files
+	fs::path recordingFileName = absoluteDirectoryName / ("RangeCam_" + sCameraIndex + ".vrec");
+
 	std::vector<std::string> extensionList;
 	extensionList.push_back(".xml"); extensionList.push_back(".bin"); extensionList.push_back(".png"); extensionList.push_back(".jpg"); extensionList.push_back(".bmp");
 	std::map<std::string, int> amplitudeImageCounter;	// first index is the extension (.xml, .bin), second is the number of such images found
@@ -279,8 +327,15 @@ unsigned long VirtualRangeCam::Open()
 	std::map<std::string, std::vector<std::string> > intensityImageFileNames;	// first index is the extension (.xml, .bin, .png, .jpg, .bmp), second is the vector of file names
 	std::map<std::string, std::vector<std::string> > coordinateImageFileNames;	// first index is the extension (.xml, .bin), second is the vector of file names
 	std::map<std::string, std::vector<std::string> > rangeImageFileNames;		// first index is the extension (.xml, .bin), second is the vector of file names
+	if ( fs::exists( recordingFileName ) )
+	{
+		if (OpenRecording(recordingFileName.string()) & RET_FAILED)
+		{
+			return ipa_CameraSensors::RET_FAILED;
+		}
+	}
 	// Extract all image filenames from the directory
-	if ( fs::exists( absoluteDirectoryName ) )
+	else if ( fs::exists( absoluteDirectoryName ) )
 	{
 		std::cout << "INFO - VirtualRangeCam::Open   :" << std::endl;
 		std::cout << "\t ... Parsing directory '" << absoluteDirectoryName.directory_string() << "'" << std::endl;
@@ -355,31 +410,33 @@ unsigned long VirtualRangeCam::Open()
 				std::cout << "\t ... Exception catch of '" << ex.what() << "'" << std::endl;
 			}
 		}
-		// intensity
+		// intensity, .xml and .bin hold 32F1 images, all other formats 8U3 images
 		std::map<std::string, int>::iterator itCounter;
 		std::string extInt = "";
 		for (itCounter = intensityImageCounter.begin(); itCounter != intensityImageCounter.end(); itCounter++) FindSourceImageFormat(itCounter, extInt);
-		if (extInt != "") m_IntensityImageFileNames = intensityImageFileNames[extInt];
+		VirtualRecording::t_Channel intensityChannel = (extInt == ".xml" || extInt == ".bin") ?
+			VirtualRecording::CHANNEL_INTENSITY_32F1 : VirtualRecording::CHANNEL_INTENSITY_8U3;
+		if (extInt != "") m_ImageFileNames[intensityChannel] = intensityImageFileNames[extInt];
 
 		// amplitude
 		std::string extAmp = "";
 		for (itCounter = amplitudeImageCounter.begin(); itCounter != amplitudeImageCounter.end(); itCounter++) FindSourceImageFormat(itCounter, extAmp);
-		if (extAmp != "") m_AmplitudeImageFileNames = amplitudeImageFileNames[extAmp];
+		if (extAmp != "") m_ImageFileNames[VirtualRecording::CHANNEL_AMPLITUDE_32F1] = amplitudeImageFileNames[extAmp];
 
 		// coordinates
 		std::string extCoord = "";
 		for (itCounter = coordinateImageCounter.begin(); itCounter != coordinateImageCounter.end(); itCounter++) FindSourceImageFormat(itCounter, extCoord);
-		if (extCoord != "") m_CoordinateImageFileNames = coordinateImageFileNames[extCoord];
+		if (extCoord != "") m_ImageFileNames[VirtualRecording::CHANNEL_COORDINATE_32F3] = coordinateImageFileNames[extCoord];
 
 		// range
 		std::string extRange = "";
 		for (itCounter = rangeImageCounter.begin(); itCounter != rangeImageCounter.end(); itCounter++) FindSourceImageFormat(itCounter, extRange);
-		if (extRange != "") m_RangeImageFileNames = rangeImageFileNames[extRange];
+		if (extRange != "") m_ImageFileNames[VirtualRecording::CHANNEL_RANGE_32F1] = rangeImageFileNames[extRange];
 
-		std::sort(m_IntensityImageFileNames.begin(),m_IntensityImageFileNames.end());
-		std::sort(m_AmplitudeImageFileNames.begin(),m_AmplitudeImageFileNames.end());
-		std::sort(m_CoordinateImageFileNames.begin(),m_CoordinateImageFileNames.end());
-		std::sort(m_RangeImageFileNames.begin(),m_RangeImageFileNames.end());
+		for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+		{
+			std::sort(m_ImageFileNames[channel].begin(), m_ImageFileNames[channel].end());
+		}
 		std::cout << "INFO - VirtualRangeCam::Open:" << std::endl;
 		std::cout << "\t ... Extracted '" << intensityImageCounter[extInt] << "' intensity images (3*8 or 16 bit/value)\n";
 		std::cout << "\t ... Extracted '" << amplitudeImageCounter[extAmp] << "' amplitude images (16 bit/value)\n";
@@ -410,6 +467,9 @@ unsigned long VirtualRangeCam::Open()
 			std::cerr << "\t ... Coordinate images must be available for calibration mode NATIVE or MATLAB_NO_Z." << std::endl;
 			return ipa_CameraSensors::RET_FAILED;
 		}
+
+		m_PrefetchChannels = 0;
+		m_Prefetcher.Start(boost::bind(&VirtualRangeCam::LoadImageFiles, this, _1, _2), GetNumberOfImages());
 	}
 	else
 	{
@@ -435,12 +495,153 @@ unsigned long VirtualRangeCam::Close()
 		return (RET_OK);
 	}
 
+	m_Prefetcher.Stop();
+	m_Recording.Close();
+
 	m_open = false;
 	return RET_OK;
 
 }
 
 
+unsigned long VirtualRangeCam::OpenRecording(const std::string& filename)
+{
+	if (!m_Recording.Open(filename))
+	{
+		std::cerr << "ERROR - VirtualRangeCam::OpenRecording:" << std::endl;
+		std::cerr << "\t ... Could not open recording '" << filename << "'" << std::endl;
+		return (RET_FAILED | RET_FAILED_OPEN_FILE);
+	}
+
+	m_ImageWidth = m_Recording.GetWidth();
+	m_ImageHeight = m_Recording.GetHeight();
+
+	std::cout << "INFO - VirtualRangeCam::OpenRecording:" << std::endl;
+	std::cout << "\t ... Mapped '" << m_Recording.GetNumberOfFrames() << "' frames of size "
+		<< m_ImageWidth << "x" << m_ImageHeight << " from '" << filename << "'" << std::endl;
+
+	if (m_Recording.GetNumberOfFrames() == 0 ||
+		(!HasChannel(VirtualRecording::CHANNEL_INTENSITY_32F1) && !HasChannel(VirtualRecording::CHANNEL_INTENSITY_8U3) &&
+		!HasChannel(VirtualRecording::CHANNEL_AMPLITUDE_32F1)))
+	{
+		std::cerr << "ERROR - VirtualRangeCam::OpenRecording:" << std::endl;
+		std::cerr << "\t ... Recording contains no intensity or amplitude images" << std::endl;
+		m_Recording.Close();
+		return RET_FAILED;
+	}
+
+	if ((m_CalibrationMethod == NATIVE || m_CalibrationMethod == MATLAB_NO_Z) && !HasChannel(VirtualRecording::CHANNEL_COORDINATE_32F3))
+	{
+		std::cerr << "ERROR - VirtualRangeCam::OpenRecording:" << std::endl;
+		std::cerr << "\t ... Coordinate images must be available for calibration mode NATIVE or MATLAB_NO_Z." << std::endl;
+		m_Recording.Close();
+		return RET_FAILED;
+	}
+
+	return RET_OK;
+}
+
+
+bool VirtualRangeCam::HasChannel(VirtualRecording::t_Channel channel)
+{
+	if (m_Recording.IsOpen())
+	{
+		return m_Recording.HasChannel(channel);
+	}
+	return !m_ImageFileNames[channel].empty();
+}
+
+
+VirtualRecording::t_Channel VirtualRangeCam::GetGrayChannel(ipa_CameraSensors::t_ToFGrayImageType grayImageType)
+{
+	if (grayImageType == ipa_CameraSensors::INTENSITY_8U3)
+	{
+		return HasChannel(VirtualRecording::CHANNEL_INTENSITY_8U3) ?
+			VirtualRecording::CHANNEL_INTENSITY_8U3 : VirtualRecording::CHANNEL_INTENSITY_32F1;
+	}
+	else if (grayImageType == ipa_CameraSensors::INTENSITY_32F1)
+	{
+		return HasChannel(VirtualRecording::CHANNEL_INTENSITY_32F1) ?
+			VirtualRecording::CHANNEL_INTENSITY_32F1 : VirtualRecording::CHANNEL_INTENSITY_8U3;
+	}
+	return VirtualRecording::CHANNEL_AMPLITUDE_32F1;
+}
+
+
+bool VirtualRangeCam::LoadImageFiles(int frame, std::vector<cv::Mat>& images)
+{
+	unsigned int channelMask = m_PrefetchChannels;
+	bool ok = true;
+
+	images.resize(VirtualRecording::NUM_CHANNELS);
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		if ((channelMask & (1u << channel)) && frame < (int)m_ImageFileNames[channel].size())
+		{
+			ok = FramePrefetcher::LoadImageFile(m_ImageFileNames[channel][frame], images[channel]) && ok;
+		}
+	}
+	return ok;
+}
+
+
+unsigned long VirtualRangeCam::LoadFrame(int frame, unsigned int channelMask, std::vector<cv::Mat>& images)
+{
+	if (m_Recording.IsOpen())
+	{
+		images.resize(VirtualRecording::NUM_CHANNELS);
+		for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+		{
+			const void* data = (channelMask & (1u << channel)) ?
+				m_Recording.GetImage(frame, (VirtualRecording::t_Channel)channel) : 0;
+			if (data)
+			{
+				images[channel] = cv::Mat(m_ImageHeight, m_ImageWidth,
+					GetImageType((VirtualRecording::t_Channel)channel), const_cast<void*>(data));
+			}
+		}
+		m_Recording.Prefetch((frame + 1) % m_Recording.GetNumberOfFrames());
+	}
+	else
+	{
+		// The prefetcher learns the requested channels, frames loaded before get completed here
+		m_PrefetchChannels.fetch_or(channelMask);
+		m_Prefetcher.GetFrame(frame, images);
+		images.resize(VirtualRecording::NUM_CHANNELS);
+		for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+		{
+			if ((channelMask & (1u << channel)) && images[channel].empty() && frame < (int)m_ImageFileNames[channel].size())
+			{
+				FramePrefetcher::LoadImageFile(m_ImageFileNames[channel][frame], images[channel]);
+			}
+		}
+	}
+
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		if (!(channelMask & (1u << channel)))
+		{
+			continue;
+		}
+		if (images[channel].empty())
+		{
+			std::cerr << "ERROR - VirtualRangeCam::LoadFrame:" << std::endl;
+			std::cerr << "\t ... No image of channel " << channel << " for frame " << frame << "." << std::endl;
+			return RET_FAILED;
+		}
+		if (images[channel].rows != m_ImageHeight || images[channel].cols != m_ImageWidth ||
+			images[channel].type() != GetImageType((VirtualRecording::t_Channel)channel))
+		{
+			std::cerr << "ERROR - VirtualRangeCam::LoadFrame:" << std::endl;
+			std::cerr << "\t ... Image of channel " << channel << " for frame " << frame << " has wrong size or type." << std::endl;
+			return RET_FAILED;
+		}
+	}
+
+	return RET_OK;
+}
+
+
 unsigned long VirtualRangeCam::SetProperty(t_cameraProperty* cameraProperty)
 {
 	switch (cameraProperty->propertyID)
@@ -496,8 +697,6 @@ unsigned long VirtualRangeCam::GetProperty(t_cameraProperty* cameraProperty)
 unsigned long VirtualRangeCam::AcquireImages(cv::Mat* rangeImage, cv::Mat* grayImage, cv::Mat* cartesianImage,
 											 bool getLatestFrame, bool undistort, ipa_CameraSensors::t_ToFGrayImageType grayImageType)
 {
-	//std::cout << m_ImageCounter << std::endl;
-
 	char* rangeImageData = 0;
 	char* grayImageData = 0;
 	char* cartesianImageData = 0;
@@ -546,288 +745,115 @@ unsigned long VirtualRangeCam::AcquireImages(int widthStepRange, int widthStepGr
 		return (RET_FAILED | RET_CAMERA_NOT_OPEN);
 	}
 
+	if (cartesianImageData && m_CalibrationMethod != MATLAB_NO_Z && m_CalibrationMethod != NATIVE)
+	{
+		std::cerr << "ERROR - VirtualRangeCam::AcquireImages:" << std::endl;
+		std::cerr << "\t ... Cartesian images require calibration method NATIVE or MATLAB_NO_Z.\n";
+		return RET_FAILED;
+	}
+
+	VirtualRecording::t_Channel grayChannel = GetGrayChannel(grayImageType);
+	int grayType = (grayImageType == ipa_CameraSensors::INTENSITY_8U3) ? CV_8UC3 : CV_32FC1;
+	if (grayImageData && GetImageType(grayChannel) != grayType)
+	{
+		std::cerr << "ERROR - VirtualRangeCam::AcquireImages:" << std::endl;
+		std::cerr << "\t ... No gray images of the requested type available.\n";
+		return RET_FAILED;
+	}
+
+	unsigned int channelMask = 0;
+	if (rangeImageData) channelMask |= 1u << VirtualRecording::CHANNEL_RANGE_32F1;
+	if (grayImageData) channelMask |= 1u << grayChannel;
+	if (cartesianImageData) channelMask |= 1u << VirtualRecording::CHANNEL_COORDINATE_32F3;
+
+	std::vector<cv::Mat> images;
+	if (LoadFrame(m_ImageCounter, channelMask, images) & RET_FAILED)
+	{
+		return RET_FAILED;
+	}
+
 ///***********************************************************************
 // Range image (distorted or undistorted)
 ///***********************************************************************
 	if (rangeImageData)
 	{
-		float* f_ptr = 0;
-		float* f_ptr_dst = 0;
-		bool releaseNecessary = false;
-
-		cv::Mat rangeMat;
-		IplImage rangeIpl;
-		IplImage* rangeImage = &rangeIpl;
-		if (m_RangeImageFileNames[m_ImageCounter].find(".bin") != std::string::npos)
-		{
-			ipa_Utils::LoadMat(rangeMat, m_RangeImageFileNames[m_ImageCounter]);
-			rangeIpl = (IplImage)rangeMat;
-		}
-		else if (m_RangeImageFileNames[m_ImageCounter].find(".xml") != std::string::npos)
-		{
-			rangeImage = (IplImage*) cvLoad(m_RangeImageFileNames[m_ImageCounter].c_str(), 0);
-			releaseNecessary = true;
-		}
-		else
-		{
-			std::cerr << "ERROR - VirtualRangeCam::AcquireImages:\n";
-			std::cerr << "\t ... Wrong file format for file " << m_RangeImageFileNames[m_ImageCounter] << ".\n";
-			CV_Assert(false);
-		}
+		const cv::Mat& rangeImage = images[VirtualRecording::CHANNEL_RANGE_32F1];
 
 		if (!undistort)
 		{
-			// put data in corresponding IPLImage structures
-			for(unsigned int row=0; row<(unsigned int)m_ImageHeight; row++)
-			{
-				f_ptr = (float*) (rangeImage->imageData + row*rangeImage->widthStep);
-				f_ptr_dst = (float*) (rangeImageData + row*widthStepRange);
-
-				for (unsigned int col=0; col<(unsigned int)m_ImageWidth; col++)
-				{
-					f_ptr_dst[col] = f_ptr[col];
-				}
-			}
+			CopyImage(rangeImage, rangeImageData, widthStepRange);
 		}
 		else
 		{
 			cv::Mat undistortedData (m_ImageHeight, m_ImageWidth, CV_32FC1, (float*) rangeImageData);
-			cv::Mat cpp_rangeImage = rangeImage;
 
 			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(cpp_rangeImage, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+			cv::remap(rangeImage, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
 		}
-
-		if (releaseNecessary) cvReleaseImage(&rangeImage);
 	} // End if (rangeImage)
 ///***********************************************************************
 // Gray image based on amplitude or intensity (distorted or undistorted)
 ///***********************************************************************
 	if(grayImageData)
 	{
-		float* f_ptr = 0;
-		float* f_ptr_dst = 0;
-		unsigned char* uc_ptr = 0;
-		unsigned char* uc_ptr_dst = 0;
-		cv::Mat grayMat;
-		IplImage grayIpl;
-		IplImage* grayImage = &grayIpl;
-		bool releaseNecessary = false;
-
-		// load image
-		if ((grayImageType == ipa_CameraSensors::INTENSITY_32F1) || (grayImageType == ipa_CameraSensors::INTENSITY_8U3))
-		{
-			// intensity image
-			if (m_IntensityImageFileNames[m_ImageCounter].find(".bin") != std::string::npos)
-			{
-				ipa_Utils::LoadMat(grayMat, m_IntensityImageFileNames[m_ImageCounter]);
-				grayIpl = (IplImage)grayMat;
-			}
-			else if (m_IntensityImageFileNames[m_ImageCounter].find(".xml") != std::string::npos)
-			{
-				grayImage = (IplImage*) cvLoad(m_IntensityImageFileNames[m_ImageCounter].c_str());
-				releaseNecessary = true;
-			}
-			else if ((m_IntensityImageFileNames[m_ImageCounter].find(".png") != std::string::npos) || (m_IntensityImageFileNames[m_ImageCounter].find(".bmp") != std::string::npos) ||
-					(m_IntensityImageFileNames[m_ImageCounter].find(".jpg") != std::string::npos))
-			{
-				grayMat = cv::imread(m_IntensityImageFileNames[m_ImageCounter], -1);
-				grayIpl = (IplImage)grayMat;
-			}
-			else
-			{
-				std::cerr << "ERROR - VirtualRangeCam::AcquireImages:\n";
-				std::cerr << "\t ... Wrong file format for file " << m_IntensityImageFileNames[m_ImageCounter] << ".\n";
-				CV_Assert(false);
-			}
-		}
-		else
-		{
-			// amplitude image
-			if (m_AmplitudeImageFileNames[m_ImageCounter].find(".bin") != std::string::npos)
-			{
-				ipa_Utils::LoadMat(grayMat, m_AmplitudeImageFileNames[m_ImageCounter]);
-				grayIpl = (IplImage)grayMat;
-			}
-			else if (m_AmplitudeImageFileNames[m_ImageCounter].find(".xml") != std::string::npos)
-			{
-				grayImage = (IplImage*) cvLoad(m_AmplitudeImageFileNames[m_ImageCounter].c_str());
-				releaseNecessary = true;
-			}
-			else
-			{
-				std::cerr << "ERROR - VirtualRangeCam::AcquireImages:\n";
-				std::cerr << "\t ... Wrong file format for file " << m_AmplitudeImageFileNames[m_ImageCounter] << ".\n";
-				CV_Assert(false);
-			}
-		}
+		const cv::Mat& grayImage = images[grayChannel];
 
-		// process image
 		if (!undistort)
 		{
-			if (grayImageType == ipa_CameraSensors::INTENSITY_8U3)
-			{
-				for(unsigned int row=0; row<(unsigned int)m_ImageHeight; row++)
-				{
-					f_ptr = (float*) (grayImage->imageData + row*grayImage->widthStep);
-					f_ptr_dst = (float*) (grayImageData + row*widthStepGray);
-
-					for (unsigned int col=0; col<(unsigned int)m_ImageWidth; col++)
-					{
-						f_ptr_dst[col] = f_ptr[col];
-					}
-				}
-			}
-			else
-			{
-				for(unsigned int row=0; row<(unsigned int)m_ImageHeight; row++)
-				{
-					uc_ptr = (unsigned char*) (grayImage->imageData + row*grayImage->widthStep);
-					uc_ptr_dst = (unsigned char*) (grayImageData + row*widthStepGray);
-
-					for (unsigned int col=0; col<(unsigned int)m_ImageWidth; col++)
-					{
-						uc_ptr_dst[col] = uc_ptr[col];
-					}
-				}
-			}
+			CopyImage(grayImage, grayImageData, widthStepGray);
 		}
 		else
 		{
-			cv::Mat undistortedData;
-			if (grayImageType == ipa_CameraSensors::INTENSITY_8U3)
-			{
-				undistortedData = cv::Mat(m_ImageHeight, m_ImageWidth, CV_8UC3, (unsigned char*) grayImageData);
-			}
-			else
-			{
-				undistortedData = cv::Mat(m_ImageHeight, m_ImageWidth, CV_32FC1, (float*) grayImageData);
-			}
-			cv::Mat cpp_grayImage = grayImage;
+			cv::Mat undistortedData(m_ImageHeight, m_ImageWidth, grayType, grayImageData);
 
 			assert (!m_undistortMapX.empty() && !m_undistortMapY.empty());
-			cv::remap(cpp_grayImage, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
+			cv::remap(grayImage, undistortedData, m_undistortMapX, m_undistortMapY, cv::INTER_LINEAR);
 		}
-
-		if (releaseNecessary) cvReleaseImage(&grayImage);
 	}
 ///***********************************************************************
 // Cartesian image (always undistorted)
 ///***********************************************************************
 	if(cartesianImageData)
 	{
-		float x = -1;
-		float y = -1;
-		float zCalibrated = -1;
-		float* f_ptr = 0;
-		float* f_ptr_dst = 0;
-		bool releaseNecessary = false;
-
-		if(m_CalibrationMethod==MATLAB)
-		{
-			CV_Assert(false);
-		}
-		else if(m_CalibrationMethod==MATLAB_NO_Z)
+		const cv::Mat& coordinateImage = images[VirtualRecording::CHANNEL_COORDINATE_32F3];
+
+		if(m_CalibrationMethod==MATLAB_NO_Z)
 		{
 			// XYZ image is assumed to be undistorted
 			// Unfortunately we have no access to the swissranger calibration
-
-			cv::Mat coordinateMat;
-			IplImage coordinateIpl;
-			IplImage* coordinateImage = &coordinateIpl;
-			if (m_CoordinateImageFileNames[m_ImageCounter].find(".bin") != std::string::npos)
-			{
-				ipa_Utils::LoadMat(coordinateMat, m_CoordinateImageFileNames[m_ImageCounter]);
-				coordinateIpl = (IplImage)coordinateMat;
-			}
-			else if (m_CoordinateImageFileNames[m_ImageCounter].find(".xml") != std::string::npos)
-			{
-				coordinateImage = (IplImage*) cvLoad(m_CoordinateImageFileNames[m_ImageCounter].c_str(), 0);
-				releaseNecessary = true;
-			}
-			else
+			if (!m_Calibration.HasIntrinsics() || m_Calibration.GetWidth() != m_ImageWidth || m_Calibration.GetHeight() != m_ImageHeight)
 			{
-				std::cerr << "ERROR - VirtualRangeCam::AcquireImages:\n";
-				std::cerr << "\t ... Wrong file format for file " << m_CoordinateImageFileNames[m_ImageCounter] << ".\n";
-				CV_Assert(false);
+				std::cerr << "ERROR - VirtualRangeCam::AcquireImages:" << std::endl;
+				std::cerr << "\t ... Intrinsics not set or not matching the image size.\n";
+				return RET_FAILED;
 			}
+			const float* rayX = m_Calibration.GetRayX();
+			const float* rayY = m_Calibration.GetRayY();
 
-			for(unsigned int row=0; row<(unsigned int)m_ImageHeight; row++)
+			for(int row=0; row<m_ImageHeight; row++)
 			{
-				f_ptr = (float*) (coordinateImage->imageData + row*coordinateImage->widthStep);
-				f_ptr_dst = (float*) (cartesianImageData + row*widthStepCartesian);
+				const float* f_ptr = coordinateImage.ptr<float>(row);
+				float* f_ptr_dst = (float*) (cartesianImageData + row*widthStepCartesian);
 
-				for (unsigned int col=0; col<(unsigned int)m_ImageWidth; col++)
+				for (int col=0; col<m_ImageWidth; col++)
 				{
 					int colTimes3 = 3*col;
+					float zCalibrated = f_ptr[colTimes3+2];
 
-					zCalibrated = f_ptr[colTimes3+2];
-					GetCalibratedXYMatlab(col, row, zCalibrated, x, y);
-
-					f_ptr_dst[colTimes3] = x;
-					f_ptr_dst[colTimes3 + 1] = y;
+					f_ptr_dst[colTimes3] = zCalibrated*rayX[col];
+					f_ptr_dst[colTimes3 + 1] = zCalibrated*rayY[row];
 					f_ptr_dst[colTimes3 + 2] = zCalibrated;
-
-					if (f_ptr_dst[colTimes3 + 2] < 0)
-					{
-						std::cout << "<0: " << row << " " << col << "\n";
-					}
 				}
 			}
-			if (releaseNecessary) cvReleaseImage(&coordinateImage);
-		}
-		else if(m_CalibrationMethod==NATIVE)
-		{
-			cv::Mat coordinateMat;
-			IplImage coordinateIpl;
-			IplImage* coordinateImage = &coordinateIpl;
-			if (m_CoordinateImageFileNames[m_ImageCounter].find(".bin") != std::string::npos)
-			{
-				ipa_Utils::LoadMat(coordinateMat, m_CoordinateImageFileNames[m_ImageCounter]);
-				coordinateIpl = (IplImage)coordinateMat;
-			}
-			else if (m_CoordinateImageFileNames[m_ImageCounter].find(".xml") != std::string::npos)
-			{
-				coordinateImage = (IplImage*) cvLoad(m_CoordinateImageFileNames[m_ImageCounter].c_str(), 0);
-				releaseNecessary = true;
-			}
-			else
-			{
-				std::cerr << "ERROR - VirtualRangeCam::AcquireImages:\n";
-				std::cerr << "\t ... Wrong file format for file " << m_CoordinateImageFileNames[m_ImageCounter] << ".\n";
-				CV_Assert(false);
-			}
-
-			for(unsigned int row=0; row<(unsigned int)m_ImageHeight; row++)
-			{
-				f_ptr = (float*) (coordinateImage->imageData + row*coordinateImage->widthStep);
-				f_ptr_dst = (float*) (cartesianImageData + row*widthStepCartesian);
-
-				for (unsigned int col=0; col<(unsigned int)m_ImageWidth; col++)
-				{
-					int colTimes3 = 3*col;
-
-					f_ptr_dst[colTimes3] =f_ptr[colTimes3+0];;
-					f_ptr_dst[colTimes3 + 1] = f_ptr[colTimes3+1];
-					f_ptr_dst[colTimes3 + 2] = f_ptr[colTimes3+2];
-				}
-			}
-			if (releaseNecessary) cvReleaseImage(&coordinateImage);
 		}
 		else
 		{
-			std::cerr << "ERROR - VirtualRangeCam::AcquireImages:" << std::endl;
-			std::cerr << "\t ... Calibration method unknown.\n";
-			return RET_FAILED;
+			CopyImage(coordinateImage, cartesianImageData, widthStepCartesian);
 		}
 	}
 
-	std::cout << m_ImageCounter << "        \r" << std::endl;
 	m_ImageCounter++;
-	if ((m_IntensityImageFileNames.size() != 0 && m_ImageCounter >= m_IntensityImageFileNames.size()) ||
-		(m_AmplitudeImageFileNames.size() != 0 && m_ImageCounter >= m_AmplitudeImageFileNames.size()) ||
-		(m_RangeImageFileNames.size() != 0 && m_ImageCounter >= m_RangeImageFileNames.size()) ||
-		(m_CoordinateImageFileNames.size() != 0 && m_ImageCounter >= m_CoordinateImageFileNames.size()))
+	if (m_ImageCounter >= (unsigned int)GetNumberOfImages())
 	{
 		// Reset image counter
 		m_ImageCounter = 0;
@@ -838,20 +864,20 @@ unsigned long VirtualRangeCam::AcquireImages(int widthStepRange, int widthStepGr
 
 int VirtualRangeCam::GetNumberOfImages()
 {
-	if (m_IntensityImageFileNames.size() == 0 &&
-		m_AmplitudeImageFileNames.size() == 0 &&
-		m_RangeImageFileNames.size() == 0 &&
-		m_CoordinateImageFileNames.size() == 0)
+	if (m_Recording.IsOpen())
 	{
-		return 0;
+		return m_Recording.GetNumberOfFrames();
 	}
 
-	int min=std::numeric_limits<int>::max();
-
-	if (m_IntensityImageFileNames.size() != 0) min = (int)std::min((float)min, (float)m_IntensityImageFileNames.size());
-	if (m_AmplitudeImageFileNames.size() != 0) min = (int)std::min((float)min, (float)m_AmplitudeImageFileNames.size());
-	if (m_RangeImageFileNames.size() != 0) min = (int)std::min((float)min, (float)m_RangeImageFileNames.size());
-	if (m_CoordinateImageFileNames.size() != 0) min = (int)std::min((float)min, (float)m_CoordinateImageFileNames.size());
+	int min = 0;
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		int size = (int)m_ImageFileNames[channel].size();
+		if (size != 0 && (min == 0 || size < min))
+		{
+			min = size;
+		}
+	}
 
 	return min;
 }
@@ -872,51 +898,27 @@ unsigned long VirtualRangeCam::SaveParameters(const char* filename)
 // Before calling <code>GetCalibratedZMatlab</code>
 unsigned long VirtualRangeCam::GetCalibratedZMatlab(int u, int v, float zRaw, float& zCalibrated)
 {
-	double c[7] = {m_CoeffsA0.at<double>(v,u), m_CoeffsA1.at<double>(v,u), m_CoeffsA2.at<double>(v,u),
-		m_CoeffsA3.at<double>(v,u), m_CoeffsA4.at<double>(v,u), m_CoeffsA5.at<double>(v,u), m_CoeffsA6.at<double>(v,u)};
-	double y = 0;
-
-	ipa_Utils::EvaluatePolynomial((double) zRaw, 6, &c[0], &y);
+	if (!m_Calibration.HasCoefficients())
+	{
+		std::cerr << "VirtualRangeCam::GetCalibratedZMatlab:" << std::endl;
+		std::cerr << "\t ... Coefficients not initialized.\n";
+		return RET_FAILED;
+	}
 
-	zCalibrated = (float) y;
+	zCalibrated = m_Calibration.GetCalibratedZ(u, v, zRaw);
 	return RET_OK;
 }
 
 unsigned long VirtualRangeCam::GetCalibratedXYMatlab(int u, int v, float z, float& x, float& y)
 {
-	// Conversion form m to mm
-	z *= 1000;
-
-	// Use intrinsic camera parameters
-	double fx, fy, cx, cy;
-
-	fx = m_intrinsicMatrix.at<double>(0, 0);
-	fy = m_intrinsicMatrix.at<double>(1, 1);
-
-	cx = m_intrinsicMatrix.at<double>(0, 2);
-	cy = m_intrinsicMatrix.at<double>(1, 2);
-
-	// Fundamental equation: u = (fx*x)/z + cx
-	if (fx == 0)
+	// Ray tables are only built for valid intrinsics (fx and fy not 0)
+	if (!m_Calibration.HasIntrinsics())
 	{
 		std::cerr << "VirtualRangeCam::GetCalibratedXYMatlab:" << std::endl;
-		std::cerr << "\t ... fx is 0.\n";
+		std::cerr << "\t ... Intrinsics not set or fx or fy is 0.\n";
 		return RET_FAILED;
 	}
-	x = (float) (z*(u-cx)/fx) ;
-
-	// Fundamental equation: v = (fy*y)/z + cy
-	if (fy == 0)
-	{
-		std::cerr << "VirtualRangeCam::GetCalibratedXYMatlab:" << std::endl;
-		std::cerr << "\t ... fy is 0.\n";
-		return RET_FAILED;
-	}
-	y = (float) (z*(v-cy)/fy);
-
-	// Conversion from mm to m
-	x /= 1000;
-	y /= 1000;
+	m_Calibration.GetCalibratedXY(u, v, z, x, y);
 
 	return RET_OK;
 }
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <iostream>
+
+#ifdef __LINUX__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cob_camera_sensors/VirtualRecording.h"
+#else
+#include "cob_driver/cob_camera_sensors/common/include/cob_camera_sensors/VirtualRecording.h"
+#endif
+
+using namespace ipa_CameraSensors;
+
+namespace
+{
+	const char RECORDING_MAGIC[8] = "IPAVREC";
+}
+
+VirtualRecording::VirtualRecording()
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+	m_Data = 0;
+	m_Size = 0;
+	m_Mapped = false;
+}
+
+VirtualRecording::~VirtualRecording()
+{
+	Close();
+}
+
+size_t VirtualRecording::GetBytesPerPixel(t_Channel channel)
+{
+	switch (channel)
+	{
+		case CHANNEL_RANGE_32F1:
+		case CHANNEL_AMPLITUDE_32F1:
+		case CHANNEL_INTENSITY_32F1:
+			return sizeof(float);
+		case CHANNEL_INTENSITY_8U3:
+		case CHANNEL_COLOR_8U3:
+			return 3;
+		case CHANNEL_COORDINATE_32F3:
+			return 3*sizeof(float);
+		default:
+			return 0;
+	}
+}
+
+bool VirtualRecording::Open(const std::string& filename)
+{
+	Close();
+
+#ifdef __LINUX__
+	int fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < HEADER_SIZE)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+	m_Size = (size_t)fileStatus.st_size;
+	void* data = mmap(0, m_Size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (data == MAP_FAILED)
+	{
+		m_Size = 0;
+		return false;
+	}
+	// Replay reads the frames in order
+	madvise(data, m_Size, MADV_SEQUENTIAL);
+	m_Data = (const unsigned char*)data;
+	m_Mapped = true;
+#else
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (file == 0)
+	{
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size < HEADER_SIZE)
+	{
+		fclose(file);
+		return false;
+	}
+	m_Buffer.resize((size_t)size);
+	bool ok = fread(&m_Buffer[0], 1, m_Buffer.size(), file) == m_Buffer.size();
+	fclose(file);
+	if (!ok)
+	{
+		m_Buffer.clear();
+		return false;
+	}
+	m_Size = m_Buffer.size();
+	m_Data = &m_Buffer[0];
+#endif
+
+	memcpy(&m_Header, m_Data, sizeof(m_Header));
+
+	// Validate header
+	bool valid = memcmp(m_Header.m_Magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) == 0 &&
+		m_Header.m_Version == VERSION &&
+		m_Header.m_Width > 0 && m_Header.m_Height > 0 &&
+		(size_t)HEADER_SIZE + (size_t)m_Header.m_NumberOfFrames*m_Header.m_FrameSize <= m_Size;
+	for (int channel=0; valid && channel<NUM_CHANNELS; channel++)
+	{
+		if (HasChannel((t_Channel)channel))
+		{
+			size_t imageSize = (size_t)m_Header.m_Width*m_Header.m_Height*GetBytesPerPixel((t_Channel)channel);
+			valid = (size_t)m_Header.m_ChannelOffsets[channel] + imageSize <= m_Header.m_FrameSize;
+		}
+	}
+	if (!valid)
+	{
+		std::cerr << "ERROR - VirtualRecording::Open:" << std::endl;
+		std::cerr << "\t ... '" << filename << "' is no valid recording" << std::endl;
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void VirtualRecording::Close()
+{
+#ifdef __LINUX__
+	if (m_Mapped)
+	{
+		munmap((void*)m_Data, m_Size);
+	}
+#endif
+	m_Buffer.clear();
+	m_Data = 0;
+	m_Size = 0;
+	m_Mapped = false;
+	memset(&m_Header, 0, sizeof(m_Header));
+}
+
+const void* VirtualRecording::GetImage(int frame, t_Channel channel) const
+{
+	if (!IsOpen() || frame < 0 || frame >= GetNumberOfFrames() || !HasChannel(channel))
+	{
+		return 0;
+	}
+	return m_Data + HEADER_SIZE + (size_t)frame*m_Header.m_FrameSize + m_Header.m_ChannelOffsets[channel];
+}
+
+void VirtualRecording::Prefetch(int frame) const
+{
+#ifdef __LINUX__
+	if (m_Mapped && frame >= 0 && frame < GetNumberOfFrames())
+	{
+		// Both offset and frame size are multiples of 64, madvise needs a page aligned address
+		size_t begin = HEADER_SIZE + (size_t)frame*m_Header.m_FrameSize;
+		size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		size_t alignedBegin = begin - begin % pageSize;
+		madvise((void*)(m_Data + alignedBegin), begin - alignedBegin + m_Header.m_FrameSize, MADV_WILLNEED);
+	}
+#endif
+}
+
+
+VirtualRecordingWriter::VirtualRecordingWriter()
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+	m_File = 0;
+}
+
+VirtualRecordingWriter::~VirtualRecordingWriter()
+{
+	Close();
+}
+
+bool VirtualRecordingWriter::Open(const std::string& filename, int width, int height, unsigned int channelMask)
+{
+	Close();
+
+	if (width <= 0 || height <= 0 || channelMask == 0 || channelMask >= (1u << VirtualRecording::NUM_CHANNELS))
+	{
+		return false;
+	}
+
+	memset(&m_Header, 0, sizeof(m_Header));
+	memcpy(m_Header.m_Magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	m_Header.m_Version = VirtualRecording::VERSION;
+	m_Header.m_Width = width;
+	m_Header.m_Height = height;
+	m_Header.m_ChannelMask = channelMask;
+
+	// Channels are aligned to 64 bytes within the frame
+	size_t offset = 0;
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		if (channelMask & (1u << channel))
+		{
+			m_Header.m_ChannelOffsets[channel] = (unsigned int)offset;
+			offset += (size_t)width*height*VirtualRecording::GetBytesPerPixel((VirtualRecording::t_Channel)channel);
+			offset = (offset + 63) & ~(size_t)63;
+		}
+	}
+	m_Header.m_FrameSize = (unsigned int)offset;
+	m_Frame.assign(offset, 0);
+
+	m_File = fopen(filename.c_str(), "wb");
+	if (m_File == 0)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> header(VirtualRecording::HEADER_SIZE, 0);
+	memcpy(&header[0], &m_Header, sizeof(m_Header));
+	if (fwrite(&header[0], 1, header.size(), m_File) != header.size())
+	{
+		fclose(m_File);
+		m_File = 0;
+		return false;
+	}
+	return true;
+}
+
+bool VirtualRecordingWriter::AddFrame(const void* const images[VirtualRecording::NUM_CHANNELS])
+{
+	if (m_File == 0)
+	{
+		return false;
+	}
+
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		if (m_Header.m_ChannelMask & (1u << channel))
+		{
+			if (images[channel] == 0)
+			{
+				return false;
+			}
+			size_t imageSize = (size_t)m_Header.m_Width*m_Header.m_Height*
+				VirtualRecording::GetBytesPerPixel((VirtualRecording::t_Channel)channel);
+			memcpy(&m_Frame[m_Header.m_ChannelOffsets[channel]], images[channel], imageSize);
+		}
+	}
+
+	if (fwrite(&m_Frame[0], 1, m_Frame.size(), m_File) != m_Frame.size())
+	{
+		return false;
+	}
+	m_Header.m_NumberOfFrames++;
+	return true;
+}
+
+bool VirtualRecordingWriter::Close()
+{
+	if (m_File == 0)
+	{
+		return true;
+	}
+
+	bool ok = fseek(m_File, 0, SEEK_SET) == 0 &&
+		fwrite(&m_Header, 1, sizeof(m_Header), m_File) == sizeof(m_Header);
+	ok = (fclose(m_File) == 0) && ok;
+	m_File = 0;
+	return ok;
+}
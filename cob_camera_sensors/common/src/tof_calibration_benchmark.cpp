@@ -0,0 +1,281 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_camera_sensors/ToFCalibration.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+
+using namespace ipa_CameraSensors;
+
+// Compares the per pixel MATLAB calibration of the range imaging sensors (7 separate double
+// matrices, double Horner, remap of the z image, per pixel back projection that re-reads
+// the intrinsics) with the ToFCalibration tables on synthetic frames.
+
+static double nowS()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+struct SyntheticFrame
+{
+	int width;
+	int height;
+	std::vector<double> coeffs[ToFCalibration::NUM_COEFFS];
+	double intrinsics[9];
+	std::vector<float> mapX;
+	std::vector<float> mapY;
+	std::vector<unsigned short> zRaw;
+};
+
+static void createFrame(SyntheticFrame& frame, int width, int height)
+{
+	frame.width = width;
+	frame.height = height;
+	srand(width*height);
+
+	// z = a0 + a1*d + ... + a6*d^6 with d in [0, 65535] mapping to about [0, 7.5] m
+	double d = 65535.0;
+	for (int k=0; k<ToFCalibration::NUM_COEFFS; k++)
+	{
+		frame.coeffs[k].resize(width*height);
+	}
+	for (int i=0; i<width*height; i++)
+	{
+		double r = (double)rand()/RAND_MAX - 0.5;
+		frame.coeffs[0][i] = 0.02*r;
+		frame.coeffs[1][i] = 7.5/d*(1 + 0.01*r);
+		frame.coeffs[2][i] = -0.3/(d*d)*(1 + 0.1*r);
+		frame.coeffs[3][i] = 0.2/(d*d*d);
+		frame.coeffs[4][i] = -0.05/(d*d*d*d)*(1 - 0.1*r);
+		frame.coeffs[5][i] = 0.01/(d*d*d*d*d);
+		frame.coeffs[6][i] = -0.002/(d*d*d*d*d*d);
+	}
+
+	double fx = 1.1*width;
+	double fy = 1.1*width;
+	double cx = 0.5*(width - 1) + 1.5;
+	double cy = 0.5*(height - 1) - 2.0;
+	double intrinsics[9] = {fx, 0, cx, 0, fy, cy, 0, 0, 1};
+	memcpy(frame.intrinsics, intrinsics, sizeof(intrinsics));
+
+	// Radial distortion k1 = -0.25, k2 = 0.1
+	frame.mapX.resize(width*height);
+	frame.mapY.resize(width*height);
+	for (int v=0; v<height; v++)
+	{
+		for (int u=0; u<width; u++)
+		{
+			double x = (u - cx)/fx;
+			double y = (v - cy)/fy;
+			double r2 = x*x + y*y;
+			double f = 1 - 0.25*r2 + 0.1*r2*r2;
+			frame.mapX[v*width + u] = (float)(x*f*fx + cx);
+			frame.mapY[v*width + u] = (float)(y*f*fy + cy);
+		}
+	}
+
+	frame.zRaw.resize(width*height);
+	for (int i=0; i<width*height; i++)
+	{
+		frame.zRaw[i] = (unsigned short)(5000 + rand()%50000);
+	}
+}
+
+/// The calibration as done before the tables: separate matrices, gather per pixel.
+static void legacyCartesian(const SyntheticFrame& frame, std::vector<float>& zBuffer, std::vector<float>& zUndistorted, float* xyz)
+{
+	int width = frame.width;
+	int height = frame.height;
+
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			int i = row*width + col;
+			double c[7] = {frame.coeffs[0][i], frame.coeffs[1][i], frame.coeffs[2][i], frame.coeffs[3][i],
+				frame.coeffs[4][i], frame.coeffs[5][i], frame.coeffs[6][i]};
+			double zRaw = frame.zRaw[i];
+			double y = c[6];
+			for (int k=5; k>=0; k--)
+			{
+				y = y*zRaw + c[k];
+			}
+			zBuffer[i] = (float)y;
+		}
+	}
+
+	// Bilinear remap, constant border 0
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			float sx = frame.mapX[row*width + col];
+			float sy = frame.mapY[row*width + col];
+			int x0 = (int)floorf(sx);
+			int y0 = (int)floorf(sy);
+			float ax = sx - x0;
+			float ay = sy - y0;
+			float w[4] = {(1-ax)*(1-ay), ax*(1-ay), (1-ax)*ay, ax*ay};
+			float z = 0;
+			for (int n=0; n<4; n++)
+			{
+				int x = x0 + (n & 1);
+				int y = y0 + (n >> 1);
+				if (x >= 0 && x < width && y >= 0 && y < height)
+				{
+					z += w[n]*zBuffer[y*width + x];
+				}
+			}
+			zUndistorted[row*width + col] = z;
+		}
+	}
+
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			volatile const double* intrinsics = frame.intrinsics;
+			float z = zUndistorted[row*width + col]*1000;
+			double fx = intrinsics[0];
+			double fy = intrinsics[4];
+			double cx = intrinsics[2];
+			double cy = intrinsics[5];
+			if (fx == 0 || fy == 0)
+			{
+				return;
+			}
+			float* p = xyz + 3*(row*width + col);
+			p[0] = (float)(z*(col - cx)/fx)/1000;
+			p[1] = (float)(z*(row - cy)/fy)/1000;
+			p[2] = z/1000;
+		}
+	}
+}
+
+/// Returns false, if the deviation from the legacy implementation exceeds maxError.
+static bool runBenchmark(int width, int height, int iFrames, double maxError)
+{
+	SyntheticFrame frame;
+	createFrame(frame, width, height);
+
+	ToFCalibration calibration;
+	const double* coeffs[ToFCalibration::NUM_COEFFS];
+	size_t steps[ToFCalibration::NUM_COEFFS];
+	for (int k=0; k<ToFCalibration::NUM_COEFFS; k++)
+	{
+		coeffs[k] = &frame.coeffs[k][0];
+		steps[k] = width*sizeof(double);
+	}
+	if (!calibration.SetCoefficients(width, height, coeffs, steps) ||
+		!calibration.SetIntrinsics(width, height, frame.intrinsics[0], frame.intrinsics[4], frame.intrinsics[2], frame.intrinsics[5]) ||
+		!calibration.SetUndistortMap(width, height, &frame.mapX[0], width*sizeof(float), &frame.mapY[0], width*sizeof(float)))
+	{
+		std::cerr << "ERROR - Could not set up the calibration tables" << std::endl;
+		return false;
+	}
+
+	std::vector<float> zBuffer(width*height), zUndistorted(width*height);
+	std::vector<float> xyzLegacy(3*width*height), xyz(3*width*height);
+
+	double start = nowS();
+	for (int f=0; f<iFrames; f++)
+	{
+		frame.zRaw[f % (width*height)] ^= 1;
+		legacyCartesian(frame, zBuffer, zUndistorted, &xyzLegacy[0]);
+	}
+	double legacyS = (nowS() - start)/iFrames;
+
+	start = nowS();
+	for (int f=0; f<iFrames; f++)
+	{
+		frame.zRaw[f % (width*height)] ^= 1;
+		calibration.CalibrateZ(&frame.zRaw[0], &zBuffer[0]);
+		for (int row=0; row<height; row++)
+		{
+			calibration.ComputeCartesianRow(row, &zBuffer[0], &xyz[3*row*width]);
+		}
+	}
+	double tableS = (nowS() - start)/iFrames;
+
+	// Both loops flipped the same bits, compare the last frame
+	legacyCartesian(frame, zBuffer, zUndistorted, &xyzLegacy[0]);
+	calibration.CalibrateZ(&frame.zRaw[0], &zBuffer[0]);
+	for (int row=0; row<height; row++)
+	{
+		calibration.ComputeCartesianRow(row, &zBuffer[0], &xyz[3*row*width]);
+	}
+	double error = 0;
+	for (int i=0; i<3*width*height; i++)
+	{
+		error = std::max(error, (double)fabs(xyz[i] - xyzLegacy[i]));
+	}
+
+	std::cout << width << "x" << height << ": legacy " << legacyS*1e6 << " us/frame, tables "
+		<< tableS*1e6 << " us/frame, speedup " << legacyS/tableS << ", max deviation " << error*1e3 << " mm" << std::endl;
+
+	return error <= maxError;
+}
+
+int main(int argc, char** argv)
+{
+	int iFrames = 200;
+	double maxError = 1e-3;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i+1 < argc)
+		{
+			iFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max-error") == 0 && i+1 < argc)
+		{
+			maxError = atof(argv[++i]);
+		}
+		else
+		{
+			std::cout << "Usage: " << argv[0] << " [--frames N] [--max-error M]" << std::endl;
+			return 2;
+		}
+	}
+
+#if defined(__AVX__)
+	std::cout << "Kernel: AVX" << std::endl;
+#elif defined(__SSE2__)
+	std::cout << "Kernel: SSE2" << std::endl;
+#else
+	std::cout << "Kernel: scalar" << std::endl;
+#endif
+
+	bool ok = true;
+	ok = runBenchmark(176, 144, iFrames, maxError) && ok;
+	ok = runBenchmark(320, 240, iFrames, maxError) && ok;
+	ok = runBenchmark(640, 480, iFrames/4 + 1, maxError) && ok;
+
+	if (!ok)
+	{
+		std::cout << "Deviation exceeds " << maxError*1e3 << " mm" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_camera_sensors/ToFFilter.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <vector>
+
+using namespace ipa_CameraSensors;
+
+// Times the ToFFilter stages on synthetic frames, single threaded and with several threads,
+// and compares the amplitude and tear-off stages with the sequential per pixel filters
+// (one pass per filter, acos per neighbour) that tof_camera used before.
+
+static double nowS()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+struct SyntheticFrame
+{
+	int width;
+	int height;
+	std::vector<float> xyz;
+	std::vector<float> amplitude;
+};
+
+/// A wall at 3 m with a box at 1.5 m in front of it, noise, flying pixels
+/// along the box border and some dark pixels.
+static void createFrame(SyntheticFrame& frame, int width, int height, int seed)
+{
+	frame.width = width;
+	frame.height = height;
+	frame.xyz.resize(3*width*height);
+	frame.amplitude.resize(width*height);
+	srand(seed);
+
+	double f = 1.1*width;
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			int i = row*width + col;
+			bool box = col > width/3 && col < 2*width/3 && row > height/3 && row < 2*height/3;
+			double z = box ? 1.5 : 3.0;
+			z += 0.003*((double)rand()/RAND_MAX - 0.5);
+			if ((col == width/3 + 1 || col == 2*width/3 - 1) && rand()%2)
+			{
+				// Mixed pixel between box and wall
+				z = 1.5 + 1.5*(double)rand()/RAND_MAX;
+			}
+			float* p = &frame.xyz[3*i];
+			p[0] = (float)(z*(col - 0.5*width)/f);
+			p[1] = (float)(z*(row - 0.5*height)/f);
+			p[2] = (float)z;
+			frame.amplitude[i] = rand()%50 == 0 ? 50.0f : (float)(2000.0/(z*z));
+		}
+	}
+}
+
+/// The filters as called before ToFFilter: tear-off edges, then amplitude on the full frame.
+static void legacyFilter(int width, int height, float* xyz, const float* amplitude,
+	float lower, float upper, float piFraction, std::vector<unsigned char>& mask)
+{
+	double minAngle = 3.14159265/piFraction;
+	double maxAngle = 3.14159265 - minAngle;
+	mask.assign(width*height, 0);
+	for (int row=0; row<height; row++)
+	{
+		for (int col=0; col<width; col++)
+		{
+			const float* p = xyz + 3*(row*width + col);
+			if (p[2] == 0)
+			{
+				continue;
+			}
+			int neighbours[4][2] = {{row, col - 1}, {row, col + 1}, {row - 1, col}, {row + 1, col}};
+			for (int n=0; n<4; n++)
+			{
+				int r = neighbours[n][0];
+				int c = neighbours[n][1];
+				if (r < 0 || r >= height || c < 0 || c >= width)
+				{
+					continue;
+				}
+				const float* q = xyz + 3*(r*width + c);
+				if (q[2] == 0)
+				{
+					continue;
+				}
+				double v[3] = {q[0] - p[0], q[1] - p[1], q[2] - p[2]};
+				double lengthP = sqrt((double)p[0]*p[0] + (double)p[1]*p[1] + (double)p[2]*p[2]);
+				double lengthV = sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+				if (lengthV == 0)
+				{
+					continue;
+				}
+				double angle = acos((p[0]*v[0] + p[1]*v[1] + p[2]*v[2])/(lengthP*lengthV));
+				if (angle < minAngle || angle > maxAngle)
+				{
+					mask[row*width + col] = 1;
+					break;
+				}
+			}
+		}
+	}
+	for (int i=0; i<width*height; i++)
+	{
+		if (mask[i] || amplitude[i] < lower || amplitude[i] > upper)
+		{
+			xyz[3*i] = 0;
+			xyz[3*i + 1] = 0;
+			xyz[3*i + 2] = 0;
+		}
+	}
+}
+
+/// Filters iFrames frames, returns the time per frame and the last filtered frame in xyz.
+static double timeFilter(ToFFilter& filter, const SyntheticFrame frames[2], int iFrames, std::vector<float>& xyz)
+{
+	int width = frames[0].width;
+	int height = frames[0].height;
+	filter.ResetHistory();
+
+	double totalS = 0;
+	for (int f=0; f<iFrames; f++)
+	{
+		const SyntheticFrame& frame = frames[f % 2];
+		xyz = frame.xyz;
+		double start = nowS();
+		filter.Apply(width, height, &xyz[0], 3*width*sizeof(float), &frame.amplitude[0], width*sizeof(float));
+		totalS += nowS() - start;
+	}
+	return totalS/iFrames;
+}
+
+/// Returns false, if the parallel filter differs from the single threaded one.
+static bool runBenchmark(int width, int height, int iFrames, int iThreads)
+{
+	SyntheticFrame frames[2];
+	createFrame(frames[0], width, height, 1);
+	createFrame(frames[1], width, height, 2);
+
+	ToFFilter::t_Parameters parameters;
+	parameters.m_LowerAmplitude = 100;
+	parameters.m_UpperAmplitude = 60000;
+	parameters.m_TearOffPiFraction = 6;
+	parameters.m_FlyingMaxDistance = 0.05f;
+	parameters.m_FlyingMinNeighbours = 3;
+	parameters.m_MedianLength = 3;
+
+	const char* names[] = {"amplitude", "tear-off", "flying", "median", "all"};
+	unsigned int stages[] = {ToFFilter::STAGE_AMPLITUDE, ToFFilter::STAGE_TEAR_OFF_EDGES, ToFFilter::STAGE_FLYING_PIXELS,
+		ToFFilter::STAGE_TEMPORAL_MEDIAN, ToFFilter::STAGE_AMPLITUDE | ToFFilter::STAGE_TEAR_OFF_EDGES |
+		ToFFilter::STAGE_FLYING_PIXELS | ToFFilter::STAGE_TEMPORAL_MEDIAN};
+
+	ToFFilter single;
+	ToFFilter parallel;
+	single.SetNumberOfThreads(1);
+	parallel.SetNumberOfThreads(iThreads);
+
+	bool ok = true;
+	std::vector<float> xyzSingle, xyzParallel;
+	std::cout << width << "x" << height << ":" << std::endl;
+	for (int s=0; s<5; s++)
+	{
+		parameters.m_Stages = stages[s];
+		single.SetParameters(parameters);
+		parallel.SetParameters(parameters);
+		double singleS = timeFilter(single, frames, iFrames, xyzSingle);
+		double parallelS = timeFilter(parallel, frames, iFrames, xyzParallel);
+		bool equal = memcmp(&xyzSingle[0], &xyzParallel[0], xyzSingle.size()*sizeof(float)) == 0;
+		ok = ok && equal;
+
+		std::cout << "\t" << names[s] << ": 1 thread " << singleS*1e6 << " us/frame, " << parallel.GetNumberOfThreads()
+			<< " threads " << parallelS*1e6 << " us/frame, speedup " << singleS/parallelS
+			<< (equal ? "" : ", RESULTS DIFFER") << std::endl;
+	}
+
+	// Amplitude and tear-off against the sequential filters
+	parameters.m_Stages = ToFFilter::STAGE_AMPLITUDE | ToFFilter::STAGE_TEAR_OFF_EDGES;
+	parallel.SetParameters(parameters);
+	double parallelS = timeFilter(parallel, frames, iFrames, xyzParallel);
+
+	std::vector<float> xyzLegacy;
+	std::vector<unsigned char> mask;
+	double legacyS = 0;
+	for (int f=0; f<iFrames; f++)
+	{
+		const SyntheticFrame& frame = frames[f % 2];
+		xyzLegacy = frame.xyz;
+		double start = nowS();
+		legacyFilter(width, height, &xyzLegacy[0], &frame.amplitude[0], parameters.m_LowerAmplitude,
+			parameters.m_UpperAmplitude, parameters.m_TearOffPiFraction, mask);
+		legacyS += nowS() - start;
+	}
+	legacyS /= iFrames;
+
+	// Points right at the angle threshold may be decided differently
+	int differences = 0;
+	for (int i=0; i<width*height; i++)
+	{
+		differences += (xyzLegacy[3*i + 2] == 0) != (xyzParallel[3*i + 2] == 0) ? 1 : 0;
+	}
+	std::cout << "\tamplitude + tear-off: sequential " << legacyS*1e6 << " us/frame, ToFFilter " << parallelS*1e6
+		<< " us/frame, speedup " << legacyS/parallelS << ", " << differences << " points differ" << std::endl;
+
+	return ok && differences <= width*height/1000;
+}
+
+int main(int argc, char** argv)
+{
+	int iFrames = 200;
+	int iThreads = 0;
+
+	for (int i=1; i<argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i+1 < argc)
+		{
+			iFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc)
+		{
+			iThreads = atoi(argv[++i]);
+		}
+		else
+		{
+			std::cout << "Usage: " << argv[0] << " [--frames N] [--threads T]" << std::endl;
+			return 2;
+		}
+	}
+
+	bool ok = true;
+	ok = runBenchmark(176, 144, iFrames, iThreads) && ok;
+	ok = runBenchmark(320, 240, iFrames, iThreads) && ok;
+	ok = runBenchmark(640, 480, iFrames/4 + 1, iThreads) && ok;
+
+	if (!ok)
+	{
+		std::cout << "The filter results differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_camera_sensors/FramePrefetcher.h>
+#include <cob_camera_sensors/VirtualRecording.h>
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv/highgui.h>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+using namespace ipa_CameraSensors;
+
+// Packs the image files of the virtual cameras in a directory into the recordings
+// RangeCam_<index>.vrec and ColorCam_<index>.vrec, which the virtual cameras prefer
+// over the image files.
+
+static std::string getExtension(const std::string& filename)
+{
+	size_t dot = filename.rfind('.');
+	return dot == std::string::npos ? "" : filename.substr(dot);
+}
+
+static int getImageType(VirtualRecording::t_Channel channel)
+{
+	switch (channel)
+	{
+		case VirtualRecording::CHANNEL_INTENSITY_8U3:
+		case VirtualRecording::CHANNEL_COLOR_8U3:
+			return CV_8UC3;
+		case VirtualRecording::CHANNEL_COORDINATE_32F3:
+			return CV_32FC3;
+		default:
+			return CV_32FC1;
+	}
+}
+
+/// Sorted files of each channel, the same naming as expected by the virtual cameras.
+/// Returns false, if a channel is stored in more than one format.
+static bool findImageFiles(const fs::path& directory, const std::string& cameraIndex,
+	std::vector<std::string> files[VirtualRecording::NUM_CHANNELS])
+{
+	const char* prefixes[VirtualRecording::NUM_CHANNELS] = {"RangeCamRange_32F1_", "RangeCamAmplitude_32F1_",
+		"RangeCamIntensity_32F1_", "RangeCamIntensity_8U3_", "RangeCamCoordinate_32F3_", "ColorCamRGB_8U3_"};
+	std::string extensions[VirtualRecording::NUM_CHANNELS];
+
+	fs::directory_iterator end_iter;
+	for (fs::directory_iterator dir_itr(directory); dir_itr != end_iter; ++dir_itr)
+	{
+		if (!fs::is_regular_file(dir_itr->status()))
+		{
+			continue;
+		}
+		std::string filename = dir_itr->path().string();
+		std::string ext = getExtension(filename);
+		if (ext == ".vrec")
+		{
+			continue;
+		}
+
+		for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+		{
+			if (filename.find(prefixes[channel] + cameraIndex) == std::string::npos)
+			{
+				continue;
+			}
+			if (extensions[channel] != "" && extensions[channel] != ext)
+			{
+				std::cerr << "ERROR - The directory contains " << prefixes[channel]
+					<< " images in mixed formats (e.g. .xml and .bin)" << std::endl;
+				return false;
+			}
+			extensions[channel] = ext;
+			files[channel].push_back(filename);
+		}
+	}
+
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		std::sort(files[channel].begin(), files[channel].end());
+	}
+	return true;
+}
+
+/// Writes the frames of the channels in channelMask, returns false on errors.
+static bool writeRecording(const std::string& filename, std::vector<std::string> files[VirtualRecording::NUM_CHANNELS],
+	unsigned int channelMask)
+{
+	int numberOfFrames = 0;
+	for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+	{
+		int size = (int)files[channel].size();
+		if ((channelMask & (1u << channel)) && size != 0 && (numberOfFrames == 0 || size < numberOfFrames))
+		{
+			numberOfFrames = size;
+		}
+	}
+	if (numberOfFrames == 0)
+	{
+		return true;
+	}
+
+	VirtualRecordingWriter writer;
+	std::vector<cv::Mat> images(VirtualRecording::NUM_CHANNELS);
+	int width = -1;
+	int height = -1;
+	for (int frame=0; frame<numberOfFrames; frame++)
+	{
+		const void* data[VirtualRecording::NUM_CHANNELS] = {0};
+		for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+		{
+			if (!(channelMask & (1u << channel)) || files[channel].empty())
+			{
+				continue;
+			}
+			int imreadFlags = (channel == VirtualRecording::CHANNEL_COLOR_8U3) ? CV_LOAD_IMAGE_COLOR : -1;
+			if (!FramePrefetcher::LoadImageFile(files[channel][frame], images[channel], imreadFlags))
+			{
+				return false;
+			}
+			// The first image defines the size
+			if (width == -1)
+			{
+				width = images[channel].cols;
+				height = images[channel].rows;
+			}
+			if (images[channel].type() != getImageType((VirtualRecording::t_Channel)channel) ||
+				images[channel].cols != width || images[channel].rows != height)
+			{
+				std::cerr << "ERROR - '" << files[channel][frame] << "' has the wrong size or type" << std::endl;
+				return false;
+			}
+			if (!images[channel].isContinuous())
+			{
+				images[channel] = images[channel].clone();
+			}
+			data[channel] = images[channel].data;
+		}
+
+		if (frame == 0)
+		{
+			unsigned int recordedChannels = 0;
+			for (int channel=0; channel<VirtualRecording::NUM_CHANNELS; channel++)
+			{
+				if (data[channel])
+				{
+					recordedChannels |= 1u << channel;
+				}
+			}
+			if (!writer.Open(filename, width, height, recordedChannels))
+			{
+				std::cerr << "ERROR - Could not create '" << filename << "'" << std::endl;
+				return false;
+			}
+		}
+
+		if (!writer.AddFrame(data))
+		{
+			std::cerr << "ERROR - Could not write frame " << frame << " to '" << filename << "'" << std::endl;
+			return false;
+		}
+	}
+
+	if (!writer.Close())
+	{
+		std::cerr << "ERROR - Could not finish '" << filename << "'" << std::endl;
+		return false;
+	}
+	std::cout << "Wrote " << numberOfFrames << " frames to '" << filename << "'" << std::endl;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2 || argc > 3)
+	{
+		std::cout << "Usage: " << argv[0] << " <directory> [cameraIndex]" << std::endl;
+		return 2;
+	}
+
+	fs::path directory(argv[1]);
+	std::string cameraIndex = argc == 3 ? argv[2] : "0";
+	if (!fs::is_directory(directory))
+	{
+		std::cerr << "ERROR - '" << argv[1] << "' is not a directory" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> files[VirtualRecording::NUM_CHANNELS];
+	if (!findImageFiles(directory, cameraIndex, files))
+	{
+		return 1;
+	}
+
+	unsigned int colorMask = 1u << VirtualRecording::CHANNEL_COLOR_8U3;
+	unsigned int rangeMask = ((1u << VirtualRecording::NUM_CHANNELS) - 1) & ~colorMask;
+
+	bool ok = writeRecording((directory / ("RangeCam_" + cameraIndex + ".vrec")).string(), files, rangeMask);
+	ok = writeRecording((directory / ("ColorCam_" + cameraIndex + ".vrec")).string(), files, colorMask) && ok;
+
+	return ok ? 0 : 1;
+}
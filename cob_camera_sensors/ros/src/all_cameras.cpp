@@ -19,17 +19,17 @@
 //#### includes ####
 
 // standard includes
-//--
+#include <math.h>
 
 // ROS includes
 #include <ros/ros.h>
-#include <cv_bridge/CvBridge.h>
 #include <image_transport/image_transport.h>
 
 // ROS message includes
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/fill_image.h>
+#include <sensor_msgs/image_encodings.h>
 #include <sensor_msgs/SetCameraInfo.h>
 
 // external includes
@@ -38,8 +38,137 @@
 #include <cob_vision_utils/GlobalDefines.h>
 #include <cob_vision_utils/CameraSensorToolbox.h>
 
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
 using namespace ipa_CameraSensors;
 
+/// Signals new frames of all camera streams to the publisher stage.
+struct FrameSignal
+{
+	FrameSignal() : count(0) {}
+
+	boost::mutex mutex;		///< Protects count and the frame pools of all streams
+	boost::condition_variable condition;
+	unsigned long count;	///< Number of frames acquired by all streams
+};
+
+/// @class CameraStream
+/// Acquisition thread of one camera.
+/// Every frame is stamped as soon as the driver returned it. The last FRAME_POOL_SIZE
+/// frames are kept for the publisher stage. The image messages of a pool slot are reused,
+/// when nobody holds them anymore, otherwise new ones are allocated.
+class CameraStream
+{
+public:
+	enum { FRAME_POOL_SIZE = 3 };
+
+	struct Frame
+	{
+		Frame() : seq(0) {}
+
+		ros::Time stamp;	///< Time, the driver returned the frame
+		unsigned long seq;	///< Running number of the frame, 0 for an empty slot
+		sensor_msgs::ImagePtr image;	///< Color image or xyz image of the tof camera
+		sensor_msgs::ImagePtr grey_image;	///< Amplitude image of the tof camera
+	};
+
+	/// Fills the images of the frame, allocates them if they are NULL.
+	typedef boost::function<bool (Frame&)> AcquireFunction;
+
+	CameraStream(const std::string& name, AcquireFunction acquire, FrameSignal& signal)
+	: name_(name),
+	  acquire_(acquire),
+	  signal_(signal),
+	  frames_(FRAME_POOL_SIZE),
+	  next_slot_(0),
+	  seq_(0),
+	  running_(false),
+	  failed_(false)
+	{
+		/// Void
+	}
+
+	~CameraStream()
+	{
+		stop();
+	}
+
+	void start(double max_frame_rate)
+	{
+		running_ = true;
+		thread_.reset(new boost::thread(boost::bind(&CameraStream::run, this, max_frame_rate)));
+	}
+
+	void stop()
+	{
+		running_ = false;
+		if (thread_)
+		{
+			thread_->join();
+			thread_.reset();
+		}
+	}
+
+	/// Frames of the pool, the caller has to hold the mutex of the frame signal.
+	/// Slots with seq 0 are empty or being filled.
+	const std::vector<Frame>& frames() const {return frames_;}
+
+	bool failed() const {return failed_;}
+
+	const std::string& name() const {return name_;}
+
+private:
+	void run(double max_frame_rate)
+	{
+		ros::Rate rate(max_frame_rate);
+		while (running_)
+		{
+			// Take the slot out of the pool while it is filled
+			Frame frame;
+			{
+				boost::mutex::scoped_lock lock(signal_.mutex);
+				std::swap(frame, frames_[next_slot_]);
+			}
+			if (frame.image && !frame.image.unique()) frame.image.reset();
+			if (frame.grey_image && !frame.grey_image.unique()) frame.grey_image.reset();
+
+			if (!acquire_(frame))
+			{
+				ROS_ERROR("[all_cameras] %s image acquisition failed, stopping its acquisition", name_.c_str());
+				failed_ = true;
+				break;
+			}
+			frame.stamp = ros::Time::now();
+
+			{
+				boost::mutex::scoped_lock lock(signal_.mutex);
+				frame.seq = ++seq_;
+				frames_[next_slot_] = frame;
+				next_slot_ = (next_slot_ + 1) % FRAME_POOL_SIZE;
+				signal_.count++;
+			}
+			signal_.condition.notify_all();
+
+			rate.sleep();
+		}
+	}
+
+	std::string name_;
+	AcquireFunction acquire_;
+	FrameSignal& signal_;
+
+	std::vector<Frame> frames_;	///< Frame pool, protected by the mutex of signal_
+	int next_slot_;
+	unsigned long seq_;
+
+	volatile bool running_;
+	volatile bool failed_;
+	boost::shared_ptr<boost::thread> thread_;
+};
+
 /// @class CobColorCameraNode
 /// ROS node to interface color cameras.
 class CobAllCamerasNode
@@ -73,28 +202,58 @@ private:
 	ros::ServiceServer right_color_camera_info_service_;
 	ros::ServiceServer tof_camera_info_service_;
 
-	cv::Mat left_color_image_8U3_;	///< color image of left camera
-	cv::Mat right_color_image_8U3_;	///< color image of right camera
-	cv::Mat xyz_tof_image_32F3_;      /// OpenCV image holding the point cloud from tof sensor
-	cv::Mat grey_tof_image_32F1_;     /// OpenCV image holding the amplitude values of the point cloud
-
 	image_transport::ImageTransport image_transport_;	///< Image transport instance
 	image_transport::CameraPublisher xyz_tof_image_publisher_;	///< Publishes xyz image data
 	image_transport::CameraPublisher grey_tof_image_publisher_;	///< Publishes grey image data
 	image_transport::CameraPublisher left_color_image_publisher_;	///< Publishes grey image data
 	image_transport::CameraPublisher right_color_image_publisher_;	///< Publishes grey image data
 
+	/// Output of one camera stream
+	struct StreamOutput
+	{
+		boost::shared_ptr<CameraStream> stream;
+		image_transport::CameraPublisher* image_publisher;	///< Publishes color or xyz images
+		image_transport::CameraPublisher* grey_image_publisher;	///< Publishes amplitude images of the tof camera, NULL for color cameras
+		const sensor_msgs::CameraInfo* camera_info;
+		std::string frame_id;
+		unsigned long published_seq;	///< Sequence number of the last published frame
+	};
+
+	enum t_SyncMode
+	{
+		SYNC_INDEPENDENT = 0,	///< Every stream publishes each of its frames
+		SYNC_MATCHED			///< Only frames matched to a tuple with nearest stamps are published
+	};
+
+	FrameSignal frame_signal_;
+	std::vector<StreamOutput> streams_;	///< Active camera streams
+
+	t_SyncMode sync_mode_;
+	double sync_tolerance_;		///< Maximal skew of the frames of a matched tuple [s]
+	double max_frame_rate_;		///< Maximal frame rate of each camera [Hz]
+
+	/// Statistics of the skew between the frames nearest to each other
+	ros::Time last_reference_stamp_;
+	ros::Time skew_stats_start_;
+	unsigned long skew_count_;
+	unsigned long skew_exceeded_;
+	double skew_sum_;
+	double skew_max_;
+
 public:
 	CobAllCamerasNode(const ros::NodeHandle& node_handle)
 	: node_handle_(node_handle),
 	  left_color_camera_(AbstractColorCameraPtr()),
 	  right_color_camera_(AbstractColorCameraPtr()),
 	  tof_camera_(AbstractRangeImagingSensorPtr()),
-	  left_color_image_8U3_(cv::Mat()),
-	  right_color_image_8U3_(cv::Mat()),
-	  xyz_tof_image_32F3_(cv::Mat()),
-	  grey_tof_image_32F1_(cv::Mat()),
-	  image_transport_(node_handle)
+	  image_transport_(node_handle),
+	  sync_mode_(SYNC_INDEPENDENT),
+	  sync_tolerance_(0.02),
+	  max_frame_rate_(30),
+	  skew_count_(0),
+	  skew_exceeded_(0),
+	  skew_sum_(0),
+	  skew_max_(0)
 	{
 		/// Void
 	}
@@ -102,6 +261,7 @@ public:
 	~CobAllCamerasNode()
 	{
 		ROS_INFO("[all_cameras] Shutting down cameras");
+		stopStreams();
 		if (left_color_camera_)
 		{
 			ROS_INFO("[all_cameras] Shutting down left color camera (1)");
@@ -322,139 +482,280 @@ public:
     		return true;
   	}
 
-	/// Callback function for image requests on topic 'request_image'
-	void spin()
+	/// Returns msg, allocates a new image message if msg is NULL.
+	static void prepareImageMsg(sensor_msgs::ImagePtr& msg, int width, int height, const std::string& encoding, int bytes_per_pixel)
 	{
-		// Set maximal spinning rate
-		ros::Rate rate(30);
-		while(node_handle_.ok())
+		if (!msg)
+		{
+			msg = boost::make_shared<sensor_msgs::Image>();
+		}
+		msg->width = width;
+		msg->height = height;
+		msg->encoding = encoding;
+		msg->is_bigendian = false;
+		msg->step = width * bytes_per_pixel;
+		msg->data.resize(msg->step * height);
+	}
+
+	/// Acquires a color image directly into the image message of the frame.
+	/// Runs in the acquisition thread of the camera.
+	static bool acquireColorFrame(AbstractColorCameraPtr camera, int width, int height, CameraStream::Frame& frame)
+	{
+		prepareImageMsg(frame.image, width, height, sensor_msgs::image_encodings::BGR8, 3);
+
+		cv::Mat image(height, width, CV_8UC3, &frame.image->data[0]);
+		if (camera->GetColorImage(&image, false) & ipa_Utils::RET_FAILED)
+		{
+			return false;
+		}
+		if (image.data != &frame.image->data[0])
+		{
+			ROS_ERROR("[all_cameras] Color camera resolution does not match the camera info");
+			return false;
+		}
+		return true;
+	}
+
+	/// Acquires the xyz and amplitude images directly into the image messages of the frame.
+	/// Runs in the acquisition thread of the camera.
+	static bool acquireTofFrame(AbstractRangeImagingSensorPtr camera, int width, int height, CameraStream::Frame& frame)
+	{
+		prepareImageMsg(frame.image, width, height, sensor_msgs::image_encodings::TYPE_32FC3, 3*sizeof(float));
+		prepareImageMsg(frame.grey_image, width, height, sensor_msgs::image_encodings::TYPE_32FC1, sizeof(float));
+
+		return !(camera->AcquireImages(0, frame.grey_image->step, frame.image->step, 0, (char*)&frame.grey_image->data[0],
+			(char*)&frame.image->data[0], false, false, ipa_CameraSensors::INTENSITY_32F1) & ipa_Utils::RET_FAILED);
+	}
+
+	void addStream(const std::string& name, CameraStream::AcquireFunction acquire,
+		image_transport::CameraPublisher* image_publisher, image_transport::CameraPublisher* grey_image_publisher,
+		const sensor_msgs::CameraInfo* camera_info, const std::string& frame_id)
+	{
+		StreamOutput output;
+		output.stream = boost::make_shared<CameraStream>(name, acquire, boost::ref(frame_signal_));
+		output.image_publisher = image_publisher;
+		output.grey_image_publisher = grey_image_publisher;
+		output.camera_info = camera_info;
+		output.frame_id = frame_id;
+		output.published_seq = 0;
+		streams_.push_back(output);
+	}
+
+	/// Creates and starts one acquisition thread per camera.
+	void startStreams()
+	{
+		if (right_color_camera_)
+		{
+			addStream("Right color camera", boost::bind(&CobAllCamerasNode::acquireColorFrame, right_color_camera_,
+				right_color_camera_info_msg_.width, right_color_camera_info_msg_.height, _1),
+				&right_color_image_publisher_, 0, &right_color_camera_info_msg_, "head_color_camera_r_link");
+		}
+		if (left_color_camera_)
 		{
-			// ROS images
-			sensor_msgs::Image right_color_image_msg;
-			sensor_msgs::Image left_color_image_msg;
-			sensor_msgs::Image xyz_tof_image_msg;
-			sensor_msgs::Image grey_tof_image_msg;
+			addStream("Left color camera", boost::bind(&CobAllCamerasNode::acquireColorFrame, left_color_camera_,
+				left_color_camera_info_msg_.width, left_color_camera_info_msg_.height, _1),
+				&left_color_image_publisher_, 0, &left_color_camera_info_msg_, "head_color_camera_l_link");
+		}
+		if (tof_camera_)
+		{
+			addStream("Tof camera", boost::bind(&CobAllCamerasNode::acquireTofFrame, tof_camera_,
+				tof_camera_info_msg_.width, tof_camera_info_msg_.height, _1),
+				&xyz_tof_image_publisher_, &grey_tof_image_publisher_, &tof_camera_info_msg_, "head_tof_link");
+		}
 
-			// ROS camera information messages
-			sensor_msgs::CameraInfo right_color_image_info;
-			sensor_msgs::CameraInfo left_color_image_info;
-			sensor_msgs::CameraInfo tof_image_info;
+		for (size_t i = 0; i < streams_.size(); i++)
+		{
+			streams_[i].stream->start(max_frame_rate_);
+		}
+	}
 
-			ros::Time now = ros::Time::now();
+	void stopStreams()
+	{
+		for (size_t i = 0; i < streams_.size(); i++)
+		{
+			streams_[i].stream->stop();
+		}
+	}
 
-			// Acquire right color image
-			if (right_color_camera_)
+	void publishFrame(StreamOutput& output, const CameraStream::Frame& frame)
+	{
+		sensor_msgs::CameraInfoPtr info = boost::make_shared<sensor_msgs::CameraInfo>(*output.camera_info);
+		info->width = frame.image->width;
+		info->height = frame.image->height;
+		info->header.stamp = frame.stamp;
+		info->header.frame_id = output.frame_id;
+
+		frame.image->header.stamp = frame.stamp;
+		frame.image->header.frame_id = output.frame_id;
+		output.image_publisher->publish(frame.image, info);
+
+		if (output.grey_image_publisher)
+		{
+			frame.grey_image->header.stamp = frame.stamp;
+			frame.grey_image->header.frame_id = output.frame_id;
+			output.grey_image_publisher->publish(frame.grey_image, info);
+		}
+
+		output.published_seq = frame.seq;
+	}
+
+	/// Publishes all frames of all streams, that have not been published yet.
+	void publishIndependent(std::vector<std::vector<CameraStream::Frame> >& frames)
+	{
+		for (size_t i = 0; i < streams_.size(); i++)
+		{
+			// Oldest frame first
+			bool published = true;
+			while (published)
 			{
-				//ROS_INFO("[all_cameras] RIGHT");
-				/// Acquire new image
-				if (right_color_camera_->GetColorImage(&right_color_image_8U3_, false) & ipa_Utils::RET_FAILED)
+				published = false;
+				const CameraStream::Frame* next = 0;
+				for (size_t k = 0; k < frames[i].size(); k++)
 				{
-					ROS_ERROR("[all_cameras] Right color image acquisition failed");
-					break;
+					const CameraStream::Frame& frame = frames[i][k];
+					if (frame.seq > streams_[i].published_seq && (!next || frame.seq < next->seq))
+					{
+						next = &frame;
+					}
 				}
-
-				try
-		  		{
-					IplImage img = right_color_image_8U3_;
-					right_color_image_msg = *(sensor_msgs::CvBridge::cvToImgMsg(&img, "bgr8"));
-				}
-				catch (sensor_msgs::CvBridgeException error)
+				if (next)
 				{
-					ROS_ERROR("[all_cameras] Could not convert right IplImage to ROS message");
-					break;
+					publishFrame(streams_[i], *next);
+					published = true;
 				}
-				right_color_image_msg.header.stamp = now;
-				right_color_image_msg.encoding = "bgr8";
-				right_color_image_msg.header.frame_id = "head_color_camera_r_link";
-
-				right_color_image_info = right_color_camera_info_msg_;
-				right_color_image_info.width = right_color_image_8U3_.cols;
-				right_color_image_info.height = right_color_image_8U3_.rows;
-				right_color_image_info.header.stamp = now;
-				right_color_image_info.header.frame_id = "head_color_camera_r_link";
-
-				right_color_image_publisher_.publish(right_color_image_msg, right_color_image_info);
 			}
+		}
+	}
 
-			// Acquire left color image
-			if (left_color_camera_)
+	/// Builds the tuple of frames nearest to the latest frame of the slowest stream.
+	/// Records the skew of each new tuple and publishes it in matched mode, if it is within the tolerance.
+	void matchFrames(std::vector<std::vector<CameraStream::Frame> >& frames)
+	{
+		// Reference: latest frame of the stream, whose latest frame is the oldest
+		ros::Time reference_stamp;
+		bool first = true;
+		for (size_t i = 0; i < streams_.size(); i++)
+		{
+			if (streams_[i].stream->failed()) continue;
+
+			const CameraStream::Frame* latest = 0;
+			for (size_t k = 0; k < frames[i].size(); k++)
 			{
-				//ROS_INFO("[all_cameras] LEFT");
+				if (frames[i][k].seq > 0 && (!latest || frames[i][k].seq > latest->seq)) latest = &frames[i][k];
+			}
+			if (!latest) return;
+			if (first || latest->stamp < reference_stamp) reference_stamp = latest->stamp;
+			first = false;
+		}
+		if (first || reference_stamp <= last_reference_stamp_) return;
+		last_reference_stamp_ = reference_stamp;
 
-				/// Acquire new image
-				if (left_color_camera_->GetColorImage(&left_color_image_8U3_, false) & ipa_Utils::RET_FAILED)
-				{
-					ROS_ERROR("[all_cameras] Left color image acquisition failed");
-					break;
-				}
+		// Nearest frame of every stream
+		std::vector<const CameraStream::Frame*> tuple(streams_.size(), (const CameraStream::Frame*)0);
+		ros::Time min_stamp = reference_stamp;
+		ros::Time max_stamp = reference_stamp;
+		bool unpublished = true;
+		for (size_t i = 0; i < streams_.size(); i++)
+		{
+			if (streams_[i].stream->failed()) continue;
 
-				try
-		  		{
-					IplImage img = left_color_image_8U3_;
-					left_color_image_msg = *(sensor_msgs::CvBridge::cvToImgMsg(&img, "bgr8"));
-				}
-				catch (sensor_msgs::CvBridgeException error)
+			double best_dt = 0;
+			for (size_t k = 0; k < frames[i].size(); k++)
+			{
+				if (frames[i][k].seq == 0) continue;
+				double dt = fabs((frames[i][k].stamp - reference_stamp).toSec());
+				if (!tuple[i] || dt < best_dt)
 				{
-					ROS_ERROR("[all_cameras] Could not convert left IplImage to ROS message");
-					break;
+					tuple[i] = &frames[i][k];
+					best_dt = dt;
 				}
-				left_color_image_msg.header.stamp = now;
-				left_color_image_msg.encoding = "bgr8";
-				left_color_image_msg.header.frame_id = "head_color_camera_l_link";
+			}
+			if (tuple[i]->stamp < min_stamp) min_stamp = tuple[i]->stamp;
+			if (tuple[i]->stamp > max_stamp) max_stamp = tuple[i]->stamp;
+			if (tuple[i]->seq <= streams_[i].published_seq) unpublished = false;
+		}
 
-				left_color_image_info = left_color_camera_info_msg_;
-				left_color_image_info.width = left_color_image_8U3_.cols;
-				left_color_image_info.height = left_color_image_8U3_.rows;
-				left_color_image_info.header.stamp = now;
-				left_color_image_info.header.frame_id = "head_color_camera_l_link";
+		double skew = (max_stamp - min_stamp).toSec();
+		skew_count_++;
+		skew_sum_ += skew;
+		if (skew > skew_max_) skew_max_ = skew;
+		if (skew > sync_tolerance_)
+		{
+			skew_exceeded_++;
+			return;
+		}
 
-				left_color_image_publisher_.publish(left_color_image_msg, left_color_image_info);
+		if (sync_mode_ == SYNC_MATCHED && unpublished)
+		{
+			for (size_t i = 0; i < streams_.size(); i++)
+			{
+				if (tuple[i]) publishFrame(streams_[i], *tuple[i]);
 			}
+		}
+	}
 
-			// Acquire image from tof camera
-			if (tof_camera_)
+	/// Logs the skew statistics every 10 seconds.
+	void logSkewStats()
+	{
+		ros::Time now = ros::Time::now();
+		if (skew_stats_start_.isZero())
+		{
+			skew_stats_start_ = now;
+			return;
+		}
+		if ((now - skew_stats_start_).toSec() < 10.0 || skew_count_ == 0) return;
+
+		ROS_INFO("[all_cameras] Inter-camera skew: mean %.1f ms, max %.1f ms, %lu of %lu tuples exceed the tolerance of %.1f ms",
+			skew_sum_ / skew_count_ * 1e3, skew_max_ * 1e3, skew_exceeded_, skew_count_, sync_tolerance_ * 1e3);
+
+		skew_stats_start_ = now;
+		skew_count_ = 0;
+		skew_exceeded_ = 0;
+		skew_sum_ = 0;
+		skew_max_ = 0;
+	}
+
+	/// Publisher stage. Each camera is acquired by its own thread,
+	/// this loop publishes their frames as they arrive.
+	void spin()
+	{
+		startStreams();
+
+		unsigned long seen_count = 0;
+		std::vector<std::vector<CameraStream::Frame> > frames(streams_.size());
+		while(node_handle_.ok())
+		{
+			// Wait for new frames and copy the frame pools (shares the images)
 			{
-				//ROS_INFO("[all_cameras] TOF");
-				if(tof_camera_->AcquireImages(0, &grey_tof_image_32F1_, &xyz_tof_image_32F3_, false, false, ipa_CameraSensors::INTENSITY_32F1) & ipa_Utils::RET_FAILED)
+				boost::mutex::scoped_lock lock(frame_signal_.mutex);
+				if (frame_signal_.count == seen_count)
+				{
+					frame_signal_.condition.timed_wait(lock, boost::posix_time::milliseconds(100));
+				}
+				seen_count = frame_signal_.count;
+				for (size_t i = 0; i < streams_.size(); i++)
 				{
-					ROS_ERROR("[all_cameras] Tof image acquisition failed");
-					tof_camera_->Close();
-		      tof_camera_ = AbstractRangeImagingSensorPtr();
-					break;
+					frames[i] = streams_[i].stream->frames();
 				}
+			}
 
-				try
-		                {
-					IplImage grey_img = grey_tof_image_32F1_;
-					IplImage xyz_img = xyz_tof_image_32F3_;
-		                        xyz_tof_image_msg = *(sensor_msgs::CvBridge::cvToImgMsg(&xyz_img, "passthrough"));
-		                        grey_tof_image_msg = *(sensor_msgs::CvBridge::cvToImgMsg(&grey_img, "passthrough"));
-		                }
-		                catch (sensor_msgs::CvBridgeException error)
-		                {
-		                        ROS_ERROR("[all_cameras] Could not convert tof IplImage to ROS message");
-					break;
-		                }
-
-				xyz_tof_image_msg.header.stamp = now;
-				xyz_tof_image_msg.header.frame_id = "head_tof_link";
-				grey_tof_image_msg.header.stamp = now;
-				grey_tof_image_msg.header.frame_id = "head_tof_link";
-
-				tof_image_info = tof_camera_info_msg_;
-				tof_image_info.width = grey_tof_image_32F1_.cols;
-				tof_image_info.height = grey_tof_image_32F1_.rows;
-				tof_image_info.header.stamp = now;
-				tof_image_info.header.frame_id = "head_tof_link";
-
-				grey_tof_image_publisher_.publish(grey_tof_image_msg, tof_image_info);
-				xyz_tof_image_publisher_.publish(xyz_tof_image_msg, tof_image_info);
+			if (sync_mode_ == SYNC_INDEPENDENT)
+			{
+				publishIndependent(frames);
 			}
+			matchFrames(frames);
+			logSkewStats();
 
-			ros::spinOnce();
-			rate.sleep();
+			// Release the images, so the acquisition threads can reuse them
+			for (size_t i = 0; i < frames.size(); i++)
+			{
+				frames[i].clear();
+			}
 
+			ros::spinOnce();
 		} // END while-loop
+
+		stopStreams();
 	}
 
 	bool loadParameters()
@@ -649,6 +950,35 @@ public:
 
 		ROS_INFO("Intrinsic for tof camera: %s_%d", tmp_string.c_str(), tof_camera_intrinsic_id_);
 
+		// Publishing of the camera streams
+		if (node_handle_.getParam("all_cameras/sync_mode", tmp_string) == false)
+		{
+			tmp_string = "SYNC_INDEPENDENT";
+		}
+		if (tmp_string == "SYNC_INDEPENDENT")
+		{
+			sync_mode_ = SYNC_INDEPENDENT;
+		}
+		else if (tmp_string == "SYNC_MATCHED")
+		{
+			sync_mode_ = SYNC_MATCHED;
+		}
+		else
+		{
+			std::string str = "[all_cameras] Sync mode '" + tmp_string + "' unknown, try 'SYNC_INDEPENDENT' or 'SYNC_MATCHED'";
+			ROS_ERROR("%s", str.c_str());
+			return false;
+		}
+		node_handle_.param("all_cameras/sync_tolerance", sync_tolerance_, 0.02);
+		node_handle_.param("all_cameras/max_frame_rate", max_frame_rate_, 30.0);
+		if (max_frame_rate_ <= 0)
+		{
+			ROS_ERROR("[all_cameras] 'max_frame_rate' has to be positive");
+			return false;
+		}
+
+		ROS_INFO("Sync mode: %s, tolerance %f s, max frame rate %f Hz", tmp_string.c_str(), sync_tolerance_, max_frame_rate_);
+
 		return true;
 	}
 };
@@ -24,16 +24,17 @@
 // ROS includes
 #include <ros/ros.h>
 #include <polled_camera/publication_server.h>
-#include <cv_bridge/CvBridge.h>
 
 // ROS message includes
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/fill_image.h>
+#include <sensor_msgs/image_encodings.h>
 #include <sensor_msgs/SetCameraInfo.h>
 
 // external includes
 #include <cob_camera_sensors/AbstractColorCamera.h>
+#include <cob_camera_sensors/AVTPikeCam.h>
 #include <cob_vision_utils/CameraSensorToolbox.h>
 #include <cob_vision_utils/GlobalDefines.h>
 
@@ -58,13 +59,19 @@ private:
 
 	ros::ServiceServer camera_info_service_;
 
-	cv::Mat color_image_8U3_;
+	int image_width_;	///< Resolution of the color camera
+	int image_height_;
+	bool rgb_encoding_;	///< Publish rgb8 instead of bgr8 images, saves the channel swap of the AVT Pike driver
+	std::string image_encoding_;	///< Encoding of the published images
 
 public:
 	CobColorCameraNode(const ros::NodeHandle& node_handle)
 	: node_handle_(node_handle),
 	  color_camera_(AbstractColorCameraPtr()),
-	  color_image_8U3_(cv::Mat())
+	  image_width_(0),
+	  image_height_(0),
+	  rgb_encoding_(false),
+	  image_encoding_(sensor_msgs::image_encodings::BGR8)
 	{
 		/// Void
 	}
@@ -96,6 +103,21 @@ public:
 			return false;
 		}
 
+		/// RGB output is only supported by the AVT Pike driver and has to be selected before
+		/// the capture thread starts
+		if (rgb_encoding_)
+		{
+			boost::shared_ptr<AVTPikeCam> avt_pike_cam = boost::dynamic_pointer_cast<AVTPikeCam>(color_camera_);
+			if (avt_pike_cam && !(avt_pike_cam->SetRGBOutput(true) & ipa_CameraSensors::RET_FAILED))
+			{
+				image_encoding_ = sensor_msgs::image_encodings::RGB8;
+			}
+			else
+			{
+				ROS_WARN("[color_camera] 'rgb_encoding' not supported by the camera, publishing bgr8 images");
+			}
+		}
+
 		if (color_camera_ && (color_camera_->Open() & ipa_CameraSensors::RET_FAILED))
 		{
 			std::stringstream ss;
@@ -114,6 +136,8 @@ public:
 		int color_sensor_width = cameraProperty.cameraResolution.xResolution;
 		int color_sensor_height = cameraProperty.cameraResolution.yResolution;
 		cv::Size color_image_size(color_sensor_width, color_sensor_height);
+		image_width_ = color_sensor_width;
+		image_height_ = color_sensor_height;
 
 		/// Setup camera toolbox
 		ipa_CameraSensors::CameraSensorToolboxPtr color_sensor_toolbox = ipa_CameraSensors::CreateCameraSensorToolbox();
@@ -175,22 +199,24 @@ public:
 			polled_camera::GetPolledImage::Response& res,
 			sensor_msgs::Image& image_msg, sensor_msgs::CameraInfo& info)
 	{
-		/// Acquire new image
-		if (color_camera_->GetColorImage(&color_image_8U3_) & ipa_Utils::RET_FAILED)
+		/// Acquire new image directly into the message
+		image_msg.width = image_width_;
+		image_msg.height = image_height_;
+		image_msg.is_bigendian = false;
+		image_msg.step = 3*image_width_;
+		image_msg.data.resize(image_msg.step * image_msg.height);
+		cv::Mat color_image_8U3(image_height_, image_width_, CV_8UC3, &image_msg.data[0], image_msg.step);
+		if (color_camera_->GetColorImage(&color_image_8U3) & ipa_Utils::RET_FAILED)
 		{
 			ROS_ERROR("[color_camera] Color image acquisition failed");
 			res.success = false;
 			return;
 		}
-
-		try
-  		{
-			IplImage img = color_image_8U3_;
-			image_msg = *(sensor_msgs::CvBridge::cvToImgMsg(&img, "bgr8"));
-		}
-		catch (sensor_msgs::CvBridgeException error)
+		if (color_image_8U3.data != &image_msg.data[0])
 		{
-			ROS_ERROR("[color_camera] Could not convert IplImage to ROS message");
+			ROS_ERROR("[color_camera] Color camera resolution does not match the camera info");
+			res.success = false;
+			return;
 		}
 
 		/// Set time stamp
@@ -200,11 +226,11 @@ public:
 			image_msg.header.frame_id = "head_color_camera_r_link";
 		else
 			image_msg.header.frame_id = "head_color_camera_l_link";
-		image_msg.encoding = "bgr8";
+		image_msg.encoding = image_encoding_;
 
 		info = camera_info_msg_;
-		info.width = color_image_8U3_.cols;
-		info.height = color_image_8U3_.rows;
+		info.width = image_width_;
+		info.height = image_height_;
 		info.header.stamp = now;
 		if (camera_index_ == 0)
 			info.header.frame_id = "head_color_camera_r_link";
@@ -285,6 +311,9 @@ public:
 
 		ROS_INFO("Intrinsic for color camera: %s_%d", tmp_string.c_str(), color_camera_intrinsic_id_);
 
+		/// Optional, bgr8 by default
+		node_handle_.getParam("rgb_encoding", rgb_encoding_);
+
 		return true;
 	}
 };
@@ -19,17 +19,17 @@
 //#### includes ####
 
 // standard includes
-//--
+#include <algorithm>
 
 // ROS includes
 #include <ros/ros.h>
 #include <image_transport/image_transport.h>
-#include <cv_bridge/CvBridge.h>
 
 // ROS message includes
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/fill_image.h>
+#include <sensor_msgs/image_encodings.h>
 #include <sensor_msgs/SetCameraInfo.h>
 #include <sensor_msgs/PointCloud.h>
 #include <sensor_msgs/PointCloud2.h>
@@ -38,20 +38,26 @@
 
 // external includes
 #include <cob_camera_sensors/AbstractRangeImagingSensor.h>
+#include <cob_camera_sensors/ToFFilter.h>
 #include <cob_vision_utils/CameraSensorToolbox.h>
 #include <cob_vision_utils/GlobalDefines.h>
 #include <cob_vision_utils/VisionUtils.h>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/make_shared.hpp>
 
 using namespace ipa_CameraSensors;
 
 class CobTofCameraNode
 {
+	/// MODE_TOPIC acquires continuously, MODE_SERVICE only for service requests and
+	/// MODE_ON_DEMAND for service requests and while any output has subscribers
 	enum t_Mode
 	{
 		MODE_TOPIC = 0,
-		MODE_SERVICE
+		MODE_SERVICE,
+		MODE_ON_DEMAND
 	};
 
 private:
@@ -78,13 +84,37 @@ private:
 	int lower_amplitude_threshold_;
 	int upper_amplitude_threshold_;
 	double tearoff_tear_half_fraction_;
-
-	cv::Mat xyz_image_32F3_;	/// OpenCV image holding the point cloud
-	cv::Mat grey_image_32F1_;	/// OpenCV image holding the amplitude values
+	bool filter_xyz_flying_pixels_;
+	double flying_pixel_max_distance_;	///< Neighbours closer than this distance [m] support a point
+	int flying_pixel_min_neighbours_;
+	int filter_temporal_median_length_;	///< Number of frames of the temporal median, 0 disables it
+	int filter_threads_;	///< Threads of the filter, 0 uses all cores
+	ipa_CameraSensors::ToFFilter tof_filter_;	///< Filters the xyz image in place
+
+	int image_width_;	///< Resolution of the tof camera
+	int image_height_;
+
+	/// The driver writes directly into the data of the outgoing messages. A message is reused for the
+	/// next frame, if no subscriber holds it anymore, otherwise a new one is allocated.
+	sensor_msgs::ImagePtr xyz_image_msg_;	///< Point cloud image of the last frame
+	sensor_msgs::ImagePtr grey_image_msg_;	///< Amplitude image of the last frame
+	sensor_msgs::PointCloud2Ptr point_cloud2_msg_;	///< Point cloud of the last frame
+	sensor_msgs::PointCloudPtr point_cloud_msg_;	///< Point cloud of the last frame
+
+	cv::Mat xyz_image_32F3_;	/// OpenCV header on the data of xyz_image_msg_
+	cv::Mat grey_image_32F1_;	/// OpenCV header on the data of grey_image_msg_
 
 	CobTofCameraNode::t_Mode ros_node_mode_;	///< Specifies if node is started as topic or service
 	boost::mutex service_mutex_;
 
+	/// Service requests of MODE_SERVICE and MODE_ON_DEMAND wait for the next acquisition,
+	/// concurrent requests are served by the same acquisition
+	boost::condition_variable request_condition_;	///< Wakes the acquisition loop on new requests
+	boost::condition_variable frame_condition_;	///< Wakes waiting requests after an acquisition
+	int pending_requests_;	///< Number of requests waiting for the next acquisition
+	unsigned long acquisition_count_;	///< Number of finished acquisitions
+	bool acquisition_ok_;	///< Result of the last acquisition
+
 	bool publish_point_cloud_;
 	bool publish_point_cloud_2_;
 
@@ -94,8 +124,18 @@ public:
     : node_handle_(node_handle),
 	  image_transport_(node_handle),
       tof_camera_(AbstractRangeImagingSensorPtr()),
+      filter_xyz_flying_pixels_(false),
+      flying_pixel_max_distance_(0.05),
+      flying_pixel_min_neighbours_(2),
+      filter_temporal_median_length_(0),
+      filter_threads_(1),
+      image_width_(0),
+      image_height_(0),
       xyz_image_32F3_(cv::Mat()),
       grey_image_32F1_(cv::Mat()),
+      pending_requests_(0),
+      acquisition_count_(0),
+      acquisition_ok_(false),
       publish_point_cloud_(false),
       publish_point_cloud_2_(false)
     {
@@ -148,6 +188,8 @@ public:
 		int range_sensor_width = cameraProperty.cameraResolution.xResolution;
 		int range_sensor_height = cameraProperty.cameraResolution.yResolution;
 		cv::Size range_image_size(range_sensor_width, range_sensor_height);
+		image_width_ = range_sensor_width;
+		image_height_ = range_sensor_height;
 
 		/// Setup camera toolbox
 		ipa_CameraSensors::CameraSensorToolboxPtr tof_sensor_toolbox = ipa_CameraSensors::CreateCameraSensorToolbox();
@@ -200,6 +242,7 @@ public:
                     sensor_msgs::SetCameraInfo::Response& rsp)
 	{
 		/// TODO: Enable the setting of intrinsic parameters
+		boost::mutex::scoped_lock lock(service_mutex_);
 		camera_info_msg_ = req.camera_info;
 
 		rsp.success = false;
@@ -208,67 +251,134 @@ public:
 		return true;
 	}
 
-    	/// Continuously advertises xyz and grey images.
+	/// Returns msg, if nobody else holds it, otherwise a new image message.
+	/// The image is sized for the tof camera resolution.
+	/// @param msg The message of the last frame, replaced by the returned message
+	/// @param encoding The image encoding
+	/// @param channels Number of float channels
+	sensor_msgs::ImagePtr& prepareImageMsg(sensor_msgs::ImagePtr& msg, const std::string& encoding, int channels)
+	{
+		if (!msg || !msg.unique())
+		{
+			msg = boost::make_shared<sensor_msgs::Image>();
+		}
+		msg->width = image_width_;
+		msg->height = image_height_;
+		msg->encoding = encoding;
+		msg->is_bigendian = false;
+		msg->step = image_width_ * channels * sizeof(float);
+		msg->data.resize(msg->step * msg->height);
+		return msg;
+	}
+
+	/// Returns true, if any output has a subscriber.
+	bool hasSubscribers()
+	{
+		return xyz_image_publisher_.getNumSubscribers() > 0 || grey_image_publisher_.getNumSubscribers() > 0 ||
+			topicPub_pointCloud_.getNumSubscribers() > 0 || topicPub_pointCloud2_.getNumSubscribers() > 0;
+	}
+
+	/// Blocks until the next frame should be acquired.
+	/// MODE_TOPIC returns immediately, the other modes sleep until there is a request or,
+	/// in MODE_ON_DEMAND, a subscriber. Subscribers are polled every 100 ms.
+	/// @return <code>true</code>, if a frame should be acquired
+	bool waitForDemand()
+	{
+		if (ros_node_mode_ == MODE_TOPIC)
+		{
+			return true;
+		}
+
+		boost::mutex::scoped_lock lock(service_mutex_);
+		if (pending_requests_ > 0 || (ros_node_mode_ == MODE_ON_DEMAND && hasSubscribers()))
+		{
+			return true;
+		}
+		request_condition_.timed_wait(lock, boost::posix_time::milliseconds(100));
+		return pending_requests_ > 0;
+	}
+
+	/// Acquires a frame and advertises xyz and grey images and point clouds to their subscribers.
+	/// Outputs without subscribers are skipped. Outside of MODE_TOPIC only the images needed by
+	/// subscribers and pending requests are acquired.
 	bool spin()
 	{
 		boost::mutex::scoped_lock lock(service_mutex_);
-		sensor_msgs::Image::Ptr xyz_image_msg_ptr;
-		sensor_msgs::Image::Ptr grey_image_msg_ptr;
-		sensor_msgs::CameraInfo tof_image_info;
 
-		if(tof_camera_->AcquireImages(0, &grey_image_32F1_, &xyz_image_32F3_, false, false, ipa_CameraSensors::INTENSITY_32F1) & ipa_Utils::RET_FAILED)
+		bool request = pending_requests_ > 0 || ros_node_mode_ == MODE_TOPIC;
+		bool publish_xyz = xyz_image_publisher_.getNumSubscribers() > 0;
+		bool publish_grey = grey_image_publisher_.getNumSubscribers() > 0;
+		bool publish_point_cloud = publish_point_cloud_ && topicPub_pointCloud_.getNumSubscribers() > 0;
+		bool publish_point_cloud_2 = publish_point_cloud_2_ && topicPub_pointCloud2_.getNumSubscribers() > 0;
+
+		bool need_xyz = request || publish_xyz || publish_point_cloud || publish_point_cloud_2;
+		bool need_grey = request || publish_grey || publish_point_cloud_2 || (need_xyz && filter_xyz_by_amplitude_);
+		if (!need_xyz && !need_grey)
 		{
-			ROS_ERROR("[tof_camera] Tof image acquisition failed");
-			return false;
+			return true;
 		}
 
-		/// Filter images by amplitude and remove tear-off edges
-		//if(filter_xyz_tearoff_edges_ || filter_xyz_by_amplitude_)
-		//	ROS_ERROR("[tof_camera] FUNCTION UNCOMMENT BY JSF");
-		if(filter_xyz_tearoff_edges_) ipa_Utils::FilterTearOffEdges(xyz_image_32F3_, 0, (float)tearoff_tear_half_fraction_);
-		if(filter_xyz_by_amplitude_) ipa_Utils::FilterByAmplitude(xyz_image_32F3_, grey_image_32F1_, 0, 0, lower_amplitude_threshold_, upper_amplitude_threshold_);
-
-		try
+		/// Acquire directly into the outgoing messages
+		if (need_xyz)
 		{
-			IplImage img = xyz_image_32F3_;
-			xyz_image_msg_ptr = sensor_msgs::CvBridge::cvToImgMsg(&img, "passthrough");
+			prepareImageMsg(xyz_image_msg_, sensor_msgs::image_encodings::TYPE_32FC3, 3);
+			xyz_image_32F3_ = cv::Mat(image_height_, image_width_, CV_32FC3, &xyz_image_msg_->data[0], xyz_image_msg_->step);
 		}
-		catch (sensor_msgs::CvBridgeException error)
+		if (need_grey)
 		{
-			ROS_ERROR("[tof_camera] Could not convert 32bit xyz IplImage to ROS message");
-			return false;
+			prepareImageMsg(grey_image_msg_, sensor_msgs::image_encodings::TYPE_32FC1, 1);
+			grey_image_32F1_ = cv::Mat(image_height_, image_width_, CV_32FC1, &grey_image_msg_->data[0], grey_image_msg_->step);
 		}
 
-		try
+		acquisition_ok_ = !(tof_camera_->AcquireImages(0, need_grey ? grey_image_msg_->step : 0, need_xyz ? xyz_image_msg_->step : 0, 0,
+			need_grey ? (char*)&grey_image_msg_->data[0] : 0, need_xyz ? (char*)&xyz_image_msg_->data[0] : 0,
+			false, false, ipa_CameraSensors::INTENSITY_32F1) & ipa_Utils::RET_FAILED);
+
+		/// Requests waiting for this acquisition are answered with its result
+		acquisition_count_++;
+		frame_condition_.notify_all();
+
+		if (!acquisition_ok_)
 		{
-			IplImage img = grey_image_32F1_;
-			grey_image_msg_ptr = sensor_msgs::CvBridge::cvToImgMsg(&img, "passthrough");
+			ROS_ERROR("[tof_camera] Tof image acquisition failed");
+			return false;
 		}
-		catch (sensor_msgs::CvBridgeException error)
+
+		/// Filter images by amplitude, remove tear-off edges and flying pixels, in place on the message data
+		if (need_xyz && tof_filter_.GetParameters().m_Stages != 0)
 		{
-			ROS_ERROR("[tof_camera] Could not convert 32bit grey IplImage to ROS message");
-			return false;
+			tof_filter_.Apply(image_width_, image_height_, (float*)&xyz_image_msg_->data[0], xyz_image_msg_->step,
+				need_grey ? (const float*)&grey_image_msg_->data[0] : 0, need_grey ? grey_image_msg_->step : 0);
 		}
 
 		/// Set time stamp
 		ros::Time now = ros::Time::now();
-		xyz_image_msg_ptr->header.stamp = now;
-		xyz_image_msg_ptr->header.frame_id = "head_tof_link";
-		grey_image_msg_ptr->header.stamp = now;
-		grey_image_msg_ptr->header.frame_id = "head_tof_link";
-
-		tof_image_info = camera_info_msg_;
-		tof_image_info.width = grey_image_32F1_.cols;
-		tof_image_info.height = grey_image_32F1_.rows;
-		tof_image_info.header.stamp = now;
-		tof_image_info.header.frame_id = "head_tof_link";
+		if (need_xyz)
+		{
+			xyz_image_msg_->header.stamp = now;
+			xyz_image_msg_->header.frame_id = "head_tof_link";
+		}
+		if (need_grey)
+		{
+			grey_image_msg_->header.stamp = now;
+			grey_image_msg_->header.frame_id = "head_tof_link";
+		}
 
-		/// publish message
-		xyz_image_publisher_.publish(*xyz_image_msg_ptr, tof_image_info);
-		grey_image_publisher_.publish(*grey_image_msg_ptr, tof_image_info);
+		if (publish_xyz || publish_grey)
+		{
+			sensor_msgs::CameraInfoPtr tof_image_info = boost::make_shared<sensor_msgs::CameraInfo>(camera_info_msg_);
+			tof_image_info->width = image_width_;
+			tof_image_info->height = image_height_;
+			tof_image_info->header.stamp = now;
+			tof_image_info->header.frame_id = "head_tof_link";
+
+			/// publish message, intra-process subscribers share the data
+			if (publish_xyz) xyz_image_publisher_.publish(xyz_image_msg_, tof_image_info);
+			if (publish_grey) grey_image_publisher_.publish(grey_image_msg_, tof_image_info);
+		}
 
-		if(publish_point_cloud_) publishPointCloud(now);
-		if(publish_point_cloud_2_) publishPointCloud2(now);
+		if(publish_point_cloud) publishPointCloud(now);
+		if(publish_point_cloud_2) publishPointCloud2(now);
 
 		return true;
 	}
@@ -276,41 +386,45 @@ public:
     void publishPointCloud(ros::Time now)
     {
         ROS_DEBUG("convert xyz_image to point_cloud");
-        sensor_msgs::PointCloud pc_msg;
+		if (!point_cloud_msg_ || !point_cloud_msg_.unique())
+		{
+			point_cloud_msg_ = boost::make_shared<sensor_msgs::PointCloud>();
+		}
+		sensor_msgs::PointCloud& pc_msg = *point_cloud_msg_;
 		// create point_cloud message
 		pc_msg.header.stamp = now;
 		pc_msg.header.frame_id = "head_tof_link";
-
-		cv::Mat cpp_xyz_image_32F3 = xyz_image_32F3_;
-		cv::Mat cpp_grey_image_32F1 = grey_image_32F1_;
+		pc_msg.points.resize(image_width_ * image_height_);
 
 		float* f_ptr = 0;
-		for (int row = 0; row < cpp_xyz_image_32F3.rows; row++)
+		int pc_msg_idx = 0;
+		for (int row = 0; row < xyz_image_32F3_.rows; row++)
 		{
-			f_ptr = cpp_xyz_image_32F3.ptr<float>(row);
-			for (int col = 0; col < cpp_xyz_image_32F3.cols; col++)
+			f_ptr = xyz_image_32F3_.ptr<float>(row);
+			for (int col = 0; col < xyz_image_32F3_.cols; col++, pc_msg_idx++)
 			{
-				geometry_msgs::Point32 pt;
+				geometry_msgs::Point32& pt = pc_msg.points[pc_msg_idx];
 				pt.x = f_ptr[3*col + 0];
 				pt.y = f_ptr[3*col + 1];
 				pt.z = f_ptr[3*col + 2];
-				pc_msg.points.push_back(pt);
 			}
 		}
-        topicPub_pointCloud_.publish(pc_msg);
+        topicPub_pointCloud_.publish(point_cloud_msg_);
     }
 
+	/// The layout x,y,z,confidence interleaves both images, so this is the one copy left.
 	void publishPointCloud2(ros::Time now)
 	{
-		cv::Mat cpp_xyz_image_32F3 = xyz_image_32F3_;
-		cv::Mat cpp_confidence_mask_32F1 = grey_image_32F1_;
-
-		sensor_msgs::PointCloud2 pc_msg;
+		if (!point_cloud2_msg_ || !point_cloud2_msg_.unique())
+		{
+			point_cloud2_msg_ = boost::make_shared<sensor_msgs::PointCloud2>();
+		}
+		sensor_msgs::PointCloud2& pc_msg = *point_cloud2_msg_;
 		// create point_cloud message
 		pc_msg.header.stamp = now;
 		pc_msg.header.frame_id = "head_tof_link";
-		pc_msg.width = cpp_xyz_image_32F3.cols;
-		pc_msg.height = cpp_xyz_image_32F3.rows;
+		pc_msg.width = xyz_image_32F3_.cols;
+		pc_msg.height = xyz_image_32F3_.rows;
 		pc_msg.fields.resize(4);
 		pc_msg.fields[0].name = "x";
 		pc_msg.fields[0].datatype = sensor_msgs::PointField::FLOAT32;
@@ -324,6 +438,7 @@ public:
 		for (size_t d = 0; d < pc_msg.fields.size(); ++d, offset += 4)
 		{
 			pc_msg.fields[d].offset = offset;
+			pc_msg.fields[d].count = 1;
 		}
 		pc_msg.point_step = 16;
 		pc_msg.row_step = pc_msg.point_step * pc_msg.width;
@@ -331,38 +446,60 @@ public:
 		pc_msg.is_dense = true;
 		pc_msg.is_bigendian = false;
 
-		float* f_ptr = 0;
-		float* g_ptr = 0;
-		int pc_msg_idx=0;
-		for (int row = 0; row < cpp_xyz_image_32F3.rows; row++)
+		const float* f_ptr = 0;
+		const float* g_ptr = 0;
+		float* pc_ptr = (float*)&pc_msg.data[0];
+		for (int row = 0; row < xyz_image_32F3_.rows; row++)
 		{
-			f_ptr = cpp_xyz_image_32F3.ptr<float>(row);
-			g_ptr = cpp_confidence_mask_32F1.ptr<float>(row);
-			for (int col = 0; col < cpp_xyz_image_32F3.cols; col++, pc_msg_idx++)
+			f_ptr = xyz_image_32F3_.ptr<float>(row);
+			g_ptr = grey_image_32F1_.ptr<float>(row);
+			for (int col = 0; col < xyz_image_32F3_.cols; col++, pc_ptr += 4)
 			{
-				memcpy(&pc_msg.data[pc_msg_idx * pc_msg.point_step], &f_ptr[3*col], 3*sizeof(float));
-				memcpy(&pc_msg.data[pc_msg_idx * pc_msg.point_step + pc_msg.fields[3].offset], &g_ptr[col], sizeof(float));
+				pc_ptr[0] = f_ptr[3*col + 0];
+				pc_ptr[1] = f_ptr[3*col + 1];
+				pc_ptr[2] = f_ptr[3*col + 2];
+				pc_ptr[3] = g_ptr[col];
 			}
 		}
-		topicPub_pointCloud2_.publish(pc_msg);
+		topicPub_pointCloud2_.publish(point_cloud2_msg_);
 	}
 
 	bool imageSrvCallback(cob_camera_sensors::GetTOFImages::Request &req,
 			cob_camera_sensors::GetTOFImages::Response &res)
 	{
 		boost::mutex::scoped_lock lock(service_mutex_);
-		// Convert openCV IplImages to ROS messages
-		try
+
+		if (ros_node_mode_ != MODE_TOPIC)
 		{
-			IplImage grey_img = grey_image_32F1_;
-			IplImage xyz_img = xyz_image_32F3_;
-			res.greyImage = *(sensor_msgs::CvBridge::cvToImgMsg(&grey_img, "passthrough"));
-			res.xyzImage = *(sensor_msgs::CvBridge::cvToImgMsg(&xyz_img, "passthrough"));
+			// Wait for an acquisition that starts after this request
+			unsigned long acquisition = acquisition_count_ + 1;
+			boost::system_time timeout = boost::get_system_time() + boost::posix_time::seconds(5);
+			pending_requests_++;
+			request_condition_.notify_one();
+			while (acquisition_count_ < acquisition)
+			{
+				if (!frame_condition_.timed_wait(lock, timeout))
+				{
+					break;
+				}
+			}
+			pending_requests_--;
+
+			if (acquisition_count_ < acquisition || !acquisition_ok_)
+			{
+				ROS_ERROR("[tof_camera] Tof image acquisition for service request failed");
+				return false;
+			}
 		}
-		catch (sensor_msgs::CvBridgeException error)
+
+		// Copy the images of the last frame
+		if (!grey_image_msg_ || !xyz_image_msg_)
 		{
-			ROS_ERROR("[tof_camera_type_node] Could not convert IplImage to ROS message");
+			ROS_ERROR("[tof_camera_type_node] No images acquired yet");
+			return false;
 		}
+		res.greyImage = *grey_image_msg_;
+		res.xyzImage = *xyz_image_msg_;
 
 		// Set time stamp
 		ros::Time now = ros::Time::now();
@@ -462,9 +599,13 @@ public:
 		{
 			ros_node_mode_ = CobTofCameraNode::MODE_TOPIC;
 		}
+		else if (tmp_string == "MODE_ON_DEMAND")
+		{
+			ros_node_mode_ = CobTofCameraNode::MODE_ON_DEMAND;
+		}
 		else
 		{
-			std::string str = "[tof_camera] Mode '" + tmp_string + "' unknown, try 'MODE_SERVICE' or 'MODE_TOPIC'";
+			std::string str = "[tof_camera] Mode '" + tmp_string + "' unknown, try 'MODE_SERVICE', 'MODE_TOPIC' or 'MODE_ON_DEMAND'";
 			ROS_ERROR("%s", str.c_str());
 			return false;
 		}
@@ -477,6 +618,42 @@ public:
 		{
 			ROS_WARN("[tof_camera] Flag for publishing PointCloud2 not set, falling back to default (false)");
 		}
+		if (node_handle_.getParam("tof_camera/filter_xyz_flying_pixels", filter_xyz_flying_pixels_) == false)
+		{
+			ROS_WARN("[tof_camera] Flag for removing flying pixels not set, falling back to default (false)");
+		}
+		if (node_handle_.getParam("tof_camera/flying_pixel_max_distance", flying_pixel_max_distance_) == false)
+		{
+			ROS_WARN("[tof_camera] 'flying_pixel_max_distance' not set, falling back to default (%f)", flying_pixel_max_distance_);
+		}
+		if (node_handle_.getParam("tof_camera/flying_pixel_min_neighbours", flying_pixel_min_neighbours_) == false)
+		{
+			ROS_WARN("[tof_camera] 'flying_pixel_min_neighbours' not set, falling back to default (%d)", flying_pixel_min_neighbours_);
+		}
+		if (node_handle_.getParam("tof_camera/filter_temporal_median_length", filter_temporal_median_length_) == false)
+		{
+			ROS_WARN("[tof_camera] 'filter_temporal_median_length' not set, falling back to default (%d)", filter_temporal_median_length_);
+		}
+		if (node_handle_.getParam("tof_camera/filter_threads", filter_threads_) == false)
+		{
+			ROS_WARN("[tof_camera] 'filter_threads' not set, falling back to default (%d)", filter_threads_);
+		}
+
+		/// All filter stages run fused in one pass over the xyz image
+		ipa_CameraSensors::ToFFilter::t_Parameters filter_parameters;
+		filter_parameters.m_Stages = 0;
+		if (filter_xyz_by_amplitude_) filter_parameters.m_Stages |= ipa_CameraSensors::ToFFilter::STAGE_AMPLITUDE;
+		if (filter_xyz_tearoff_edges_) filter_parameters.m_Stages |= ipa_CameraSensors::ToFFilter::STAGE_TEAR_OFF_EDGES;
+		if (filter_xyz_flying_pixels_) filter_parameters.m_Stages |= ipa_CameraSensors::ToFFilter::STAGE_FLYING_PIXELS;
+		if (filter_temporal_median_length_ > 1) filter_parameters.m_Stages |= ipa_CameraSensors::ToFFilter::STAGE_TEMPORAL_MEDIAN;
+		filter_parameters.m_LowerAmplitude = (float)lower_amplitude_threshold_;
+		filter_parameters.m_UpperAmplitude = (float)upper_amplitude_threshold_;
+		filter_parameters.m_TearOffPiFraction = (float)tearoff_tear_half_fraction_;
+		filter_parameters.m_FlyingMaxDistance = (float)flying_pixel_max_distance_;
+		filter_parameters.m_FlyingMinNeighbours = flying_pixel_min_neighbours_;
+		filter_parameters.m_MedianLength = std::max(1, filter_temporal_median_length_);
+		tof_filter_.SetParameters(filter_parameters);
+		tof_filter_.SetNumberOfThreads(filter_threads_);
 
 
 		ROS_INFO("ROS node mode: %s", tmp_string.c_str());
@@ -502,13 +679,18 @@ int main(int argc, char** argv)
     /// Initialize camera node
     if (!camera_node.init()) return 0;
 
-    //ros::spin();
+    /// Service requests wait for the acquisition loop, so callbacks run on their own threads
+    ros::AsyncSpinner spinner(2);
+    spinner.start();
+
 	ros::Rate rate(100);
 	while(nh.ok())
 	{
-		camera_node.spin();
-		ros::spinOnce();
-		rate.sleep();
+		if (camera_node.waitForDemand())
+		{
+			camera_node.spin();
+			rate.sleep();
+		}
 	}
 
 	return 0;
@@ -19,7 +19,8 @@
 //#### includes ####
 
 // standard includes
-//--
+#include <string.h>
+#include <vector>
 
 // ROS includes
 #include <ros/ros.h>
@@ -33,6 +34,7 @@
 #include <sensor_msgs/CameraInfo.h>
 
 // external includes
+#include <boost/functional/hash.hpp>
 #include <opencv/cv.h>
 #include <opencv/highgui.h>
 
@@ -45,18 +47,36 @@ class UndistortTOF
 {
 private:
 	ros::NodeHandle node_handle_;
-	sensor_msgs::PointCloud2 pc2_msg_;
+	sensor_msgs::PointCloud2 pc2_msg_;	///< Undistorted point cloud, its buffer is reused as long as the layout does not change
 
 	message_filters::Subscriber<sensor_msgs::PointCloud2> sub_pc2_;
 	message_filters::Subscriber<sensor_msgs::CameraInfo> sub_camera_info_;
 	message_filters::Synchronizer<SyncPolicy> sub_sync_;
 	ros::Publisher pub_pc2_;
 
+	bool show_debug_windows_;	///< Shows the distorted and undistorted z image (needs a display)
+
+	/// Undistortion tables, valid for the camera info and point cloud layout with hash maps_hash_.
+	/// Every output pixel is interpolated bilinearly from 4 source points, given by their byte offsets
+	/// in the source cloud and their weights (0 for neighbours outside of the image).
+	bool maps_valid_;
+	std::size_t maps_hash_;
+	std::vector<int> remap_offset_;		///< 4 byte offsets per pixel
+	std::vector<float> remap_weight_;	///< 4 weights per pixel
+	std::vector<int> nearest_offset_;	///< Byte offset of the nearest source point per pixel, -1 if outside of the image
+	std::vector<float> ray_x_;			///< (u-cx)/fx per column
+	std::vector<float> ray_y_;			///< (v-cy)/fy per row
+
 public:
 	UndistortTOF(const ros::NodeHandle& node_handle)
 	: node_handle_(node_handle),
-	  sub_sync_(SyncPolicy(3))
+	  sub_sync_(SyncPolicy(3)),
+	  show_debug_windows_(false),
+	  maps_valid_(false),
+	  maps_hash_(0)
 	  {
+		node_handle_.param("undistort_tof/show_debug_windows", show_debug_windows_, false);
+
 		sub_sync_.connectInput(sub_pc2_, sub_camera_info_);
 		sub_sync_.registerCallback(boost::bind(&UndistortTOF::Undistort, this, _1, _2));
 		sub_pc2_.subscribe(node_handle_, "tof/point_cloud2", 1);
@@ -64,131 +84,218 @@ public:
 		pub_pc2_ = node_handle_.advertise<sensor_msgs::PointCloud2>("point_cloud_undistorted", 1);
 	  }
 
-	// Return value is in m
-	unsigned long GetCalibratedZSwissranger(int u, int v, int width, float& zCalibrated)
+	/// Hash of everything the undistortion tables depend on.
+	static std::size_t HashMaps(const sensor_msgs::CameraInfo& camera_info, const sensor_msgs::PointCloud2& pc)
 	{
-		//zCalibrated = (float) m_Z[v*width + u];
-
-		//return RET_OK;
+		std::size_t hash = 0;
+		boost::hash_combine(hash, pc.width);
+		boost::hash_combine(hash, pc.height);
+		boost::hash_combine(hash, pc.point_step);
+		boost::hash_combine(hash, pc.row_step);
+		boost::hash_range(hash, camera_info.D.begin(), camera_info.D.end());
+		boost::hash_range(hash, camera_info.K.begin(), camera_info.K.end());
+		return hash;
 	}
 
-	// u and v are assumed to be distorted coordinates
-	unsigned long GetCalibratedXYMatlab(int u, int v, float z, float& x, float& y)
+	/// Computes the undistortion tables (once per camera calibration).
+	bool UpdateMaps(const sensor_msgs::CameraInfo& camera_info, const sensor_msgs::PointCloud2& pc)
 	{
-		// Use intrinsic camera parameters
-		/*double fx, fy, cx, cy;
+		const int width = pc.width;
+		const int height = pc.height;
+		double fx = camera_info.K[0];
+		double fy = camera_info.K[4];
+		double cx = camera_info.K[2];
+		double cy = camera_info.K[5];
+
+		if (fx == 0 || fy == 0)
+		{
+			ROS_ERROR("[undistort_tof] Camera info contains no intrinsic parameters (fx or fy is 0)");
+			return false;
+		}
 
-		fx = m_intrinsicMatrix.at<double>(0, 0);
-		fy = m_intrinsicMatrix.at<double>(1, 1);
+		cv::Mat cam_matrix = cv::Mat::zeros(3,3,CV_64FC1);
+		cam_matrix.at<double>(0,0) = fx;
+		cam_matrix.at<double>(0,2) = cx;
+		cam_matrix.at<double>(1,1) = fy;
+		cam_matrix.at<double>(1,2) = cy;
+		cam_matrix.at<double>(2,2) = 1;
+		cv::Mat D;
+		if (!camera_info.D.empty())
+		{
+			D = cv::Mat(1, camera_info.D.size(), CV_64FC1);
+			for (size_t i = 0; i < camera_info.D.size(); i++)
+				D.at<double>(0,i) = camera_info.D[i];
+		}
 
-		cx = m_intrinsicMatrix.at<double>(0, 2);
-		cy = m_intrinsicMatrix.at<double>(1, 2);
+		// same maps as used by cv::undistort
+		cv::Mat map_x, map_y;
+		cv::initUndistortRectifyMap(cam_matrix, D, cv::Mat(), cam_matrix, cv::Size(width, height), CV_32FC1, map_x, map_y);
 
-		// Fundamental equation: u = (fx*x)/z + cx
-		if (fx == 0)
+		remap_offset_.resize(4 * width * height);
+		remap_weight_.resize(4 * width * height);
+		nearest_offset_.resize(width * height);
+		for (int row = 0, pixel = 0; row < height; row++)
 		{
-			std::cerr << "ERROR - Swissranger::GetCalibratedXYZ:" << std::endl;
-			std::cerr << "\t ... fx is 0.\n";
-			return RET_FAILED;
+			const float* sx_ptr = map_x.ptr<float>(row);
+			const float* sy_ptr = map_y.ptr<float>(row);
+			for (int col = 0; col < width; col++, pixel++)
+			{
+				float sx = sx_ptr[col];
+				float sy = sy_ptr[col];
+				int x0 = cvFloor(sx);
+				int y0 = cvFloor(sy);
+				float ax = sx - x0;
+				float ay = sy - y0;
+				const int nx[4] = {x0, x0 + 1, x0, x0 + 1};
+				const int ny[4] = {y0, y0, y0 + 1, y0 + 1};
+				const float w[4] = {(1 - ax) * (1 - ay), ax * (1 - ay), (1 - ax) * ay, ax * ay};
+
+				for (int k = 0; k < 4; k++)
+				{
+					bool inside = (nx[k] >= 0) && (nx[k] < width) && (ny[k] >= 0) && (ny[k] < height);
+					remap_offset_[4 * pixel + k] = inside ? ny[k] * pc.row_step + nx[k] * pc.point_step : 0;
+					remap_weight_[4 * pixel + k] = inside ? w[k] : 0.f;
+				}
+
+				int xn = cvRound(sx);
+				int yn = cvRound(sy);
+				if ((xn >= 0) && (xn < width) && (yn >= 0) && (yn < height))
+					nearest_offset_[pixel] = yn * pc.row_step + xn * pc.point_step;
+				else
+					nearest_offset_[pixel] = -1;
+			}
 		}
-		x = (float) (z*(u-cx)/fx) ;
 
-		// Fundamental equation: v = (fy*y)/z + cy
-		if (fy == 0)
+		// the undistorted image has the camera matrix K, so the ray of a pixel only depends on its row and column
+		ray_x_.resize(width);
+		for (int col = 0; col < width; col++)
+			ray_x_[col] = (float) ((col - cx) / fx);
+		ray_y_.resize(height);
+		for (int row = 0; row < height; row++)
+			ray_y_[row] = (float) ((row - cy) / fy);
+
+		return true;
+	}
+
+	static inline float ReadFloat(const unsigned char* p)
+	{
+		float f;
+		memcpy(&f, p, sizeof(float));
+		return f;
+	}
+
+	static inline void WriteFloat(unsigned char* p, float f)
+	{
+		memcpy(p, &f, sizeof(float));
+	}
+
+	/// Shows the z channel of a point cloud (debugging only).
+	static void ShowZImage(const char* window_name, const sensor_msgs::PointCloud2& pc, int z_offset)
+	{
+		cv::Mat z_image = cv::Mat(pc.height, pc.width, CV_32FC1);
+		for (unsigned int row = 0; row < pc.height; row++)
 		{
-			std::cerr << "ERROR - Swissranger::GetCalibratedXYZ:" << std::endl;
-			std::cerr << "\t ... fy is 0.\n";
-			return RET_FAILED;
+			float* f_ptr = z_image.ptr<float>(row);
+			for (unsigned int col = 0; col < pc.width; col++)
+				f_ptr[col] = ReadFloat(&pc.data[row * pc.row_step + col * pc.point_step + z_offset]);
 		}
-		y = (float) (z*(v-cy)/fy);
-
-		return RET_OK;*/
+		cv::imshow(window_name, z_image);
 	}
 
 	//void Undistort(const sensor_msgs::PointCloud2ConstPtr& tof_camera_data, const sensor_msgs::CameraInfoConstPtr& camera_info)
 	void Undistort(const boost::shared_ptr<sensor_msgs::PointCloud2 const>& tof_camera_data, const sensor_msgs::CameraInfoConstPtr& camera_info)
 	{
-		cv::Mat D = cv::Mat(1,4,CV_64FC1);
-		D.at<double>(0,0) = camera_info->D[0];
-		D.at<double>(0,1) = camera_info->D[1];
-		D.at<double>(0,2) = camera_info->D[2];
-		D.at<double>(0,3) = camera_info->D[3];
-		cv::Mat cam_matrix = cv::Mat::zeros(3,3,CV_64FC1);
-		cam_matrix.at<double>(0,0) = camera_info->K[0];
-		cam_matrix.at<double>(0,2) = camera_info->K[2];
-		cam_matrix.at<double>(1,1) = camera_info->K[4];
-		cam_matrix.at<double>(1,2) = camera_info->K[5];
-		cam_matrix.at<double>(2,2) = 1;
+		const sensor_msgs::PointCloud2& pc_in = *tof_camera_data;
 
-		int z_offset = 0, i_offset = 0, c_offset = 0, x_offset = 0, y_offset = 0;;
-		for (size_t d = 0; d < tof_camera_data->fields.size(); ++d)
+		int z_offset = -1, i_offset = -1, x_offset = -1, y_offset = -1;
+		for (size_t d = 0; d < pc_in.fields.size(); ++d)
 		{
-			if(tof_camera_data->fields[d].name == "x")
-				x_offset = tof_camera_data->fields[d].offset;
-			if(tof_camera_data->fields[d].name == "y")
-				y_offset = tof_camera_data->fields[d].offset;
-			if(tof_camera_data->fields[d].name == "z")
-				z_offset = tof_camera_data->fields[d].offset;
-			if(tof_camera_data->fields[d].name == "intensity")
-				i_offset = tof_camera_data->fields[d].offset;
-			if(tof_camera_data->fields[d].name == "confidence")
-				c_offset = tof_camera_data->fields[d].offset;
+			if(pc_in.fields[d].name == "x")
+				x_offset = pc_in.fields[d].offset;
+			if(pc_in.fields[d].name == "y")
+				y_offset = pc_in.fields[d].offset;
+			if(pc_in.fields[d].name == "z")
+				z_offset = pc_in.fields[d].offset;
+			if(pc_in.fields[d].name == "intensity")
+				i_offset = pc_in.fields[d].offset;
 		}
-		cv::Mat z_image = cv::Mat(tof_camera_data->height, tof_camera_data->width,CV_32FC1);
-		cv::Mat intensity_image = cv::Mat(tof_camera_data->height, tof_camera_data->width,CV_32FC1);
-		float* f_ptr = 0;
-		float* i_ptr = 0;
-		int pc_msg_idx=0;
-		for (int row = 0; row < z_image.rows; row++)
+		if (x_offset < 0 || y_offset < 0 || z_offset < 0)
 		{
-			f_ptr = z_image.ptr<float>(row);
-			i_ptr = intensity_image.ptr<float>(row);
-			for (int col = 0; col < z_image.cols; col++, pc_msg_idx++)
-			{
-				memcpy(&f_ptr[col], &tof_camera_data->data[pc_msg_idx * tof_camera_data->point_step + z_offset], sizeof(float));
-				memcpy(&i_ptr[col], &tof_camera_data->data[pc_msg_idx * tof_camera_data->point_step + i_offset], sizeof(float));
-			}
+			ROS_ERROR("[undistort_tof] Point cloud has no x, y or z field");
+			return;
+		}
+		if (pc_in.data.size() < pc_in.height * pc_in.row_step || pc_in.width * pc_in.height == 0)
+		{
+			ROS_ERROR("[undistort_tof] Point cloud is empty or smaller than given by its size");
+			return;
 		}
 
-		cv::imshow("distorted", z_image);
-		// Undistort
-		cv::Mat z_image_undistorted;
-		cv::undistort(z_image, z_image_undistorted, cam_matrix, D);
-		cv::Mat intensity_image_undistorted;
-		cv::undistort(intensity_image, intensity_image_undistorted, cam_matrix, D);
-
-		cv::imshow("undistorted", z_image_undistorted);
-		cv::waitKey(20);
-
-		sensor_msgs::PointCloud2 pc_pub = *(tof_camera_data.get());
-		// Calculate X and Y based on instrinsic rotation and translation
-		double fx, fy, cx, cy;
-
-		fx = cam_matrix.at<double>(0,0);
-		fy = cam_matrix.at<double>(1, 1);
-
-		cx = cam_matrix.at<double>(0, 2);
-		cy = cam_matrix.at<double>(1, 2);
-
-
-		for (size_t d = 0; d < pc_pub.fields.size(); ++d)
+		// the tables are only recomputed if the calibration or the layout of the cloud changes
+		std::size_t hash = HashMaps(*camera_info, pc_in);
+		if (!maps_valid_ || hash != maps_hash_)
 		{
+			maps_valid_ = UpdateMaps(*camera_info, pc_in);
+			maps_hash_ = hash;
+			if (!maps_valid_)
+				return;
 		}
-		for(unsigned int row=0; row<pc_pub.height; row++)
+
+		// the output cloud has the layout of the input, the fields are copied every time because
+		// layouts with the same point size may differ in names or offsets, the buffer keeps its
+		// capacity and is only reallocated if the cloud grows
+		pc2_msg_.header = pc_in.header;
+		pc2_msg_.width = pc_in.width;
+		pc2_msg_.height = pc_in.height;
+		pc2_msg_.fields = pc_in.fields;
+		pc2_msg_.is_bigendian = pc_in.is_bigendian;
+		pc2_msg_.point_step = pc_in.point_step;
+		pc2_msg_.row_step = pc_in.row_step;
+		pc2_msg_.data.resize(pc_in.height * pc_in.row_step);
+		pc2_msg_.is_dense = pc_in.is_dense;
+
+		// single pass: every output point takes the other fields (e.g. confidence) from the nearest source point,
+		// z and intensity are interpolated and x, y are calculated from z and the ray of the pixel
+		const unsigned char* src = &pc_in.data[0];
+		const int* offset = &remap_offset_[0];
+		const float* weight = &remap_weight_[0];
+		const int point_step = pc_in.point_step;
+		for (unsigned int row = 0, pixel = 0; row < pc_in.height; row++)
 		{
-			float* z =  z_image_undistorted.ptr<float>(row);
-			//f_ptr = (float*)(cartesianImageData + row*widthStepCartesianImage);
+			unsigned char* dst = &pc2_msg_.data[row * pc2_msg_.row_step];
+			const float ray_y = ray_y_[row];
 
-			for (unsigned int col=0; col<pc_pub.width; col++)
+			for (unsigned int col = 0; col < pc_in.width; col++, pixel++, offset += 4, weight += 4, dst += point_step)
 			{
-				memcpy(&pc_pub.data[row * col * pc_pub.point_step + z_offset], &z[col], sizeof(float));
-				float x = (float) (z[col]*(col-cx)/fx);
-				float y =  (float) (z[col]*(row-cy)/fy);
-				memcpy(&pc_pub.data[row * col * pc_pub.point_step + x_offset], &x, sizeof(float));
-				memcpy(&pc_pub.data[row * col * pc_pub.point_step + y_offset], &y, sizeof(float));
+				if (nearest_offset_[pixel] < 0)
+				{
+					memset(dst, 0, point_step);
+					continue;
+				}
+				memcpy(dst, src + nearest_offset_[pixel], point_step);
+
+				float z = weight[0] * ReadFloat(src + offset[0] + z_offset) + weight[1] * ReadFloat(src + offset[1] + z_offset) +
+					weight[2] * ReadFloat(src + offset[2] + z_offset) + weight[3] * ReadFloat(src + offset[3] + z_offset);
+				WriteFloat(dst + z_offset, z);
+				WriteFloat(dst + x_offset, z * ray_x_[col]);
+				WriteFloat(dst + y_offset, z * ray_y);
+
+				if (i_offset >= 0)
+				{
+					float intensity = weight[0] * ReadFloat(src + offset[0] + i_offset) + weight[1] * ReadFloat(src + offset[1] + i_offset) +
+						weight[2] * ReadFloat(src + offset[2] + i_offset) + weight[3] * ReadFloat(src + offset[3] + i_offset);
+					WriteFloat(dst + i_offset, intensity);
+				}
 			}
 		}
-		pub_pc2_.publish(pc_pub);
+
+		if (show_debug_windows_)
+		{
+			ShowZImage("distorted", pc_in, z_offset);
+			ShowZImage("undistorted", pc2_msg_, z_offset);
+			cv::waitKey(20);
+		}
+
+		pub_pc2_.publish(pc2_msg_);
 	}
 
 };
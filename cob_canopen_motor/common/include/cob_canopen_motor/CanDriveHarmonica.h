@@ -24,6 +24,8 @@
 
 #include <cob_canopen_motor/SDOSegmented.h>
 #include <cob_canopen_motor/ElmoRecorder.h>
+
+#include <deque>
 //-----------------------------------------------
 
 /**
@@ -42,6 +44,7 @@ public:
 		int iNumRetryOfSend;
 		int iDivForRequestStatus;
 		double dCanTimeout;
+		double dSDOTimeout;
 	};
 
 	/**
@@ -178,6 +181,12 @@ public:
 	 */
 	void setGearVelRadS(double dVelEncRadS);
 
+	/**
+	 * Sets the velocity, SYNC and heartbeat have to be sent by the caller.
+	 * By calling the function the status is requested, too.
+	 */
+	void setGearVelRadSNoSync(double dVelEncRadS);
+
 	/**
 	 * Sets the motion type drive.
 	 */
@@ -309,12 +318,35 @@ public:
 	 * 0: Configure the Recorder to record the sources Main Speed(1), Main position(2), Active current(10), Speed command(16). With iParam = iRecordingGap you specify every which time quantum (4*90usec) a new data point (of 1024 points in total) is recorded;
 	 * 1: Query Upload of recorded source (1=Main Speed, 2=Main position, 10=Active Current, 16=Speed command) with iParam and log data to file sParam = file prefix. Filename is extended with _MotorNumber_RecordedSource.log
 	 * 2: Request status of ongoing readout process
+	 * 3: Select the format of the log files with iParam (0=text .log, 1=binary .bin, 2=both), see ElmoRecorder::LogFormat
+	 * 4: Like 0, but the recording starts with the next velocity command (BG), which allows to trigger the recorders of several drives at once
 	 * 99: Abort and clear current SDO readout process
 	 * @return 0: Success, 1: Recorder hasn't been configured yet, 2: data collection still in progress
 	 *
 	*/
 	int setRecorder(int iFlag, int iParam = 0, std::string sParam = "/home/MyLog_");
 
+	/**
+	 * Returns the values of the last readout of the ElmoRecorder, see ElmoRecorder::getRecordedData().
+	 */
+	bool getRecordedData(std::vector<float>& vfValues, float* pfStepSec, TimeStamp* pTriggerTime);
+
+	/**
+	 * While throttling is enabled, the acknowledges of SDO uploads, which make the device send further segments, are held back until sendPendingSDOAck() is called.
+	 * This allows to limit the bus load of uploads, e.g. to one block per control cycle.
+	 */
+	void setSDOThrottle(bool bThrottle);
+
+	/**
+	 * Returns the number of segments the device sends after the held back SDO acknowledge, 0 if no acknowledge is held back.
+	 */
+	int getPendingSDOAckSegments() { return m_iPendingSDOAckSegments; }
+
+	/**
+	 * Sends the held back SDO acknowledge.
+	 */
+	void sendPendingSDOAck();
+
 
 	//--------------------------
 	//CanDriveHarmonica specific functions (not from CanDriveItf)
@@ -349,8 +381,41 @@ public:
 	 */
 	int getSDODataInt32(CanMsg& CMsg);
 
+	/**
+	 * CANopen: Queues an upload of a service data object (device to master).
+	 * The transfer is started as soon as the SDO channel of this node is free. Expedited or segmented transfer is chosen by the device.
+	 * With bBlockTransfer a SDO block upload is requested, which falls back to a segmented upload if the device refuses it.
+	 * The callback is invoked from evalReceivedMsg() when the transfer has finished or was aborted.
+	 * The optional dataCallback receives the data segment by segment while the transfer is running.
+	 * Don't mix queued transfers with sendSDOUpload()/sendSDODownload() on the same node, as the answers can't be told apart.
+	 */
+	void queueSDOUpload(int iObjIndex, int iObjSubIndex, SDOCallback callback, bool bBlockTransfer = false,
+		SDODataCallback dataCallback = SDODataCallback());
+
+	/**
+	 * CANopen: Queues an expedited download of a service data object (master to device).
+	 * The callback is invoked from evalReceivedMsg() when the device confirmed the download or aborted it.
+	 */
+	void queueSDODownload(int iObjIndex, int iObjSubIndex, int iData, SDOCallback callback = SDOCallback());
+
+	/**
+	 * Returns the number of queued SDO transfers of this node, including the active one.
+	 */
+	int getNumPendingSDO() { return m_SDOQueue.size(); }
+
+	/**
+	 * Aborts the active SDO transfer and drops all queued ones without invoking their callbacks.
+	 */
+	void clearSDOQueue();
+
 
 protected:
+
+	/**
+	 * Sends the velocity command, optionally followed by SYNC and heartbeat.
+	 */
+	void sendGearVelRadS(double dVelGearRadS, bool bSendSync);
+
 	// ------------------------- Parameters
 	ParamCanOpenType m_ParamCanOpen;
 	DriveParam m_DriveParam;
@@ -382,6 +447,7 @@ protected:
 	bool m_bLimSwRight;
 
 	double m_dOldPos;
+	double m_dVelEstimRadS;
 
 	std::string m_sErrorMessage;
 
@@ -404,6 +470,17 @@ protected:
 
 	segData seg_Data;
 
+	/// SDO abort code "SDO protocol timed out"
+	static const unsigned int c_iSDOTimeoutError = 0x05040000;
+
+	std::deque<SDORequest> m_SDOQueue;
+	bool m_bSDOActive;
+	TimeStamp m_SDORequestTime;
+
+	bool m_bSDOThrottle;
+	int m_iPendingSDOAckSegments;
+	CanMsg m_PendingSDOAck;
+
 
 	// ------------------------- Member functions
 	double estimVel(double dPos);
@@ -459,6 +536,49 @@ protected:
 	 */
 	void finishedSDOSegmentedTransfer();
 
+	/**
+	 * CANopen: Sends the request of the first entry in the SDO queue, if no transfer is active.
+	 */
+	void startNextSDORequest();
+
+	/**
+	 * CANopen: Finishes the active queued transfer, invokes its callback and starts the next one.
+	 * @param iErrorCode 0 on success, otherwise the SDO abort code
+	 */
+	void finishSDORequest(unsigned int iErrorCode);
+
+	/**
+	 * CANopen: Aborts the active queued transfer, if the device didn't answer within dSDOTimeout.
+	 */
+	void checkSDOTimeout();
+
+	/**
+	 * CANopen: Evaluates a SDO answer that belongs to the active queued transfer (expedited upload, download confirmation and block upload).
+	 * @return true if the message was consumed
+	 */
+	bool receivedSDOQueuedAnswer(CanMsg& msg);
+
+	/**
+	 * CANopen: Initiates a SDO block upload with the given number of segments per block.
+	 */
+	void sendSDOBlockUploadInitiate(int iObjIndex, int iObjSubIndex, int iBlockSize);
+
+	/**
+	 * CANopen: Sends a block upload command without further data (start upload, block acknowledge, end upload).
+	 * Commands that make the device send iNumSegments > 0 segments are subject to SDO throttling.
+	 */
+	void sendSDOBlockUploadCmd(int iCmd, int iData1 = 0, int iData2 = 0, int iNumSegments = 0);
+
+	/**
+	 * CANopen: Sends an acknowledge, after which the device sends iNumSegments segments, or holds it back if SDO throttling is enabled.
+	 */
+	void transmitSDOAck(CanMsg& msg, int iNumSegments);
+
+	/**
+	 * CANopen: Collects one segment of a SDO block upload and acknowledges the block when it's complete.
+	 */
+	int receivedSDOBlockSegment(CanMsg& msg);
+
 };
 //-----------------------------------------------
 #endif
@@ -19,7 +19,9 @@
 #define CANDRIVEITF_INCLUDEDEF_H
 
 //-----------------------------------------------
+#include <vector>
 #include <cob_generic_can/CanItf.h>
+#include <cob_utilities/TimeStamp.h>
 #include <cob_canopen_motor/DriveParam.h>
 #include <cob_canopen_motor/SDOSegmented.h>
 //-----------------------------------------------
@@ -149,6 +151,13 @@ public:
 	 */
 	virtual void setGearVelRadS(double dVelRadS) = 0;
 
+	/**
+	 * Sets the velocity without triggering the measurement (SYNC) and without heartbeat.
+	 * Used if the commands of all drives on the bus are sent as one batch:
+	 * the caller sends a single SYNC and heartbeat after the last command.
+	 */
+	virtual void setGearVelRadSNoSync(double dVelRadS) = 0;
+
 	/**
 	 * Sets the motion type drive.
 	 * The function is not implemented for Harmonica.
@@ -222,6 +231,29 @@ public:
      */
     virtual	int setRecorder(int iFlag, int iParam = 0, std::string sParam = "/home/MyLog") = 0;
 
+	/**
+	 * Returns the values of the last readout of the recorder.
+	 * @param pfStepSec time between two values
+	 * @param pTriggerTime start of the recording (monotonic clock)
+	 * @return false, if there is no readout
+	 */
+	virtual bool getRecordedData(std::vector<float>& vfValues, float* pfStepSec, TimeStamp* pTriggerTime) = 0;
+
+	/**
+	 * Enables holding back the acknowledges of SDO uploads to limit their bus load.
+	 */
+	virtual void setSDOThrottle(bool bThrottle) = 0;
+
+	/**
+	 * Returns the number of segments released by the held back SDO acknowledge, 0 if there is none.
+	 */
+	virtual int getPendingSDOAckSegments() = 0;
+
+	/**
+	 * Sends the held back SDO acknowledge.
+	 */
+	virtual void sendPendingSDOAck() = 0;
+
 	/**
 	 * Sends Requests for "active current" to motor via CAN
 	 */
@@ -19,6 +19,8 @@
 #define _ElmoRecorder_H
 
 #include <string>
+#include <vector>
+#include <cob_utilities/TimeStamp.h>
 #include <cob_canopen_motor/SDOSegmented.h>
 
 class CanDriveHarmonica;
@@ -32,6 +34,17 @@ class CanDriveHarmonica;
  */
 class ElmoRecorder {
 	public:
+		/**
+		* Formats of the logfile.
+		* The binary file (extension .bin) holds an "ELMOREC1" tag, drive ID, recorded object, recording step (float, s) and
+		* number of values (uint32) followed by the values (float), all in the byte order of the host.
+		*/
+		enum LogFormat {
+			LOG_TEXT = 0, /**< text file with time and value per line (extension .log) */
+			LOG_BINARY = 1, /**< binary file (extension .bin) */
+			LOG_TEXT_AND_BINARY = 2 /**< both files */
+		};
+
 		/**
 		* @param pParentHarmonicaDrive This pointer is used to give ElmoRecorder the ability to take use of CANopen functions of CanDriveHarmonica
 		*/
@@ -41,9 +54,22 @@ class ElmoRecorder {
 
 		/**
 		* Processes the collected Elmo Recorder data and saves them into a logfile.
+		* Data that was already decoded by decodeSegment() while the transfer was running is not decoded again.
 		*/
 		int processData(segData& SDOData);
 
+		/**
+		* Decodes the recorded data segment by segment while the SDO upload is running.
+		* @param iOffset Position of the segment in the uploaded data, 0 starts a new upload
+		*/
+		void decodeSegment(const unsigned char* pData, int iNumBytes, unsigned int iOffset);
+
+		/**
+		* Callback of the queued SDO upload of the recorder object. Processes the data, if the transfer was successful.
+		* @param iErrorCode 0 on success, otherwise the SDO abort code
+		*/
+		void readoutFinished(unsigned int iErrorCode, segData& SDOData);
+
 		/**
 		* Configures the Elmo Recorder to log internal data at a high frequency
 		* (This can be used for identification of the drive chain)
@@ -55,6 +81,25 @@ class ElmoRecorder {
 		*/
 		int configureElmoRecorder(int iRecordingGap, int driveID, int startImmediately = 1);
 
+		/**
+		* Has to be called when a BG (begin motion) command is sent to the drive.
+		* If the recorder waits for this trigger, the time is kept to align the recording with the ones of other drives.
+		*/
+		void beginMotion() {
+			if(m_bWaitingForTrigger) {
+				m_TriggerTime.SetNow();
+				m_bWaitingForTrigger = false;
+			}
+		}
+
+		/**
+		* Returns the values of the last processed readout.
+		* @param pfStepSec Time between two values
+		* @param pTriggerTime Time the recording was started at (monotonic clock of the host)
+		* @return false, if there is no processed readout of the current recording or the last readout failed
+		*/
+		bool getRecordedData(std::vector<float>& vfValues, float* pfStepSec, TimeStamp* pTriggerTime);
+
 		/**
 		* @param initNow Enter true to set the initialization state to true, enter false to only request the state.
 		* @return Return the initialization state of the recorder.
@@ -78,6 +123,21 @@ class ElmoRecorder {
 		*/
 		int setLogFilename(std::string sLogFileprefix);
 
+		/**
+		* @param iLogFormat One of LogFormat, default is LOG_TEXT
+		*/
+		int setLogFormat(int iLogFormat);
+
+		/**
+		* Convert the 32bit binary representation of a float to an actual 32bit float value
+		*/
+		static float convertBinaryToFloat(unsigned int iBinaryRepresentation);
+
+		/**
+		* Convert the 16bit binary representation of a float to an actual 16bit (half)float value
+		*/
+		static float convertBinaryToHalfFloat(unsigned int iBinaryRepresentation);
+
 	private:
 		/**
 		* Stores the targeted object from the time of requesting the read-out to the actual begin after "Recorder has finished" confirmation by SR
@@ -86,8 +146,31 @@ class ElmoRecorder {
 
 		float m_fRecordingStepSec;
 
+		/**
+		* Start of the recording, taken when the recorder was started or at the first BG (begin motion) after arming it
+		*/
+		TimeStamp m_TriggerTime;
+		bool m_bWaitingForTrigger;
+		bool m_bDataValid;
+
 		std::string m_sLogFilename;
 
+		int m_iLogFormat;
+
+		/**
+		* State of the decoder: header of the recorded data, bytes of an incomplete item and the decoded values
+		*/
+		bool m_bHeaderValid;
+		bool m_bDecoderValid;
+		int m_iDataType;
+		int m_iItemSize;
+		unsigned int m_iNumDataItems;
+		float m_fFloatingPointFactor;
+		unsigned char m_cPending[8];
+		int m_iNumPending;
+		unsigned int m_iDecodedBytes;
+		std::vector<float> m_vfResData[2];
+
 		/**
 		* A flag that tells, whether we are waiting for read-out until the confirmation by SR, that the recorder is ready for read-out
 		*/
@@ -118,14 +201,17 @@ class ElmoRecorder {
 		int logToFile(std::string filename, std::vector<float> vtValues[]);
 
 		/**
-		* Convert the 32bit binary representation of a float to an actual 32bit float value
+		* Log the values to a binary file, see LogFormat.
 		*/
-		float convertBinaryToFloat(unsigned int binaryRepresentation);
+		int logToBinaryFile(std::string filename, std::vector<float> vtValues[]);
+
+		void resetDecoder();
 
 		/**
-		* Convert the 16bit binary representation of a float to an actual 16bit (half)float value
+		* Decodes the header (7 bytes) or one item (m_iItemSize bytes) of the recorded data
 		*/
-		float convertBinaryToHalfFloat(unsigned int iBinaryRepresentation);
+		void decodeHeader(const unsigned char* pData);
+		void decodeItem(const unsigned char* pData);
 };
 
 #endif
@@ -19,6 +19,13 @@
 #define _SDOSegmented_H
 
 #include <vector>
+#include <boost/function.hpp>
+
+/**
+* Callback that is invoked for every chunk of data appended to a SDO collector while the transfer is running.
+* iOffset is the position of the chunk in the transferred data, a transfer that is started again begins with offset 0.
+*/
+typedef boost::function<void (const unsigned char* pData, int iNumBytes, unsigned int iOffset)> SDODataCallback;
 
 /**
 * This class is used to collect data that is uploaded to the master in an segmented SDO transfer. Additionally, it includes some administrative functions for this proccess.
@@ -43,6 +50,10 @@ class segData {
 			objectSubID = 0x00;
 			toggleBit = false;
 			statusFlag = SDO_SEG_FREE;
+			numTotalBytes = 0;
+			blockTransfer = false;
+			blockSize = 0;
+			blockSeqNo = 0;
 		}
 
 		~segData() {}
@@ -56,6 +67,28 @@ class segData {
 			objectSubID = 0x00;
 			toggleBit = false;
 			statusFlag = SDO_SEG_FREE;
+			numTotalBytes = 0;
+			blockTransfer = false;
+			blockSize = 0;
+			blockSeqNo = 0;
+			dataCallback.clear();
+		}
+
+		/**
+		* Reserve the receive buffer for the number of bytes announced in the SDO header.
+		* The capacity is kept over resetTransferData(), so repeated uploads of the same object don't reallocate.
+		*/
+		void reserveTransferData(unsigned int numBytes) {
+			if(numBytes > data.capacity()) data.reserve(numBytes);
+		}
+
+		/**
+		* Append the payload of one received segment to the collected data
+		*/
+		void appendData(const unsigned char* pData, int iNumBytes) {
+			unsigned int iOffset = data.size();
+			data.insert(data.end(), pData, pData + iNumBytes);
+			if(!dataCallback.empty()) dataCallback(pData, iNumBytes, iOffset);
 		}
 
 		//public attributes
@@ -90,10 +123,57 @@ class segData {
 		*/
 		unsigned int numTotalBytes;
 
+		/**
+		* True, if the data is collected by a SDO block upload instead of a segmented upload
+		*/
+		bool blockTransfer;
+
+		/**
+		* Number of segments per block, that was negotiated for the current block upload
+		*/
+		int blockSize;
+
+		/**
+		* Sequence number of the last segment, that was received in order during the current block
+		*/
+		int blockSeqNo;
+
 		/**
 		* This vector holds the received data byte-wise
 		*/
 		std::vector<unsigned char> data;
+
+		/**
+		* If set, every chunk of appended data is passed to this callback (e.g. to process the data while it arrives)
+		*/
+		SDODataCallback dataCallback;
+};
+
+/**
+* Callback that is invoked, when a queued SDO transfer has finished.
+* iErrorCode is 0 on success, otherwise the SDO abort code of the transfer.
+* SDOData holds the uploaded data of an upload request.
+*/
+typedef boost::function<void (unsigned int iErrorCode, segData& SDOData)> SDOCallback;
+
+/**
+* A single request in the SDO queue of a drive.
+* Requests of one node are processed one after another, as a CANopen SDO server only handles one transfer at a time.
+* Queues of different nodes are processed concurrently.
+*/
+struct SDORequest {
+	enum SDORequestType {
+		SDO_UPLOAD = 0, /**< upload (device to master), expedited or segmented as chosen by the device */
+		SDO_DOWNLOAD = 1, /**< expedited download (master to device) of a 32bit value */
+		SDO_BLOCK_UPLOAD = 2, /**< block upload, falls back to SDO_UPLOAD if the device refuses it */
+	};
+
+	int iType;
+	int iObjIndex;
+	int iObjSubIndex;
+	int iData;
+	SDOCallback callback;
+	SDODataCallback dataCallback;
 };
 
 #endif
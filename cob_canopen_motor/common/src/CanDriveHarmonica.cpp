@@ -25,6 +25,7 @@ CanDriveHarmonica::CanDriveHarmonica()
 	// Parameter
 	m_Param.iDivForRequestStatus = 10;
 	m_Param.dCanTimeout = 6;
+	m_Param.dSDOTimeout = 1;
 
 	// Variables
 	m_pCanCtrl = NULL;
@@ -34,6 +35,18 @@ CanDriveHarmonica::CanDriveHarmonica()
 	m_dAngleGearRadMem  = 0;
 	m_dVelGearMeasRadS = 0;
 
+	// all time stamps are used for intervals only -> monotonic clock (setting the system time does not trigger the watchdog),
+	// the stamps taken for every message are only compared against timeouts of 1s and more -> coarse clock is sufficient
+	m_CurrentTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE);
+	m_WatchdogTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE);
+	m_SendTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE);
+	m_SDORequestTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE);
+	m_VelCalcTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC);
+	m_FailureStartTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC);
+	m_StartTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC);
+
+	m_dOldPos = 0;
+	m_dVelEstimRadS = 0;
 	m_VelCalcTime.SetNow();
 
 	m_bLimSwLeft = false;
@@ -55,6 +68,9 @@ CanDriveHarmonica::CanDriveHarmonica()
 
 	m_bIsInitialized = false;
 
+	m_bSDOActive = false;
+	m_bSDOThrottle = false;
+	m_iPendingSDOAckSegments = 0;
 
 	ElmoRec = new ElmoRecorder(this);
 
@@ -84,6 +100,10 @@ bool CanDriveHarmonica::evalReceivedMsg(CanMsg& msg)
 
 	m_CanMsgLast = msg;
 
+	//a held back acknowledge keeps the device silent, so that's no timeout
+	if(m_bSDOActive && (m_iPendingSDOAckSegments == 0))
+		checkSDOTimeout();
+
 	//-----------------------
 	// eval answers from PDO1 - transmitted on SYNC msg
 	if (msg.m_iID == m_ParamCanOpen.iTxPDO1)
@@ -228,7 +248,15 @@ bool CanDriveHarmonica::evalReceivedMsg(CanMsg& msg)
 	{
 		m_WatchdogTime.SetNow();
 
-		if( (msg.getAt(0) >> 5) == 0) { //Received Upload SDO Segment (scs = 0)
+		if(m_bSDOActive)
+			m_SDORequestTime = m_WatchdogTime;
+
+		//During a block upload every message is a data segment without command specifier.
+		//Sequence numbers start at 1, so 0x80 is always an Abort SDO Transfer (cs = 4) and handled below.
+		if( seg_Data.blockTransfer && (seg_Data.statusFlag == segData::SDO_SEG_COLLECTING) && (msg.getAt(0) != 0x80) ) {
+			receivedSDOBlockSegment(msg);
+
+		} else if( (msg.getAt(0) >> 5) == 0) { //Received Upload SDO Segment (scs = 0)
 			//std::cout << "SDO Upload Segment received" << std::endl;
 			receivedSDODataSegment(msg);
 
@@ -239,6 +267,9 @@ bool CanDriveHarmonica::evalReceivedMsg(CanMsg& msg)
 		} else if( (msg.getAt(0) >> 5) == 4) { // Received an Abort SDO Transfer message, cs = 4
 			unsigned int iErrorNum = (msg.getAt(4) | msg.getAt(5) << 8 | msg.getAt(6) << 16 | msg.getAt(7) << 24);
 			receivedSDOTransferAbort(iErrorNum);
+
+		} else if(m_bSDOActive) { //Expedited upload, download confirmation or block upload of a queued transfer
+			receivedSDOQueuedAnswer(msg);
 		}
 
 		bRet = true;
@@ -665,6 +696,18 @@ void CanDriveHarmonica::setGearPosVelRadS(double dPosGearRad, double dVelGearRad
 
 //-----------------------------------------------
 void CanDriveHarmonica::setGearVelRadS(double dVelGearRadS)
+{
+	sendGearVelRadS(dVelGearRadS, true);
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::setGearVelRadSNoSync(double dVelGearRadS)
+{
+	sendGearVelRadS(dVelGearRadS, false);
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::sendGearVelRadS(double dVelGearRadS, bool bSendSync)
 {
 	int iVelEncIncrPeriod;
 
@@ -685,21 +728,25 @@ void CanDriveHarmonica::setGearVelRadS(double dVelGearRadS)
 
 	IntprtSetInt(8, 'J', 'V', 0, iVelEncIncrPeriod);
 	IntprtSetInt(4, 'B', 'G', 0, 0);
+	ElmoRec->beginMotion();
 
-	// request pos and vel by TPDO1, triggered by SYNC msg
-	// (to request pos by SDO use sendSDOUpload(0x6064, 0) )
-	// sync msg is: iID 0x80 with msg (0,0,0,0,0,0,0,0)
-	CanMsg msg;
-	msg.m_iID  = 0x80;
-	msg.m_iLen = 0;
-	msg.set(0,0,0,0,0,0,0,0);
-	m_pCanCtrl->transmitMsg(msg);
-
-	// send heartbeat to keep watchdog inactive
-	msg.m_iID  = 0x700;
-	msg.m_iLen = 5;
-	msg.set(0x00,0,0,0,0,0,0,0);
-	m_pCanCtrl->transmitMsg(msg);
+	if(bSendSync)
+	{
+		// request pos and vel by TPDO1, triggered by SYNC msg
+		// (to request pos by SDO use sendSDOUpload(0x6064, 0) )
+		// sync msg is: iID 0x80 with msg (0,0,0,0,0,0,0,0)
+		CanMsg msg;
+		msg.m_iID  = 0x80;
+		msg.m_iLen = 0;
+		msg.set(0,0,0,0,0,0,0,0);
+		m_pCanCtrl->transmitMsg(msg);
+
+		// send heartbeat to keep watchdog inactive
+		msg.m_iID  = 0x700;
+		msg.m_iLen = 5;
+		msg.set(0x00,0,0,0,0,0,0,0);
+		m_pCanCtrl->transmitMsg(msg);
+	}
 
 	m_CurrentTime.SetNow();
 	double dt = m_CurrentTime - m_SendTime;
@@ -955,8 +1002,12 @@ void CanDriveHarmonica::sendSDOAbort(int iObjIndex, int iObjSubIndex, unsigned i
 
 //-----------------------------------------------
 void CanDriveHarmonica::receivedSDOTransferAbort(unsigned int iErrorCode){
-	std::cout << "SDO Abort Transfer received with error code: " << iErrorCode;
-	seg_Data.statusFlag = segData::SDO_SEG_FREE;
+	std::cout << "SDO Abort Transfer received with error code: " << iErrorCode << std::endl;
+
+	if(m_bSDOActive)
+		finishSDORequest(iErrorCode);
+	else
+		seg_Data.statusFlag = segData::SDO_SEG_FREE;
 }
 
 //-----------------------------------------------
@@ -1040,6 +1091,7 @@ int CanDriveHarmonica::receivedSDOSegmentedInitiation(CanMsg& msg) {
 		//data in byte 4 to 7 contain the number of bytes to be uploaded (if Size indicator flag is set)
 		if( (msg.getAt(0) & 0x01) == 1) {
 			seg_Data.numTotalBytes = msg.getAt(7) << 24 | msg.getAt(6) << 16 | msg.getAt(5) << 8 | msg.getAt(4);
+			seg_Data.reserveTransferData(seg_Data.numTotalBytes);
 		} else seg_Data.numTotalBytes = 0;
 
 		sendSDOUploadSegmentConfirmation(seg_Data.toggleBit);
@@ -1053,6 +1105,7 @@ int CanDriveHarmonica::receivedSDOSegmentedInitiation(CanMsg& msg) {
 int CanDriveHarmonica::receivedSDODataSegment(CanMsg& msg){
 
 	int numEmptyBytes = 0;
+	unsigned char cData[7];
 
 	//Read SDO Upload Protocol:
 	//Byte 0: SSS T NNN C | SSS=Cmd-Specifier, T=ToggleBit, NNN=num of empty bytes, C=Finished
@@ -1075,8 +1128,9 @@ int CanDriveHarmonica::receivedSDODataSegment(CanMsg& msg){
 	//std::cout << "NUM empty bytes in SDO :" << numEmptyBytes << std::endl;
 
 	for(int i=1; i<=7-numEmptyBytes; i++) {
-		seg_Data.data.push_back(msg.getAt(i));
+		cData[i-1] = msg.getAt(i);
 	}
+	seg_Data.appendData(cData, 7-numEmptyBytes);
 
 	if(seg_Data.statusFlag == segData::SDO_SEG_PROCESSING) {
 		finishedSDOSegmentedTransfer();
@@ -1110,7 +1164,7 @@ void CanDriveHarmonica::sendSDOUploadSegmentConfirmation(bool toggleBit) {
 	cMsg[7] = 0x00;
 
 	CMsgTr.set(cMsg[0], cMsg[1], cMsg[2], cMsg[3], cMsg[4], cMsg[5], cMsg[6], cMsg[7]);
-	m_pCanCtrl->transmitMsg(CMsgTr);
+	transmitSDOAck(CMsgTr, 1);
 }
 
 //-----------------------------------------------
@@ -1123,27 +1177,338 @@ void CanDriveHarmonica::finishedSDOSegmentedTransfer() {
 		//abort processing?
 	}
 
-	if(seg_Data.objectID == 0x2030) {
+	if(m_bSDOActive) {
+		//queued transfer, the data is handed to the callback of the request
+		finishSDORequest(0);
+	} else if(seg_Data.objectID == 0x2030) {
 		if(ElmoRec->processData(seg_Data) == 0) seg_Data.statusFlag = segData::SDO_SEG_FREE;
 	}
 }
 
+//-----------------------------------------------
+// Queued SDO transfers
+//-----------------------------------------------
+
+//-----------------------------------------------
+void CanDriveHarmonica::queueSDOUpload(int iObjIndex, int iObjSubIndex, SDOCallback callback, bool bBlockTransfer,
+	SDODataCallback dataCallback)
+{
+	SDORequest req;
+
+	req.iType = bBlockTransfer ? SDORequest::SDO_BLOCK_UPLOAD : SDORequest::SDO_UPLOAD;
+	req.iObjIndex = iObjIndex;
+	req.iObjSubIndex = iObjSubIndex;
+	req.iData = 0;
+	req.callback = callback;
+	req.dataCallback = dataCallback;
+
+	m_SDOQueue.push_back(req);
+	startNextSDORequest();
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::queueSDODownload(int iObjIndex, int iObjSubIndex, int iData, SDOCallback callback)
+{
+	SDORequest req;
+
+	req.iType = SDORequest::SDO_DOWNLOAD;
+	req.iObjIndex = iObjIndex;
+	req.iObjSubIndex = iObjSubIndex;
+	req.iData = iData;
+	req.callback = callback;
+
+	m_SDOQueue.push_back(req);
+	startNextSDORequest();
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::clearSDOQueue()
+{
+	if(m_bSDOActive)
+		sendSDOAbort(m_SDOQueue.front().iObjIndex, m_SDOQueue.front().iObjSubIndex, 0x08000000); //general error
+
+	m_SDOQueue.clear();
+	m_bSDOActive = false;
+	m_iPendingSDOAckSegments = 0;
+	seg_Data.resetTransferData();
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::startNextSDORequest()
+{
+	// Number of segments the device may send before it waits for an acknowledge.
+	// Up to 127 are allowed, smaller blocks keep the bursts on the bus short.
+	const int c_iSDOBlockSize = 32;
+
+	if(m_bSDOActive || m_SDOQueue.empty())
+		return;
+
+	SDORequest& req = m_SDOQueue.front();
+
+	seg_Data.resetTransferData();
+	seg_Data.dataCallback = req.dataCallback;
+	seg_Data.statusFlag = segData::SDO_SEG_WAITING;
+	m_bSDOActive = true;
+	m_SDORequestTime.SetNow();
+
+	switch(req.iType) {
+		case SDORequest::SDO_DOWNLOAD:
+			sendSDODownload(req.iObjIndex, req.iObjSubIndex, req.iData);
+			break;
+
+		case SDORequest::SDO_BLOCK_UPLOAD:
+			seg_Data.blockTransfer = true;
+			seg_Data.blockSize = c_iSDOBlockSize;
+			sendSDOBlockUploadInitiate(req.iObjIndex, req.iObjSubIndex, c_iSDOBlockSize);
+			break;
+
+		default:
+			sendSDOUpload(req.iObjIndex, req.iObjSubIndex);
+			break;
+	}
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::finishSDORequest(unsigned int iErrorCode)
+{
+	if(!m_bSDOActive)
+		return;
+
+	SDORequest req = m_SDOQueue.front();
+	m_SDOQueue.pop_front();
+	m_bSDOActive = false;
+	m_iPendingSDOAckSegments = 0;
+
+	if( (iErrorCode != 0) && (iErrorCode != c_iSDOTimeoutError) && (req.iType == SDORequest::SDO_BLOCK_UPLOAD)
+		&& (seg_Data.statusFlag == segData::SDO_SEG_WAITING) )
+	{
+		// device refused the block upload initiation -> repeat as normal upload
+		// (an abort during the transfer is reported to the callback)
+		std::cout << "SDO block upload of object " << req.iObjIndex << " refused, using segmented upload" << std::endl;
+		req.iType = SDORequest::SDO_UPLOAD;
+		m_SDOQueue.push_front(req);
+	}
+	else
+	{
+		if(!req.callback.empty())
+			req.callback(iErrorCode, seg_Data);
+
+		// the callback might already have started a new transfer
+		if(!m_bSDOActive)
+			seg_Data.statusFlag = segData::SDO_SEG_FREE;
+	}
+
+	startNextSDORequest();
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::checkSDOTimeout()
+{
+	TimeStamp now(TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE);
+
+	now.SetNow();
+
+	if( (now - m_SDORequestTime) > m_Param.dSDOTimeout )
+	{
+		std::cout << "SDO transfer of object " << m_SDOQueue.front().iObjIndex << " of motor "
+			<< m_DriveParam.getDriveIdent() << " timed out" << std::endl;
+		sendSDOAbort(m_SDOQueue.front().iObjIndex, m_SDOQueue.front().iObjSubIndex, c_iSDOTimeoutError);
+		finishSDORequest(c_iSDOTimeoutError);
+	}
+}
+
+//-----------------------------------------------
+bool CanDriveHarmonica::receivedSDOQueuedAnswer(CanMsg& msg)
+{
+	SDORequest& req = m_SDOQueue.front();
+	int iCmd = msg.getAt(0);
+	int iIndex, iSubindex;
+	unsigned char cData[4];
+
+	evalSDO(msg, &iIndex, &iSubindex);
+
+	if( (iCmd & 0xE2) == 0x42 ) { //Initiate SDO Upload in expedited transfer (scs = 2 AND expedited flag = 1)
+		if( (iIndex != req.iObjIndex) || (iSubindex != req.iObjSubIndex) )
+			return false;
+
+		//bits 2,3 contain the number of empty bytes, if the size indicator is set
+		int numBytes = 4;
+		if( (iCmd & 0x01) == 0x01 )
+			numBytes = 4 - ((iCmd >> 2) & 0x03);
+
+		for(int i=0; i<numBytes; i++)
+			cData[i] = msg.getAt(4+i);
+
+		seg_Data.objectID = iIndex;
+		seg_Data.objectSubID = iSubindex;
+		seg_Data.numTotalBytes = numBytes;
+		seg_Data.appendData(cData, numBytes);
+
+		finishSDORequest(0);
+		return true;
+	}
+
+	if( (iCmd >> 5) == 3 ) { //Initiate SDO Download response (scs = 3)
+		if( (iIndex != req.iObjIndex) || (iSubindex != req.iObjSubIndex) )
+			return false;
+
+		finishSDORequest(0);
+		return true;
+	}
+
+	if( (iCmd >> 5) == 6 ) { //Block upload (scs = 6)
+		if( (iCmd & 0x01) == 0x00 ) { //ss = 0: initiate block upload
+			if( (iIndex != req.iObjIndex) || (iSubindex != req.iObjSubIndex) )
+				return false;
+
+			seg_Data.objectID = iIndex;
+			seg_Data.objectSubID = iSubindex;
+
+			//data in byte 4 to 7 contain the number of bytes to be uploaded (if size indicator flag is set)
+			if( (iCmd & 0x02) == 0x02 ) {
+				seg_Data.numTotalBytes = msg.getAt(7) << 24 | msg.getAt(6) << 16 | msg.getAt(5) << 8 | msg.getAt(4);
+				seg_Data.reserveTransferData(seg_Data.numTotalBytes);
+			}
+
+			seg_Data.blockSeqNo = 0;
+			seg_Data.statusFlag = segData::SDO_SEG_COLLECTING;
+			sendSDOBlockUploadCmd(0xA3, 0, 0, seg_Data.blockSize); //start upload
+		} else { //ss = 1: end block upload
+			//bits 2 to 4 contain the number of bytes in the last segment that don't contain data
+			unsigned int numEmptyBytes = (iCmd >> 2) & 0x07;
+			if(numEmptyBytes <= seg_Data.data.size())
+				seg_Data.data.resize(seg_Data.data.size() - numEmptyBytes);
+
+			sendSDOBlockUploadCmd(0xA1); //end upload
+			finishedSDOSegmentedTransfer();
+		}
+		return true;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::sendSDOBlockUploadInitiate(int iObjIndex, int iObjSubIndex, int iBlockSize)
+{
+	CanMsg CMsgTr;
+	const int ciInitBlockUploadReq = 0xA0; //ccs = 5, no CRC support, cs = 0
+
+	CMsgTr.m_iLen = 8;
+	CMsgTr.m_iID = m_ParamCanOpen.iRxSDO;
+
+	unsigned char cMsg[8];
+
+	cMsg[0] = ciInitBlockUploadReq;
+	cMsg[1] = iObjIndex;
+	cMsg[2] = iObjIndex >> 8;
+	cMsg[3] = iObjSubIndex;
+	cMsg[4] = iBlockSize;
+	cMsg[5] = 0x00; //protocol switch threshold: don't switch to segmented/expedited by size
+	cMsg[6] = 0x00;
+	cMsg[7] = 0x00;
+
+	CMsgTr.set(cMsg[0], cMsg[1], cMsg[2], cMsg[3], cMsg[4], cMsg[5], cMsg[6], cMsg[7]);
+	m_pCanCtrl->transmitMsg(CMsgTr);
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::sendSDOBlockUploadCmd(int iCmd, int iData1, int iData2, int iNumSegments)
+{
+	CanMsg CMsgTr;
+
+	CMsgTr.m_iLen = 8;
+	CMsgTr.m_iID = m_ParamCanOpen.iRxSDO;
+
+	CMsgTr.set(iCmd, iData1, iData2, 0, 0, 0, 0, 0);
+	if(iNumSegments > 0)
+		transmitSDOAck(CMsgTr, iNumSegments);
+	else
+		m_pCanCtrl->transmitMsg(CMsgTr);
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::transmitSDOAck(CanMsg& msg, int iNumSegments)
+{
+	if(m_bSDOThrottle) {
+		m_PendingSDOAck = msg;
+		m_iPendingSDOAckSegments = iNumSegments;
+	} else {
+		m_pCanCtrl->transmitMsg(msg);
+	}
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::setSDOThrottle(bool bThrottle)
+{
+	m_bSDOThrottle = bThrottle;
+	if(!bThrottle)
+		sendPendingSDOAck();
+}
+
+//-----------------------------------------------
+void CanDriveHarmonica::sendPendingSDOAck()
+{
+	if(m_iPendingSDOAckSegments == 0)
+		return;
+
+	m_iPendingSDOAckSegments = 0;
+	m_SDORequestTime.SetNow(); //the device answers from now on
+	m_pCanCtrl->transmitMsg(m_PendingSDOAck);
+}
+
+//-----------------------------------------------
+int CanDriveHarmonica::receivedSDOBlockSegment(CanMsg& msg)
+{
+	unsigned char cData[7];
+
+	//Read SDO Block Upload Segment:
+	//Byte 0: C SSSSSSS | C=last segment of the transfer, SSSSSSS=sequence number within the block (1..blksize)
+	//Byte 1 to 7: Data
+	int iSeqNo = msg.getAt(0) & 0x7F;
+	bool bLastSegment = (msg.getAt(0) & 0x80) != 0;
+	bool bInSequence = (iSeqNo == seg_Data.blockSeqNo + 1);
+
+	if(bInSequence) {
+		//empty bytes of the last segment are only known at end block upload, they are removed there
+		for(int i=1; i<=7; i++)
+			cData[i-1] = msg.getAt(i);
+		seg_Data.appendData(cData, 7);
+		seg_Data.blockSeqNo = iSeqNo;
+	}
+
+	//a segment out of sequence is dropped, the device repeats all segments after the acknowledged one
+	if(bLastSegment || (iSeqNo >= seg_Data.blockSize)) {
+		//after the last block only the end block upload follows
+		sendSDOBlockUploadCmd(0xA2, seg_Data.blockSeqNo, seg_Data.blockSize, bLastSegment ? 1 : seg_Data.blockSize); //block acknowledge
+
+		if(bLastSegment && bInSequence)
+			seg_Data.statusFlag = segData::SDO_SEG_PROCESSING; //waiting for end block upload
+		seg_Data.blockSeqNo = 0;
+	}
+
+	return 0;
+}
+
 //-----------------------------------------------
 double CanDriveHarmonica::estimVel(double dPos)
 {
-	double dVel;
-	double dt;
+	TimeStamp Now(TimeStamp::CLOCK_TYPE_MONOTONIC);
+	long long llDtNS;
 
-	m_CurrentTime.SetNow();
+	Now.SetNow();
+	llDtNS = Now.NanoSecSince(m_VelCalcTime);
 
-	dt = m_CurrentTime - m_VelCalcTime;
+	// positions taken less than 0.1ms apart give no usable estimate -> keep the last one
+	if (llDtNS < 100000)
+		return m_dVelEstimRadS;
 
-	dVel = (dPos - m_dOldPos)/dt;
+	m_dVelEstimRadS = (dPos - m_dOldPos) * 1e9 / double(llDtNS);
 
 	m_dOldPos = dPos;
-	m_VelCalcTime.SetNow();
+	m_VelCalcTime = Now;
 
-	return dVel;
+	return m_dVelEstimRadS;
 }
 //-----------------------------------------------
 bool CanDriveHarmonica::evalStatusRegister(int iStatus)
@@ -1394,11 +1759,32 @@ int CanDriveHarmonica::setRecorder(int iFlag, int iParam, std::string sParam) {
 
 			break;
 
+		case 3: //Select the format of the log files, param = 0: text, 1: binary, 2: both
+			ElmoRec->setLogFormat(iParam);
+			return 0;
+
+		case 4: //Configure Elmo Recorder to start with the next BG command, param = iRecordingGap
+			if(iParam < 1) iParam = 1;
+			ElmoRec->isInitialized(true);
+			ElmoRec->configureElmoRecorder(iParam, m_DriveParam.getDriveIdent(), 0);
+			return 0;
+
 		case 99: //Abort ongoing SDO data Transmission and clear collected data
-			sendSDOAbort(0x2030, 0x00, 0x08000020); //send general error abort
-			seg_Data.resetTransferData(); //!overwrites previous collected data (even from other processes)
+			if(m_bSDOActive) {
+				clearSDOQueue(); //!drops all queued transfers of this drive
+			} else {
+				sendSDOAbort(0x2030, 0x00, 0x08000020); //send general error abort
+				seg_Data.resetTransferData(); //!overwrites previous collected data (even from other processes)
+				m_iPendingSDOAckSegments = 0;
+			}
 			return 0;
 	}
 
 	return 0;
 }
+
+//-----------------------------------------------
+bool CanDriveHarmonica::getRecordedData(std::vector<float>& vfValues, float* pfStepSec, TimeStamp* pTriggerTime)
+{
+	return ElmoRec->getRecordedData(vfValues, pfStepSec, pTriggerTime);
+}
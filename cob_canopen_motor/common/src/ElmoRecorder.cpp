@@ -16,9 +16,15 @@
 
 
 #include <math.h>
+#include <string.h>
+#include <stdint.h>
 #include <vector>
 #include <stdio.h>
 #include <sstream>
+#include <boost/bind.hpp>
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 #include <cob_canopen_motor/ElmoRecorder.h>
 #include <cob_canopen_motor/CanDriveHarmonica.h>
 
@@ -27,6 +33,12 @@ ElmoRecorder::ElmoRecorder(CanDriveHarmonica * pParentHarmonicaDrive) {
 
 	m_bIsInitialized = false;
 	m_iReadoutRecorderTry = 0;
+	m_iLogFormat = LOG_TEXT;
+	m_fRecordingStepSec = 0;
+	m_TriggerTime.SetClock(TimeStamp::CLOCK_TYPE_MONOTONIC);
+	m_bWaitingForTrigger = false;
+
+	resetDecoder();
 }
 
 ElmoRecorder::~ElmoRecorder() {
@@ -64,16 +76,32 @@ int ElmoRecorder::configureElmoRecorder(int iRecordingGap, int driveID, int star
 	m_pHarmonicaDrive->IntprtSetInt(8, 'R', 'R', 0, startImmediately + 1); //2 launches immediately (8, 'R', 'R', 0, 1) launches at next BG
 
 	m_fRecordingStepSec = 0.000090 * 4 * iRecordingGap;
+	m_bDataValid = false; //data of the previous recording doesn't belong to this one
+
+	if(startImmediately == 1)
+		m_TriggerTime.SetNow();
+	m_bWaitingForTrigger = (startImmediately == 0);
 
 	return 0;
 }
 
+bool ElmoRecorder::getRecordedData(std::vector<float>& vfValues, float* pfStepSec, TimeStamp* pTriggerTime) {
+	if(!m_bDataValid)
+		return false;
+
+	vfValues = m_vfResData[1];
+	*pfStepSec = m_fRecordingStepSec;
+	*pTriggerTime = m_TriggerTime;
+	return true;
+}
+
 int ElmoRecorder::readoutRecorderTry(int iObjSubIndex) {
 	//Request the SR (status register) and begin all the read-out process with this action.
 	//SDOData.statusFlag is segData::SDO_SEG_WAITING;
 
 	m_iReadoutRecorderTry = 1;
 	m_iCurrentObject = iObjSubIndex;
+	m_bDataValid = false; //valid again only if this readout succeeds
 
 	m_pHarmonicaDrive->requestStatus();
 
@@ -110,21 +138,114 @@ int ElmoRecorder::readoutRecorder(int iObjSubIndex){
 	//initialize Upload of Recorded Data (object 0x2030)
 	int iObjIndex = 0x2030;
 
-	m_pHarmonicaDrive->sendSDOUpload(iObjIndex, iObjSubIndex);
+	//block upload needs one acknowledge per block instead of one per 7 bytes, falls back to segmented upload if unsupported
+	//the data is decoded segment by segment while it arrives, so only logging is left when the upload has finished
+	m_pHarmonicaDrive->queueSDOUpload(iObjIndex, iObjSubIndex, boost::bind(&ElmoRecorder::readoutFinished, this, _1, _2), true,
+		boost::bind(&ElmoRecorder::decodeSegment, this, _1, _2, _3));
 	m_iCurrentObject = iObjSubIndex;
 
 	return 0;
 }
 
+void ElmoRecorder::readoutFinished(unsigned int iErrorCode, segData& SDOData) {
+	if(iErrorCode == 0)
+		processData(SDOData);
+	else
+		std::cout << "Readout of recorder " << m_iDriveID << " failed with SDO abort code " << iErrorCode << std::endl;
+}
+
 int ElmoRecorder::processData(segData& SDOData) {
-	int iItemSize = 4;
-	int iItemCount = 0;
-	unsigned int iNumDataItems = 0;
-	bool bCollectFloats = true;
-	float fFloatingPointFactor = 0;
+	//decode everything now, if the data wasn't decoded (completely) while it arrived
+	if( !m_bDecoderValid || (m_iDecodedBytes < SDOData.data.size()) ) {
+		resetDecoder();
+		if(!SDOData.data.empty())
+			decodeSegment(&SDOData.data[0], SDOData.data.size(), 0);
+	}
+
+	if(!m_bHeaderValid) {
+		std::cout << "Recorded data of drive " << m_iDriveID << " is too short for the header" << std::endl;
+		SDOData.statusFlag = segData::SDO_SEG_FREE;
+		return 1;
+	}
+
+	std::cout << ">>>>>ElmoRec: HEADER INFOS<<<<<\nData type is: " << m_iDataType << std::endl;
+	std::cout << "Floating point factor for recorded values is: " << m_fFloatingPointFactor << std::endl;
+
+	if( ((SDOData.numTotalBytes-7)/m_iItemSize) != m_iNumDataItems)
+		std::cout << "SDODataSize announced in SDO-Header" << ((SDOData.numTotalBytes-7)/m_iItemSize) << " differs from NumDataItems by ElmoData-Header" <<  m_iNumDataItems << std::endl;
+	if(m_vfResData[1].size() != m_iNumDataItems)
+		std::cout << "Received " << m_vfResData[1].size() << " of " << m_iNumDataItems << " recorded data points" << std::endl;
+
+	if(m_iLogFormat != LOG_BINARY)
+		logToFile(m_sLogFilename, m_vfResData);
+	if(m_iLogFormat != LOG_TEXT)
+		logToBinaryFile(m_sLogFilename, m_vfResData);
+
+	m_bDataValid = true;
+
+	SDOData.statusFlag = segData::SDO_SEG_FREE;
+	return 0;
+}
+
+void ElmoRecorder::decodeSegment(const unsigned char* pData, int iNumBytes, unsigned int iOffset) {
+	int iNeeded, iCopy;
+
+	if(iOffset == 0)
+		resetDecoder();
 
-	std::vector<float> vfResData[2];
+	//segments are appended in order, anything else is decoded from the complete data in processData()
+	if(!m_bDecoderValid || (iOffset != m_iDecodedBytes)) {
+		m_bDecoderValid = false;
+		return;
+	}
+	m_iDecodedBytes += iNumBytes;
+
+	while(iNumBytes > 0) {
+		iNeeded = m_bHeaderValid ? m_iItemSize : 7;
+
+		if( (m_iNumPending > 0) || (iNumBytes < iNeeded) ) {
+			//item is split over two segments -> collect its bytes
+			iCopy = iNeeded - m_iNumPending;
+			if(iCopy > iNumBytes)
+				iCopy = iNumBytes;
+			memcpy(m_cPending + m_iNumPending, pData, iCopy);
+			m_iNumPending += iCopy;
+			pData += iCopy;
+			iNumBytes -= iCopy;
+			if(m_iNumPending < iNeeded)
+				break;
+
+			m_iNumPending = 0;
+			if(m_bHeaderValid)
+				decodeItem(m_cPending);
+			else
+				decodeHeader(m_cPending);
+		} else {
+			if(m_bHeaderValid)
+				decodeItem(pData);
+			else
+				decodeHeader(pData);
+			pData += iNeeded;
+			iNumBytes -= iNeeded;
+		}
+	}
+}
+
+void ElmoRecorder::resetDecoder() {
+	m_bHeaderValid = false;
+	m_bDecoderValid = true;
+	m_bDataValid = false;
+	m_iDataType = 0;
+	m_iItemSize = 4;
+	m_iNumDataItems = 0;
+	m_fFloatingPointFactor = 0;
+	m_iNumPending = 0;
+	m_iDecodedBytes = 0;
+	m_vfResData[0].clear();
+	m_vfResData[1].clear();
+}
 
+void ElmoRecorder::decodeHeader(const unsigned char* pData) {
 	//see SimplIQ CANopen DS 301 Implementation Guide, object 0x2030
 
 	//HEADER
@@ -132,77 +253,44 @@ int ElmoRecorder::processData(segData& SDOData) {
 	//First 7 Bytes of the data sequence contain header information:
 	//Byte 0: First four bits: 4 = Long Int data type, 1 = Half Float data type, 5 = Double Float
 	//			Next four bits: Recording frequency in 1 per n * TS => deltaT =  n * 90µsec
-	//Byte 2, Byte 3: Number of recorded data points
+	//Byte 1, Byte 2: Number of recorded data points
 	//Byte 3 to 6: Floating point factor for data to be multiplied with
 	//
 	//Byte 7 to Byte (7+ iNumdataItems * 4) contain data
+	m_iDataType = pData[0] >> 4;
+	m_iItemSize = (m_iDataType == 1) ? 2 : 4;
 
-	//B[0]: Time quantum and data type
-	switch ((SDOData.data[0] >> 4) ) {
-		case 4:
-			bCollectFloats = false;
-			iItemSize = 4;
-			break;
-		case 5:
-			bCollectFloats = true;
-			iItemSize = 4;
-			break;
-		case 1:
-			bCollectFloats = true;
-			iItemSize = 2;
-			break;
-		default:
-			bCollectFloats = false;
-			iItemSize = 4;
-			break;
-	}
-	std::cout << ">>>>>ElmoRec: HEADER INFOS<<<<<\nData type is: " << (SDOData.data[0] >> 4) << std::endl;
-
-	//std::cout << "fTimeQuantum from Header is " << fTimeQuantum << " m_fRecordingStepSec is " << m_fRecordingStepSec << std::endl;
-
-
-	//B[1]..[2] //Number of recorded items
-	iNumDataItems = (SDOData.data[2] << 8 | SDOData.data[1]);
-	//std::cout << "Number of recorded data points: " << iNumDataItems << std::endl;
+	m_iNumDataItems = (pData[2] << 8 | pData[1]);
 
-	//B[3] ... [6] //Floating point factor
-	fFloatingPointFactor = convertBinaryToFloat( (SDOData.data[6] << 24) | (SDOData.data[5] << 16) | (SDOData.data[4] << 8) | (SDOData.data[3]) );
-	std::cout << "Floating point factor for recorded values is: " << fFloatingPointFactor << std::endl;
+	m_fFloatingPointFactor = convertBinaryToFloat( (pData[6] << 24) | (pData[5] << 16) | (pData[4] << 8) | (pData[3]) );
 
+	m_vfResData[0].reserve(m_iNumDataItems);
+	m_vfResData[1].reserve(m_iNumDataItems);
+	m_bHeaderValid = true;
+}
 
-	if( ((SDOData.numTotalBytes-7)/iItemSize) != iNumDataItems)
-		std::cout << "SDODataSize announced in SDO-Header" << ((SDOData.numTotalBytes-7)/iItemSize) << " differs from NumDataItems by ElmoData-Header" <<  iNumDataItems << std::endl;
-	//END HEADER
-	//--------------------------------------
+void ElmoRecorder::decodeItem(const unsigned char* pData) {
+	float fValue;
 
-	vfResData[0].assign(iNumDataItems, 0.0);
-	vfResData[1].assign(iNumDataItems, 0.0);
-	iItemCount = 0;
+	//the last segment may be padded
+	if(m_vfResData[1].size() >= m_iNumDataItems)
+		return;
 
 	//extract values from data stream, consider Little Endian conversion for every single object!
-	for(unsigned int i=7;i<=SDOData.data.size() - iItemSize; i=i+iItemSize) {
-		if(bCollectFloats) {
-			if(iItemSize == 4)
-				vfResData[1][iItemCount] = fFloatingPointFactor * convertBinaryToFloat( (SDOData.data[i] << 0) | (SDOData.data[i+1] << 8) | (SDOData.data[i+2] << 16) | (SDOData.data[i+3] << 24) );
-
-				//DEBUG
-				if(iItemCount == 120)
-					std::cout << (unsigned int)( (SDOData.data[i] << 0) | (SDOData.data[i+1] << 8) | (SDOData.data[i+2] << 16) | (SDOData.data[i+3] << 24) ) << std::endl;
-
-			else vfResData[1][iItemCount] = fFloatingPointFactor * convertBinaryToHalfFloat( (SDOData.data[i] << 0) | (SDOData.data[i+1] << 8) | (SDOData.data[i+2] << 16) | (SDOData.data[i+3] << 24) );
-			iItemCount ++;
-		} else {
-			vfResData[1][iItemCount] = fFloatingPointFactor * (float)( (SDOData.data[i] << 0) | (SDOData.data[i+1] << 8) | (SDOData.data[i+2] << 16) | (SDOData.data[i+3] << 24) );
-			iItemCount ++;
-		}
-
-		vfResData[0][iItemCount] = m_fRecordingStepSec * iItemCount;
+	switch(m_iDataType) {
+		case 5:
+			fValue = convertBinaryToFloat( (pData[0] << 0) | (pData[1] << 8) | (pData[2] << 16) | (pData[3] << 24) );
+			break;
+		case 1:
+			fValue = convertBinaryToHalfFloat( (pData[0] << 0) | (pData[1] << 8) );
+			break;
+		default:
+			fValue = (float)(int32_t)( (pData[0] << 0) | (pData[1] << 8) | (pData[2] << 16) | (pData[3] << 24) );
+			break;
 	}
 
-	logToFile(m_sLogFilename, vfResData);
-
-	SDOData.statusFlag = segData::SDO_SEG_FREE;
-	return 0;
+	m_vfResData[0].push_back(m_fRecordingStepSec * m_vfResData[1].size());
+	m_vfResData[1].push_back(m_fFloatingPointFactor * fValue);
 }
 
 int ElmoRecorder::setLogFilename(std::string sLogFileprefix) {
@@ -210,60 +298,83 @@ int ElmoRecorder::setLogFilename(std::string sLogFileprefix) {
 	return 0;
 }
 
-
+int ElmoRecorder::setLogFormat(int iLogFormat) {
+	if( (iLogFormat < LOG_TEXT) || (iLogFormat > LOG_TEXT_AND_BINARY) ) {
+		std::cout << "Unknown log format " << iLogFormat << " of Elmo Recorder, using text format" << std::endl;
+		iLogFormat = LOG_TEXT;
+	}
+	m_iLogFormat = iLogFormat;
+	return 0;
+}
 
 float ElmoRecorder::convertBinaryToFloat(unsigned int iBinaryRepresentation) {
-	//Converting binary-numbers to 32bit float values according to IEEE 754 see http://de.wikipedia.org/wiki/IEEE_754
-	int iSign;
-	int iExponent;
-	unsigned int iMantissa;
-	float iNumMantissa = 0.0f;
-
-	if((iBinaryRepresentation & (1 << 31)) == 0) //first bit is sign bit: 0 = +, 1 = -
-		iSign = 1;
-	else
-		iSign = -1;
-
-	iExponent = ((iBinaryRepresentation >> 23) & 0xFF) - 127; //take away Bias(127) for positive and negative exponents
-
-	iMantissa = (iBinaryRepresentation & 0x7FFFFF); //only keep mantissa part of binary number
+	//the recorder sends floats according to IEEE 754, as used by the host -> reinterpret the bits
+	uint32_t iBits = iBinaryRepresentation;
+	float fValue;
 
-	iNumMantissa = 1.0f;
+	memcpy(&fValue, &iBits, sizeof(fValue));
+	return fValue;
+}
 
-	for(int i=1; i<=23; i++) { //calculate decimal places (convert binary mantissa to decimal number
-		if((iMantissa & (1 << (23-i))) > 0) {
-			iNumMantissa = iNumMantissa + pow(2,(-1)*i);
+namespace {
+
+// Tables for the conversion of 16bit to 32bit floats (see J. van der Zijp, "Fast Half Float Conversions"):
+// the bits of the float are mantissa[offset[h >> 10] + (h & 0x3FF)] + exponent[h >> 10]
+struct HalfFloatTables {
+	uint32_t mantissa[2048];
+	uint32_t exponent[64];
+	uint16_t offset[64];
+
+	HalfFloatTables() {
+		uint32_t m, e;
+
+		mantissa[0] = 0;
+		for(int i = 1; i < 1024; i++) { //subnormals: normalize mantissa
+			m = i << 13;
+			e = 0;
+			while((m & 0x00800000) == 0) {
+				e -= 0x00800000;
+				m <<= 1;
+			}
+			m &= ~0x00800000;
+			e += 0x38800000;
+			mantissa[i] = m | e;
 		}
+		for(int i = 1024; i < 2048; i++)
+			mantissa[i] = 0x38000000 + ((i - 1024) << 13);
+
+		exponent[0] = 0;
+		for(int i = 1; i < 31; i++)
+			exponent[i] = i << 23;
+		exponent[31] = 0x47800000; //inf, nan
+		exponent[32] = 0x80000000;
+		for(int i = 33; i < 63; i++)
+			exponent[i] = 0x80000000 + ((i - 32) << 23);
+		exponent[63] = 0xC7800000;
+
+		for(int i = 0; i < 64; i++)
+			offset[i] = 1024;
+		offset[0] = 0;
+		offset[32] = 0;
 	}
+};
 
-	return iSign * pow(2,iExponent) * iNumMantissa;
 }
 
 float ElmoRecorder::convertBinaryToHalfFloat(unsigned int iBinaryRepresentation) {
 	//Converting binary-numbers to 16bit float values according to IEEE 754 see http://de.wikipedia.org/wiki/IEEE_754
-	int iSign;
-	int iExponent;
-	unsigned int iMantissa;
-	float iNumMantissa = 0.0f;
-
-	if((iBinaryRepresentation & (1 << 15)) == 0) //first bit is sign bit: 0 = +, 1 = -
-		iSign = 1;
-	else
-		iSign = -1;
-
-	iExponent = ((iBinaryRepresentation >> 10) & 0x1F) - 15; //take away Bias(15) for positive and negative exponents
-
-	iMantissa = (iBinaryRepresentation & 0x3FF); //only keep mantissa part of binary number
-
-	iNumMantissa = 1.0f;
-
-	for(int i=1; i<=10; i++) { //calculate decimal places (convert binary mantissa to decimal number
-		if((iMantissa & (1 << (10-i))) > 0) {
-			iNumMantissa = iNumMantissa + pow(2,(-1)*i);
-		}
-	}
-
-	return iSign * pow(2,iExponent) * iNumMantissa;
+	unsigned int iHalf = iBinaryRepresentation & 0xFFFF;
+
+#if defined(__F16C__)
+	return _cvtsh_ss(iHalf);
+#else
+	static const HalfFloatTables tables;
+	uint32_t iBits = tables.mantissa[tables.offset[iHalf >> 10] + (iHalf & 0x3FF)] + tables.exponent[iHalf >> 10];
+	float fValue;
+
+	memcpy(&fValue, &iBits, sizeof(fValue));
+	return fValue;
+#endif
 }
 
 // Function for writing Logfile
@@ -290,3 +401,37 @@ int ElmoRecorder::logToFile(std::string filename, std::vector<float> vtValues[])
 
 	return true;
 }
+
+// Function for writing binary Logfile
+int ElmoRecorder::logToBinaryFile(std::string filename, std::vector<float> vtValues[]) {
+	std::stringstream outputFileName;
+	outputFileName << filename << "mot_" << m_iDriveID << "_" << m_iCurrentObject << ".bin";
+
+	const char cTag[8] = {'E', 'L', 'M', 'O', 'R', 'E', 'C', '1'};
+	uint32_t iDriveID = m_iDriveID;
+	uint32_t iObject = m_iCurrentObject;
+	uint32_t iNumValues = vtValues[1].size();
+	float fStep = m_fRecordingStepSec;
+
+	FILE* pFile;
+	pFile = fopen(outputFileName.str().c_str(), "wb");
+
+	if( pFile == NULL )
+	{
+		std::cout << "Error while writing file: " << outputFileName.str() << " Maybe the selected folder does'nt exist." << std::endl;
+	}
+	else
+	{
+		// the time of value i is i * step, so only the values are written
+		fwrite(cTag, 1, sizeof(cTag), pFile);
+		fwrite(&iDriveID, sizeof(iDriveID), 1, pFile);
+		fwrite(&iObject, sizeof(iObject), 1, pFile);
+		fwrite(&fStep, sizeof(fStep), 1, pFile);
+		fwrite(&iNumValues, sizeof(iNumValues), 1, pFile);
+		if(iNumValues > 0)
+			fwrite(&vtValues[1][0], sizeof(float), iNumValues, pFile);
+		fclose(pFile);
+	}
+
+	return true;
+}
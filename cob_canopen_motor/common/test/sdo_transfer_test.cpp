@@ -0,0 +1,165 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_canopen_motor/CanDriveHarmonica.h>
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <vector>
+
+// Checks the queued SDO block upload of CanDriveHarmonica against scripted device answers.
+
+static const int c_iTxSDO = 0x581;
+static const int c_iRxSDO = 0x601;
+static const int c_iObjIndex = 0x2030;
+static const int c_iObjSubIndex = 1;
+
+/// CAN interface which records the transmitted messages.
+class RecordingCanItf : public CanItf
+{
+public:
+	RecordingCanItf() { setCanItfType(CAN_DUMMY); }
+
+	bool init_ret() { return true; }
+	void init() { }
+	bool transmitMsg(CanMsg CMsg, bool bBlocking = true) { m_Sent.push_back(CMsg); return true; }
+	bool receiveMsg(CanMsg* pCMsg) { return false; }
+	bool receiveMsgRetry(CanMsg* pCMsg, int iNrOfRetry) { return false; }
+	bool receiveMsgTimeout(CanMsg* pCMsg, int nMicroSecTimeout) { return false; }
+	bool isObjectMode() { return false; }
+
+	std::vector<CanMsg> m_Sent;
+};
+
+struct Result
+{
+	Result() : iCalls(0), iErrorCode(0), iNumBytes(0) {}
+	int iCalls;
+	unsigned int iErrorCode;
+	int iNumBytes;
+};
+
+static void onSDOFinished(Result* pResult, unsigned int iErrorCode, segData& SDOData)
+{
+	pResult->iCalls++;
+	pResult->iErrorCode = iErrorCode;
+	pResult->iNumBytes = SDOData.data.size();
+}
+
+static void receive(CanDriveHarmonica& drive, int iByte0, int iByte1 = 0, int iByte2 = 0, int iByte3 = 0,
+	int iByte4 = 0, int iByte5 = 0, int iByte6 = 0, int iByte7 = 0)
+{
+	CanMsg msg;
+	msg.m_iID = c_iTxSDO;
+	msg.set(iByte0, iByte1, iByte2, iByte3, iByte4, iByte5, iByte6, iByte7);
+	drive.evalReceivedMsg(msg);
+}
+
+static void receiveAbort(CanDriveHarmonica& drive, unsigned int iErrorCode)
+{
+	receive(drive, 0x80, c_iObjIndex, c_iObjIndex >> 8, c_iObjSubIndex,
+		iErrorCode, iErrorCode >> 8, iErrorCode >> 16, iErrorCode >> 24);
+}
+
+static bool check(bool bCondition, const char* pcCase, const char* pcWhat)
+{
+	if(!bCondition)
+		std::cerr << "FAILED - " << pcCase << ": " << pcWhat << std::endl;
+	return bCondition;
+}
+
+static void setup(CanDriveHarmonica& drive, RecordingCanItf& can, Result& result)
+{
+	drive.setCanItf(&can);
+	drive.setCanOpenParam(0x181, 0x281, 0x301, c_iTxSDO, c_iRxSDO);
+	drive.queueSDOUpload(c_iObjIndex, c_iObjSubIndex, boost::bind(&onSDOFinished, &result, _1, _2), true);
+}
+
+// 10 bytes in two segments, the second one (0x82) shares the bits of cs = 4 with an abort
+static bool testBlockUpload()
+{
+	const char* pcCase = "block upload";
+	CanDriveHarmonica drive;
+	RecordingCanItf can;
+	Result result;
+	bool bOk = true;
+
+	setup(drive, can, result);
+	receive(drive, 0xC2, c_iObjIndex, c_iObjIndex >> 8, c_iObjSubIndex, 10); //initiate, size indicated
+	receive(drive, 0x01, 1, 2, 3, 4, 5, 6, 7);
+	receive(drive, 0x82, 8, 9, 10);
+	receive(drive, 0xC1 | (4 << 2)); //end, 4 empty bytes in the last segment
+
+	bOk &= check(result.iCalls == 1, pcCase, "callback not invoked once");
+	bOk &= check(result.iErrorCode == 0, pcCase, "transfer failed");
+	bOk &= check(result.iNumBytes == 10, pcCase, "wrong number of bytes");
+	bOk &= check(!can.m_Sent.empty() && (can.m_Sent.back().getAt(0) == 0xA1), pcCase, "end not confirmed");
+	return bOk;
+}
+
+// the device aborts while segments are collected -> the abort code reaches the callback
+static bool testAbortDuringBlockUpload()
+{
+	const char* pcCase = "abort during block upload";
+	const unsigned int c_iAbortCode = 0x08000020; //data can't be transferred to the application
+	CanDriveHarmonica drive;
+	RecordingCanItf can;
+	Result result;
+	bool bOk = true;
+
+	setup(drive, can, result);
+	receive(drive, 0xC2, c_iObjIndex, c_iObjIndex >> 8, c_iObjSubIndex, 100);
+	receive(drive, 0x01, 1, 2, 3, 4, 5, 6, 7);
+	size_t iNumSent = can.m_Sent.size();
+	receiveAbort(drive, c_iAbortCode);
+
+	bOk &= check(result.iCalls == 1, pcCase, "callback not invoked once");
+	bOk &= check(result.iErrorCode == c_iAbortCode, pcCase, "abort code lost");
+	bOk &= check(can.m_Sent.size() == iNumSent, pcCase, "answered the abort");
+	bOk &= check(drive.getNumPendingSDO() == 0, pcCase, "request still queued");
+	return bOk;
+}
+
+// the device refuses the block upload -> it is repeated as segmented upload
+static bool testBlockUploadRefused()
+{
+	const char* pcCase = "block upload refused";
+	CanDriveHarmonica drive;
+	RecordingCanItf can;
+	Result result;
+	bool bOk = true;
+
+	setup(drive, can, result);
+	receiveAbort(drive, 0x05040001); //command specifier not valid
+
+	bOk &= check(result.iCalls == 0, pcCase, "callback invoked");
+	bOk &= check(drive.getNumPendingSDO() == 1, pcCase, "request dropped");
+	bOk &= check(!can.m_Sent.empty() && (can.m_Sent.back().getAt(0) == 0x40), pcCase, "no segmented upload requested");
+	return bOk;
+}
+
+int main(int argc, char** argv)
+{
+	bool bOk = true;
+
+	bOk &= testBlockUpload();
+	bOk &= testAbortDuringBlockUpload();
+	bOk &= testBlockUploadRefused();
+
+	std::cout << (bOk ? "All SDO transfer tests passed" : "SDO transfer tests failed") << std::endl;
+	return bOk ? 0 : 1;
+}
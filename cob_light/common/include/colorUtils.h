@@ -26,6 +26,9 @@ namespace color
 struct rgba
 {
 	rgba(): r(0.0), g(0.0), b(0.0), a(0.0) {}
+	bool operator==(const rgba& other) const
+		{ return r == other.r && g == other.g && b == other.b && a == other.a; }
+	bool operator!=(const rgba& other) const { return !(*this == other); }
 	float r;
 	float g;
 	float b;
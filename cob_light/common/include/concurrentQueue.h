@@ -15,56 +15,112 @@
  */
 
 
-#include <iostream>
+#ifndef CONCURRENTQUEUE_H
+#define CONCURRENTQUEUE_H
+
+#include <boost/atomic.hpp>
 #include <boost/thread.hpp>
-#include <boost/circular_buffer.hpp>
 
+// Single producer, single consumer mailbox, which holds only the latest value.
+// A value pushed before the previous one was popped replaces it. Producer and consumer
+// swap three slots with one atomic exchange (triple buffering), so neither blocks the
+// other, and the slots keep their memory, e.g. the capacity of a vector.
+// The mutex is only used to wake a consumer waiting in wait().
 template<typename T>
 class ConcurrentQueue
 {
 private:
-    boost::circular_buffer<T> _queue;
-    mutable boost::mutex _mutex;
+    enum { FRESH = 4, SLOT_MASK = 3 };
+
+    T _slots[3];
+    int _back;                  // written by the producer
+    int _front;                 // read by the consumer
+    boost::atomic<int> _middle; // slot index of the latest value | FRESH if not popped yet
+
+    boost::atomic<bool> _waiting;
+    boost::mutex _mutex;
     boost::condition_variable _condition;
+
 public:
     ConcurrentQueue()
-	: _queue(2)
-	{
-	}
+    : _back(0), _front(1), _middle(2), _waiting(false)
+    {
+    }
 
     bool empty() const
     {
-        boost::mutex::scoped_lock lock(_mutex);
-        return _queue.empty();
+        return (_middle.load() & FRESH) == 0;
+    }
+
+    // Slot of the producer, fill it and call publish()
+    T& back()
+    {
+        return _slots[_back];
+    }
+
+    // Hands back() to the consumer, an unpopped value is dropped
+    void publish()
+    {
+        _back = _middle.exchange(_back | FRESH) & SLOT_MASK;
+        if(_waiting.load())
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _condition.notify_one();
+        }
     }
 
     void push(T const& data)
     {
-        boost::mutex::scoped_lock lock(_mutex);
-        _queue.push_back(data);
-        lock.unlock();
-        _condition.notify_one();
+        back() = data;
+        publish();
+    }
+
+    // Returns the latest value or NULL, if there is no new one.
+    // The value is valid until the next call.
+    const T* acquire()
+    {
+        if(empty())
+            return NULL;
+        _front = _middle.exchange(_front) & SLOT_MASK;
+        return &_slots[_front];
     }
 
     bool pop(T& data)
     {
-        boost::mutex::scoped_lock lock(_mutex);
-        if(_queue.empty())
+        const T* latest = acquire();
+        if(latest == NULL)
             return false;
-
-        data = _queue.front();
-        _queue.pop_front();
-
+        data = *latest;
         return true;
     }
 
-    void wait_pop(T& data)
+    // Blocks until a value is available, interruption point
+    void wait()
     {
+        if(!empty())
+            return;
         boost::mutex::scoped_lock lock(_mutex);
-        while(_queue.empty())
-        	_condition.wait(lock);
+        _waiting.store(true);
+        while(empty())
+        {
+            try
+            {
+                _condition.wait(lock);
+            }
+            catch(boost::thread_interrupted&)
+            {
+                _waiting.store(false);
+                throw;
+            }
+        }
+        _waiting.store(false);
+    }
 
-        data=_queue.front();
-        _queue.pop_front();
+    void wait_pop(T& data)
+    {
+        wait();
+        pop(data);
     }
 };
+
+#endif
@@ -21,15 +21,16 @@
 #include <ros/ros.h>
 #include <colorUtils.h>
 #include <boost/signals2.hpp>
-#include <boost/thread.hpp>
 
 class Mode
 {
 public:
+    /// rate of the ModeExecutor's scheduler, execute() computes one frame per tick
+    static const unsigned int UPDATE_RATE_HZ = 100;
+
     Mode(int priority = 0, double freq = 0, int pulses = 0, double timeout = 0)
         : _priority(priority), _freq(freq), _pulses(pulses), _timeout(timeout),
-          _finished(false), _pulsed(0), _isStopRequested(false), _isPauseRequested(false),
-          _isRunning(false)
+          _finished(false), _pulsed(0), _isRunning(false)
           {
               if(this->getFrequency() == 0.0)
                   this->setFrequency(1.0);
@@ -38,45 +39,44 @@ public:
 
     void start()
     {
-        if(_thread == NULL)
-            _thread.reset(new boost::thread(&Mode::run, this));
-        if(isPauseRequested())
-        {
-            boost::mutex::scoped_lock lock(_mutex_pause);
-            _isPauseRequested = false;
-            _cond_pause.notify_one();
-        }
+        if(_timeStart.isZero())
+            _timeStart = ros::Time::now();
         _isRunning = true;
     }
 
     void stop()
     {
-        _mutex.lock();
-        _isStopRequested = true;
-        _mutex.unlock();
-        if(isPauseRequested())
-        {
-            _isPauseRequested = false;
-            boost::mutex::scoped_lock lock(_mutex_pause);
-            _cond_pause.notify_one();
-        }
-        if(_thread != NULL)
-        {
-            _thread->join();
-            _thread.reset();
-        }
-        _isStopRequested = false;
+        _timeStart = ros::Time();
         _isRunning = false;
     }
 
     void pause()
     {
-        _mutex.lock();
-        _isPauseRequested = true;
-        _mutex.unlock();
         _isRunning = false;
     }
 
+    /**
+     * Computes the next frame, called by the ModeExecutor at UPDATE_RATE_HZ while the mode runs.
+     * A paused mode is not ticked, so its frames depend on the number of ticks it was running.
+     * @return false, if the mode finished its pulses or timed out
+     */
+    bool tick()
+    {
+        this->execute();
+
+        if((this->getPulses() != 0) &&
+            (this->getPulses() <= this->pulsed()))
+            return false;
+
+        if(this->getTimeout() != 0)
+        {
+            ros::Duration timePassed = ros::Time::now() - _timeStart;
+            if(timePassed.toSec() >= this->getTimeout())
+                return false;
+        }
+        return true;
+    }
+
     virtual void execute() = 0;
 
     virtual std::string getName() = 0;
@@ -107,7 +107,6 @@ public:
 
     boost::signals2::signal<void (color::rgba color)>* signalColorReady(){ return &m_sigColorReady; }
     boost::signals2::signal<void (std::vector<color::rgba> colors)>* signalColorsReady(){ return &m_sigColorsReady; }
-    boost::signals2::signal<void (int)>* signalModeFinished(){ return &m_sigFinished; }
 
 protected:
     int _priority;
@@ -123,72 +122,12 @@ protected:
     color::rgba _actualColor;
     color::rgba _init_color;
 
-    static const unsigned int UPDATE_RATE_HZ = 100;
-
     boost::signals2::signal<void (color::rgba color)> m_sigColorReady;
     boost::signals2::signal<void (std::vector<color::rgba> colors)> m_sigColorsReady;
-    boost::signals2::signal<void (int)> m_sigFinished;
 
 private:
-    boost::shared_ptr<boost::thread> _thread;
-    boost::mutex _mutex;
-    boost::mutex _mutex_pause;
-    bool _isStopRequested;
-    bool _isPauseRequested;
+    ros::Time _timeStart;
     bool _isRunning;
-
-    boost::condition_variable _cond_pause;
-
-    bool isStopRequested()
-    {
-        bool ret;
-        _mutex.lock();
-        ret = _isStopRequested;
-        _mutex.unlock();
-        return ret;
-    }
-
-    bool isPauseRequested()
-    {
-        bool ret;
-        _mutex.lock();
-        ret = _isPauseRequested;
-        _mutex.unlock();
-        return ret;
-    }
-
-protected:
-    virtual void run()
-    {
-        ros::Rate r(UPDATE_RATE_HZ);
-
-        ros::Time timeStart = ros::Time::now();
-
-        while(!isStopRequested() && !ros::isShuttingDown())
-        {
-            while(isPauseRequested())
-            {
-                boost::mutex::scoped_lock lock(_mutex_pause);
-                _cond_pause.wait(lock);
-            }
-            this->execute();
-
-            if((this->getPulses() != 0) &&
-                (this->getPulses() <= this->pulsed()))
-                break;
-
-            if(this->getTimeout() != 0)
-            {
-                ros::Duration timePassed = ros::Time::now() - timeStart;
-                if(timePassed.toSec() >= this->getTimeout())
-                    break;
-            }
-            r.sleep();
-        }
-        ROS_DEBUG("Mode %s finished",this->getName().c_str());
-        if(!isStopRequested())
-            m_sigFinished(this->getPriority());
-    }
 };
 
 #endif
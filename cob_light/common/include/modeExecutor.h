@@ -24,7 +24,14 @@
 #include <boost/thread.hpp>
 #include <boost/lambda/bind.hpp>
 #include <map>
+#include <vector>
 
+/**
+ * Executes the mode with the highest priority.
+ * One scheduler thread ticks the running mode at Mode::UPDATE_RATE_HZ from a timerfd and
+ * writes a frame to the IColorO only if it differs from the last one written. The thread
+ * sleeps without a timer while no mode runs.
+ */
 class ModeExecutor
 {
 public:
@@ -48,14 +55,38 @@ public:
 private:
 	IColorO* _colorO;
 
-	boost::shared_ptr<Mode> _activeMode;
 	std::map<int, boost::shared_ptr<Mode>, std::greater<int> > _mapActiveModes;
 	color::rgba _activeColor;
 
-	bool _stopRequested;
 	int default_priority;
 
-	void onModeFinishedReceived(int prio);
+	// scheduler, _mutex guards the modes and the frames
+	boost::thread _scheduler;
+	boost::mutex _mutex;
+	boost::condition_variable _condRunning;
+	int _timerFd;
+	bool _stopRequested;
+
+	// latest frame of the ticked mode and the last frame written
+	color::rgba _frameColor;
+	std::vector<color::rgba> _frameColors;
+	bool _hasFrameColor;
+	bool _hasFrameColors;
+	color::rgba _sentColor;
+	std::vector<color::rgba> _sentColors;
+	bool _hasSentColor;
+	bool _hasSentColors;
+
+	void run();
+	void tick(uint64_t ticks);
+	void writeFrame();
+	void startMode(boost::shared_ptr<Mode> mode);
+	void armTimer();
+	bool hasRunningMode();
+
+	void onModeFinished(int prio);
+	void onColorReady(color::rgba color);
+	void onColorsReady(std::vector<color::rgba> colors);
 	void onColorSetReceived(color::rgba color);
 };
 
@@ -18,17 +18,12 @@
 #ifndef SERIALIO_H
 #define SERIALIO_H
 
-// serial connection includes
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
-#include <termios.h>
-#include <time.h>
-#include <sys/time.h>
+#include <vector>
 
-#include <string>
+#include <cob_utilities/SerialIO.h>
 
 #include <concurrentQueue.h>
+#include <boost/function.hpp>
 #include <boost/thread.hpp>
 
 typedef struct ioData{
@@ -36,64 +31,48 @@ typedef struct ioData{
 	size_t len;
 } ioData_t;
 
-class SerialIO
+// Sends the latest frame to a SerialIO from its own thread.
+// Frames enqueued faster than the device frame rate are coalesced, only the newest is sent.
+// Frames may be enqueued from one thread at a time.
+class SerialWriter
 {
 public:
+	// Transmits one frame, returns false on errors
+	typedef boost::function<bool (const char* data, size_t len)> SendFunction;
+
 	// Constructor
-	SerialIO();
+	SerialWriter(SerialIO* serialIO, double frameRate = maxUpdateRate);
 	// Destructor
-	~SerialIO();
-
-	// Open Serial Port
-	int openPort(std::string devicestring, int baudrate);
-
-	// Send Data to Serial Port
-	int sendData(std::string value);
+	~SerialWriter();
 
-	// Send Data to Serial Port
-	int sendData(const char* data, size_t len);
+	// Replaces SerialIO::sendData() as transmission of a frame, e.g. for protocols
+	// with an acknowledge per message. Has to be set before start().
+	void setSendFunction(const SendFunction& send);
 
-	// Read Data from Serial Port
-	int readData(std::string &value, size_t nBytes);
-
-	void enqueueData(std::vector<ioData_t> data);
+	// The data is copied, the buffers may be reused after the call
+	void enqueueData(const std::vector<ioData_t>& data);
 
 	void enqueueData(const char* data, size_t len);
 
-	// Check if Serial Port is opened
-	bool isOpen();
-
-	// Close Serial Port
-	void closePort();
-
-	bool recover();
-
 	void start();
 	void stop();
 
 private:
-	//ioQueue
-	ConcurrentQueue<std::vector<struct ioData> > _oQueue;
+	SerialIO* _serialIO;
+	SendFunction _send;
 
-	boost::shared_ptr<boost::thread> _thread;
-	boost::mutex _mutex;
-	boost::condition_variable _condition;
+	//latest frame
+	ConcurrentQueue<std::vector<char> > _oQueue;
 
-	// filedescriptor
-	int _fd;
-	// serial port settings
-	struct termios port_settings;
-	// device string
-	std::string _device_string;
-	// baudrate
-	int _baudrate;
+	boost::shared_ptr<boost::thread> _thread;
 
-	// resolve int to baudrate
-	speed_t getBaudFromInt(int baud);
+	// minimal time between two frames
+	boost::posix_time::time_duration _framePeriod;
 
 	static const int maxUpdateRate = 50;
 
 	void run();
+	bool sendData(const char* data, size_t len);
 };
 
 #endif
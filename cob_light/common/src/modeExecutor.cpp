@@ -17,16 +17,33 @@
 
 #include <modeExecutor.h>
 #include <ros/ros.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 ModeExecutor::ModeExecutor(IColorO* colorO)
-: _stopRequested(false), default_priority(0)
+: default_priority(0), _stopRequested(false), _hasFrameColor(false), _hasFrameColors(false),
+  _hasSentColor(false), _hasSentColors(false)
 {
 	_colorO = colorO;
 	_colorO->signalColorSet()->connect(boost::bind(&ModeExecutor::onColorSetReceived, this, _1));
+
+	_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if(_timerFd == -1)
+		ROS_ERROR("Could not create timer for the modes, falling back to sleeping");
+	_scheduler = boost::thread(&ModeExecutor::run, this);
 }
 
 ModeExecutor::~ModeExecutor()
 {
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		_stopRequested = true;
+		armTimer();
+		_condRunning.notify_one();
+	}
+	_scheduler.join();
+	if(_timerFd != -1)
+		close(_timerFd);
 }
 
 uint64_t ModeExecutor::execute(cob_light::LightMode requestedMode)
@@ -41,6 +58,7 @@ uint64_t ModeExecutor::execute(cob_light::LightMode requestedMode)
 
 uint64_t ModeExecutor::execute(boost::shared_ptr<Mode> mode)
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	uint64_t u_id;
 
 	// check if modes allready executing
@@ -66,9 +84,8 @@ uint64_t ModeExecutor::execute(boost::shared_ptr<Mode> mode)
 			}
 		}
 	}
-	mode->signalColorReady()->connect(boost::bind(&IColorO::setColor, _colorO, _1));
-	mode->signalColorsReady()->connect(boost::bind(&IColorO::setColorMulti, _colorO, _1));
-	mode->signalModeFinished()->connect(boost::bind(&ModeExecutor::onModeFinishedReceived, this, _1));
+	mode->signalColorReady()->connect(boost::bind(&ModeExecutor::onColorReady, this, _1));
+	mode->signalColorsReady()->connect(boost::bind(&ModeExecutor::onColorsReady, this, _1));
 	mode->setActualColor(_activeColor);
 	ROS_DEBUG("Attaching Mode %i with prio: %i freq: %f timeout: %f pulses: %i ",
 		ModeFactory::type(mode.get()), mode->getPriority(), mode->getFrequency(), mode->getTimeout(), mode->getPulses());
@@ -78,7 +95,7 @@ uint64_t ModeExecutor::execute(boost::shared_ptr<Mode> mode)
 	{
 		ROS_DEBUG("Executing Mode %i with prio: %i freq: %f timeout: %f pulses: %i ",
 			ModeFactory::type(mode.get()), mode->getPriority(), mode->getFrequency(), mode->getTimeout(), mode->getPulses());
-		_mapActiveModes.begin()->second->start();
+		startMode(_mapActiveModes.begin()->second);
 	}
 	Mode* ptr = mode.get();
 	u_id = reinterpret_cast<uint64_t>( ptr );
@@ -87,6 +104,7 @@ uint64_t ModeExecutor::execute(boost::shared_ptr<Mode> mode)
 
 void ModeExecutor::pause()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size() > 0)
 	{
 		_mapActiveModes.begin()->second->pause();
@@ -95,12 +113,14 @@ void ModeExecutor::pause()
 
 void ModeExecutor::resume()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size() > 0 && !_mapActiveModes.begin()->second->isRunning())
-		_mapActiveModes.begin()->second->start();
+		startMode(_mapActiveModes.begin()->second);
 }
 
 void ModeExecutor::stop()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size() > 0)
 	{
 		std::map<int, boost::shared_ptr<Mode>, std::greater<int> >::iterator itr;
@@ -114,6 +134,7 @@ void ModeExecutor::stop()
 
 bool ModeExecutor::stop(uint64_t uId)
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	bool ret = false;
 	if(_mapActiveModes.size() > 0)
 	{
@@ -134,7 +155,7 @@ bool ModeExecutor::stop(uint64_t uId)
 					{
 						ROS_DEBUG("Resume mode: %i with prio %i",
 							ModeFactory::type(_mapActiveModes.begin()->second.get()), _mapActiveModes.begin()->second->getPriority());
-						_mapActiveModes.begin()->second->start();
+						startMode(_mapActiveModes.begin()->second);
 					}
 				}
 				ret = true;
@@ -144,7 +165,109 @@ bool ModeExecutor::stop(uint64_t uId)
 	}
 	return ret;
 }
-void ModeExecutor::onModeFinishedReceived(int prio)
+
+void ModeExecutor::run()
+{
+	boost::mutex::scoped_lock lock(_mutex);
+	while(!_stopRequested)
+	{
+		if(!hasRunningMode())
+		{
+			// no timer wakeups while idle, startMode() rearms it
+			if(_timerFd != -1)
+			{
+				itimerspec spec = {};
+				timerfd_settime(_timerFd, 0, &spec, NULL);
+			}
+			_condRunning.wait(lock);
+			continue;
+		}
+
+		lock.unlock();
+		uint64_t ticks = 0;
+		if(_timerFd == -1 || read(_timerFd, &ticks, sizeof(ticks)) != sizeof(ticks))
+		{
+			boost::this_thread::sleep(boost::posix_time::microseconds(1000000 / Mode::UPDATE_RATE_HZ));
+			ticks = 1;
+		}
+		lock.lock();
+
+		if(!_stopRequested && hasRunningMode())
+			tick(ticks);
+	}
+}
+
+void ModeExecutor::tick(uint64_t ticks)
+{
+	boost::shared_ptr<Mode> mode = _mapActiveModes.begin()->second;
+
+	// the timer counts the periods since the last read, so late wakeups catch up
+	// (at most one second) and only the last frame is written
+	if(ticks > Mode::UPDATE_RATE_HZ)
+		ticks = Mode::UPDATE_RATE_HZ;
+	bool finished = false;
+	for(uint64_t i = 0; i < ticks && !finished; i++)
+		finished = !mode->tick();
+	writeFrame();
+
+	if(finished)
+	{
+		ROS_DEBUG("Mode %s finished", mode->getName().c_str());
+		onModeFinished(mode->getPriority());
+	}
+}
+
+void ModeExecutor::writeFrame()
+{
+	if(_hasFrameColor)
+	{
+		_hasFrameColor = false;
+		if(!_hasSentColor || _frameColor != _sentColor)
+		{
+			_sentColor = _frameColor;
+			_hasSentColor = true;
+			_colorO->setColor(_sentColor);
+		}
+	}
+	if(_hasFrameColors)
+	{
+		_hasFrameColors = false;
+		if(!_hasSentColors || _frameColors != _sentColors)
+		{
+			_sentColors = _frameColors;
+			_hasSentColors = true;
+			_colorO->setColorMulti(_sentColors);
+		}
+	}
+}
+
+void ModeExecutor::startMode(boost::shared_ptr<Mode> mode)
+{
+	mode->start();
+	// the output might have been changed meanwhile, write the next frame in any case
+	_hasFrameColor = _hasFrameColors = false;
+	_hasSentColor = _hasSentColors = false;
+	armTimer();
+	_condRunning.notify_one();
+}
+
+void ModeExecutor::armTimer()
+{
+	if(_timerFd == -1)
+		return;
+	// first tick immediately, then periodic
+	itimerspec spec = {};
+	spec.it_interval.tv_nsec = 1000000000 / Mode::UPDATE_RATE_HZ;
+	spec.it_value.tv_nsec = 1;
+	timerfd_settime(_timerFd, 0, &spec, NULL);
+}
+
+bool ModeExecutor::hasRunningMode()
+{
+	return _mapActiveModes.size() > 0 && _mapActiveModes.begin()->second->isRunning();
+}
+
+void ModeExecutor::onModeFinished(int prio)
 {
 	//check if finished mode is the current active
 	if(_mapActiveModes.begin()->first == prio)
@@ -155,7 +278,7 @@ void ModeExecutor::onModeFinishedReceived(int prio)
 		{
 			ROS_DEBUG("Resume mode: %i with prio %i",
 				ModeFactory::type(_mapActiveModes.begin()->second.get()), _mapActiveModes.begin()->second->getPriority());
-			_mapActiveModes.begin()->second->start();
+			startMode(_mapActiveModes.begin()->second);
 		}
 	}
 	//finished mode is not the current executing one (this should never happen)
@@ -166,6 +289,18 @@ void ModeExecutor::onModeFinishedReceived(int prio)
 	}
 }
 
+void ModeExecutor::onColorReady(color::rgba color)
+{
+	_frameColor = color;
+	_hasFrameColor = true;
+}
+
+void ModeExecutor::onColorsReady(std::vector<color::rgba> colors)
+{
+	_frameColors = colors;
+	_hasFrameColors = true;
+}
+
 void ModeExecutor::onColorSetReceived(color::rgba color)
 {
   _activeColor = color;
@@ -173,6 +308,7 @@ void ModeExecutor::onColorSetReceived(color::rgba color)
 
 int ModeExecutor::getExecutingMode()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size() > 0)
 		return ModeFactory::type(_mapActiveModes.begin()->second.get());
 	else
@@ -181,6 +317,7 @@ int ModeExecutor::getExecutingMode()
 
 int ModeExecutor::getExecutingPriority()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size()>0)
 		return _mapActiveModes.begin()->second->getPriority();
 	else
@@ -189,6 +326,7 @@ int ModeExecutor::getExecutingPriority()
 
 uint64_t ModeExecutor::getExecutingUId()
 {
+	boost::mutex::scoped_lock lock(_mutex);
 	if(_mapActiveModes.size()>0)
 		return reinterpret_cast<uint64_t>(_mapActiveModes.begin()->second.get());
 	else
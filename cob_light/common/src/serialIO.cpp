@@ -16,95 +16,32 @@
 
 
 #include "serialIO.h"
-#include "sys/select.h"
-#include <iostream>
-#include <cstring>
-
 #include <ros/ros.h>
+#include <boost/bind.hpp>
 
-SerialIO::SerialIO() :
-	 _fd(-1), _device_string(""), _baudrate(9600)
-{
-}
-
-SerialIO::~SerialIO()
-{
-	stop();
-	closePort();
-}
-
-// Open Serial Port
-int SerialIO::openPort(std::string devicestring, int baudrate)
-{
-	if(_fd != -1) return _fd;
-
-	_device_string = devicestring;
-	_baudrate = baudrate;
-
-	speed_t baud = getBaudFromInt(baudrate);
-	std::memset(&port_settings,0,sizeof(port_settings));
-	port_settings.c_iflag = 0;
-	port_settings.c_oflag = 0;
-	port_settings.c_cflag = CS8|CREAD|CLOCAL;
-	port_settings.c_lflag = 0;
-	port_settings.c_cc[VMIN]=1;
-	port_settings.c_cc[VTIME]=5;
-
-	_fd=open(devicestring.c_str(), O_RDWR | O_NONBLOCK);
-	cfsetospeed(&port_settings, baud);
-	cfsetispeed(&port_settings, baud);
-
-	tcsetattr(_fd, TCSANOW, &port_settings);
-
-	return _fd;
-}
-
-// Send Data to Serial Port
-int SerialIO::sendData(std::string value)
+SerialWriter::SerialWriter(SerialIO* serialIO, double frameRate) :
+	 _serialIO(serialIO), _framePeriod(boost::posix_time::microseconds((long)(1e6 / frameRate)))
 {
-	boost::mutex::scoped_lock lock(_mutex);
-	int wrote = -1;
-	if(_fd != -1)
-		wrote = write(_fd, value.c_str(), value.length());
-	return wrote;
+	_send = boost::bind(&SerialWriter::sendData, this, _1, _2);
 }
 
-// Send Data to Serial Port
-int SerialIO::sendData(const char* data, size_t len)
+void SerialWriter::setSendFunction(const SendFunction& send)
 {
-	boost::mutex::scoped_lock lock(_mutex);
-	int wrote = -1;
-	if(_fd != -1)
-		wrote = write(_fd, data, len);
-	return wrote;
+	_send = send;
 }
 
-// Read Data from Serial Port
-int SerialIO::readData(std::string &value, size_t nBytes)
+SerialWriter::~SerialWriter()
 {
-	boost::mutex::scoped_lock lock(_mutex);
-	fd_set fds;
-	FD_ZERO(&fds);
-	FD_SET(_fd, &fds);
-	struct timeval timeout = {0, 100000};
-	char buffer[32];
-	size_t rec = -1;
-	if(select(_fd+1, &fds, NULL, NULL, &timeout))
-	{
-		rec = read(_fd, buffer, nBytes);
-		value = std::string(buffer, rec);
-	}
-
-	return rec;
+	stop();
 }
 
-void SerialIO::start()
+void SerialWriter::start()
 {
 	if(_thread == NULL)
-		_thread.reset(new boost::thread(&SerialIO::run, this));
+		_thread.reset(new boost::thread(&SerialWriter::run, this));
 }
 
-void SerialIO::stop()
+void SerialWriter::stop()
 {
 	if(_thread != NULL)
 	{
@@ -114,90 +51,51 @@ void SerialIO::stop()
 	}
 }
 
-void SerialIO::run()
+void SerialWriter::run()
 {
-	ros::Rate r(maxUpdateRate);
-	std::vector<ioData_t> data;
-	while(true)
+	boost::system_time nextWrite = boost::get_system_time();
+	try
 	{
-		_oQueue.wait_pop(data);
-		for(size_t i = 0; i < data.size(); i++)
-			this->sendData(data[i].buf, data[i].len);
-		r.sleep();
+		while(true)
+		{
+			// sleeps until there is a new frame, frames arriving until the device
+			// is ready again replace it
+			_oQueue.wait();
+			boost::this_thread::sleep(nextWrite);
+
+			const std::vector<char>* frame = _oQueue.acquire();
+			if(frame != NULL && !frame->empty())
+				_send(&(*frame)[0], frame->size());
+			nextWrite = boost::get_system_time() + _framePeriod;
+		}
 	}
-}
-
-void SerialIO::enqueueData(std::vector<ioData_t> data)
-{
-	_oQueue.push(data);
-}
-
-void SerialIO::enqueueData(const char* buf, size_t len)
-{
-	struct ioData data;
-	data.buf=buf;
-	data.len=len;
-	std::vector<ioData_t> vec;
-	vec.push_back(data);
-	_oQueue.push(vec);
-}
-
-// Check if Serial Port is opened
-bool SerialIO::isOpen()
-{
-	return (_fd != -1);
-}
-
-// Close Serial Port
-void SerialIO::closePort()
-{
-	if(_fd != -1)
+	catch(boost::thread_interrupted&)
 	{
-		close(_fd);
-		_fd = -1;
 	}
 }
 
-bool SerialIO::recover()
+bool SerialWriter::sendData(const char* data, size_t len)
 {
-  closePort();
-  if(openPort(_device_string, _baudrate))
-  {
-    usleep(50000);
-    tcflush(_fd, TCIOFLUSH);
-    return true;
-  }
-  else
-    return false;
+	int bytes_wrote = _serialIO->sendData(data, len);
+	if(bytes_wrote == -1)
+		ROS_WARN("Can not write to serial port. Port closed!");
+	else
+		ROS_DEBUG("Wrote %i bytes from %lu bytes", bytes_wrote, len);
+	return bytes_wrote == (int)len;
 }
 
+void SerialWriter::enqueueData(const std::vector<ioData_t>& data)
+{
+	std::vector<char>& frame = _oQueue.back();
+	frame.clear();
+	for(size_t i = 0; i < data.size(); i++)
+		frame.insert(frame.end(), data[i].buf, data[i].buf + data[i].len);
+	_oQueue.publish();
+}
 
-speed_t SerialIO::getBaudFromInt(int baud)
+void SerialWriter::enqueueData(const char* buf, size_t len)
 {
-	speed_t ret;
-	switch(baud)
-	{
-		case 0: 	ret=B0;		break;
-		case 50: 	ret=B50; 	break;
-		case 75: 	ret=B75; 	break;
-		case 110: 	ret=B110;	break;
-		case 134: 	ret=B134;	break;
-		case 150: 	ret=B150;	break;
-		case 200: 	ret=B200;	break;
-		case 300: 	ret=B300;	break;
-		case 1200: 	ret=B1200; 	break;
-		case 1800: 	ret=B1800; 	break;
-		case 2400: 	ret=B2400; 	break;
-		case 4800: 	ret=B4800; 	break;
-		case 9600: 	ret=B9600; 	break;
-		case 19200: ret=B19200; break;
-		case 38400: ret=B38400;	break;
-		case 57600: ret=B57600; break;
-		case 115200: ret=B115200; break;
-		case 230400: ret=B230400; break;
-		default:
-			ret=B230400;
-			break;
-	}
-	return ret;
+	std::vector<char>& frame = _oQueue.back();
+	frame.assign(buf, buf + len);
+	_oQueue.publish();
 }
@@ -27,7 +27,7 @@
 class ColorO : public IColorO
 {
 public:
-  ColorO(SerialIO* serialIO);
+  ColorO(SerialWriter* serialWriter);
   virtual ~ColorO();
 
   bool init();
@@ -35,7 +35,7 @@ public:
   void setColorMulti(std::vector<color::rgba> &colors);
 
 private:
-  SerialIO* _serialIO;
+  SerialWriter* _serialWriter;
   std::stringstream _ssOut;
 };
 
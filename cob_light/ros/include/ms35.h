@@ -27,7 +27,8 @@
 class MS35 : public IColorO
 {
 public:
-  MS35(SerialIO* serialIO);
+  // init() talks to serialIO directly, the color packages are sent by serialWriter
+  MS35(SerialIO* serialIO, SerialWriter* serialWriter);
   virtual ~MS35();
 
   bool init();
@@ -36,6 +37,7 @@ public:
 
 private:
   SerialIO* _serialIO;
+  SerialWriter* _serialWriter;
   std::stringstream _ssOut;
   static const int PACKAGE_SIZE = 9;
   char buffer[PACKAGE_SIZE];
@@ -27,7 +27,9 @@
 class StageProfi : public IColorO
 {
 public:
-  StageProfi(SerialIO* serialIO, unsigned int leds, int led_offset);
+  // Registers the DMX transmission as send function of serialWriter, every message
+  // is acknowledged by the controller, so the frames are exchanged on the writer thread
+  StageProfi(SerialIO* serialIO, SerialWriter* serialWriter, unsigned int leds, int led_offset);
   virtual ~StageProfi();
 
   bool init();
@@ -37,12 +39,14 @@ public:
 
 private:
   SerialIO* _serialIO;
+  SerialWriter* _serialWriter;
   std::stringstream _ssOut;
   int _led_offset;
   static const unsigned int HEADER_SIZE = 4;
   static const unsigned int MAX_CHANNELS = 255;
 
   bool recover();
+  bool sendFrame(const char* data, size_t len);
   bool sendDMX(uint16_t start, const char* buf, unsigned int length);
 };
 
@@ -78,7 +78,7 @@ class LightControl
 {
 public:
   LightControl() :
-    _invertMask(0), _topic_priority(0)
+    _invertMask(0), _topic_priority(0), _serialWriter(&_serialIO)
   {
   }
   bool init()
@@ -175,6 +175,7 @@ public:
     {
       //open serial port
       ROS_INFO("Open Port on %s",_deviceString.c_str());
+      _serialIO.setNonBlocking(true);
       if(_serialIO.openPort(_deviceString, _baudrate) != -1)
       {
         ROS_INFO("Serial connection on %s succeeded.", _deviceString.c_str());
@@ -182,11 +183,11 @@ public:
         status.message = "light controller running";
 
         if(_deviceDriver == "cob_ledboard")
-          p_colorO = new ColorO(&_serialIO);
+          p_colorO = new ColorO(&_serialWriter);
         else if(_deviceDriver == "ms-35")
-          p_colorO = new MS35(&_serialIO);
+          p_colorO = new MS35(&_serialIO, &_serialWriter);
         else if(_deviceDriver == "stageprofi")
-          p_colorO = new StageProfi(&_serialIO, _num_leds, led_offset);
+          p_colorO = new StageProfi(&_serialIO, &_serialWriter, _num_leds, led_offset);
         else
         {
           ROS_ERROR_STREAM("Unsupported devicedriver ["<<_deviceDriver<<"], falling back to sim mode");
@@ -202,6 +203,11 @@ public:
           ROS_ERROR("Initializing connection to driver failed. Exiting");
           ret = false;
         }
+        else
+        {
+          //the port is only written by the writer thread from now on
+          _serialWriter.start();
+        }
       }
       else
       {
@@ -251,6 +257,7 @@ public:
       p_modeExecutor->stop();
       delete p_modeExecutor;
     }
+    _serialWriter.stop();
     if(p_colorO != NULL)
     {
       delete p_colorO;
@@ -455,6 +462,9 @@ private:
 
   IColorO* p_colorO;
   SerialIO _serialIO;
+  //frames of the mode scheduler and the topic callback, which writes only while the
+  //executor is paused, so there is one producer at a time
+  SerialWriter _serialWriter;
   ModeExecutor* p_modeExecutor;
 
   boost::mutex _mutex;
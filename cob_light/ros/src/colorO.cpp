@@ -18,9 +18,9 @@
 #include <colorO.h>
 #include <ros/ros.h>
 
-ColorO::ColorO(SerialIO* serialIO)
+ColorO::ColorO(SerialWriter* serialWriter)
 {
-  _serialIO = serialIO;
+  _serialWriter = serialWriter;
 }
 
 ColorO::~ColorO()
@@ -39,8 +39,6 @@ void ColorO::setColorMulti(std::vector<color::rgba> &colors)
 
 void ColorO::setColor(color::rgba color)
 {
-  int bytes_wrote = 0;
-
   color::rgba color_tmp = color;
 
   //calculate rgb spektrum for spezific alpha value, because
@@ -58,16 +56,8 @@ void ColorO::setColor(color::rgba color)
   _ssOut.str("");
   _ssOut << (int)color.r << " " << (int)color.g << " " << (int)color.b << "\n\r";
 
-  // send data over serial port
-  bytes_wrote = _serialIO->sendData(_ssOut.str());
-  if(bytes_wrote == -1)
-  {
-    ROS_WARN("Can not write to serial port. Port closed!");
-  }
-  else
-  {
-    ROS_DEBUG("Wrote [%s] with %i bytes from %i bytes", \
-              _ssOut.str().c_str(), bytes_wrote, (int)_ssOut.str().length());
-    m_sigColorSet(color_tmp);
-  }
+  // the frame is sent by the writer thread, failures are reported there
+  std::string frame = _ssOut.str();
+  _serialWriter->enqueueData(frame.c_str(), frame.length());
+  m_sigColorSet(color_tmp);
 }
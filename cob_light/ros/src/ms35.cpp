@@ -21,9 +21,10 @@
 #include <boost/cstdint.hpp>
 #include <boost/integer.hpp>
 
-MS35::MS35(SerialIO* serialIO)
+MS35::MS35(SerialIO* serialIO, SerialWriter* serialWriter)
 {
   _serialIO = serialIO;
+  _serialWriter = serialWriter;
 }
 
 MS35::~MS35()
@@ -109,9 +110,8 @@ void MS35::setColor(color::rgba color)
   unsigned short int crc = getChecksum(buffer, 7);
   buffer[7] = ((char*)&crc)[1];
   buffer[8] = ((char*)&crc)[0];
-  
-  if(sendData(buffer, PACKAGE_SIZE) == PACKAGE_SIZE)
-    m_sigColorSet(color_tmp);
-  else
-    ROS_ERROR("Could not write to serial port");
+
+  // the package is sent by the writer thread, failures are reported there
+  _serialWriter->enqueueData(buffer, PACKAGE_SIZE);
+  m_sigColorSet(color_tmp);
 }
@@ -17,15 +17,18 @@
 
 #include <stageprofi.h>
 #include <ros/ros.h>
+#include <boost/bind.hpp>
 #include <boost/cstdint.hpp>
 #include <boost/integer.hpp>
 #include <algorithm>
 
-StageProfi::StageProfi(SerialIO* serialIO, unsigned int leds, int led_offset)
+StageProfi::StageProfi(SerialIO* serialIO, SerialWriter* serialWriter, unsigned int leds, int led_offset)
 {
   _serialIO = serialIO;
+  _serialWriter = serialWriter;
   _num_leds = leds;
   _led_offset = led_offset;
+  _serialWriter->setSendFunction(boost::bind(&StageProfi::sendFrame, this, _1, _2));
 }
 
 StageProfi::~StageProfi()
@@ -74,20 +77,7 @@ void StageProfi::setColor(color::rgba color)
     channelbuffer[i * 3 + 2] = (int) color_tmp.b;
   }
 
-  uint16_t index = 0;
-  while (index < num_channels)
-  {
-    unsigned int size = std::min((unsigned int) MAX_CHANNELS,
-        num_channels - index);
-    if (sendDMX(index, channelbuffer + index, size))
-      index += size;
-    else
-    {
-      ROS_ERROR("Sending color to stageprofi failed");
-      this->recover();
-      break;
-    }
-  }
+  _serialWriter->enqueueData(channelbuffer, num_channels);
   m_sigColorSet(color);
 }
 
@@ -122,21 +112,27 @@ void StageProfi::setColorMulti(std::vector<color::rgba> &colors)
     channelbuffer[i * 3 + 2] = (int) color_tmp.b;
   }
 
+  _serialWriter->enqueueData(channelbuffer, num_channels);
+  m_sigColorSet(colors[0]);
+}
+
+bool StageProfi::sendFrame(const char* data, size_t len)
+{
   uint16_t index = 0;
-  while (index < num_channels)
+  while (index < len)
   {
     unsigned int size = std::min((unsigned int) MAX_CHANNELS,
-        num_channels - index);
-    if (sendDMX(index, channelbuffer + index, size))
+        (unsigned int) (len - index));
+    if (sendDMX(index, data + index, size))
       index += size;
     else
     {
       ROS_ERROR("Sending color to stageprofi failed");
       this->recover();
-      break;
+      return false;
     }
   }
-  m_sigColorSet(colors[0]);
+  return true;
 }
 
 bool StageProfi::sendDMX(uint16_t start, const char* buf, unsigned int length)
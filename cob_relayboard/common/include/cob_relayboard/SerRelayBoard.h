@@ -19,7 +19,7 @@
 #define SerRelayBoard_INCLUDEDEF_H
 
 //-----------------------------------------------
-#include <cob_relayboard/SerialIO.h>
+#include <cob_utilities/SerialIO.h>
 #include <cob_relayboard/Mutex.h>
 #include <cob_relayboard/CmdRelaisBoard.h>
 
@@ -45,6 +45,15 @@ public:
 	int evalRxBuffer(); //needs to be calles to read new data from relayboard
 	int sendRequest(); //sends collected data and requests response
 
+	/**
+	 * Blocks until the next message of the relayboard has been parsed.
+	 * Bytes are parsed as they arrive, messages are evaluated in order, so no status change is skipped.
+	 * Must not be mixed with evalRxBuffer().
+	 * @param dTimeoutS returns TOO_LESS_BYTES_IN_QUEUE, if no bytes arrive for this time
+	 * @return NO_ERROR, if a message has been evaluated
+	 */
+	int receiveMessage(double dTimeoutS);
+
 	//Services by relayboard
 	int setDigOut(int iChannel, bool bOn);
 	int getAnalogIn(int* piAnalogIn);
@@ -113,6 +122,9 @@ protected:
 	void convDataToSendMsg(unsigned char cMsg[]);
 	bool convRecMsgToData(unsigned char cMsg[]);
 
+	int getNumByteRec();
+	int parseRxBuffer();
+
 	Mutex m_Mutex;
 
 	int m_iNumBytesSend;
@@ -167,6 +179,10 @@ protected:
 
 	SerialIO m_SerIO;
 
+	// received bytes of receiveMessage(), which are not evaluated yet
+	unsigned char m_cRxBuffer[1024];
+	int m_iRxBufferFill;
+
 	bool m_bComInit;
 };
 
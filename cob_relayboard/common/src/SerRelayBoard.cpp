@@ -16,6 +16,7 @@
 
 
 #include <math.h>
+#include <string.h>
 #include <cob_relayboard/SerRelayBoard.h>
 #include <iostream>
 
@@ -44,7 +45,9 @@ SerRelayBoard::SerRelayBoard(std::string ComPort, int ProtocolVersion)
 {
 	m_iProtocolVersion = ProtocolVersion;
 	if(m_iProtocolVersion == 1)
-		m_NUM_BYTE_SEND = 50;
+	{	m_NUM_BYTE_SEND = 50;
+		m_iTypeLCD = LCD_20CHAR_TEXT;
+	}
 	else if(m_iProtocolVersion == 2)
 	{	m_NUM_BYTE_SEND = 79;
 		m_iTypeLCD = LCD_60CHAR_TEXT;
@@ -63,6 +66,8 @@ SerRelayBoard::SerRelayBoard(std::string ComPort, int ProtocolVersion)
 	m_iCmdRelayBoard = 0;
 	m_iDigIn = 0;
 	m_cSoftEMStop = 0;
+	m_iRelBoardStatus = 0;
+	m_iRxBufferFill = 0;
 
 }
 
@@ -73,15 +78,21 @@ SerRelayBoard::~SerRelayBoard()
 }
 
 //-----------------------------------------------
-int SerRelayBoard::evalRxBuffer()
+int SerRelayBoard::getNumByteRec()
 {
-	static int siNoMsgCnt = 0;
-
-	int iNumByteRec = NUM_BYTE_REC;
 	if(m_iTypeLCD == RELAY_BOARD_1_4)
 	{
-		iNumByteRec = NUM_BYTE_REC_RELAYBOARD_14;
+		return NUM_BYTE_REC_RELAYBOARD_14;
 	}
+	return NUM_BYTE_REC;
+}
+
+//-----------------------------------------------
+int SerRelayBoard::evalRxBuffer()
+{
+	static int siNoMsgCnt = 0;
+
+	int iNumByteRec = getNumByteRec();
 
 	const int c_iNrBytesMin = NUM_BYTE_REC_HEADER + iNumByteRec + NUM_BYTE_REC_CHECKSUM;
 	const int c_iSizeBuffer = 4096;
@@ -140,6 +151,74 @@ int SerRelayBoard::evalRxBuffer()
 	return errorFlag;
 }
 
+//-----------------------------------------------
+int SerRelayBoard::receiveMessage(double dTimeoutS)
+{
+	int errorFlag;
+	int iNrBytesRead;
+
+	if( !m_bComInit ) return NOT_INITIALIZED;
+
+	while(true)
+	{
+		errorFlag = parseRxBuffer();
+		if(errorFlag != TOO_LESS_BYTES_IN_QUEUE)
+		{
+			return errorFlag;
+		}
+
+		if(m_SerIO.waitForData(dTimeoutS) <= 0)
+		{
+			return TOO_LESS_BYTES_IN_QUEUE;
+		}
+
+		iNrBytesRead = m_SerIO.readNonBlocking((char*)&m_cRxBuffer[m_iRxBufferFill], sizeof(m_cRxBuffer) - m_iRxBufferFill);
+		if(iNrBytesRead <= 0)
+		{
+			// readable without data: the device is gone
+			return NO_MESSAGES;
+		}
+		m_iRxBufferFill += iNrBytesRead;
+	}
+}
+
+//-----------------------------------------------
+int SerRelayBoard::parseRxBuffer()
+{
+	const int c_iNrBytesMin = NUM_BYTE_REC_HEADER + getNumByteRec() + NUM_BYTE_REC_CHECKSUM;
+
+	int i = 0;
+	int errorFlag = TOO_LESS_BYTES_IN_QUEUE;
+	unsigned char cTest[4] = {0x02, 0x80, 0xD6, 0x02};
+
+	// oldest message first
+	for(; m_iRxBufferFill - i >= c_iNrBytesMin; i++)
+	{
+		//try to find start bytes
+		if((m_cRxBuffer[i] == cTest[0]) && (m_cRxBuffer[i+1] == cTest[1]) && (m_cRxBuffer[i+2] == cTest[2]) && (m_cRxBuffer[i+3] == cTest[3]))
+		{
+			if( convRecMsgToData(&m_cRxBuffer[i + NUM_BYTE_REC_HEADER]) )
+			{
+				errorFlag = NO_ERROR;
+				i += c_iNrBytesMin;
+			}
+			else
+			{
+				// the start bytes may have been part of the data, resync behind them
+				errorFlag = CHECKSUM_ERROR;
+				i++;
+			}
+			break;
+		}
+	}
+
+	// no message starts in front of i
+	m_iRxBufferFill -= i;
+	memmove(&m_cRxBuffer[0], &m_cRxBuffer[i], m_iRxBufferFill);
+
+	return errorFlag;
+}
+
 //-----------------------------------------------
 bool SerRelayBoard::init()
 {
@@ -147,6 +226,8 @@ bool SerRelayBoard::init()
 	m_SerIO.setDeviceName( m_sNumComPort.c_str() );
 	m_SerIO.setBufferSize(RS422_RX_BUFFERSIZE, RS422_TX_BUFFERSIZE);
 	m_SerIO.setTimeout(RS422_TIMEOUT);
+	m_SerIO.setNonBlocking(true);
+	m_SerIO.setLowLatency(true);
 
 	m_SerIO.openIO();
 
@@ -180,7 +261,11 @@ bool SerRelayBoard::shutdown()
 //-----------------------------------------------
 bool SerRelayBoard::isEMStop()
 {
-	if( (m_iRelBoardStatus & 0x0001) != 0)
+	m_Mutex.lock();
+	int iRelBoardStatus = m_iRelBoardStatus;
+	m_Mutex.unlock();
+
+	if( (iRelBoardStatus & 0x0001) != 0)
 	{
 		return true;
 	}
@@ -193,7 +278,11 @@ bool SerRelayBoard::isEMStop()
 //-----------------------------------------------
 bool SerRelayBoard::isScannerStop()
 {
-	if( (m_iRelBoardStatus & 0x0002) != 0)
+	m_Mutex.lock();
+	int iRelBoardStatus = m_iRelBoardStatus;
+	m_Mutex.unlock();
+
+	if( (iRelBoardStatus & 0x0002) != 0)
 	{
 		return true;
 	}
@@ -447,21 +536,7 @@ void SerRelayBoard::convDataToSendMsg(unsigned char cMsg[])
 bool SerRelayBoard::convRecMsgToData(unsigned char cMsg[])
 {
 
-	int iNumByteRec = NUM_BYTE_REC;
-	if(m_iTypeLCD == LCD_20CHAR_TEXT)
-	{
-		iNumByteRec = NUM_BYTE_REC;
-	}
-	if(m_iTypeLCD == LCD_60CHAR_TEXT)
-	{
-		iNumByteRec = NUM_BYTE_REC;
-	}
-	if(m_iTypeLCD == RELAY_BOARD_1_4)
-	{
-		iNumByteRec = NUM_BYTE_REC_RELAYBOARD_14;
-	}
-
-	const int c_iStartCheckSum = iNumByteRec;
+	const int c_iStartCheckSum = getNumByteRec();
 
 	int i;
 	unsigned int iTxCheckSum;
@@ -481,6 +556,7 @@ bool SerRelayBoard::convRecMsgToData(unsigned char cMsg[])
 
 	if(iCheckSum != iTxCheckSum)
 	{
+		m_Mutex.unlock();
 		return false;
 	}
 
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_relayboard/SerRelayBoard.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+// Measures the time from an EM-stop edge on the relayboard until the driver reports it.
+// A pseudo terminal stands in for the board: it answers every status request with a
+// message carrying the current EM-stop bit. Compares the polling loop of the former node
+// (request, evaluate, sleep) with the reader thread and an independent request timer.
+
+#define PROTOCOL_VERSION 2
+#define NUM_BYTE_SEND 79
+#define NUM_BYTE_REC 104
+
+static double nowS()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void sleepS(double dS)
+{
+	boost::this_thread::sleep(boost::posix_time::microseconds((long)(dS*1e6)));
+}
+
+/// The board side of the pseudo terminal.
+class BoardSimulator
+{
+public:
+	BoardSimulator(double dReplyDelayS)
+	{
+		m_dReplyDelayS = dReplyDelayS;
+		m_iStatus = 0;
+		m_bStop = false;
+		m_iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+		if(m_iMaster < 0 || grantpt(m_iMaster) != 0 || unlockpt(m_iMaster) != 0)
+		{
+			std::cerr << "ERROR - Could not create a pseudo terminal" << std::endl;
+			exit(1);
+		}
+		m_sSlaveName = ptsname(m_iMaster);
+	}
+
+	~BoardSimulator()
+	{
+		m_bStop = true;
+		m_Thread.join();
+		close(m_iMaster);
+	}
+
+	const std::string& getDeviceName() const { return m_sSlaveName; }
+
+	void start() { m_Thread = boost::thread(&BoardSimulator::run, this); }
+
+	void setEMStop(bool bStop)
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		m_iStatus = bStop ? 0x0001 : 0;
+	}
+
+private:
+	void run()
+	{
+		std::vector<unsigned char> request;
+		unsigned char cBuffer[256];
+		while(!m_bStop)
+		{
+			pollfd fd = {m_iMaster, POLLIN, 0};
+			if(poll(&fd, 1, 10) <= 0 || !(fd.revents & POLLIN))
+			{
+				continue;
+			}
+			int iNrBytes = read(m_iMaster, cBuffer, sizeof(cBuffer));
+			if(iNrBytes <= 0)
+			{
+				continue;
+			}
+			request.insert(request.end(), cBuffer, cBuffer + iNrBytes);
+
+			while((int)request.size() >= NUM_BYTE_SEND)
+			{
+				request.erase(request.begin(), request.begin() + NUM_BYTE_SEND);
+				// transfer time of request and answer
+				sleepS(m_dReplyDelayS);
+				reply();
+			}
+		}
+	}
+
+	void reply()
+	{
+		unsigned char cMsg[4 + NUM_BYTE_REC + 2] = {0x02, 0x80, 0xD6, 0x02};
+		unsigned char* cData = &cMsg[4];
+		{
+			boost::mutex::scoped_lock lock(m_Mutex);
+			cData[0] = m_iStatus;
+			cData[1] = m_iStatus >> 8;
+		}
+
+		unsigned int iCheckSum = 0;
+		for(int i = 0; i < NUM_BYTE_REC; i++)
+		{
+			iCheckSum %= 0xFF00;
+			iCheckSum += cData[i];
+		}
+		cData[NUM_BYTE_REC] = iCheckSum;
+		cData[NUM_BYTE_REC + 1] = iCheckSum >> 8;
+
+		if(write(m_iMaster, cMsg, sizeof(cMsg)) != (int)sizeof(cMsg))
+		{
+			std::cerr << "ERROR - Could not write the answer of the simulated board" << std::endl;
+		}
+	}
+
+	int m_iMaster;
+	std::string m_sSlaveName;
+	double m_dReplyDelayS;
+	int m_iStatus;
+	volatile bool m_bStop;
+	boost::mutex m_Mutex;
+	boost::thread m_Thread;
+};
+
+/// Collects the detection times of the driver side.
+class Detector
+{
+public:
+	Detector() { m_bEMStop = false; m_dDetectedS = 0; }
+
+	void update(bool bEMStop)
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		if(bEMStop != m_bEMStop)
+		{
+			m_bEMStop = bEMStop;
+			m_dDetectedS = nowS();
+			m_Condition.notify_all();
+		}
+	}
+
+	/// Returns the detection time of the state bEMStop, 0 on timeout.
+	double waitFor(bool bEMStop, double dTimeoutS)
+	{
+		boost::mutex::scoped_lock lock(m_Mutex);
+		boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds((long)(dTimeoutS*1e6));
+		while(m_bEMStop != bEMStop)
+		{
+			if(!m_Condition.timed_wait(lock, deadline))
+			{
+				return 0;
+			}
+		}
+		return m_dDetectedS;
+	}
+
+private:
+	bool m_bEMStop;
+	double m_dDetectedS;
+	boost::mutex m_Mutex;
+	boost::condition_variable m_Condition;
+};
+
+struct Driver
+{
+	SerRelayBoard* pBoard;
+	Detector* pDetector;
+	double dRequestPeriodS;
+	volatile bool bStop;
+
+	/// The loop of the former node: request, evaluate the buffer, sleep.
+	void pollingLoop()
+	{
+		while(!bStop)
+		{
+			pBoard->sendRequest();
+			if(pBoard->evalRxBuffer() == SerRelayBoard::NO_ERROR)
+			{
+				pDetector->update(pBoard->isEMStop());
+			}
+			sleepS(dRequestPeriodS);
+		}
+	}
+
+	void requestLoop()
+	{
+		while(!bStop)
+		{
+			pBoard->sendRequest();
+			sleepS(dRequestPeriodS);
+		}
+	}
+
+	void readerLoop()
+	{
+		while(!bStop)
+		{
+			if(pBoard->receiveMessage(0.1) == SerRelayBoard::NO_ERROR)
+			{
+				pDetector->update(pBoard->isEMStop());
+			}
+		}
+	}
+};
+
+/// Toggles the EM-stop bit iTrials times, returns the sorted latencies in seconds.
+static std::vector<double> measure(bool bEventDriven, double dRequestRate, double dReplyDelayS, int iTrials)
+{
+	BoardSimulator simulator(dReplyDelayS);
+	simulator.start();
+
+	SerRelayBoard board(simulator.getDeviceName(), PROTOCOL_VERSION);
+	board.init();
+
+	Detector detector;
+	Driver driver;
+	driver.pBoard = &board;
+	driver.pDetector = &detector;
+	driver.dRequestPeriodS = 1.0/dRequestRate;
+	driver.bStop = false;
+
+	boost::thread_group threads;
+	if(bEventDriven)
+	{
+		threads.create_thread(boost::bind(&Driver::requestLoop, &driver));
+		threads.create_thread(boost::bind(&Driver::readerLoop, &driver));
+	}
+	else
+	{
+		threads.create_thread(boost::bind(&Driver::pollingLoop, &driver));
+	}
+
+	std::vector<double> latencies;
+	srand(1);
+	for(int i = 0; i < iTrials; i++)
+	{
+		// edges at random phases of the request cycle
+		sleepS(0.05 + 0.1*rand()/RAND_MAX);
+		bool bEMStop = (i % 2) == 0;
+		double dEdgeS = nowS();
+		simulator.setEMStop(bEMStop);
+		double dDetectedS = detector.waitFor(bEMStop, 1.0);
+		if(dDetectedS == 0)
+		{
+			std::cerr << "ERROR - Edge " << i << " was not detected within 1 s" << std::endl;
+			continue;
+		}
+		latencies.push_back(dDetectedS - dEdgeS);
+	}
+
+	driver.bStop = true;
+	threads.join_all();
+
+	std::sort(latencies.begin(), latencies.end());
+	return latencies;
+}
+
+static void printLatencies(const char* cName, const std::vector<double>& latencies)
+{
+	if(latencies.empty())
+	{
+		std::cout << cName << ": no edge detected" << std::endl;
+		return;
+	}
+	double dSum = 0;
+	for(unsigned int i = 0; i < latencies.size(); i++)
+	{
+		dSum += latencies[i];
+	}
+	std::cout << cName << ": mean " << dSum/latencies.size()*1e3 << " ms, median "
+		<< latencies[latencies.size()/2]*1e3 << " ms, max " << latencies.back()*1e3 << " ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int iTrials = 40;
+	double dRequestRate = 100.0;
+	double dReplyDelayS = 0.0026;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--trials") == 0 && i+1 < argc)
+		{
+			iTrials = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--request-rate") == 0 && i+1 < argc)
+		{
+			dRequestRate = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i], "--reply-delay") == 0 && i+1 < argc)
+		{
+			dReplyDelayS = atof(argv[++i]);
+		}
+		else
+		{
+			std::cout << "Usage: " << argv[0] << " [--trials N] [--request-rate Hz] [--reply-delay s]" << std::endl;
+			return 2;
+		}
+	}
+
+	std::vector<double> polling = measure(false, 20.0, dReplyDelayS, iTrials);
+	std::vector<double> eventDriven = measure(true, dRequestRate, dReplyDelayS, iTrials);
+
+	printLatencies("Polling at 20 Hz", polling);
+	std::cout << "Reader thread, requests at " << dRequestRate << " Hz";
+	printLatencies("", eventDriven);
+
+	return (int)eventDriven.size() == iTrials ? 0 : 1;
+}
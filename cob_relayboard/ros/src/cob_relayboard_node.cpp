@@ -34,7 +34,8 @@
 //--
 
 // external includes
-//--
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 
 //####################
 //#### node class ####
@@ -67,16 +68,25 @@ public:
     relayboard_online = false;
     relayboard_timeout_ = 2.0;
     protocol_version_ = 1;
+    request_rate_ = 100.0;
+    publish_rate_ = 20.0;
     duration_for_EM_free_ = ros::Duration(1);
+    last_EM_signal_ = false;
+    last_scanner_signal_ = false;
+    stop_reader_ = false;
+    m_SerRelayBoard = NULL;
   }
 
   // Destructor
   ~NodeClass()
   {
+    stop_reader_ = true;
+    reader_thread_.join();
     delete m_SerRelayBoard;
   }
 
-  void sendEmergencyStopStates();
+  void requestBoardStatus(const ros::TimerEvent& event);
+  void sendEmergencyStopStates(const ros::TimerEvent& event);
   void sendBatteryVoltage();
   int init();
 
@@ -84,6 +94,18 @@ private:
   std::string sComPort;
   SerRelayBoard * m_SerRelayBoard;
 
+  // The board answers every status request. Answers are parsed by the reader thread as soon as
+  // they arrive, EM-stop and scanner-stop edges are published immediately.
+  double request_rate_; // rate of the status requests [Hz], bounds the reaction time to EM-stop edges
+  double publish_rate_; // rate of the periodic EM-stop state and voltage messages [Hz]
+  ros::Timer request_timer_;
+  ros::Timer publish_timer_;
+  boost::thread reader_thread_;
+  volatile bool stop_reader_;
+  boost::mutex state_mutex_; // guards the EM-stop and connection state
+  bool last_EM_signal_;
+  bool last_scanner_signal_;
+
   int EM_stop_status_;
   ros::Duration duration_for_EM_free_;
   ros::Time time_of_EM_confirmed_;
@@ -102,7 +124,8 @@ private:
       ST_EM_CONFIRMED = 2
     };
 
-  int requestBoardStatus();
+  void readerThread();
+  void evalEmergencyStopState(const ros::Time& now);
 };
 
 //#######################
@@ -115,14 +138,8 @@ int main(int argc, char** argv)
   NodeClass node;
   if(node.init() != 0) return 1;
 
-  ros::Rate r(20); //Cycle-Rate: Frequency of publishing EMStopStates
-  while(node.n.ok())
-    {
-      node.sendEmergencyStopStates();
-
-      ros::spinOnce();
-      r.sleep();
-    }
+  // status requests and periodic messages run on timers, received messages on the reader thread
+  ros::spin();
 
   return 0;
 }
@@ -145,6 +162,8 @@ int NodeClass::init()
 
   n_priv.param("relayboard_timeout", relayboard_timeout_, 2.0);
   n_priv.param("protocol_version", protocol_version_, 1);
+  n_priv.param("request_rate", request_rate_, 100.0);
+  n_priv.param("publish_rate", publish_rate_, 20.0);
 
   m_SerRelayBoard = new SerRelayBoard(sComPort, protocol_version_);
   ROS_INFO("Opened Relayboard at ComPort = %s", sComPort.c_str());
@@ -154,11 +173,16 @@ int NodeClass::init()
   // Init member variable for EM State
   EM_stop_status_ = ST_EM_ACTIVE;
   duration_for_EM_free_ = ros::Duration(1);
+  time_last_message_received_ = ros::Time::now();
+
+  reader_thread_ = boost::thread(&NodeClass::readerThread, this);
+  request_timer_ = n.createTimer(ros::Duration(1.0/request_rate_), &NodeClass::requestBoardStatus, this);
+  publish_timer_ = n.createTimer(ros::Duration(1.0/publish_rate_), &NodeClass::sendEmergencyStopStates, this);
 
   return 0;
 }
 
-int NodeClass::requestBoardStatus() {
+void NodeClass::requestBoardStatus(const ros::TimerEvent& event) {
   int ret;
 
   // Request Status of RelayBoard
@@ -167,24 +191,41 @@ int NodeClass::requestBoardStatus() {
     ROS_ERROR("Error in sending message to Relayboard over SerialIO, lost bytes during writing");
   }
 
-  ret = m_SerRelayBoard->evalRxBuffer();
-  if(ret==SerRelayBoard::NOT_INITIALIZED) {
-    ROS_ERROR("Failed to read relayboard data over Serial, the device is not initialized");
-    relayboard_online = false;
-  } else if(ret==SerRelayBoard::NO_MESSAGES) {
+  boost::mutex::scoped_lock lock(state_mutex_);
+  if(relayboard_online && (ros::Time::now() - time_last_message_received_).toSec() > relayboard_timeout_) {
     ROS_ERROR("For a long time, no messages from RelayBoard have been received, check com port!");
-    if(time_last_message_received_.toSec() - ros::Time::now().toSec() > relayboard_timeout_) {relayboard_online = false;}
-  } else if(ret==SerRelayBoard::TOO_LESS_BYTES_IN_QUEUE) {
-    //ROS_ERROR("Relayboard: Too less bytes in queue");
-  } else if(ret==SerRelayBoard::CHECKSUM_ERROR) {
-    ROS_ERROR("A checksum error occurred while reading from relayboard data");
-  } else if(ret==SerRelayBoard::NO_ERROR) {
-    relayboard_online = true;
-    relayboard_available = true;
-    time_last_message_received_ = ros::Time::now();
+    relayboard_online = false;
   }
+}
 
-  return 0;
+void NodeClass::readerThread()
+{
+  while(!stop_reader_ && ros::ok())
+    {
+      // the timeout only bounds the reaction to stop_reader_
+      int ret = m_SerRelayBoard->receiveMessage(0.1);
+      if(ret==SerRelayBoard::NOT_INITIALIZED || ret==SerRelayBoard::NO_MESSAGES) {
+        ROS_ERROR_THROTTLE(1.0, "Failed to read relayboard data over Serial, check com port!");
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+      } else if(ret==SerRelayBoard::CHECKSUM_ERROR) {
+        ROS_ERROR("A checksum error occurred while reading from relayboard data");
+      } else if(ret==SerRelayBoard::NO_ERROR) {
+        ros::Time now = ros::Time::now();
+        bool EM_signal = m_SerRelayBoard->isEMStop();
+        bool scanner_signal = m_SerRelayBoard->isScannerStop();
+
+        boost::mutex::scoped_lock lock(state_mutex_);
+        bool was_online = relayboard_online;
+        relayboard_online = true;
+        relayboard_available = true;
+        time_last_message_received_ = now;
+
+        // publish edges without waiting for the publish timer
+        if(!was_online || EM_signal != last_EM_signal_ || scanner_signal != last_scanner_signal_) {
+          evalEmergencyStopState(now);
+        }
+      }
+    }
 }
 
 void NodeClass::sendBatteryVoltage()
@@ -194,15 +235,20 @@ void NodeClass::sendBatteryVoltage()
   topicPub_Voltage.publish(voltage);
 }
 
-void NodeClass::sendEmergencyStopStates()
+void NodeClass::sendEmergencyStopStates(const ros::TimerEvent& event)
 {
-  requestBoardStatus();
+  boost::mutex::scoped_lock lock(state_mutex_);
 
   if(!relayboard_available) return;
 
   sendBatteryVoltage();
 
+  evalEmergencyStopState(ros::Time::now());
+}
 
+// state_mutex_ must be locked
+void NodeClass::evalEmergencyStopState(const ros::Time& now)
+{
   bool EM_signal;
   ros::Duration duration_since_EM_confirmed;
   cob_msgs::EmergencyStopState EM_msg;
@@ -210,6 +256,8 @@ void NodeClass::sendEmergencyStopStates()
   // assign input (laser, button) specific EM state TODO: Laser and Scanner stop can't be read independently (e.g. if button is stop --> no informtion about scanner, if scanner ist stop --> no informtion about button stop)
   EM_msg.emergency_button_stop = m_SerRelayBoard->isEMStop();
   EM_msg.scanner_stop = m_SerRelayBoard->isScannerStop();
+  last_EM_signal_ = EM_msg.emergency_button_stop;
+  last_scanner_signal_ = EM_msg.scanner_stop;
 
   // determine current EMStopState
   EM_signal = (EM_msg.emergency_button_stop || EM_msg.scanner_stop);
@@ -231,7 +279,7 @@ void NodeClass::sendEmergencyStopStates()
         {
           ROS_INFO("Emergency stop was confirmed");
           EM_stop_status_ = EM_msg.EMCONFIRMED;
-          time_of_EM_confirmed_ = ros::Time::now();
+          time_of_EM_confirmed_ = now;
         }
       break;
       }
@@ -244,7 +292,7 @@ void NodeClass::sendEmergencyStopStates()
         }
       else
         {
-          duration_since_EM_confirmed = ros::Time::now() - time_of_EM_confirmed_;
+          duration_since_EM_confirmed = now - time_of_EM_confirmed_;
           if( duration_since_EM_confirmed.toSec() > duration_for_EM_free_.toSec() )
             {
             ROS_INFO("Emergency stop released");
@@ -27,7 +27,7 @@
 #include <math.h>
 #include <stdio.h>
 
-#include <cob_sick_s300/SerialIO.h>
+#include <cob_utilities/SerialIO.h>
 #include <cob_sick_s300/TelegramS300.h>
 
 /**
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <arpa/inet.h>
+#include <string.h>
 
 /*
 * S300 header format in continuous mode:
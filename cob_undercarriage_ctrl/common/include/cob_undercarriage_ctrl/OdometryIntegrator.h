@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+
+#ifndef OdometryIntegrator_INCLUDEDEF_H
+#define OdometryIntegrator_INCLUDEDEF_H
+
+//-----------------------------------------------
+/**
+ * Integrates the platform velocity (result of the direct kinematics) to a pose in the plane.
+ *
+ * The integration is driven by the time stamps of the measurements, so the
+ * scheduling of the caller does not enter the result. Between two measurements
+ * the mean of both velocities is applied as constant twist and integrated exactly
+ * on SE(2) (exponential map), so driving on a circle gives an exact circle.
+ * The pose covariance is propagated from the covariance of the velocities.
+ */
+class OdometryIntegrator
+{
+public:
+	OdometryIntegrator();
+
+	/// Sets pose and covariance to zero and forgets the last measurement.
+	void reset();
+
+	/**
+	 * Integrates a new measurement.
+	 * @param dStampS time stamp of the measurement in s
+	 * @param dVelXMS, dVelYMS, dRotRadS velocity of the platform in robot coordinates
+	 * @param pdVelCov covariance of (vx, vy, w) as 3x3 row-major matrix, NULL for no uncertainty
+	 * @return false if the measurement is not newer than the previous one (not integrated)
+	 */
+	bool update(double dStampS, double dVelXMS, double dVelYMS, double dRotRadS, const double* pdVelCov);
+
+	/// Returns the integrated pose.
+	void getPose(double& dXM, double& dYM, double& dThetaRad) const;
+
+	/// Returns the covariance of (x, y, theta) as 3x3 row-major matrix.
+	void getPoseCov(double* pdCov) const;
+
+	/**
+	 * Calculates the displacement in the start frame for a constant twist applied over dt
+	 * (exponential map of se(2)).
+	 */
+	static void expSE2(double dVelXMS, double dVelYMS, double dRotRadS, double dDtS,
+		double& dDeltaXM, double& dDeltaYM, double& dDeltaThetaRad);
+
+private:
+	bool m_bValid;
+	double m_dLastStampS;
+	double m_dLastVel[3];
+	double m_dLastVelCov[9];
+
+	double m_dXM, m_dYM, m_dThetaRad;
+	double m_dPoseCov[9];
+};
+
+#endif
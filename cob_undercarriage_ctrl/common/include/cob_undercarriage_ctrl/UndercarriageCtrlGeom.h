@@ -23,6 +23,10 @@
 #include <cob_utilities/IniFile.h>
 #include <cob_utilities/MathSup.h>
 #include <cob_utilities/TimeStamp.h>
+#include <cob_undercarriage_ctrl/UndercarriageKinematics.h>
+
+#include <string>
+#include <vector>
 
 class UndercarriageCtrlGeom
 {
@@ -34,138 +38,24 @@ private:
 
 	std::string m_sIniDirectory;
 
-	/*// Logging for debugging
-	// create Filepointers
-	FILE * m_pfileDesVel, * m_pfileMeasVel;
-	FILE * m_pfileSteerAngTarget1, * m_pfileSteerAngTarget2;
-	FILE * m_pfileSteerAngTarget, * m_pfileDriveVelTarget;
-	FILE * m_pfileSteerAngCmd, * m_pfileSteerVelCmd, * m_pfileDriveVelCmd;
-	// create TimeStamp
-	TimeStamp m_RawTime, m_StartTime;
-	double m_dNowTime;*/
-
-
-	// Actual Values for PltfMovement (calculated from Actual Wheelspeeds)
-	double m_dVelLongMMS;
-	double m_dVelLatMMS;
-	double m_dRotRobRadS;
-	double m_dRotVelRadS;
-
-	// Actual Wheelspeed (read from Motor-Ctrls)
-	std::vector<double> m_vdVelGearDriveRadS;
-	std::vector<double> m_vdVelGearSteerRadS;
-	std::vector<double> m_vdDltAngGearDriveRad;
-	std::vector<double> m_vdAngGearSteerRad;
-
-	// Desired Pltf-Movement (set from PltfHwItf)
-	double m_dCmdVelLongMMS;
-	double m_dCmdVelLatMMS;
-	double m_dCmdRotRobRadS;
-	double m_dCmdRotVelRadS;
-
-	/*// Interpolated Wheelspeeds (calculated from desired and current Pltf-Config)
-	std::vector<double> m_vdVelGearDriveIntpRadS;
-	std::vector<double> m_vdVelGearSteerIntpRadS;
-	std::vector<double> m_vdAngGearSteerIntpRad;
-
-	// Delta values for interpolating between two commands
-	std::vector<double> m_vdDeltaAngIntpRad;
-	std::vector<double> m_vdDeltaDriveIntpRadS;*/
-
-	// Desired Wheelspeeds set to ELMO-Ctrl's (calculated from desired Pltf-Movement)
-	std::vector<double> m_vdVelGearDriveCmdRadS;
-	std::vector<double> m_vdVelGearSteerCmdRadS;
-	std::vector<double> m_vdAngGearSteerCmdRad;
-
-	// Target Wheelspeed and -angle (calculated from desired Pltf-Movement with Inverse without controle!)
-	// This Values might not be valid (to high step response in steering rate, ...) for commanding the drives
-	std::vector<double> m_vdAngGearSteerTarget1Rad; // alternativ 1 for steering angle
-	std::vector<double> m_vdVelGearDriveTarget1RadS;
-	std::vector<double> m_vdAngGearSteerTarget2Rad; // alternativ 2 for steering angle (+/- PI)
-	std::vector<double> m_vdVelGearDriveTarget2RadS;
-	std::vector<double> m_vdAngGearSteerTargetRad; // choosen alternativ for steering angle
-	std::vector<double> m_vdVelGearDriveTargetRadS;
-
-	/** Position of the Wheels' Steering Axis'
-	 *  in cartesian (X/Y) and polar (Dist/Ang) coordinates
-	 *  relative to robot coordinate System
-	 */
-	std::vector<double> m_vdWheelXPosMM;
-	std::vector<double> m_vdWheelYPosMM;
-	std::vector<double> m_vdWheelDistMM;
-	std::vector<double> m_vdWheelAngRad;
-
-	/** Exact Position of the Wheels' itself
-	 *  in cartesian (X/Y) and polar (Dist/Ang) coordinates
-	 *  relative to robot coordinate System
-	 */
-	std::vector<double> m_vdExWheelXPosMM;
-	std::vector<double> m_vdExWheelYPosMM;
-	std::vector<double> m_vdExWheelDistMM;
-	std::vector<double> m_vdExWheelAngRad;
-
-	struct ParamType
-	{
-		int iDistWheels;
-		int iRadiusWheelMM;
-
-		int iDistSteerAxisToDriveWheelMM;
-
-		double dMaxDriveRateRadpS;
-		double dMaxSteerRateRadpS;
-		double dCmdRateS;
-		std::vector<double> WheelNeutralPos;
-		std::vector<double> vdSteerDriveCoupling;
-		/** Factor between steering motion and steering induced motion of drive wheels
-		 *  subtract from Drive-Wheel Vel to get effective Drive Velocity (Direct Kinematics)
-		 *  add to Drive-Wheel Vel (Inverse Kinematics) to account for coupling when commanding velos
-		 */
-		std::vector<double> vdFactorVel;
-	};
-
-	ParamType m_UnderCarriagePrms;
-
-	/** ------- Position Controller Steer Wheels -------
-	 * Impedance-Ctrlr Prms
-	 *  -> model Stiffness via Spring-Damper-Modell
-	 *  -> only oriented at impedance-ctrl (no forces commanded)
-	 *  m_dSpring	Spring-constant (elasticity)
-	 *  m_dDamp		Damping coefficient (also prop. for Velocity Feedforward)
-	 *  m_dVirtM	Virtual Mass of Spring-Damper System
-	 *  m_dDPhiMax	maximum angular velocity (cut-off)
-	 *  m_dDDPhiMax	maximum angular acceleration (cut-off)
+	/** Kinematics and steering controller for the configured number of wheels.
+	 *  All per-wheel state lives in this fixed-size core,
+	 *  this class only reads the configuration and converts the interface.
 	 */
-	double m_dSpring, m_dDamp, m_dVirtM, m_dDPhiMax, m_dDDPhiMax;
-	/** storage for internal controller states
-	 *  m_vdCtrlVal is Vector with stored Controller-values of all wheels
-	 *  m_vdCtrlVal[iWheelNr][iVariableNr]
-	 *  iWheelNr: 		Index of Wheel Number (0..3)
-	 *  iVariableNr:	0: previous Commanded deltaPhi e(k-1)
-	 *					1: pre-previous Commanded deltaPhi e(k-2)
-	 *					2: previous Commanded Velocity u(k-1)
-	 */
-	std::vector< std::vector<double> > m_vdCtrlVal;
-
-	// Factor for thread cycle time of ThreadMotionPltfCtrl and ThreadUnderCarriageCtrl
-	//double m_dThreadCycleMultiplier;
-
-	// calculate inverse kinematics
-	void CalcInverse(void);
+	UndercarriageKinematicsItf * m_pKinematics;
 
-	// calculate direct kinematics
-	void CalcDirect(void);
+	UndercarriageKinematicsPrms m_UnderCarriagePrms;
 
-	// calculate Exact Wheel Position in robot coordinates
-	void CalcExWheelPos(void);
-
-	// perform one discrete Controle Step
-	void CalcControlStep(void);
+	int m_iDistWheels;
 
 public:
 
 	// Constructor
 	UndercarriageCtrlGeom(std::string sIniDirectory);
 
+	// Copy-Constructor
+	UndercarriageCtrlGeom(const UndercarriageCtrlGeom & GeomCtrl);
+
 	// Destructor
 	~UndercarriageCtrlGeom(void);
 
@@ -176,7 +66,8 @@ public:
 	void SetDesiredPltfVelocity(double dCmdVelLongMMS, double dCmdVelLatMMS, double dCmdRotRobRadS, double dCmdRotVelRadS);
 
 	// Set actual values of wheels (steer/drive velocity/position) (Istwerte)
-	void SetActualWheelValues(std::vector<double> vdVelGearDriveRadS, std::vector<double> vdVelGearSteerRadS, std::vector<double> vdDltAngGearDriveRad, std::vector<double> vdAngGearSteerRad);
+	void SetActualWheelValues(const std::vector<double> & vdVelGearDriveRadS, const std::vector<double> & vdVelGearSteerRadS,
+				  const std::vector<double> & vdDltAngGearDriveRad, const std::vector<double> & vdAngGearSteerRad);
 
 	// Get result of inverse kinematics (without controller)
 	void GetSteerDriveSetValues(std::vector<double> & vdVelGearDriveRadS, std::vector<double> & vdAngGearSteerRad);
@@ -189,6 +80,15 @@ public:
 	void GetActualPltfVelocity(double & dDeltaLongMM, double & dDeltaLatMM, double & dDeltaRotRobRad, double & dDeltaRotVelRad,
 					double & dVelLongMMS, double & dVelLatMMS, double & dRotRobRadS, double & dRotVelRadS);
 
+	// Get residual of every wheel w.r.t. the result of direct kinematics in mm/s (slip indicator)
+	void GetWheelResiduals(std::vector<double> & vdResidualMMS);
+
+	// Get covariance of the result of direct kinematics (vx [mm/s], vy [mm/s], w [rad/s]) as 3x3 row-major matrix
+	void GetActualPltfVelocityCov(double * pdCov);
+
+	// Get number of wheels handled by the controller
+	int GetNumberOfDrives(void) const { return m_iNumberOfDrives; }
+
 	// Set EM flag and stop Ctrlr
 	void setEMStopActive(bool bEMStopActive);
 
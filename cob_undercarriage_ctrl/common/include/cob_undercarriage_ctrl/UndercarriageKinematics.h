@@ -0,0 +1,831 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef UndercarriageKinematics_INCLUDEDEF_H
+#define UndercarriageKinematics_INCLUDEDEF_H
+
+#include <math.h>
+#include <cstddef>
+
+#include <cob_utilities/MathSup.h>
+
+//-----------------------------------------------
+/**
+ * Parameters of the undercarriage which are equal for all wheels.
+ */
+struct UndercarriageKinematicsPrms
+{
+	int iRadiusWheelMM;
+	int iDistSteerAxisToDriveWheelMM;
+
+	double dMaxDriveRateRadpS;
+	double dMaxSteerRateRadpS;
+	double dCmdRateS;
+
+	/** Prms of the Impedance-Ctrlr for the steering position
+	 *  dSpring		Spring-constant (elasticity)
+	 *  dDamp		Damping coefficient (also prop. for Velocity Feedforward)
+	 *  dVirtM		Virtual Mass of Spring-Damper System
+	 *  dDPhiMax	maximum angular velocity (cut-off)
+	 *  dDDPhiMax	maximum angular acceleration (cut-off)
+	 */
+	double dSpring, dDamp, dVirtM, dDPhiMax, dDDPhiMax;
+
+	/** Prms of the direct kinematics
+	 *  bLeastSquaresDirect		solve the over-determined system of all wheels in the least squares sense
+	 *							(false: average of the rotation between neighbouring wheels)
+	 *  dOutlierThresholdMMS	wheels with a larger residual are down-weighted (Huber), 0 disables
+	 */
+	bool bLeastSquaresDirect;
+	double dOutlierThresholdMMS;
+
+	/** Noise model of the wheel velocities for the covariance of the platform velocity
+	 *  sigma = dWheelVelNoiseMMS + dWheelVelNoiseFactor * |v_wheel|
+	 */
+	double dWheelVelNoiseMMS;
+	double dWheelVelNoiseFactor;
+
+	UndercarriageKinematicsPrms()
+	{
+		iRadiusWheelMM = 1;
+		iDistSteerAxisToDriveWheelMM = 0;
+		dMaxDriveRateRadpS = 0;
+		dMaxSteerRateRadpS = 0;
+		dCmdRateS = 0;
+		dSpring = 10.0;
+		dDamp = 2.5;
+		dVirtM = 0.1;
+		dDPhiMax = 12.0;
+		dDDPhiMax = 100.0;
+		bLeastSquaresDirect = true;
+		dOutlierThresholdMMS = 0.0;
+		dWheelVelNoiseMMS = 10.0;
+		dWheelVelNoiseFactor = 0.05;
+	}
+};
+
+//-----------------------------------------------
+/**
+ * Interface of the kinematics core used by UndercarriageCtrlGeom.
+ * The number of wheels is only known at runtime (Platform.ini),
+ * so the controller talks to the fixed-size implementation through this interface.
+ */
+class UndercarriageKinematicsItf
+{
+public:
+	virtual ~UndercarriageKinematicsItf() {}
+
+	/// Returns a copy of this kinematics core.
+	virtual UndercarriageKinematicsItf* clone() const = 0;
+
+	/// Returns the number of wheels.
+	virtual int getNumberOfWheels() const = 0;
+
+	/// Sets the common undercarriage parameters.
+	virtual void setPrms(const UndercarriageKinematicsPrms& Prms) = 0;
+
+	/**
+	 * Sets the parameters of a single wheel.
+	 * @param iWheel index of the wheel (0..N-1)
+	 * @param dXPosMM x position of the steering axis in robot coordinates
+	 * @param dYPosMM y position of the steering axis in robot coordinates
+	 * @param dNeutralPosRad neutral position of the steering
+	 * @param dSteerDriveCoupling coupling between steering and drive gear
+	 */
+	virtual void setWheelPrms(int iWheel, double dXPosMM, double dYPosMM, double dNeutralPosRad, double dSteerDriveCoupling) = 0;
+
+	/// Calculates the derived parameters. Has to be called after setting all parameters.
+	virtual void init() = 0;
+
+	/// Sets the actual wheel values and calculates the direct kinematics.
+	virtual void setActualWheelValues(const double* pdVelGearDriveRadS, const double* pdVelGearSteerRadS,
+		const double* pdDltAngGearDriveRad, const double* pdAngGearSteerRad) = 0;
+
+	/// Sets the desired platform velocity and calculates the target wheel configuration.
+	virtual void setDesiredPltfVelocity(double dCmdVelLongMMS, double dCmdVelLatMMS, double dCmdRotRobRadS, double dCmdRotVelRadS) = 0;
+
+	/// Calculates the inverse kinematics (both alternatives, without controller).
+	virtual void calcInverse() = 0;
+
+	/// Performs one discrete control step.
+	virtual void calcControlStep() = 0;
+
+	/// Resets the controller states and the commanded velocities to zero.
+	virtual void resetCtrl() = 0;
+
+	/// Returns the result of the inverse kinematics (alternative 1, without controller).
+	virtual void getSteerDriveSetValues(double* pdVelGearDriveRadS, double* pdAngGearSteerRad) const = 0;
+
+	/// Returns the commanded wheel values of the last control step.
+	virtual void getCmdValues(double* pdVelGearDriveRadS, double* pdVelGearSteerRadS, double* pdAngGearSteerRad) const = 0;
+
+	/// Returns the commanded platform velocity.
+	virtual void getCmdPltfVelocity(double& dVelLongMMS, double& dVelLatMMS, double& dRotRobRadS, double& dRotVelRadS) const = 0;
+
+	/// Returns the result of the direct kinematics.
+	virtual void getActualPltfVelocity(double& dVelLongMMS, double& dVelLatMMS, double& dRotRobRadS, double& dRotVelRadS) const = 0;
+
+	/**
+	 * Returns the residual of every wheel w.r.t. the result of the direct kinematics.
+	 * A large residual indicates a slipping wheel (only calculated in least squares mode).
+	 */
+	virtual void getWheelResiduals(double* pdResidualMMS) const = 0;
+
+	/**
+	 * Returns the covariance of the platform velocity (vx in mm/s, vy in mm/s, w in rad/s)
+	 * as 3x3 row-major matrix. It is calculated from the wheel noise model and
+	 * the residuals of the direct kinematics.
+	 */
+	virtual void getActualPltfVelocityCov(double* pdCov) const = 0;
+};
+
+//-----------------------------------------------
+/**
+ * Kinematics and steering controller for an undercarriage with N steered wheels.
+ *
+ * All per-wheel values are kept in fixed-size arrays (one array per quantity),
+ * so the loops have a compile-time trip count and can be unrolled/vectorized.
+ * Sine and cosine of the measured steering angles are calculated once in
+ * setActualWheelValues() and shared by CalcExWheelPos(), CalcDirect() and
+ * CalcInverse(); the latter two only need products of the cached values.
+ *
+ * The direct kinematics solves the 2N equations
+ *   v_i * (cos(phi_i), sin(phi_i)) = (vx - w * y_i, vy + w * x_i)
+ * in the least squares sense. The pseudo-inverse only depends on the exact
+ * wheel positions: it is given by their centroid and polar moment, whose sums
+ * are updated for the wheels whose position changed since the last cycle.
+ */
+template <int N>
+class UndercarriageKinematics : public UndercarriageKinematicsItf
+{
+public:
+	UndercarriageKinematics()
+	{
+		for(int i = 0; i < N; i++)
+		{
+			m_dWheelXPosMM[i] = 0;
+			m_dWheelYPosMM[i] = 0;
+			m_dWheelNeutralPosRad[i] = 0;
+			m_dSteerDriveCoupling[i] = 0;
+			m_dFactorVel[i] = 0;
+
+			m_dVelGearDriveRadS[i] = 0;
+			m_dVelGearSteerRadS[i] = 0;
+			m_dDltAngGearDriveRad[i] = 0;
+			m_dAngGearSteerRad[i] = 0;
+			m_dAngGearSteerNormRad[i] = 0;
+			m_dSinSteer[i] = 0;
+			m_dCosSteer[i] = 1;
+
+			m_dExWheelXPosMM[i] = 0;
+			m_dExWheelYPosMM[i] = 0;
+
+			m_dAngGearSteerTarget1Rad[i] = 0;
+			m_dVelGearDriveTarget1RadS[i] = 0;
+			m_dAngGearSteerTarget2Rad[i] = 0;
+			m_dVelGearDriveTarget2RadS[i] = 0;
+			m_dAngGearSteerTargetRad[i] = 0;
+			m_dVelGearDriveTargetRadS[i] = 0;
+
+			m_dVelGearDriveCmdRadS[i] = 0;
+			m_dVelGearSteerCmdRadS[i] = 0;
+			m_dAngGearSteerCmdRad[i] = 0;
+
+			m_dCtrlDeltaPhi[i] = 0;
+			m_dCtrlVelCmdInt[i] = 0;
+
+			m_dLsqExWheelXPosMM[i] = 0;
+			m_dLsqExWheelYPosMM[i] = 0;
+			m_dResidualMMS[i] = 0;
+		}
+
+		m_dLsqSumX = 0;
+		m_dLsqSumY = 0;
+		m_dLsqSumR2 = 0;
+		m_iLsqUpdates = 0;
+		m_bLsqValid = false;
+
+		for(int i = 0; i < 9; i++)
+			m_dVelCov[i] = 0;
+
+		m_dCmdVelLongMMS = 0;
+		m_dCmdVelLatMMS = 0;
+		m_dCmdRotRobRadS = 0;
+		m_dCmdRotVelRadS = 0;
+
+		m_dVelLongMMS = 0;
+		m_dVelLatMMS = 0;
+		m_dRotRobRadS = 0;
+		m_dRotVelRadS = 0;
+	}
+
+	UndercarriageKinematicsItf* clone() const
+	{
+		return new UndercarriageKinematics<N>(*this);
+	}
+
+	int getNumberOfWheels() const
+	{
+		return N;
+	}
+
+	void setPrms(const UndercarriageKinematicsPrms& Prms)
+	{
+		m_Prms = Prms;
+	}
+
+	void setWheelPrms(int iWheel, double dXPosMM, double dYPosMM, double dNeutralPosRad, double dSteerDriveCoupling)
+	{
+		if((iWheel < 0) || (iWheel >= N))
+			return;
+
+		m_dWheelXPosMM[iWheel] = dXPosMM;
+		m_dWheelYPosMM[iWheel] = dYPosMM;
+		m_dWheelNeutralPosRad[iWheel] = dNeutralPosRad;
+		m_dSteerDriveCoupling[iWheel] = dSteerDriveCoupling;
+	}
+
+	void init()
+	{
+		for(int i = 0; i < N; i++)
+		{
+			// provisorial --> skip interpolation
+			m_dAngGearSteerCmdRad[i] = m_dWheelNeutralPosRad[i];
+			// also Init choosen Target angle
+			m_dAngGearSteerTargetRad[i] = m_dWheelNeutralPosRad[i];
+
+			// calculate compensation factor for velocity
+			m_dFactorVel[i] = - m_dSteerDriveCoupling[i]
+				+ (double(m_Prms.iDistSteerAxisToDriveWheelMM) / double(m_Prms.iRadiusWheelMM));
+		}
+
+		// Calculate exact position of wheels in robot coordinate frame
+		CalcExWheelPos();
+	}
+
+	void setActualWheelValues(const double* pdVelGearDriveRadS, const double* pdVelGearSteerRadS,
+		const double* pdDltAngGearDriveRad, const double* pdAngGearSteerRad)
+	{
+		for(int i = 0; i < N; i++)
+		{
+			m_dVelGearDriveRadS[i] = pdVelGearDriveRadS[i];
+			m_dVelGearSteerRadS[i] = pdVelGearSteerRadS[i];
+			m_dDltAngGearDriveRad[i] = pdDltAngGearDriveRad[i];
+			m_dAngGearSteerRad[i] = pdAngGearSteerRad[i];
+
+			// the only trigonometric evaluation of the steering angles per cycle
+			// (sin and cos of the same argument are merged into one sincos call by the compiler)
+			m_dSinSteer[i] = sin(m_dAngGearSteerRad[i]);
+			m_dCosSteer[i] = cos(m_dAngGearSteerRad[i]);
+
+			m_dAngGearSteerNormRad[i] = m_dAngGearSteerRad[i];
+			MathSup::normalizePi(m_dAngGearSteerNormRad[i]);
+		}
+
+		// calc exact Wheel Positions (taking into account lever arm)
+		CalcExWheelPos();
+
+		// Peform calculation of direct kinematics (approx.) based on corrected Wheel Positions
+		CalcDirect();
+	}
+
+	void setDesiredPltfVelocity(double dCmdVelLongMMS, double dCmdVelLatMMS, double dCmdRotRobRadS, double dCmdRotVelRadS)
+	{
+		double dtempDeltaPhi1RAD, dtempDeltaPhi2RAD;	// difference between possible steering angels and current steering angle
+		double dtempDeltaPhiCmd1RAD, dtempDeltaPhiCmd2RAD;	// difference between possible steering angels and last target steering angle
+		double dtempWeightedDelta1RAD, dtempWeightedDelta2RAD; // weighted Summ of the two distance values
+
+		m_dCmdVelLongMMS = dCmdVelLongMMS;
+		m_dCmdVelLatMMS = dCmdVelLatMMS;
+		m_dCmdRotRobRadS = dCmdRotRobRadS;
+		m_dCmdRotVelRadS = dCmdRotVelRadS;
+
+		calcInverse();
+
+		// determine optimal Pltf-Configuration
+		for(int i = 0; i < N; i++)
+		{
+			// Calculate differences between current config to possible set-points
+			dtempDeltaPhi1RAD = m_dAngGearSteerTarget1Rad[i] - m_dAngGearSteerNormRad[i];
+			dtempDeltaPhi2RAD = m_dAngGearSteerTarget2Rad[i] - m_dAngGearSteerNormRad[i];
+			MathSup::normalizePi(dtempDeltaPhi1RAD);
+			MathSup::normalizePi(dtempDeltaPhi2RAD);
+			// Calculate differences between last steering target to possible set-points
+			dtempDeltaPhiCmd1RAD = m_dAngGearSteerTarget1Rad[i] - m_dAngGearSteerTargetRad[i];
+			dtempDeltaPhiCmd2RAD = m_dAngGearSteerTarget2Rad[i] - m_dAngGearSteerTargetRad[i];
+			MathSup::normalizePi(dtempDeltaPhiCmd1RAD);
+			MathSup::normalizePi(dtempDeltaPhiCmd2RAD);
+
+			// "fitness criteria" to choose optimal set point:
+			// accumulated (+ weighted) difference between targets, current config. and last command
+			dtempWeightedDelta1RAD = 0.6*fabs(dtempDeltaPhi1RAD) + 0.4*fabs(dtempDeltaPhiCmd1RAD);
+			dtempWeightedDelta2RAD = 0.6*fabs(dtempDeltaPhi2RAD) + 0.4*fabs(dtempDeltaPhiCmd2RAD);
+
+			// check which set point "minimizes fitness criteria"
+			if (dtempWeightedDelta1RAD <= dtempWeightedDelta2RAD)
+			{
+				m_dVelGearDriveTargetRadS[i] = m_dVelGearDriveTarget1RadS[i];
+				m_dAngGearSteerTargetRad[i] = m_dAngGearSteerTarget1Rad[i];
+			}
+			else
+			{
+				m_dVelGearDriveTargetRadS[i] = m_dVelGearDriveTarget2RadS[i];
+				m_dAngGearSteerTargetRad[i] = m_dAngGearSteerTarget2Rad[i];
+			}
+		}
+	}
+
+	// calculate inverse kinematics
+	void calcInverse()
+	{
+		// help variable to store velocities of the steering axis in mm/s
+		double dtempAxVelXRobMMS, dtempAxVelYRobMMS;
+
+		// check if zero movement commanded -> keep orientation of wheels, set wheel velocity to zero
+		if(isZeroCmd())
+		{
+			for(int i = 0; i < N; i++)
+			{
+				m_dAngGearSteerTarget1Rad[i] = m_dAngGearSteerRad[i];
+				m_dVelGearDriveTarget1RadS[i] = 0.0;
+				m_dAngGearSteerTarget2Rad[i] = m_dAngGearSteerRad[i];
+				m_dVelGearDriveTarget2RadS[i] = 0.0;
+			}
+			return;
+		}
+
+		// calculate sets of possible Steering Angle // Drive-Velocity combinations
+		for(int i = 0; i < N; i++)
+		{
+			// Translational Portion + Rotational Portion
+			// (ExWheelDist * -sin(ExWheelAng) == -ExWheelY, ExWheelDist * cos(ExWheelAng) == ExWheelX)
+			dtempAxVelXRobMMS = m_dCmdVelLongMMS - m_dCmdRotRobRadS * m_dExWheelYPosMM[i];
+			dtempAxVelYRobMMS = m_dCmdVelLatMMS + m_dCmdRotRobRadS * m_dExWheelXPosMM[i];
+
+			// Wheel has to move in direction of resulting velocity vector of steering axis
+			m_dAngGearSteerTarget1Rad[i] = MathSup::atan4quad(dtempAxVelYRobMMS, dtempAxVelXRobMMS);
+			// calculate corresponding angle in opposite direction (+180 degree)
+			m_dAngGearSteerTarget2Rad[i] = m_dAngGearSteerTarget1Rad[i] + MathSup::PI;
+			MathSup::normalizePi(m_dAngGearSteerTarget2Rad[i]);
+
+			// calculate absolute value of rotational rate of driving wheels in rad/s
+			m_dVelGearDriveTarget1RadS[i] = sqrt( (dtempAxVelXRobMMS * dtempAxVelXRobMMS) +
+				(dtempAxVelYRobMMS * dtempAxVelYRobMMS) ) / (double)m_Prms.iRadiusWheelMM;
+			// now adapt to direction (forward/backward) of wheel
+			m_dVelGearDriveTarget2RadS[i] = - m_dVelGearDriveTarget1RadS[i];
+		}
+	}
+
+	// perform one discrete Control Step (controls steering angle)
+	void calcControlStep()
+	{
+		// check if zero movement commanded -> keep orientation of wheels, set steer velocity to zero
+		if(isZeroCmd())
+		{
+			for(int i = 0; i < N; i++)
+			{
+				m_dVelGearDriveCmdRadS[i] = 0.0;
+				m_dVelGearSteerCmdRadS[i] = 0.0;
+				m_dCtrlDeltaPhi[i] = 0.0;
+				m_dCtrlVelCmdInt[i] = 0.0;
+			}
+			return;
+		}
+
+		double dDeltaPhi;
+		double dForceDamp, dForceProp, dAccCmd, dVelCmdInt; // Impedance-Ctrl
+
+		for(int i = 0; i < N; i++)
+		{
+			// provisorial --> skip interpolation and always take Target
+			m_dAngGearSteerCmdRad[i] = m_dAngGearSteerTargetRad[i];
+
+			dDeltaPhi = m_dAngGearSteerCmdRad[i] - m_dAngGearSteerNormRad[i];
+			MathSup::normalizePi(dDeltaPhi);
+
+			// Impedance-Ctrl
+			dForceDamp = - m_Prms.dDamp * m_dCtrlVelCmdInt[i];
+			dForceProp = m_Prms.dSpring * dDeltaPhi;
+			dAccCmd = (dForceDamp + dForceProp) / m_Prms.dVirtM;
+			MathSup::limit(&dAccCmd, m_Prms.dDDPhiMax);
+
+			dVelCmdInt = m_dCtrlVelCmdInt[i] + m_Prms.dCmdRateS * dAccCmd;
+			MathSup::limit(&dVelCmdInt, m_Prms.dDPhiMax);
+
+			// Store internal ctrlr-states
+			m_dCtrlDeltaPhi[i] = dDeltaPhi;
+			m_dCtrlVelCmdInt[i] = dVelCmdInt;
+
+			// set outputs, check if Steeringvelocity overgo maximum allowed rates
+			m_dVelGearSteerCmdRadS[i] = dVelCmdInt;
+			MathSup::limit(&m_dVelGearSteerCmdRadS[i], m_Prms.dMaxSteerRateRadpS);
+
+			// Correct Driving-Wheel-Velocity, because of coupling and axis-offset
+			m_dVelGearDriveCmdRadS[i] = m_dVelGearDriveTargetRadS[i] + m_dVelGearSteerCmdRadS[i] * m_dFactorVel[i];
+		}
+	}
+
+	void resetCtrl()
+	{
+		for(int i = 0; i < N; i++)
+		{
+			m_dCtrlDeltaPhi[i] = 0.0;
+			m_dCtrlVelCmdInt[i] = 0.0;
+			m_dVelGearDriveCmdRadS[i] = 0.0;
+			m_dVelGearSteerCmdRadS[i] = 0.0;
+		}
+	}
+
+	void getSteerDriveSetValues(double* pdVelGearDriveRadS, double* pdAngGearSteerRad) const
+	{
+		for(int i = 0; i < N; i++)
+		{
+			pdVelGearDriveRadS[i] = m_dVelGearDriveTarget1RadS[i];
+			pdAngGearSteerRad[i] = m_dAngGearSteerTarget1Rad[i];
+		}
+	}
+
+	void getCmdValues(double* pdVelGearDriveRadS, double* pdVelGearSteerRadS, double* pdAngGearSteerRad) const
+	{
+		for(int i = 0; i < N; i++)
+		{
+			pdVelGearDriveRadS[i] = m_dVelGearDriveCmdRadS[i];
+			pdVelGearSteerRadS[i] = m_dVelGearSteerCmdRadS[i];
+			pdAngGearSteerRad[i] = m_dAngGearSteerCmdRad[i];
+		}
+	}
+
+	void getCmdPltfVelocity(double& dVelLongMMS, double& dVelLatMMS, double& dRotRobRadS, double& dRotVelRadS) const
+	{
+		dVelLongMMS = m_dCmdVelLongMMS;
+		dVelLatMMS = m_dCmdVelLatMMS;
+		dRotRobRadS = m_dCmdRotRobRadS;
+		dRotVelRadS = m_dCmdRotVelRadS;
+	}
+
+	void getActualPltfVelocity(double& dVelLongMMS, double& dVelLatMMS, double& dRotRobRadS, double& dRotVelRadS) const
+	{
+		dVelLongMMS = m_dVelLongMMS;
+		dVelLatMMS = m_dVelLatMMS;
+		dRotRobRadS = m_dRotRobRadS;
+		dRotVelRadS = m_dRotVelRadS;
+	}
+
+	void getWheelResiduals(double* pdResidualMMS) const
+	{
+		for(int i = 0; i < N; i++)
+			pdResidualMMS[i] = m_dResidualMMS[i];
+	}
+
+	void getActualPltfVelocityCov(double* pdCov) const
+	{
+		for(int i = 0; i < 9; i++)
+			pdCov[i] = m_dVelCov[i];
+	}
+
+protected:
+	UndercarriageKinematicsPrms m_Prms;
+
+	// Position of the Wheels' Steering Axis relative to robot coordinate System
+	double m_dWheelXPosMM[N];
+	double m_dWheelYPosMM[N];
+	double m_dWheelNeutralPosRad[N];
+	double m_dSteerDriveCoupling[N];
+	/** Factor between steering motion and steering induced motion of drive wheels
+	 *  subtract from Drive-Wheel Vel to get effective Drive Velocity (Direct Kinematics)
+	 *  add to Drive-Wheel Vel (Inverse Kinematics) to account for coupling when commanding velos
+	 */
+	double m_dFactorVel[N];
+
+	// Actual Wheelspeed (read from Motor-Ctrls) and cached trigonometry of the steering angle
+	double m_dVelGearDriveRadS[N];
+	double m_dVelGearSteerRadS[N];
+	double m_dDltAngGearDriveRad[N];
+	double m_dAngGearSteerRad[N];
+	double m_dAngGearSteerNormRad[N];
+	double m_dSinSteer[N];
+	double m_dCosSteer[N];
+
+	// Exact Position of the Wheels' itself relative to robot coordinate System
+	double m_dExWheelXPosMM[N];
+	double m_dExWheelYPosMM[N];
+
+	// Target Wheelspeed and -angle (calculated from desired Pltf-Movement with Inverse without controle!)
+	double m_dAngGearSteerTarget1Rad[N]; // alternativ 1 for steering angle
+	double m_dVelGearDriveTarget1RadS[N];
+	double m_dAngGearSteerTarget2Rad[N]; // alternativ 2 for steering angle (+/- PI)
+	double m_dVelGearDriveTarget2RadS[N];
+	double m_dAngGearSteerTargetRad[N]; // choosen alternativ for steering angle
+	double m_dVelGearDriveTargetRadS[N];
+
+	// Desired Wheelspeeds set to ELMO-Ctrl's
+	double m_dVelGearDriveCmdRadS[N];
+	double m_dVelGearSteerCmdRadS[N];
+	double m_dAngGearSteerCmdRad[N];
+
+	// internal controller states: previous commanded deltaPhi e(k-1) and previous commanded velocity u(k-1)
+	double m_dCtrlDeltaPhi[N];
+	double m_dCtrlVelCmdInt[N];
+
+	/** Cache for the least squares direct kinematics (unit weights)
+	 *  m_dLsqExWheelX/YPosMM	wheel positions contained in the sums
+	 *  m_dLsqSumX/Y/R2			sum of x, y and x^2+y^2 over all wheels
+	 *  m_dLsqCntX/Y, m_dLsqInvJ	centroid and inverse polar moment around it (-> pseudo-inverse)
+	 */
+	double m_dLsqExWheelXPosMM[N];
+	double m_dLsqExWheelYPosMM[N];
+	double m_dLsqSumX, m_dLsqSumY, m_dLsqSumR2;
+	double m_dLsqCntX, m_dLsqCntY, m_dLsqInvJ;
+	int m_iLsqUpdates;
+	bool m_bLsqValid;
+
+	// Residual of every wheel (slip indicator) in mm/s
+	double m_dResidualMMS[N];
+
+	// Covariance of the platform velocity (vx, vy, w)
+	double m_dVelCov[9];
+
+	// Desired Pltf-Movement
+	double m_dCmdVelLongMMS;
+	double m_dCmdVelLatMMS;
+	double m_dCmdRotRobRadS;
+	double m_dCmdRotVelRadS;
+
+	// Actual Pltf-Movement (calculated from Actual Wheelspeeds)
+	double m_dVelLongMMS;
+	double m_dVelLatMMS;
+	double m_dRotRobRadS;
+	double m_dRotVelRadS;
+
+	bool isZeroCmd() const
+	{
+		return (m_dCmdVelLongMMS == 0) && (m_dCmdVelLatMMS == 0) && (m_dCmdRotRobRadS == 0) && (m_dCmdRotVelRadS == 0);
+	}
+
+	// calculate Exact Wheel Position in robot coordinates
+	void CalcExWheelPos()
+	{
+		const double dDist = m_Prms.iDistSteerAxisToDriveWheelMM;
+
+		for(int i = 0; i < N; i++)
+		{
+			m_dExWheelXPosMM[i] = m_dWheelXPosMM[i] + dDist * m_dSinSteer[i];
+			m_dExWheelYPosMM[i] = m_dWheelYPosMM[i] - dDist * m_dCosSteer[i];
+		}
+	}
+
+	// calculate direct kinematics
+	void CalcDirect()
+	{
+		double dVelWheelMMS[N];		// effective Wheel-Velocities in mm/s
+
+		for(int i = 0; i < N; i++)
+			dVelWheelMMS[i] = m_Prms.iRadiusWheelMM * (m_dVelGearDriveRadS[i] - m_dFactorVel[i] * m_dVelGearSteerRadS[i]);
+
+		UpdateLeastSquaresCache();
+
+		if(m_Prms.bLeastSquaresDirect)
+			CalcDirectLeastSquares(dVelWheelMMS);
+		else
+			CalcDirectPairwise(dVelWheelMMS);
+
+		m_dRotVelRadS = 0; // currently not used to represent 3rd degree of freedom -> set to zero
+
+		CalcVelocityCovariance(dVelWheelMMS);
+	}
+
+	/**
+	 * Covariance of the least squares estimate sigma^2 * (A'A)^-1 for independent wheel noise.
+	 * sigma^2 is the mean variance of the noise model plus the variance of the residuals,
+	 * so slipping wheels increase the uncertainty. Around the centroid (A'A)^-1 decouples into
+	 * 1/N for the translation and 1/J for the rotation.
+	 */
+	void CalcVelocityCovariance(const double* pdVelWheelMMS)
+	{
+		double dSigma, dVar = 0, dResSq = 0;
+
+		for(int i = 0; i < N; i++)
+		{
+			dSigma = m_Prms.dWheelVelNoiseMMS + m_Prms.dWheelVelNoiseFactor * fabs(pdVelWheelMMS[i]);
+			dVar += dSigma * dSigma;
+			dResSq += m_dResidualMMS[i] * m_dResidualMMS[i];
+		}
+		dVar /= N;
+		if(2 * N > 3)
+			dVar += dResSq / (2 * N - 3);
+
+		const double dVarRot = dVar * m_dLsqInvJ;
+		const double dCx = m_dLsqCntX;
+		const double dCy = m_dLsqCntY;
+
+		m_dVelCov[0] = dVar / N + dCy * dCy * dVarRot;
+		m_dVelCov[1] = - dCx * dCy * dVarRot;
+		m_dVelCov[2] = dCy * dVarRot;
+		m_dVelCov[4] = dVar / N + dCx * dCx * dVarRot;
+		m_dVelCov[5] = - dCx * dVarRot;
+		m_dVelCov[8] = dVarRot;
+		m_dVelCov[3] = m_dVelCov[1];
+		m_dVelCov[6] = m_dVelCov[2];
+		m_dVelCov[7] = m_dVelCov[5];
+	}
+
+	// rotation as average over the linking axes of neighbouring wheels, translation as average of all wheels
+	void CalcDirectPairwise(const double* pdVelWheelMMS)
+	{
+		double dtempVelXRobMMS = 0;
+		double dtempVelYRobMMS = 0;
+		double dtempRotRobRADPS = 0;
+		double dtempDiffXMM, dtempDiffYMM, dtempRelDistSqMM;
+		int j;
+
+		for(int i = 0; i < N; i++)
+		{
+			dtempVelXRobMMS += pdVelWheelMMS[i] * m_dCosSteer[i];
+			dtempVelYRobMMS += pdVelWheelMMS[i] * m_dSinSteer[i];
+		}
+
+		// rotational rate from the "virtual" linking axes between neighbouring wheels (closed loop).
+		// sin(phi - phiAxis) = (sin(phi)*dx - cos(phi)*dy) / dist, so no angle of the axis is needed
+		for(int i = 0; i < N; i++)
+		{
+			j = (i + 1 < N) ? (i + 1) : 0;
+			dtempDiffXMM = m_dExWheelXPosMM[j] - m_dExWheelXPosMM[i];
+			dtempDiffYMM = m_dExWheelYPosMM[j] - m_dExWheelYPosMM[i];
+			dtempRelDistSqMM = dtempDiffXMM*dtempDiffXMM + dtempDiffYMM*dtempDiffYMM;
+
+			dtempRotRobRADPS += ( pdVelWheelMMS[j] * (m_dSinSteer[j]*dtempDiffXMM - m_dCosSteer[j]*dtempDiffYMM)
+				- pdVelWheelMMS[i] * (m_dSinSteer[i]*dtempDiffXMM - m_dCosSteer[i]*dtempDiffYMM) ) / dtempRelDistSqMM;
+		}
+
+		m_dRotRobRadS = dtempRotRobRADPS / N;
+		m_dVelLongMMS = dtempVelXRobMMS / N;
+		m_dVelLatMMS = dtempVelYRobMMS / N;
+
+		for(int i = 0; i < N; i++)
+			m_dResidualMMS[i] = 0;
+	}
+
+	// update the sums of the pseudo-inverse for all wheels which moved since the last cycle
+	void UpdateLeastSquaresCache()
+	{
+		bool bChanged = false;
+
+		// start from scratch once in a while to get rid of accumulated rounding errors
+		if(!m_bLsqValid || (m_iLsqUpdates > 10000))
+		{
+			m_dLsqSumX = 0;
+			m_dLsqSumY = 0;
+			m_dLsqSumR2 = 0;
+			for(int i = 0; i < N; i++)
+			{
+				m_dLsqExWheelXPosMM[i] = m_dExWheelXPosMM[i];
+				m_dLsqExWheelYPosMM[i] = m_dExWheelYPosMM[i];
+				m_dLsqSumX += m_dExWheelXPosMM[i];
+				m_dLsqSumY += m_dExWheelYPosMM[i];
+				m_dLsqSumR2 += m_dExWheelXPosMM[i]*m_dExWheelXPosMM[i] + m_dExWheelYPosMM[i]*m_dExWheelYPosMM[i];
+			}
+			m_iLsqUpdates = 0;
+			m_bLsqValid = true;
+			bChanged = true;
+		}
+		else
+		{
+			for(int i = 0; i < N; i++)
+			{
+				if( (m_dLsqExWheelXPosMM[i] == m_dExWheelXPosMM[i]) && (m_dLsqExWheelYPosMM[i] == m_dExWheelYPosMM[i]) )
+					continue;
+
+				// replace contribution of this wheel
+				m_dLsqSumX += m_dExWheelXPosMM[i] - m_dLsqExWheelXPosMM[i];
+				m_dLsqSumY += m_dExWheelYPosMM[i] - m_dLsqExWheelYPosMM[i];
+				m_dLsqSumR2 += m_dExWheelXPosMM[i]*m_dExWheelXPosMM[i] + m_dExWheelYPosMM[i]*m_dExWheelYPosMM[i]
+					- m_dLsqExWheelXPosMM[i]*m_dLsqExWheelXPosMM[i] - m_dLsqExWheelYPosMM[i]*m_dLsqExWheelYPosMM[i];
+				m_dLsqExWheelXPosMM[i] = m_dExWheelXPosMM[i];
+				m_dLsqExWheelYPosMM[i] = m_dExWheelYPosMM[i];
+				m_iLsqUpdates++;
+				bChanged = true;
+			}
+		}
+
+		if(bChanged)
+		{
+			// centroid and polar moment around it
+			m_dLsqCntX = m_dLsqSumX / N;
+			m_dLsqCntY = m_dLsqSumY / N;
+			double dJ = m_dLsqSumR2 - N * (m_dLsqCntX*m_dLsqCntX + m_dLsqCntY*m_dLsqCntY);
+			m_dLsqInvJ = (dJ > 1e-9) ? (1.0 / dJ) : 0.0;
+		}
+	}
+
+	/**
+	 * Solves the weighted least squares problem for the given wheel velocities (in x/y of robot frame).
+	 * With the centroid (cx,cy) and the polar moment J around it the normal equations decouple:
+	 *   w = sum( -(y_i-cy)*vx_i + (x_i-cx)*vy_i ) / J,  vx = mean(vx_i) + w*cy,  vy = mean(vy_i) - w*cx
+	 */
+	void SolveLeastSquares(const double* pdVelXMMS, const double* pdVelYMMS, const double* pdWeight,
+		double dCntX, double dCntY, double dInvJ, double dSumW)
+	{
+		double dSumVx = 0, dSumVy = 0, dSumMoment = 0;
+
+		for(int i = 0; i < N; i++)
+		{
+			dSumVx += pdWeight[i] * pdVelXMMS[i];
+			dSumVy += pdWeight[i] * pdVelYMMS[i];
+			dSumMoment += pdWeight[i] * ( -(m_dExWheelYPosMM[i] - dCntY) * pdVelXMMS[i] + (m_dExWheelXPosMM[i] - dCntX) * pdVelYMMS[i] );
+		}
+
+		m_dRotRobRadS = dSumMoment * dInvJ;
+		m_dVelLongMMS = dSumVx / dSumW + m_dRotRobRadS * dCntY;
+		m_dVelLatMMS = dSumVy / dSumW - m_dRotRobRadS * dCntX;
+
+		for(int i = 0; i < N; i++)
+		{
+			double dResX = pdVelXMMS[i] - (m_dVelLongMMS - m_dRotRobRadS * m_dExWheelYPosMM[i]);
+			double dResY = pdVelYMMS[i] - (m_dVelLatMMS + m_dRotRobRadS * m_dExWheelXPosMM[i]);
+			m_dResidualMMS[i] = sqrt(dResX*dResX + dResY*dResY);
+		}
+	}
+
+	// least squares fit of the platform motion to all wheels, optionally down-weighting slipping wheels
+	void CalcDirectLeastSquares(const double* pdVelWheelMMS)
+	{
+		double dVelXMMS[N], dVelYMMS[N], dWeight[N];
+		bool bOutlier = false;
+
+		for(int i = 0; i < N; i++)
+		{
+			dVelXMMS[i] = pdVelWheelMMS[i] * m_dCosSteer[i];
+			dVelYMMS[i] = pdVelWheelMMS[i] * m_dSinSteer[i];
+			dWeight[i] = 1.0;
+		}
+
+		SolveLeastSquares(dVelXMMS, dVelYMMS, dWeight, m_dLsqCntX, m_dLsqCntY, m_dLsqInvJ, N);
+
+		if(m_Prms.dOutlierThresholdMMS <= 0)
+			return;
+
+		// Huber weights: wheels beyond the threshold contribute with threshold/residual
+		for(int i = 0; i < N; i++)
+		{
+			if(m_dResidualMMS[i] > m_Prms.dOutlierThresholdMMS)
+			{
+				dWeight[i] = m_Prms.dOutlierThresholdMMS / m_dResidualMMS[i];
+				bOutlier = true;
+			}
+		}
+
+		if(!bOutlier)
+			return;
+
+		// weighted pseudo-inverse (only needed when a wheel slips -> not cached)
+		double dSumW = 0, dSumX = 0, dSumY = 0, dSumR2 = 0;
+		for(int i = 0; i < N; i++)
+		{
+			dSumW += dWeight[i];
+			dSumX += dWeight[i] * m_dExWheelXPosMM[i];
+			dSumY += dWeight[i] * m_dExWheelYPosMM[i];
+			dSumR2 += dWeight[i] * (m_dExWheelXPosMM[i]*m_dExWheelXPosMM[i] + m_dExWheelYPosMM[i]*m_dExWheelYPosMM[i]);
+		}
+		double dCntX = dSumX / dSumW;
+		double dCntY = dSumY / dSumW;
+		double dJ = dSumR2 - dSumW * (dCntX*dCntX + dCntY*dCntY);
+
+		SolveLeastSquares(dVelXMMS, dVelYMMS, dWeight, dCntX, dCntY, (dJ > 1e-9) ? (1.0 / dJ) : 0.0, dSumW);
+	}
+};
+
+//-----------------------------------------------
+/**
+ * Creates the kinematics core for the given number of wheels.
+ * @return pointer to the new kinematics core, NULL if the number of wheels is not supported
+ */
+inline UndercarriageKinematicsItf* createUndercarriageKinematics(int iNumberOfWheels)
+{
+	switch(iNumberOfWheels)
+	{
+	case 2: return new UndercarriageKinematics<2>();
+	case 3: return new UndercarriageKinematics<3>();
+	case 4: return new UndercarriageKinematics<4>();
+	case 5: return new UndercarriageKinematics<5>();
+	case 6: return new UndercarriageKinematics<6>();
+	case 7: return new UndercarriageKinematics<7>();
+	case 8: return new UndercarriageKinematics<8>();
+	default: return NULL;
+	}
+}
+
+#endif
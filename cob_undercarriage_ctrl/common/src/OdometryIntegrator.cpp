@@ -0,0 +1,182 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+
+#include <cob_undercarriage_ctrl/OdometryIntegrator.h>
+
+#include <math.h>
+#include <cstddef>
+#include <cob_utilities/MathSup.h>
+
+//-----------------------------------------------
+OdometryIntegrator::OdometryIntegrator()
+{
+	reset();
+}
+
+//-----------------------------------------------
+void OdometryIntegrator::reset()
+{
+	m_bValid = false;
+	m_dLastStampS = 0;
+	m_dXM = 0;
+	m_dYM = 0;
+	m_dThetaRad = 0;
+
+	for(int i = 0; i < 3; i++)
+		m_dLastVel[i] = 0;
+
+	for(int i = 0; i < 9; i++)
+	{
+		m_dLastVelCov[i] = 0;
+		m_dPoseCov[i] = 0;
+	}
+}
+
+//-----------------------------------------------
+void OdometryIntegrator::expSE2(double dVelXMS, double dVelYMS, double dRotRadS, double dDtS,
+	double& dDeltaXM, double& dDeltaYM, double& dDeltaThetaRad)
+{
+	double dA = dVelXMS * dDtS;
+	double dB = dVelYMS * dDtS;
+	double dPhi = dRotRadS * dDtS;
+	double dSinPhiByPhi, dOneMinusCosPhiByPhi;
+
+	if(fabs(dPhi) > 1e-6)
+	{
+		dSinPhiByPhi = sin(dPhi) / dPhi;
+		dOneMinusCosPhiByPhi = (1.0 - cos(dPhi)) / dPhi;
+	}
+	else
+	{
+		// series expansion to avoid 0/0
+		dSinPhiByPhi = 1.0 - dPhi * dPhi / 6.0;
+		dOneMinusCosPhiByPhi = dPhi / 2.0;
+	}
+
+	dDeltaXM = dSinPhiByPhi * dA - dOneMinusCosPhiByPhi * dB;
+	dDeltaYM = dOneMinusCosPhiByPhi * dA + dSinPhiByPhi * dB;
+	dDeltaThetaRad = dPhi;
+}
+
+//-----------------------------------------------
+bool OdometryIntegrator::update(double dStampS, double dVelXMS, double dVelYMS, double dRotRadS, const double* pdVelCov)
+{
+	double dVel[3] = {dVelXMS, dVelYMS, dRotRadS};
+	double dVelCov[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	if(pdVelCov != NULL)
+	{
+		for(int i = 0; i < 9; i++)
+			dVelCov[i] = pdVelCov[i];
+	}
+
+	if(!m_bValid)
+	{
+		// first measurement only defines the start
+		m_bValid = true;
+	}
+	else
+	{
+		double dDtS = dStampS - m_dLastStampS;
+
+		if(dDtS <= 0)
+			return false;
+
+		// mean velocity and its covariance over the interval
+		double dMeanVel[3], dMeanVelCov[9];
+		for(int i = 0; i < 3; i++)
+			dMeanVel[i] = 0.5 * (m_dLastVel[i] + dVel[i]);
+		for(int i = 0; i < 9; i++)
+			dMeanVelCov[i] = 0.25 * (m_dLastVelCov[i] + dVelCov[i]);
+
+		double dDx, dDy, dDTheta;
+		expSE2(dMeanVel[0], dMeanVel[1], dMeanVel[2], dDtS, dDx, dDy, dDTheta);
+
+		double dCos = cos(m_dThetaRad);
+		double dSin = sin(m_dThetaRad);
+		double dDxGlobal = dCos * dDx - dSin * dDy;
+		double dDyGlobal = dSin * dDx + dCos * dDy;
+
+		// covariance propagation P = F*P*F' + G*Q*G'
+		// F: jacobian w.r.t. the pose, G: jacobian w.r.t. the velocity (rotation into world times dt)
+		double dF[9] = {1, 0, -dDyGlobal,
+						0, 1, dDxGlobal,
+						0, 0, 1};
+		double dG[9] = {dCos * dDtS, -dSin * dDtS, 0,
+						dSin * dDtS, dCos * dDtS, 0,
+						0, 0, dDtS};
+		double dTmp[9], dNewCov[9];
+
+		for(int r = 0; r < 3; r++)
+			for(int c = 0; c < 3; c++)
+			{
+				dTmp[3*r+c] = 0;
+				for(int k = 0; k < 3; k++)
+					dTmp[3*r+c] += dF[3*r+k] * m_dPoseCov[3*k+c];
+			}
+		for(int r = 0; r < 3; r++)
+			for(int c = 0; c < 3; c++)
+			{
+				dNewCov[3*r+c] = 0;
+				for(int k = 0; k < 3; k++)
+					dNewCov[3*r+c] += dTmp[3*r+k] * dF[3*c+k];
+			}
+
+		for(int r = 0; r < 3; r++)
+			for(int c = 0; c < 3; c++)
+			{
+				dTmp[3*r+c] = 0;
+				for(int k = 0; k < 3; k++)
+					dTmp[3*r+c] += dG[3*r+k] * dMeanVelCov[3*k+c];
+			}
+		for(int r = 0; r < 3; r++)
+			for(int c = 0; c < 3; c++)
+				for(int k = 0; k < 3; k++)
+					dNewCov[3*r+c] += dTmp[3*r+k] * dG[3*c+k];
+
+		for(int i = 0; i < 9; i++)
+			m_dPoseCov[i] = dNewCov[i];
+
+		m_dXM += dDxGlobal;
+		m_dYM += dDyGlobal;
+		m_dThetaRad += dDTheta;
+		MathSup::normalizePi(m_dThetaRad);
+	}
+
+	m_dLastStampS = dStampS;
+	for(int i = 0; i < 3; i++)
+		m_dLastVel[i] = dVel[i];
+	for(int i = 0; i < 9; i++)
+		m_dLastVelCov[i] = dVelCov[i];
+
+	return true;
+}
+
+//-----------------------------------------------
+void OdometryIntegrator::getPose(double& dXM, double& dYM, double& dThetaRad) const
+{
+	dXM = m_dXM;
+	dYM = m_dYM;
+	dThetaRad = m_dThetaRad;
+}
+
+//-----------------------------------------------
+void OdometryIntegrator::getPoseCov(double* pdCov) const
+{
+	for(int i = 0; i < 9; i++)
+		pdCov[i] = m_dPoseCov[i];
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+
+#include <cob_undercarriage_ctrl/UndercarriageKinematics.h>
+#include <cob_utilities/TimeStamp.h>
+
+#include <stdlib.h>
+#include <iostream>
+
+// Runs SetDesiredPltfVelocity + CalcControlStep + CalcDirect (one controller cycle)
+// for an undercarriage with N wheels placed on a circle and prints the mean cycle time.
+template <int N>
+void runBenchmark(int iCycles)
+{
+	UndercarriageKinematics<N> Kin;
+	UndercarriageKinematicsPrms Prms;
+	double dVelGearDriveRadS[N], dVelGearSteerRadS[N], dDltAngGearDriveRad[N], dAngGearSteerRad[N];
+	double dCmdDrive[N], dCmdSteer[N], dCmdAng[N];
+	double dVx, dVy, dW, dDummy, dChecksum = 0;
+	TimeStamp Start(TimeStamp::CLOCK_TYPE_MONOTONIC), End(TimeStamp::CLOCK_TYPE_MONOTONIC);
+
+	Prms.iRadiusWheelMM = 40;
+	Prms.iDistSteerAxisToDriveWheelMM = 10;
+	Prms.dMaxDriveRateRadpS = 30.0;
+	Prms.dMaxSteerRateRadpS = 10.0;
+	Prms.dCmdRateS = 0.001;
+	Kin.setPrms(Prms);
+
+	for(int i = 0; i < N; i++)
+	{
+		Kin.setWheelPrms(i, 250.0 * cos(MathSup::TWO_PI * i / N), 250.0 * sin(MathSup::TWO_PI * i / N), 0.0, 0.0);
+		dVelGearDriveRadS[i] = 1.0;
+		dVelGearSteerRadS[i] = 0.0;
+		dDltAngGearDriveRad[i] = 0.0;
+		dAngGearSteerRad[i] = 0.0;
+	}
+	Kin.init();
+
+	Start.SetNow();
+	for(int k = 0; k < iCycles; k++)
+	{
+		// slowly varying command and measurement, so no branch is trivially predicted
+		Kin.setDesiredPltfVelocity(200.0 * sin(k * 1e-3), 100.0 * cos(k * 1e-3), 0.3, 0.0);
+		Kin.calcControlStep();
+		Kin.getCmdValues(dCmdDrive, dCmdSteer, dCmdAng);
+
+		for(int i = 0; i < N; i++)
+		{
+			dVelGearDriveRadS[i] = dCmdDrive[i];
+			dVelGearSteerRadS[i] = dCmdSteer[i];
+			dAngGearSteerRad[i] += dCmdSteer[i] * Prms.dCmdRateS;
+		}
+		Kin.setActualWheelValues(dVelGearDriveRadS, dVelGearSteerRadS, dDltAngGearDriveRad, dAngGearSteerRad);
+		Kin.getActualPltfVelocity(dVx, dVy, dW, dDummy);
+		dChecksum += dVx + dVy + dW;
+	}
+	End.SetNow();
+
+	std::cout << "N=" << N << ": " << iCycles << " cycles, "
+		<< (End - Start) / iCycles * 1e6 << " us/cycle (checksum " << dChecksum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int iCycles = 100000;
+
+	if(argc > 1)
+		iCycles = atoi(argv[1]);
+	if(iCycles <= 0)
+		iCycles = 100000;
+
+	runBenchmark<3>(iCycles);
+	runBenchmark<4>(iCycles);
+	runBenchmark<6>(iCycles);
+
+	return 0;
+}
@@ -20,6 +20,8 @@
 
 // standard includes
 #include <math.h>
+#include <stdio.h>
+#include <algorithm>
 
 // ROS includes
 #include <ros/ros.h>
@@ -32,10 +34,14 @@
 #include <tf/transform_broadcaster.h>
 #include <cob_msgs/EmergencyStopState.h>
 #include <control_msgs/JointTrajectoryControllerState.h>
+#include <std_srvs/Trigger.h>
 
 // external includes
 #include <cob_undercarriage_ctrl/UndercarriageCtrlGeom.h>
+#include <cob_undercarriage_ctrl/OdometryIntegrator.h>
 #include <cob_utilities/IniFile.h>
+#include <cob_utilities/JointNameMap.h>
+#include <cob_utilities/CycleStats.h>
 //#include <cob_utilities/MathSup.h>
 
 //####################
@@ -65,6 +71,11 @@ class NodeClass
     // diagnostic stuff
     diagnostic_updater::Updater updater_;
 
+    // timing of the control loop (enabled by parameter cycle_stats)
+    CycleStats cycle_stats_;
+    int stage_timer_latency_, stage_ctrl_step_, stage_joint_states_;
+    ros::ServiceServer srv_dump_cycle_stats_;
+
     // controller Timer
     ros::Timer timer_ctrl_step_;
 
@@ -77,12 +88,23 @@ class NodeClass
     ros::Time last_time_;				// time Stamp for last odometry measurement
     ros::Time joint_state_odom_stamp_;	// time stamp of joint states used for current odometry calc
     double sample_time_, timeout_;
-    double x_rob_m_, y_rob_m_, theta_rob_rad_; // accumulated motion of robot since startup
+    OdometryIntegrator odometry_;		// accumulated motion of robot since startup (incl. covariance)
     int iwatchdog_;
-    double 	vel_x_rob_last_, vel_y_rob_last_, vel_theta_rob_last_; //save velocities for better odom calculation
     double max_vel_trans_, max_vel_rot_;
 
     int m_iNumJoints;
+    int num_wheels_;
+
+    // joint naming: slot 2*w is the drive joint, slot 2*w+1 the steer joint of wheel w
+    std::vector<std::string> joint_names_;
+    JointNameMap joint_name_map_;	// association of the joint names in the state msg to the slots (resolved once)
+
+    // preallocated buffers for measured values and commands of the wheels
+    std::vector<double> drive_joint_ang_rad_, drive_joint_vel_rads_;
+    std::vector<double> steer_joint_ang_rad_, steer_joint_vel_rads_;
+    std::vector<double> drive_jointvel_cmds_rads_, steer_jointvel_cmds_rads_, steer_jointang_cmds_rad_;
+    control_msgs::JointTrajectoryControllerState joint_state_cmd_;		// published every control step
+    control_msgs::JointTrajectoryControllerState joint_state_heartbeat_;	// zero cmd published during init of the drive chain
 
     diagnostic_msgs::DiagnosticStatus diagnostic_status_lookup_; // used to access defines for warning levels
 
@@ -95,12 +117,6 @@ class NodeClass
       iwatchdog_ = 0;
       last_time_ = ros::Time::now();
       sample_time_ = 0.020;
-      x_rob_m_ = 0.0;
-      y_rob_m_ = 0.0;
-      theta_rob_rad_ = 0.0;
-      vel_x_rob_last_ = 0.0;
-      vel_y_rob_last_ = 0.0;
-      vel_theta_rob_last_ = 0.0;
       // set status of drive chain to WARN by default
       drive_chain_diagnostic_ = diagnostic_status_lookup_.OK; //WARN; <- THATS FOR DEBUGGING ONLY!
 
@@ -159,11 +175,48 @@ class NodeClass
         n.getParam("broadcast_tf", broadcast_tf_);
       }
 
+      // latency of the timer and duration of the callbacks, budgets are used to count overruns
+      bool cycle_stats;
+      n.param<bool>("cycle_stats", cycle_stats, false);
+      stage_timer_latency_ = cycle_stats_.addStage("timer latency", 0.2 * sample_time_);
+      stage_ctrl_step_ = cycle_stats_.addStage("CalcCtrlStep", 0.001);
+      stage_joint_states_ = cycle_stats_.addStage("joint states callback", 0.001);
+      cycle_stats_.setEnabled(cycle_stats);
+
       IniFile iniFile;
       iniFile.SetFileName(sIniDirectory + "Platform.ini", "PltfHardwareCoB3.h");
       iniFile.GetKeyInt("Config", "NumberOfMotors", &m_iNumJoints, true);
 
       ucar_ctrl_ = new UndercarriageCtrlGeom(sIniDirectory);
+      num_wheels_ = ucar_ctrl_->GetNumberOfDrives();
+
+      // joint names can be configured, default to the names of the Care-O-bot base
+      if (n.hasParam("joint_names"))
+      {
+        n.getParam("joint_names", joint_names_);
+      }
+      if ((int)joint_names_.size() != m_iNumJoints)
+      {
+        if (!joint_names_.empty())
+          ROS_WARN("Parameter joint_names has %d entries but %d motors are configured. Using default names", (int)joint_names_.size(), m_iNumJoints);
+        joint_names_.assign(c_cDefaultBaseJointNames, c_cDefaultBaseJointNames + c_iNumDefaultBaseJoints);
+        joint_names_.resize(m_iNumJoints);
+      }
+      joint_name_map_.setNames(joint_names_);
+
+      // preallocate buffers and messages
+      drive_joint_ang_rad_.assign(num_wheels_, 0.0);
+      drive_joint_vel_rads_.assign(num_wheels_, 0.0);
+      steer_joint_ang_rad_.assign(num_wheels_, 0.0);
+      steer_joint_vel_rads_.assign(num_wheels_, 0.0);
+      drive_jointvel_cmds_rads_.assign(num_wheels_, 0.0);
+      steer_jointvel_cmds_rads_.assign(num_wheels_, 0.0);
+      steer_jointang_cmds_rad_.assign(num_wheels_, 0.0);
+
+      joint_state_cmd_.joint_names = joint_names_;
+      joint_state_cmd_.desired.positions.assign(m_iNumJoints, 0.0);
+      joint_state_cmd_.desired.velocities.assign(m_iNumJoints, 0.0);
+      joint_state_heartbeat_ = joint_state_cmd_;
 
 
       // implementation of topics
@@ -186,6 +239,11 @@ class NodeClass
       // diagnostics
       updater_.setHardwareID(ros::this_node::getName());
       updater_.add("initialization", this, &NodeClass::diag_init);
+      if (cycle_stats)
+      {
+        updater_.add("cycle times", this, &NodeClass::diag_cycle_stats);
+      }
+      srv_dump_cycle_stats_ = n.advertiseService("dump_cycle_stats", &NodeClass::srvCallbackDumpCycleStats, this);
 
       //set up timer to cyclically call controller-step
       timer_ctrl_step_ = n.createTimer(ros::Duration(sample_time_), &NodeClass::timerCallbackCtrlStep, this);
@@ -206,6 +264,27 @@ class NodeClass
       stat.add("Initialized", is_initialized_bool_);
     }
 
+    void diag_cycle_stats(diagnostic_updater::DiagnosticStatusWrapper &stat)
+    {
+      std::vector<std::pair<std::string, std::string> > key_values;
+      bool overruns;
+
+      cycle_stats_.toKeyValues(key_values);
+      for(size_t i = 0; i < key_values.size(); i++)
+        stat.add(key_values[i].first, key_values[i].second);
+
+      std::string summary = cycle_stats_.summary("control loop", overruns);
+      stat.summary(overruns ? diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK, summary);
+    }
+
+    bool srvCallbackDumpCycleStats(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
+    {
+      res.success = cycle_stats_.dumpMessage(res.message);
+      if (res.success)
+        ROS_INFO_STREAM("Timing statistics of the control loop:\n" << res.message);
+      return true;
+    }
+
     // Listen for Pltf Cmds
     void topicCallbackTwistCmd(const geometry_msgs::Twist::ConstPtr& msg)
     {
@@ -308,34 +387,8 @@ class NodeClass
     // Listens for status of underlying hardware (base drive chain)
     void topicCallbackDiagnostic(const diagnostic_msgs::DiagnosticStatus::ConstPtr& msg)
     {
-      control_msgs::JointTrajectoryControllerState joint_state_cmd;
-
-      // prepare joint_cmds for heartbeat (compose header)
-      joint_state_cmd.header.stamp = ros::Time::now();
-      //joint_state_cmd.header.frame_id = frame_id; //Where to get this id from?
-      // ToDo: configure over Config-File (number of motors) and Msg
-      // assign right size to JointState data containers
-      //joint_state_cmd.set_name_size(m_iNumMotors);
-      joint_state_cmd.desired.positions.resize(m_iNumJoints);
-      joint_state_cmd.desired.velocities.resize(m_iNumJoints);
-      //joint_state_cmd.desired.effort.resize(m_iNumJoints);
-      joint_state_cmd.joint_names.push_back("fl_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("fl_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("bl_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("bl_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("br_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("br_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("fr_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("fr_caster_rotation_joint");
-      joint_state_cmd.joint_names.resize(m_iNumJoints);
-
-      // compose jointcmds
-      for(int i=0; i<m_iNumJoints; i++)
-      {
-        joint_state_cmd.desired.positions[i] = 0.0;
-        joint_state_cmd.desired.velocities[i] = 0.0;
-        //joint_state_cmd.desired.effort[i] = 0.0;
-      }
+      // prepare joint_cmds for heartbeat (zero cmds, compose header)
+      joint_state_heartbeat_.header.stamp = ros::Time::now();
 
       // set status of underlying drive chain to member variable
       drive_chain_diagnostic_ = msg->level;
@@ -372,91 +425,57 @@ class NodeClass
         if(drive_chain_diagnostic_ != diagnostic_status_lookup_.WARN)
         {
           // publish zero-vel. jointcmds to avoid Watchdogs stopping ctrlr
-          topic_pub_controller_joint_command_.publish(joint_state_cmd);
+          topic_pub_controller_joint_command_.publish(joint_state_heartbeat_);
         }
       }
     }
 
     void topicCallbackJointControllerStates(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg) {
-      int num_joints;
-      int iter_k, iter_j;
-      std::vector<double> drive_joint_ang_rad, drive_joint_vel_rads, drive_joint_effort_NM;
-      std::vector<double> steer_joint_ang_rad, steer_joint_vel_rads, steer_joint_effort_NM;
+      int slot, wheel;
+      bool resolved;
+      CycleStats::Scope scope(cycle_stats_, stage_joint_states_);
 
       joint_state_odom_stamp_ = msg->header.stamp;
 
-      // copy configuration into vector classes
-      num_joints = msg->joint_names.size();
-      // drive joints
-      drive_joint_ang_rad.assign(m_iNumJoints, 0.0);
-      drive_joint_vel_rads.assign(m_iNumJoints, 0.0);
-      drive_joint_effort_NM.assign(m_iNumJoints, 0.0);
-      // steer joints
-      steer_joint_ang_rad.assign(m_iNumJoints, 0.0);
-      steer_joint_vel_rads.assign(m_iNumJoints, 0.0);
-      steer_joint_effort_NM.assign(m_iNumJoints, 0.0);
-
-      // init iterators
-      iter_k = 0;
-      iter_j = 0;
-
-      for(int i = 0; i < num_joints; i++)
+      // joints not contained in the msg are set to zero
+      std::fill(drive_joint_ang_rad_.begin(), drive_joint_ang_rad_.end(), 0.0);
+      std::fill(drive_joint_vel_rads_.begin(), drive_joint_vel_rads_.end(), 0.0);
+      std::fill(steer_joint_ang_rad_.begin(), steer_joint_ang_rad_.end(), 0.0);
+      std::fill(steer_joint_vel_rads_.begin(), steer_joint_vel_rads_.end(), 0.0);
+
+      // associate inputs to according steer and drive joints (only searched if the name list changed)
+      const std::vector<int> & slots = joint_name_map_.resolve(msg->joint_names, &resolved);
+      if (resolved)
       {
-        // associate inputs to according steer and drive joints
-        // ToDo: specify this globally (Prms-File or config-File or via msg-def.)
-        if(msg->joint_names[i] ==  "fl_caster_r_wheel_joint")
-        {
-          drive_joint_ang_rad[0] = msg->actual.positions[i];
-          drive_joint_vel_rads[0] = msg->actual.velocities[i];
-          //drive_joint_effort_NM[0] = msg->effort[i];
-        }
-        if(msg->joint_names[i] ==  "bl_caster_r_wheel_joint")
-        {
-          drive_joint_ang_rad[1] = msg->actual.positions[i];
-          drive_joint_vel_rads[1] = msg->actual.velocities[i];
-          //drive_joint_effort_NM[1] = msg->effort[i];
-        }
-        if(msg->joint_names[i] ==  "br_caster_r_wheel_joint")
+        for(unsigned int i = 0; i < slots.size(); i++)
         {
-          drive_joint_ang_rad[2] = msg->actual.positions[i];
-          drive_joint_vel_rads[2] = msg->actual.velocities[i];
-          //drive_joint_effort_NM[2] = msg->effort[i];
+          if (slots[i] < 0)
+            ROS_WARN("Unknown joint name %s", msg->joint_names[i].c_str());
         }
-        if(msg->joint_names[i] ==  "fr_caster_r_wheel_joint")
-        {
-          drive_joint_ang_rad[3] = msg->actual.positions[i];
-          drive_joint_vel_rads[3] = msg->actual.velocities[i];
-          //drive_joint_effort_NM[3] = msg->effort[i];
-        }
-        if(msg->joint_names[i] ==  "fl_caster_rotation_joint")
-        {
-          steer_joint_ang_rad[0] = msg->actual.positions[i];
-          steer_joint_vel_rads[0] = msg->actual.velocities[i];
-          //steer_joint_effort_NM[0] = msg->effort[i];
-        }
-        if(msg->joint_names[i] ==  "bl_caster_rotation_joint")
-        {
-          steer_joint_ang_rad[1] = msg->actual.positions[i];
-          steer_joint_vel_rads[1] = msg->actual.velocities[i];
-          //steer_joint_effort_NM[1] = msg->effort[i];
-        }
-        if(msg->joint_names[i] ==  "br_caster_rotation_joint")
+      }
+
+      for(unsigned int i = 0; i < slots.size(); i++)
+      {
+        slot = slots[i];
+        wheel = slot / 2;
+        if ((slot < 0) || (wheel >= num_wheels_))
+          continue;
+
+        if (slot % 2 == 0)
         {
-          steer_joint_ang_rad[2] = msg->actual.positions[i];
-          steer_joint_vel_rads[2] = msg->actual.velocities[i];
-          //steer_joint_effort_NM[2] = msg->effort[i];
+          drive_joint_ang_rad_[wheel] = msg->actual.positions[i];
+          drive_joint_vel_rads_[wheel] = msg->actual.velocities[i];
         }
-        if(msg->joint_names[i] ==  "fr_caster_rotation_joint")
+        else
         {
-          steer_joint_ang_rad[3] = msg->actual.positions[i];
-          steer_joint_vel_rads[3] = msg->actual.velocities[i];
-          //steer_joint_effort_NM[3] = msg->effort[i];
+          steer_joint_ang_rad_[wheel] = msg->actual.positions[i];
+          steer_joint_vel_rads_[wheel] = msg->actual.velocities[i];
         }
       }
 
       // Set measured Wheel Velocities and Angles to Controler Class (implements inverse kinematic)
-      ucar_ctrl_->SetActualWheelValues(drive_joint_vel_rads, steer_joint_vel_rads,
-          drive_joint_ang_rad, steer_joint_ang_rad);
+      ucar_ctrl_->SetActualWheelValues(drive_joint_vel_rads_, steer_joint_vel_rads_,
+          drive_joint_ang_rad_, steer_joint_ang_rad_);
 
 
       // calculate odometry every time
@@ -465,7 +484,15 @@ class NodeClass
     }
 
     void timerCallbackCtrlStep(const ros::TimerEvent& e) {
+      if (cycle_stats_.isEnabled())
+        cycle_stats_.record(stage_timer_latency_, (e.current_real - e.current_expected).toNSec());
+
+      cycle_stats_.begin(stage_ctrl_step_);
       CalcCtrlStep();
+      cycle_stats_.end(stage_ctrl_step_);
+
+      // diagnostics are published with the period of the updater
+      updater_.update();
     }
 
     // other function declarations
@@ -518,9 +545,7 @@ int main(int argc, char** argv)
 void NodeClass::CalcCtrlStep()
 {
   double vx_cmd_ms, vy_cmd_ms, w_cmd_rads, dummy;
-  std::vector<double> drive_jointvel_cmds_rads, steer_jointvel_cmds_rads, steer_jointang_cmds_rad;
-  control_msgs::JointTrajectoryControllerState joint_state_cmd;
-  int j, k;
+  int wheel;
   iwatchdog_ += 1;
 
   // if controller is initialized and underlying hardware is operating normal
@@ -533,73 +558,50 @@ void NodeClass::CalcCtrlStep()
     // perform one control step,
     // get the resulting cmd's for the wheel velocities and -angles from the controller class
     // and output the achievable pltf velocity-cmds (if velocity limits where exceeded)
-    ucar_ctrl_->GetNewCtrlStateSteerDriveSetValues(drive_jointvel_cmds_rads,  steer_jointvel_cmds_rads, steer_jointang_cmds_rad, vx_cmd_ms, vy_cmd_ms, w_cmd_rads, dummy);
+    ucar_ctrl_->GetNewCtrlStateSteerDriveSetValues(drive_jointvel_cmds_rads_,  steer_jointvel_cmds_rads_, steer_jointang_cmds_rad_, vx_cmd_ms, vy_cmd_ms, w_cmd_rads, dummy);
     // ToDo: adapt interface of controller class --> remove last values (not used anymore)
 
     // if drives not operating nominal -> force commands to zero
     if(drive_chain_diagnostic_ != diagnostic_status_lookup_.OK)
     {
-      steer_jointang_cmds_rad.assign(m_iNumJoints, 0.0);
-      steer_jointvel_cmds_rads.assign(m_iNumJoints, 0.0);
+      std::fill(steer_jointang_cmds_rad_.begin(), steer_jointang_cmds_rad_.end(), 0.0);
+      std::fill(steer_jointvel_cmds_rads_.begin(), steer_jointvel_cmds_rads_.end(), 0.0);
     }
 
     // convert variables to SI-Units
     vx_cmd_ms = vx_cmd_ms/1000.0;
     vy_cmd_ms = vy_cmd_ms/1000.0;
 
-    // compose jointcmds
-    // compose header
-    joint_state_cmd.header.stamp = ros::Time::now();
-    //joint_state_cmd.header.frame_id = frame_id; //Where to get this id from?
-    // ToDo: configure over Config-File (number of motors) and Msg
-    // assign right size to JointState data containers
-    //joint_state_cmd.set_name_size(m_iNumMotors);
-    joint_state_cmd.desired.positions.resize(m_iNumJoints);
-    joint_state_cmd.desired.velocities.resize(m_iNumJoints);
-    //joint_state_cmd.effort.resize(m_iNumJoints);
-    joint_state_cmd.joint_names.push_back("fl_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("fl_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("bl_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("bl_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("br_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("br_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("fr_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("fr_caster_rotation_joint");
-    joint_state_cmd.joint_names.resize(m_iNumJoints);
+    // compose jointcmds (names and size are set once in the constructor)
+    joint_state_cmd_.header.stamp = ros::Time::now();
 
     // compose data body
-    j = 0;
-    k = 0;
     for(int i = 0; i<m_iNumJoints; i++)
     {
-      if(iwatchdog_ < (int) std::floor(timeout_/sample_time_) )
+      wheel = i / 2;
+      if(iwatchdog_ < (int) std::floor(timeout_/sample_time_) && wheel < num_wheels_)
       {
         // for steering motors
-        if( i == 1 || i == 3 || i == 5 || i == 7) // ToDo: specify this via the Msg
+        if(i % 2 == 1)
         {
-          joint_state_cmd.desired.positions[i] = steer_jointang_cmds_rad[j];
-          joint_state_cmd.desired.velocities[i] = steer_jointvel_cmds_rads[j];
-          //joint_state_cmd.effort[i] = 0.0;
-          j = j + 1;
+          joint_state_cmd_.desired.positions[i] = steer_jointang_cmds_rad_[wheel];
+          joint_state_cmd_.desired.velocities[i] = steer_jointvel_cmds_rads_[wheel];
         }
         else
         {
-          joint_state_cmd.desired.positions[i] = 0.0;
-          joint_state_cmd.desired.velocities[i] = drive_jointvel_cmds_rads[k];
-          //joint_state_cmd.effort[i] = 0.0;
-          k = k + 1;
+          joint_state_cmd_.desired.positions[i] = 0.0;
+          joint_state_cmd_.desired.velocities[i] = drive_jointvel_cmds_rads_[wheel];
         }
       }
       else
       {
-        joint_state_cmd.desired.positions[i] = 0.0;
-        joint_state_cmd.desired.velocities[i] = 0.0;
-        //joint_state_cmd.effort[i] = 0.0;
+        joint_state_cmd_.desired.positions[i] = 0.0;
+        joint_state_cmd_.desired.velocities[i] = 0.0;
       }
     }
 
     // publish jointcmds
-    topic_pub_controller_joint_command_.publish(joint_state_cmd);
+    topic_pub_controller_joint_command_.publish(joint_state_cmd_);
   }
 
 }
@@ -608,10 +610,11 @@ void NodeClass::CalcCtrlStep()
 // and publishes it via an odometry topic and the tf broadcaster
 void NodeClass::UpdateOdometry()
 {
-  double vel_x_rob_ms, vel_y_rob_ms, vel_rob_ms, rot_rob_rads, delta_x_rob_m, delta_y_rob_m, delta_theta_rob_rad;
+  double vel_x_rob_ms, vel_y_rob_ms, rot_rob_rads, delta_x_rob_m, delta_y_rob_m, delta_theta_rob_rad;
   double dummy1, dummy2;
-  double dt;
-  ros::Time current_time;
+  double vel_cov[9], pose_cov[9];
+  double x_rob_m, y_rob_m, theta_rob_rad;
+  ros::Time stamp;
 
   // if drive chain already initialized process joint data
   //if (drive_chain_diagnostic_ != diagnostic_status_lookup_.OK)
@@ -623,12 +626,19 @@ void NodeClass::UpdateOdometry()
     // ToDo: last values are not used anymore --> remove from interface
     ucar_ctrl_->GetActualPltfVelocity(delta_x_rob_m, delta_y_rob_m, delta_theta_rob_rad, dummy1,
         vel_x_rob_ms, vel_y_rob_ms, rot_rob_rads, dummy2);
+    ucar_ctrl_->GetActualPltfVelocityCov(vel_cov);
 
     // convert variables to SI-Units
     vel_x_rob_ms = vel_x_rob_ms/1000.0;
     vel_y_rob_ms = vel_y_rob_ms/1000.0;
     delta_x_rob_m = delta_x_rob_m/1000.0;
     delta_y_rob_m = delta_y_rob_m/1000.0;
+    for(int r = 0; r < 3; r++)
+      for(int c = 0; c < 3; c++)
+      {
+        if (r < 2) vel_cov[3*r+c] /= 1000.0;
+        if (c < 2) vel_cov[3*r+c] /= 1000.0;
+      }
 
     ROS_DEBUG("Odmonetry delta is: x=%f, y=%f, th=%f", delta_x_rob_m, delta_y_rob_m, rot_rob_rads);
   }
@@ -637,43 +647,42 @@ void NodeClass::UpdateOdometry()
     // otherwise set data (velocity and pose-delta) to zero
     vel_x_rob_ms = 0.0;
     vel_y_rob_ms = 0.0;
+    rot_rob_rads = 0.0;
     delta_x_rob_m = 0.0;
     delta_y_rob_m = 0.0;
+    for(int i = 0; i < 9; i++)
+      vel_cov[i] = 0.0;
   }
 
   // calc odometry (from startup)
-  // get time since last odometry-measurement
-  current_time = ros::Time::now();
-  dt = current_time.toSec() - last_time_.toSec();
-  last_time_ = current_time;
-  vel_rob_ms = sqrt(vel_x_rob_ms*vel_x_rob_ms + vel_y_rob_ms*vel_y_rob_ms);
-
-  // calculation from ROS odom publisher tutorial http://www.ros.org/wiki/navigation/Tutorials/RobotSetup/Odom, using now midpoint integration
-  x_rob_m_ = x_rob_m_ + ((vel_x_rob_ms+vel_x_rob_last_)/2.0 * cos(theta_rob_rad_) - (vel_y_rob_ms+vel_y_rob_last_)/2.0 * sin(theta_rob_rad_)) * dt;
-  y_rob_m_ = y_rob_m_ + ((vel_x_rob_ms+vel_x_rob_last_)/2.0 * sin(theta_rob_rad_) + (vel_y_rob_ms+vel_y_rob_last_)/2.0 * cos(theta_rob_rad_)) * dt;
-  theta_rob_rad_ = theta_rob_rad_ + rot_rob_rads * dt;
-  //theta_rob_rad_ = theta_rob_rad_ + (rot_rob_rads+vel_theta_rob_last_)/2.0 * dt;
-
-  vel_x_rob_last_ = vel_x_rob_ms;
-  vel_y_rob_last_ = vel_y_rob_ms;
-  vel_theta_rob_last_ = rot_rob_rads;
+  // integrate on the time stamp of the joint states, so the scheduling of this callback does not enter the result
+  stamp = joint_state_odom_stamp_;
+  if (stamp.isZero())
+    stamp = ros::Time::now();
+  if (!odometry_.update(stamp.toSec(), vel_x_rob_ms, vel_y_rob_ms, rot_rob_rads, vel_cov))
+  {
+    ROS_DEBUG("Joint state stamp not newer than last one, odometry not integrated");
+  }
+  odometry_.getPose(x_rob_m, y_rob_m, theta_rob_rad);
+  odometry_.getPoseCov(pose_cov);
+  last_time_ = stamp;
 
 
   // format data for compatibility with tf-package and standard odometry msg
   // generate quaternion for rotation
-  geometry_msgs::Quaternion odom_quat = tf::createQuaternionMsgFromYaw(theta_rob_rad_);
+  geometry_msgs::Quaternion odom_quat = tf::createQuaternionMsgFromYaw(theta_rob_rad);
 
   if (broadcast_tf_ == true)
   {
     // compose and publish transform for tf package
     geometry_msgs::TransformStamped odom_tf;
     // compose header
-    odom_tf.header.stamp = joint_state_odom_stamp_;
+    odom_tf.header.stamp = stamp;
     odom_tf.header.frame_id = "/odom_combined";
     odom_tf.child_frame_id = "/base_footprint";
     // compose data container
-    odom_tf.transform.translation.x = x_rob_m_;
-    odom_tf.transform.translation.y = y_rob_m_;
+    odom_tf.transform.translation.x = x_rob_m;
+    odom_tf.transform.translation.y = y_rob_m;
     odom_tf.transform.translation.z = 0.0;
     odom_tf.transform.rotation = odom_quat;
 
@@ -684,16 +693,14 @@ void NodeClass::UpdateOdometry()
   // compose and publish odometry message as topic
   nav_msgs::Odometry odom_top;
   // compose header
-  odom_top.header.stamp = joint_state_odom_stamp_;
+  odom_top.header.stamp = stamp;
   odom_top.header.frame_id = "/odom_combined";
   odom_top.child_frame_id = "/base_footprint";
   // compose pose of robot
-  odom_top.pose.pose.position.x = x_rob_m_;
-  odom_top.pose.pose.position.y = y_rob_m_;
+  odom_top.pose.pose.position.x = x_rob_m;
+  odom_top.pose.pose.position.y = y_rob_m;
   odom_top.pose.pose.position.z = 0.0;
   odom_top.pose.pose.orientation = odom_quat;
-  for(int i = 0; i < 6; i++)
-    odom_top.pose.covariance[i*6+i] = 0.1;
 
   // compose twist of robot
   odom_top.twist.twist.linear.x = vel_x_rob_ms;
@@ -702,8 +709,21 @@ void NodeClass::UpdateOdometry()
   odom_top.twist.twist.angular.x = 0.0;
   odom_top.twist.twist.angular.y = 0.0;
   odom_top.twist.twist.angular.z = rot_rob_rads;
+
+  // covariances: (x, y, yaw) are mapped to the indices (0, 1, 5) of the 6x6 matrices,
+  // the not estimated dofs (z, roll, pitch) keep a constant value
+  const int dof[3] = {0, 1, 5};
   for(int i = 0; i < 6; i++)
-    odom_top.twist.covariance[6*i+i] = 0.1;
+  {
+    odom_top.pose.covariance[i*6+i] = 0.1;
+    odom_top.twist.covariance[i*6+i] = 0.1;
+  }
+  for(int r = 0; r < 3; r++)
+    for(int c = 0; c < 3; c++)
+    {
+      odom_top.pose.covariance[dof[r]*6+dof[c]] = pose_cov[3*r+c];
+      odom_top.twist.covariance[dof[r]*6+dof[c]] = vel_cov[3*r+c];
+    }
 
   // publish odometry msg
   topic_pub_odometry_.publish(odom_top);
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CYCLESTATS_INCLUDEDEF_H
+#define CYCLESTATS_INCLUDEDEF_H
+
+#include <time.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+//-----------------------------------------------
+/**
+ * Timing statistics of the stages of a control loop.
+ *
+ * Every stage owns a histogram with logarithmic buckets (bucket 0: < 1us,
+ * bucket k: [2^(k-1), 2^k) us, the last bucket collects everything above),
+ * a sample and an overrun counter and the worst case. Durations are taken
+ * from CLOCK_MONOTONIC.
+ *
+ * Samples of one stage are recorded by one thread (the control loop), other
+ * threads may read snapshots or request a reset at any time. No locks are
+ * taken: counters are updated by atomic operations and a reset is executed
+ * by the recording thread on its next sample.
+ *
+ * If disabled, begin(), end() and tick() return after testing one flag.
+ */
+class CycleStats
+{
+public:
+	enum
+	{
+		MAX_STAGES = 8,
+		NUM_BUCKETS = 20
+	};
+
+	/// Copy of the statistics of one stage.
+	struct StageSnapshot
+	{
+		std::string sName;
+		double dBudgetS;
+		unsigned long ulCount;
+		unsigned long ulOverruns;
+		double dLastS;
+		double dMeanS;
+		double dWorstS;
+		unsigned long ulBuckets[NUM_BUCKETS];
+	};
+
+	/**
+	 * Measures the duration of the enclosing scope as stage iStage.
+	 */
+	class Scope
+	{
+	public:
+		Scope(CycleStats& stats, int iStage) : m_Stats(stats), m_iStage(iStage) { m_Stats.begin(m_iStage); }
+		~Scope() { m_Stats.end(m_iStage); }
+	private:
+		CycleStats& m_Stats;
+		int m_iStage;
+	};
+
+	CycleStats();
+
+	/// Enables or disables recording (disabled by default).
+	void setEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+
+	bool isEnabled() const { return m_bEnabled; }
+
+	/**
+	 * Adds a stage. Stages have to be added before the first sample is recorded.
+	 * @param sName name of the stage used in diagnostics and dumps
+	 * @param dBudgetS samples longer than the budget are counted as overrun, 0 for no budget
+	 * @return index of the stage, -1 if there are already MAX_STAGES stages
+	 */
+	int addStage(const std::string& sName, double dBudgetS);
+
+	int getNumStages() const { return m_iNumStages; }
+
+	/// Marks the start of stage iStage.
+	void begin(int iStage)
+	{
+		if(!m_bEnabled)
+			return;
+		m_Stage[iStage].llStartNS = nowNS();
+	}
+
+	/// Marks the end of stage iStage and records the time since begin().
+	void end(int iStage)
+	{
+		if(!m_bEnabled)
+			return;
+		record(iStage, nowNS() - m_Stage[iStage].llStartNS);
+	}
+
+	/**
+	 * Records the time since the last tick of stage iStage,
+	 * used to measure the period (and hence the jitter) of a loop.
+	 */
+	void tick(int iStage)
+	{
+		if(!m_bEnabled)
+			return;
+		long long llNowNS = nowNS();
+		if(m_Stage[iStage].llStartNS > 0)
+			record(iStage, llNowNS - m_Stage[iStage].llStartNS);
+		m_Stage[iStage].llStartNS = llNowNS;
+	}
+
+	/// Records a sample of stage iStage.
+	void record(int iStage, long long llDurationNS);
+
+	/// Resets the statistics of all stages (executed with the next sample of every stage).
+	void requestReset();
+
+	/// Returns a copy of the statistics of stage iStage.
+	void getSnapshot(int iStage, StageSnapshot& snapshot) const;
+
+	/// Returns the statistics of all stages as human readable table.
+	std::string dump() const;
+
+	/**
+	 * Returns the answer of a dump service: dump() if recording is enabled,
+	 * otherwise a hint to the parameter cycle_stats.
+	 * @return true if recording is enabled
+	 */
+	bool dumpMessage(std::string& sMessage) const;
+
+	/**
+	 * Returns one entry per stage for diagnostics: the stage name and
+	 * "mean ..us, worst ..us, overruns .. of ..".
+	 */
+	void toKeyValues(std::vector<std::pair<std::string, std::string> >& keyValues) const;
+
+	/**
+	 * Returns the summary for diagnostics: "<loop> overruns occurred" or "<loop> within budget".
+	 * @param sLoopName name of the loop, e.g. "control loop"
+	 * @param bOverruns set if any stage had an overrun
+	 */
+	std::string summary(const std::string& sLoopName, bool& bOverruns) const;
+
+	/**
+	 * Fills level, message and values of a diagnostic_msgs::DiagnosticStatus
+	 * from summary() and toKeyValues(). The name is left to the caller.
+	 */
+	template <class DiagnosticStatus>
+	void fillDiagnosticStatus(const std::string& sLoopName, DiagnosticStatus& status) const
+	{
+		std::vector<std::pair<std::string, std::string> > keyValues;
+		typename DiagnosticStatus::_values_type::value_type kv;
+		bool bOverruns;
+
+		status.message = summary(sLoopName, bOverruns);
+		status.level = bOverruns ? DiagnosticStatus::WARN : DiagnosticStatus::OK;
+
+		toKeyValues(keyValues);
+		status.values.clear();
+		for(size_t i = 0; i < keyValues.size(); i++)
+		{
+			kv.key = keyValues[i].first;
+			kv.value = keyValues[i].second;
+			status.values.push_back(kv);
+		}
+	}
+
+	/// Returns the current time of CLOCK_MONOTONIC in nanoseconds.
+	static long long nowNS()
+	{
+		::timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+	}
+
+	/// Returns the upper limit of bucket iBucket in seconds (lower limit of the next bucket).
+	static double getBucketLimitS(int iBucket);
+
+private:
+	struct Stage
+	{
+		std::string sName;
+		long long llBudgetNS;
+		long long llStartNS;
+		long long llLastNS;
+		long long llSumNS;
+		long long llWorstNS;
+		unsigned long ulCount;
+		unsigned long ulOverruns;
+		unsigned long ulBuckets[NUM_BUCKETS];
+		int iResetRequest;
+	};
+
+	void resetStage(Stage& stage);
+
+	volatile bool m_bEnabled;
+	int m_iNumStages;
+	Stage m_Stage[MAX_STAGES];
+};
+
+#endif
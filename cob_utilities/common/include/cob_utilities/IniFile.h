@@ -22,6 +22,9 @@
 #include <vector>
 #include <string>
 #include <stdio.h>
+#include <time.h>
+
+#include <boost/unordered_map.hpp>
 
 //-------------------------------------------------------------------
 
@@ -30,8 +33,9 @@
  * Used to store persistend program configuration in INI-Files.
  * The INI-File is organized into sections and Keys (variables) like
  * ordinary Windows INI-Files.
- * The write functions create a temporary file in the root directory.
- * If there is no write permission in this directory, they don't work.
+ * The file is read once and indexed (section -> key -> value), the read functions
+ * are served from memory. The file is read again if its modification time or size changes.
+ * The write functions change the file in memory only, Flush() or the destructor write it.
  * @par sections:
  * identifcator between '[' and ']', a section headline must not have blanks
  * at the beginning neither right after or before the '[ ]'.
@@ -72,6 +76,11 @@ public:
 	 * @param fileName file name.
 	 */
 	IniFile(std::string fileName);
+
+	/**
+	 * Destructor.
+	 * Writes changes, which were not flushed yet.
+	 */
 	~IniFile();
 
 	/**
@@ -85,6 +94,12 @@ public:
 	 */
 	int SetFileName(std::string fileName, std::string strIniFileUsedBy = "", bool bCreate = false);
 
+	/**
+	 * Writes the changes of the write functions to the file.
+	 * @return 0 if the file was written or there were no changes
+	 */
+	int Flush();
+
 
 	/**
 	 * Write character string to INI-File.
@@ -236,9 +251,47 @@ public:
 
 private:
 
-	int FindSection(const char* sect, bool bWarnIfNotfound = true);
-	int FindKey(const char* skey,	bool bWarnIfNotfound = true);
-	int FindNextLine(std::vector<char>& NewLine, int& CharInd);
+	/// Position of a key in the file text.
+	struct KeyEntry
+	{
+		std::string::size_type ValueBegin;	// first char after the '='
+		std::string::size_type LineEnd;		// the '\n' or the end of the text
+	};
+
+	typedef boost::unordered_map<std::string, KeyEntry> KeyMap;
+
+	struct Section
+	{
+		KeyMap Keys;
+		std::string::size_type InsertPos;	// behind the last key line, new keys go here
+	};
+
+	typedef boost::unordered_map<std::string, Section> SectionMap;
+
+	/**
+	 * Reads the file (mmap) and indexes it.
+	 * @return 0 on success, -1 if the file can not be read
+	 */
+	int Load();
+
+	/**
+	 * Reads the file again, if it changed since Load().
+	 * Unflushed changes keep the text in memory.
+	 */
+	int Refresh();
+
+	/**
+	 * Builds the index of m_Text in one pass.
+	 * Sections start with '[' in the first column, the first occurence of
+	 * a section and of a key within a section is used.
+	 */
+	void Parse();
+
+	/**
+	 * Looks up a key, reads the file again if it changed.
+	 * @return the position of the key, NULL if the section or the key is not found
+	 */
+	const KeyEntry* FindKey(const char* pSect, const char* pKey, bool bWarnIfNotfound);
 
 	/**
 	 * Write character string to INI-File.
@@ -264,41 +317,22 @@ private:
 	int GetKeyValue(const char* pSect,const char* pKey, char* pBuf, int lenBuf,
 							bool bWarnIfNotfound = true);
 
-	/**
-	 * Skips chars in line until Endchar.
-	 * return:	- Nr of chars skipped if successful
-	 * 			- RF_E if end of line (\n) or end of file before Endchar is found
-	 */
-	int SkipLineUntil(FILE* pFile, const char EndChar);
-
-	/**
-	 * Reads chars in line until Endchar into string.
-	 * return:	- Nr of chars read if successful
-	 * 			- RF_E if end of line (\n) or end of file before Endchar is found.
-	 * In this case, the string will contain the chars read so far.
-	 */
-	int ReadLineUntil(FILE* pFile, const char EndChar, std::string& ReadIntoStr);
-
 	bool m_bFileOK;
 
-	/**
-	 * Vector to store the chars of the most recently read line.
-	 */
-	std::vector<char> m_CurLine;
-
-	/**
-	 * Size of the vector CurLine.
-	 */
-	const int m_vectorSize;
+	/// Content of the file including the changes of the write functions.
+	std::string m_Text;
+	SectionMap m_Sections;
+	/// All section names in file order, for FindNextSection().
+	std::vector<std::string> m_SectionOrder;
 
-	/**
-	 * Index of the current character in the current line.
-	 */
-    int m_CurCharInd;
+	/// Modification time and size of the file when it was loaded.
+	timespec m_FileTime;
+	long long m_FileSize;
+	/// The text has changes, which were not written yet.
+	bool m_bDirty;
 
 	std::string m_fileName;
 	std::string m_strIniFileUsedBy;	//used for debug to inidcate user class of ini-file
-	FILE* f;
 };
 
 #endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+
+#ifndef JOINTNAMEMAP_INCLUDEDEF_H
+#define JOINTNAMEMAP_INCLUDEDEF_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Number of joints of the base, a drive and a steer joint for each of the four wheels.
+static const int c_iNumDefaultBaseJoints = 8;
+
+/// Default joint names of the base in the order of the motors of the base drive chain.
+static const char* const c_cDefaultBaseJointNames[c_iNumDefaultBaseJoints] = {
+	"fl_caster_r_wheel_joint", "fl_caster_rotation_joint",
+	"bl_caster_r_wheel_joint", "bl_caster_rotation_joint",
+	"br_caster_r_wheel_joint", "br_caster_rotation_joint",
+	"fr_caster_r_wheel_joint", "fr_caster_rotation_joint"};
+
+//-----------------------------------------------
+/**
+ * Maps the joint names of incoming messages to fixed slots (e.g. motor indices).
+ * The association is resolved once and reused as long as the messages carry
+ * the same name list, so the per message cost is one string compare per joint
+ * instead of a search over all configured names.
+ */
+class JointNameMap
+{
+public:
+	JointNameMap() {}
+
+	/**
+	 * Sets the configured joint names, the index in the vector is the slot.
+	 */
+	void setNames(const std::vector<std::string>& vsNames)
+	{
+		m_vsNames = vsNames;
+		m_vsMsgNames.clear();
+		m_viSlots.clear();
+	}
+
+	/// Returns the configured joint names.
+	const std::vector<std::string>& getNames() const
+	{
+		return m_vsNames;
+	}
+
+	/// Returns the number of slots.
+	int getNumSlots() const
+	{
+		return (int)m_vsNames.size();
+	}
+
+	/**
+	 * Returns the slot of every entry of the given name list, -1 for unknown names.
+	 * The mapping is only recalculated if the name list differs from the previous call.
+	 * @param vsMsgNames joint names of the message
+	 * @param pbResolved is set to true if the mapping had to be (re-)calculated
+	 */
+	const std::vector<int>& resolve(const std::vector<std::string>& vsMsgNames, bool* pbResolved = NULL)
+	{
+		bool bChanged = (vsMsgNames.size() != m_vsMsgNames.size());
+
+		for(unsigned int i = 0; !bChanged && (i < vsMsgNames.size()); i++)
+		{
+			if(vsMsgNames[i] != m_vsMsgNames[i])
+				bChanged = true;
+		}
+
+		if(bChanged)
+		{
+			m_vsMsgNames = vsMsgNames;
+			m_viSlots.assign(vsMsgNames.size(), -1);
+
+			for(unsigned int i = 0; i < vsMsgNames.size(); i++)
+			{
+				for(unsigned int j = 0; j < m_vsNames.size(); j++)
+				{
+					if(vsMsgNames[i] == m_vsNames[j])
+					{
+						m_viSlots[i] = j;
+						break;
+					}
+				}
+			}
+		}
+
+		if(pbResolved != NULL)
+			*pbResolved = bChanged;
+
+		return m_viSlots;
+	}
+
+private:
+	std::vector<std::string> m_vsNames;
+	std::vector<std::string> m_vsMsgNames;
+	std::vector<int> m_viSlots;
+};
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SerialIO_H
+#define _SerialIO_H
+
+#include <stdint.h>
+#include <termios.h>
+#include <sys/select.h>
+
+#include <string>
+#include <vector>
+
+#include <cob_utilities/Mutex.h>
+
+/**
+ * Wrapper class for serial communication.
+ * Used by the drivers of the relayboard, the Sick S300 scanners and the lights.
+ */
+class SerialIO
+{
+public:
+	// ---------------------- Constants
+	/// Constants for defining the handshake.
+	enum HandshakeFlags
+	{
+		HS_NONE,
+		HS_HARDWARE,
+		HS_XONXOFF
+	};
+
+	/// Constants for defining the parity bits.
+	enum ParityFlags
+	{
+		PA_NONE,
+		PA_EVEN,
+		PA_ODD,
+// UNIX serial drivers only support even, odd, and no parity bit generation.
+ 		PA_MARK,
+		PA_SPACE
+	};
+
+	/// Constants for defining the stop bits.
+	enum StopBits
+	{
+		SB_ONE,
+		SB_ONE_5, // ????? returns an error ?????
+		SB_TWO
+	};
+
+	/// Default constructor
+	SerialIO();
+
+	/// Destructor
+	virtual ~SerialIO();
+
+	/**
+	 * Sets the device name
+	 * @param Name '/dev/ttyUSB0', ...
+	 */
+	void setDeviceName(const char *Name) { m_DeviceName = Name; }
+
+	/**
+	 * Sets the baudrate.
+	 * Baudrates without termios code are set exactly (BOTHER).
+	 * @param BaudRate baudrate.
+	 */
+	void setBaudRate(int BaudRate) { m_BaudRate = BaudRate; }
+
+	/**
+	 * Changes the baudrate.
+	 * The serial port is allready open.
+	 * @param BaudRate new baudrate.
+	 */
+	void changeBaudRate(int BaudRate);
+
+	/**
+	 * Sets a multiplier for the baudrate.
+	 * Some serial cards need a specific multiplier for the baudrate.
+	 * @param Multiplier default is one.
+	 */
+	void setMultiplier(double Multiplier = 1) { m_Multiplier = Multiplier; };
+
+	/**
+	 * Sets the message format.
+	 */
+	void SetFormat(int ByteSize, ParityFlags Parity, int StopBits)
+		{ m_ByteSize = ByteSize; m_Parity = Parity; m_StopBits = StopBits; }
+
+	/**
+	 * Defines the handshake type.
+	 */
+	void setHandshake(HandshakeFlags Handshake) { m_Handshake = Handshake; }
+
+	/**
+	 * Sets the buffer sizes.
+	 * The read buffer size is the capacity of the receive buffer of readBuffered().
+	 * @param ReadBufSize number of bytes of the read buffer.
+	 * @param WriteBufSize number of bytes of the write buffer.
+	 */
+	void setBufferSize(int ReadBufSize, int WriteBufSize)
+		{ m_ReadBufSize = ReadBufSize; m_WriteBufSize = WriteBufSize; }
+
+	/**
+	 * Opens the device with O_NONBLOCK, reads return immediately.
+	 * Has to be set before openIO(), default is blocking.
+	 */
+	void setNonBlocking(bool NonBlocking) { m_NonBlocking = NonBlocking; }
+
+	/**
+	 * Sets the timeout (VTIME).
+	 * A blocking read returns after this time without a received byte.
+	 * @param Timeout in seconds, rounded up to tenths
+	 */
+	void setTimeout(double Timeout);
+
+	/**
+	 * Sets the number of bytes a blocking read waits for (VMIN).
+	 * @param MinBytes default is 1.
+	 */
+	void setMinBytes(int MinBytes);
+
+	/**
+	 * Requests low latency from the UART driver (ASYNC_LOW_LATENCY).
+	 * Received bytes are passed on immediately instead of after the driver's latency timer.
+	 * Has to be set before openIO(), devices without support ignore it.
+	 */
+	void setLowLatency(bool LowLatency) { m_LowLatency = LowLatency; }
+
+	/**
+	 * Sets the byte period for transmitting bytes.
+	 * If the period is not equal to 0, writeIO() paces the transmission: it writes
+	 * chunks of setPacingChunk() bytes, waits for them to be sent (tcdrain) and sleeps
+	 * until the average period is reached.
+	 * @param Period in seconds, default is 0.
+	 */
+	void setBytePeriod(double Period);
+
+	/**
+	 * Sets the number of bytes written at once by a paced writeIO().
+	 * @param ChunkSize 1 sends every byte on its own.
+	 */
+	void setPacingChunk(int ChunkSize) { m_PacingChunk = ChunkSize < 1 ? 1 : ChunkSize; }
+
+	/**
+	 * Opens serial port.
+	 * The port has to be configured before.
+	 */
+	int openIO();
+
+	/**
+	 * Closes the serial port.
+	 */
+	void closeIO();
+
+	/// Returns true, if the port is open.
+	bool isOpen() const { return m_Device != -1; }
+
+	/**
+	 * Returns the file descriptor of the port, -1 if closed.
+	 * E.g. to wait on several devices in one select() or epoll.
+	 */
+	int getFileDescriptor() const { return m_Device; }
+
+	/**
+	 * Adds the port to an epoll instance.
+	 * @param EpollFd epoll instance
+	 * @param Events epoll events, e.g. EPOLLIN
+	 * @param Data returned in epoll_event::data.ptr
+	 * @return 0 on success, -1 on errors
+	 */
+	int addToEpoll(int EpollFd, uint32_t Events, void *Data);
+
+	/**
+	 * Removes the port from an epoll instance.
+	 */
+	int removeFromEpoll(int EpollFd);
+
+	/**
+	 * Reads the serial port blocking.
+	 * The function blocks until the requested number of bytes have been
+	 * read or the timeout occurs.
+	 * @param Buffer pointer to the buffer.
+	 * @param Length number of bytes to read
+	 */
+	int readBlocking(char *Buffer, int Length);
+
+
+	/**
+	 * Reads the serial port non blocking.
+	 * The function returns all avaiable bytes but not more than requested.
+	 * @param Buffer pointer to the buffer.
+	 * @param Length number of bytes to read
+	 */
+	int readNonBlocking(char *Buffer, int Length);
+
+	/**
+	 * Reads through a receive buffer of setBufferSize() bytes.
+	 * Bytes missing in the buffer are read with one system call, which fetches
+	 * everything available (up to the buffer size), so small reads mostly do not
+	 * enter the kernel. Blocks like readBlocking(), if the port is blocking.
+	 * Must not be mixed with the other read functions.
+	 * @param Buffer pointer to the buffer.
+	 * @param Length maximum number of bytes to read
+	 * @return number of bytes read, -1 on errors
+	 */
+	int readBuffered(char *Buffer, int Length);
+
+	/**
+	 * Like readNonBlocking(), additionally estimates the receive time of the first byte.
+	 * The estimate is the time of the read minus the transmission time of the bytes,
+	 * which were already waiting in the kernel queue.
+	 * @param Stamp receive time of the first byte in seconds (CLOCK_MONOTONIC)
+	 */
+	int readTimestamped(char *Buffer, int Length, double *Stamp);
+
+	/**
+	 * Writes bytes to the serial port.
+	 * Partial writes of a non blocking port are continued until the timeout.
+	 * @param Buffer buffer of the message
+	 * @param Length number of bytes to send
+	 * @return number of bytes written
+	 */
+	int writeIO(const char *Buffer, int Length);
+
+	/**
+	 * Returns the number of bytes available in the read buffer.
+	 */
+	int getSizeRXQueue();
+
+	/**
+	 * Waits until bytes are available in the read buffer.
+	 * @param Timeout in seconds
+	 * @return >0 if bytes are available, 0 on timeout, -1 on errors
+	 */
+	int waitForData(double Timeout);
+
+	/**
+	 * Returns the transmission time of one byte in seconds.
+	 */
+	double getByteTime() const;
+
+	// ---------------------- Thread safe message interface
+	/**
+	 * Opens the port with the given device and baudrate, if it is not open yet.
+	 * @return file descriptor, -1 on errors
+	 */
+	int openPort(const std::string& DeviceName, int BaudRate);
+
+	/// Closes the port.
+	void closePort() { closeIO(); }
+
+	/**
+	 * Writes a message, serialized with the other message functions.
+	 * @return number of bytes written, -1 if the port is closed
+	 */
+	int sendData(const std::string& Value);
+	int sendData(const char *Data, size_t Length);
+
+	/**
+	 * Reads up to Bytes bytes, waits at most 100 ms for the first one.
+	 * @return number of bytes read, -1 if nothing was received
+	 */
+	int readData(std::string& Value, size_t Bytes);
+
+	/**
+	 * Reopens the port and clears its buffers.
+	 */
+	bool recover();
+
+
+	/** Clears the read and transmit buffer.
+	 */
+	void purge()
+	{
+		::tcflush(m_Device, TCIOFLUSH);
+		m_RxHead = m_RxTail = 0;
+	}
+
+	/** Clears the read buffer.
+	 */
+	void purgeRx() {
+		tcflush(m_Device, TCIFLUSH);
+		m_RxHead = m_RxTail = 0;
+	}
+
+	/**
+	 * Clears the transmit buffer.
+	 * The content of the buffer will not be transmitted.
+	 */
+	void purgeTx() {
+		tcflush(m_Device, TCOFLUSH);
+	}
+
+	/**
+	 * Sends the transmit buffer.
+	 * All bytes of the transmit buffer will be sent.
+	 */
+	void flushTx() {
+		tcdrain(m_Device);
+	}
+
+protected:
+	/// Sets the baudrate of the open port, exactly if there is no termios code.
+	bool setDeviceBaudRate(int BaudRate);
+
+	/// Waits for the port to become writable.
+	bool waitForWrite(double Timeout);
+
+	::termios m_tio;
+	std::string m_DeviceName;
+	int m_Device;
+	int m_BaudRate;
+	double m_Multiplier;
+	int m_ByteSize, m_StopBits;
+	ParityFlags m_Parity;
+	HandshakeFlags m_Handshake;
+	int m_ReadBufSize, m_WriteBufSize;
+	double m_Timeout;
+	int m_MinBytes;
+	bool m_NonBlocking;
+	bool m_LowLatency;
+	double m_BytePeriod;
+	int m_PacingChunk;
+
+	// buffer of readBuffered(), m_RxTail == m_RxHead means empty
+	std::vector<char> m_RxBuffer;
+	int m_RxHead;	// next byte to read
+	int m_RxTail;	// next byte to fill
+
+	Mutex m_Mutex;	// serializes the message interface
+};
+
+
+#endif //
@@ -27,22 +27,49 @@
  * Use this class for measure system time accurately. Under Windows, it uses
  * QueryPerformanceCounter(), which has a resolution of approx. one micro-second.
  * The difference between two time stamps can be calculated.
+ *
+ * By default the wall clock (CLOCK_REALTIME) is used, which jumps if the system
+ * time is set (e.g. by NTP). Time stamps used for timeouts and rates should use
+ * a monotonic clock. Only time stamps of the same clock may be compared.
  */
 class TimeStamp
 {
 	public:
-		/// Constructor.
+		/// Clock the time stamp is taken from.
+		enum ClockType
+		{
+			CLOCK_TYPE_REALTIME,		///< wall clock, can jump
+			CLOCK_TYPE_MONOTONIC,		///< steady clock, never jumps
+			CLOCK_TYPE_MONOTONIC_COARSE	///< steady clock with the resolution of the kernel tick (1-4ms), cheaper to read
+		};
+
+		/// Constructor (wall clock).
 		TimeStamp();
 
+		/// Constructor for the given clock.
+		explicit TimeStamp(ClockType Clock);
+
 		/// Destructor.
 		virtual ~TimeStamp() {};
 
 		/// Makes time measurement.
 		void SetNow();
 
+		/// Selects the clock used by SetNow().
+		void SetClock(ClockType Clock);
+
+		/// Returns the clock used by SetNow().
+		ClockType GetClock() const { return m_Clock; }
+
 		/// Retrieves time difference in seconds.
 		double operator- ( const TimeStamp& EarlierTime ) const;
 
+		/// Retrieves time difference in nanoseconds (exact integer arithmetic).
+		long long NanoSecSince ( const TimeStamp& EarlierTime ) const;
+
+		/// Returns the time stamp in nanoseconds since the epoch of the clock.
+		long long GetNanoSec() const;
+
 		/// Increase the timestamp by TimeS seconds.
 		/** @param TimeS must be >0!.
 		 */
@@ -82,6 +109,10 @@ class TimeStamp
 		/// Internal time stamp data.
 		timespec m_TimeStamp;
 
+		/// Clock used by SetNow().
+		ClockType m_Clock;
+		::clockid_t m_ClockId;
+
 	private:
 
 		/// Conversion timespec -> double
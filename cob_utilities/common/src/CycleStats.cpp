@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <cob_utilities/CycleStats.h>
+
+//-----------------------------------------------------------------------------
+
+CycleStats::CycleStats()
+{
+	m_bEnabled = false;
+	m_iNumStages = 0;
+	for(int i = 0; i < MAX_STAGES; i++)
+	{
+		m_Stage[i].llBudgetNS = 0;
+		m_Stage[i].llStartNS = 0;
+		resetStage(m_Stage[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+int CycleStats::addStage(const std::string& sName, double dBudgetS)
+{
+	if(m_iNumStages >= MAX_STAGES)
+		return -1;
+
+	Stage& stage = m_Stage[m_iNumStages];
+	stage.sName = sName;
+	stage.llBudgetNS = (long long)(dBudgetS * 1e9);
+	stage.llStartNS = 0;
+	resetStage(stage);
+
+	return m_iNumStages++;
+}
+
+//-----------------------------------------------------------------------------
+void CycleStats::record(int iStage, long long llDurationNS)
+{
+	Stage& stage = m_Stage[iStage];
+	int iBucket;
+	long long llUS;
+
+	if(__sync_lock_test_and_set(&stage.iResetRequest, 0))
+		resetStage(stage);
+
+	if(llDurationNS < 0)
+		llDurationNS = 0;
+
+	// bucket k holds [2^(k-1), 2^k) us
+	iBucket = 0;
+	for(llUS = llDurationNS / 1000; (llUS > 0) && (iBucket < NUM_BUCKETS - 1); llUS >>= 1)
+		iBucket++;
+
+	__sync_fetch_and_add(&stage.ulBuckets[iBucket], 1UL);
+	__sync_fetch_and_add(&stage.llSumNS, llDurationNS);
+	if((stage.llBudgetNS > 0) && (llDurationNS > stage.llBudgetNS))
+		__sync_fetch_and_add(&stage.ulOverruns, 1UL);
+	if(llDurationNS > stage.llWorstNS)
+		__sync_lock_test_and_set(&stage.llWorstNS, llDurationNS);
+	__sync_lock_test_and_set(&stage.llLastNS, llDurationNS);
+	__sync_fetch_and_add(&stage.ulCount, 1UL);
+}
+
+//-----------------------------------------------------------------------------
+void CycleStats::requestReset()
+{
+	for(int i = 0; i < m_iNumStages; i++)
+		__sync_lock_test_and_set(&m_Stage[i].iResetRequest, 1);
+}
+
+//-----------------------------------------------------------------------------
+void CycleStats::getSnapshot(int iStage, StageSnapshot& snapshot) const
+{
+	const Stage& stage = m_Stage[iStage];
+	long long llSumNS;
+
+	// values are read one by one, a concurrent sample may be counted in some of them only
+	snapshot.sName = stage.sName;
+	snapshot.dBudgetS = stage.llBudgetNS / 1e9;
+	snapshot.ulCount = stage.ulCount;
+	snapshot.ulOverruns = stage.ulOverruns;
+	snapshot.dLastS = stage.llLastNS / 1e9;
+	snapshot.dWorstS = stage.llWorstNS / 1e9;
+	llSumNS = stage.llSumNS;
+	snapshot.dMeanS = (snapshot.ulCount > 0) ? (llSumNS / 1e9) / snapshot.ulCount : 0.0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+		snapshot.ulBuckets[i] = stage.ulBuckets[i];
+}
+
+//-----------------------------------------------------------------------------
+std::string CycleStats::dump() const
+{
+	StageSnapshot snapshot;
+	std::string sDump;
+	char cBuf[256];
+
+	for(int i = 0; i < m_iNumStages; i++)
+	{
+		getSnapshot(i, snapshot);
+		snprintf(cBuf, sizeof(cBuf), "%s: count %lu, mean %.1fus, last %.1fus, worst %.1fus, overruns %lu (budget %.1fus)\n",
+			snapshot.sName.c_str(), snapshot.ulCount, snapshot.dMeanS * 1e6, snapshot.dLastS * 1e6,
+			snapshot.dWorstS * 1e6, snapshot.ulOverruns, snapshot.dBudgetS * 1e6);
+		sDump += cBuf;
+
+		for(int j = 0; j < NUM_BUCKETS; j++)
+		{
+			if(snapshot.ulBuckets[j] == 0)
+				continue;
+			if(j < NUM_BUCKETS - 1)
+				snprintf(cBuf, sizeof(cBuf), "  < %9.0fus: %lu\n", getBucketLimitS(j) * 1e6, snapshot.ulBuckets[j]);
+			else
+				snprintf(cBuf, sizeof(cBuf), "  >=%9.0fus: %lu\n", getBucketLimitS(j - 1) * 1e6, snapshot.ulBuckets[j]);
+			sDump += cBuf;
+		}
+	}
+
+	return sDump;
+}
+
+//-----------------------------------------------------------------------------
+bool CycleStats::dumpMessage(std::string& sMessage) const
+{
+	if(!m_bEnabled)
+	{
+		sMessage = "Recording of timing statistics is disabled (parameter cycle_stats)";
+		return false;
+	}
+
+	sMessage = dump();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void CycleStats::toKeyValues(std::vector<std::pair<std::string, std::string> >& keyValues) const
+{
+	StageSnapshot snapshot;
+	char cBuf[128];
+
+	keyValues.clear();
+	for(int i = 0; i < m_iNumStages; i++)
+	{
+		getSnapshot(i, snapshot);
+		snprintf(cBuf, sizeof(cBuf), "mean %.1fus, worst %.1fus, overruns %lu of %lu",
+			snapshot.dMeanS * 1e6, snapshot.dWorstS * 1e6, snapshot.ulOverruns, snapshot.ulCount);
+		keyValues.push_back(std::make_pair(snapshot.sName, std::string(cBuf)));
+	}
+}
+
+//-----------------------------------------------------------------------------
+std::string CycleStats::summary(const std::string& sLoopName, bool& bOverruns) const
+{
+	StageSnapshot snapshot;
+
+	bOverruns = false;
+	for(int i = 0; i < m_iNumStages; i++)
+	{
+		getSnapshot(i, snapshot);
+		if(snapshot.ulOverruns > 0)
+			bOverruns = true;
+	}
+
+	return sLoopName + (bOverruns ? " overruns occurred" : " within budget");
+}
+
+//-----------------------------------------------------------------------------
+double CycleStats::getBucketLimitS(int iBucket)
+{
+	return (double)(1LL << iBucket) * 1e-6;
+}
+
+//-----------------------------------------------------------------------------
+void CycleStats::resetStage(Stage& stage)
+{
+	stage.llLastNS = 0;
+	stage.llSumNS = 0;
+	stage.llWorstNS = 0;
+	stage.ulCount = 0;
+	stage.ulOverruns = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+		stage.ulBuckets[i] = 0;
+	stage.iResetRequest = 0;
+}
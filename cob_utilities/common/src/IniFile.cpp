@@ -22,33 +22,47 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace std;
 
 //-------------------------------------------------------------------
-IniFile::IniFile(): m_vectorSize(500), m_CurCharInd(0)
+IniFile::IniFile(): m_FileSize(0), m_bDirty(false)
 {
 	m_bFileOK=false;
-	m_CurLine.resize(m_vectorSize);
+	m_FileTime.tv_sec = 0;
+	m_FileTime.tv_nsec = 0;
 }
 //--------------------------------------------------------------------------------
 
-IniFile::IniFile(std::string fileName): m_vectorSize(500), m_CurCharInd(0)
+IniFile::IniFile(std::string fileName): m_FileSize(0), m_bDirty(false)
 {
 	m_bFileOK=false;
-	m_CurLine.resize(m_vectorSize);
+	m_FileTime.tv_sec = 0;
+	m_FileTime.tv_nsec = 0;
 	if(fileName != "")
 		SetFileName(fileName);
 }
 //--------------------------------------------------------------------------------
 IniFile::~IniFile()
 {
+	Flush();
 }
 //--------------------------------------------------------------------------------
 int IniFile::SetFileName(std::string fileName, std::string strIniFileUsedBy, bool bCreate)
 {
+	// changes belong to the previous file
+	Flush();
+	m_bFileOK = false;
+	m_bDirty = false;
+
 	m_fileName = fileName;
 	m_strIniFileUsedBy = strIniFileUsedBy;
 
+	FILE* f;
 	if ((f = fopen(m_fileName.c_str(),"r")) == NULL)
 	{
 		if (bCreate == true)
@@ -64,108 +78,173 @@ int IniFile::SetFileName(std::string fileName, std::string strIniFileUsedBy, boo
 		}
 	}
 	else fclose(f);
+
+	if (Load() != 0)
+		return -1;
 	m_bFileOK = true;
 	return 0;
 }
 //--------------------------------------------------------------------------------
-int IniFile::WriteKeyString(const char* pSect, const char* pKey, const std::string* pStrToWrite, bool bWarnIfNotfound)
+int IniFile::Load()
 {
-	std::string StrWithDelimeters = '"' + *pStrToWrite + '"';
-	return WriteKeyValue(pSect, pKey, StrWithDelimeters.c_str(), bWarnIfNotfound);
-}
-//--------------------------------------------------------------------------------
-int IniFile::WriteKeyValue(const char* szSect,const char* szKey,const char* szValue, bool bWarnIfNotfound)
-{
-	if (!m_bFileOK) return -1;
-
-	FILE* ftemp;
-	int   lS,lK,i,bEoff;
-	int   bFoundSect,bFoundKey;
-	char  c;
-	long fpos;
-
-
-/*------------------------verifications*/
-
-	bFoundSect = 1 /* true*/;
-	bFoundKey = 0 /* */;
-	bEoff = 0;
-	lS = strlen(szSect);
-	lK = strlen(szKey);
-	if ((lS * lK) == 0) return -1;
-
-/*--------------------- file opening */
-
-	f = fopen(m_fileName.c_str(),"r");
-	if (f == NULL)
+	int fd = open(m_fileName.c_str(), O_RDONLY);
+	if (fd == -1)
 	{
 		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
 		return -1;
 	}
-	if ((ftemp = tmpfile()) == NULL)
+
+	struct stat st;
+	if (fstat(fd, &st) == -1)
 	{
-		std::cout << "tmpfile() did not work!" << std::endl;
+		close(fd);
 		return -1;
 	}
 
-
-/* ---------------------- search section and key */
-	if (FindSection(szSect, bWarnIfNotfound) != 0)
-	{
-		bFoundSect = 0;
-	}
-	fpos = ftell(f);
-	if (bFoundSect)
+	// one read of the whole file
+	m_Text.clear();
+	if (st.st_size > 0)
 	{
-		if (!FindKey(szKey, false))	bFoundKey = 1;
-		fpos = ftell(f);
+		void* pData = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (pData == MAP_FAILED)
+		{
+			std::cout << "INI-File could not be read " << m_fileName.c_str() << std::endl;
+			close(fd);
+			return -1;
+		}
+		m_Text.assign((const char*)pData, st.st_size);
+		munmap(pData, st.st_size);
 	}
-	if (feof(f)) bEoff = 1;
+	close(fd);
 
-/* --------------------- updating the file */
-	fseek(f,0,SEEK_SET);
-	for (i=0;i<fpos;i++)
+	m_FileTime = st.st_mtim;
+	m_FileSize = st.st_size;
+	m_bDirty = false;
+	Parse();
+	return 0;
+}
+//--------------------------------------------------------------------------------
+int IniFile::Refresh()
+{
+	if (m_bDirty)
+		return 0;
+
+	struct stat st;
+	if (stat(m_fileName.c_str(), &st) == -1)
 	{
-		fscanf(f,"%c",&c);
-		fprintf(ftemp,"%c",c);
-		// MMB/23.02.2006: The counter i must not be incremented here on Linux machines!
-#ifdef WIN32
-		if (c=='\n')
-			i++;
-#endif
-	};
-
-	if (!bFoundSect) {
-		fprintf(ftemp,"\n\n[%s]\n",szSect);
+		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
+		return -1;
 	}
-	if (bFoundSect && (!bFoundKey) && (bEoff))
+
+	if (st.st_mtim.tv_sec != m_FileTime.tv_sec || st.st_mtim.tv_nsec != m_FileTime.tv_nsec ||
+		st.st_size != m_FileSize)
 	{
-		fprintf(ftemp,"\n");
+		return Load();
 	}
+	return 0;
+}
+//--------------------------------------------------------------------------------
+void IniFile::Parse()
+{
+	m_Sections.clear();
+	m_SectionOrder.clear();
 
-
-	if (!bFoundKey)
+	Section* pSection = NULL;
+	std::string::size_type Size = m_Text.size();
+	std::string::size_type LineBegin = 0;
+	while (LineBegin < Size)
 	{
-		fprintf(ftemp,"%s=",szKey);
-	}
+		std::string::size_type LineEnd = m_Text.find('\n', LineBegin);
+		if (LineEnd == std::string::npos)
+			LineEnd = Size;
+		std::string::size_type NextLine = (LineEnd < Size) ? LineEnd + 1 : Size;
 
-	fprintf(ftemp,"%s",szValue);
+		if (m_Text[LineBegin] == '[')
+		{
+			std::string::size_type Close = m_Text.find(']', LineBegin + 1);
+			pSection = NULL;
+			if (Close < LineEnd)
+			{
+				std::string Name = m_Text.substr(LineBegin + 1, Close - LineBegin - 1);
+				m_SectionOrder.push_back(Name);
 
-	if (bFoundKey) FindNextLine(m_CurLine, m_CurCharInd);
-	if (!(bEoff || feof(f)))
-	{	fprintf(ftemp,"\n");
-		while (!feof(f))
+				std::pair<SectionMap::iterator, bool> Res = m_Sections.insert(std::make_pair(Name, Section()));
+				if (Res.second)
+				{
+					pSection = &Res.first->second;
+					pSection->InsertPos = NextLine;
+				}
+			}
+		}
+		else
 		{
-			fscanf(f,"%c",&c);
-			if (!feof(f))
+			std::string::size_type KeyBegin = LineBegin;
+			while (KeyBegin < LineEnd && m_Text[KeyBegin] == ' ') // skip blanks
+				KeyBegin++;
+
+			if (KeyBegin < LineEnd && m_Text[KeyBegin] == '[') // a section must start in the first column
+			{
+				pSection = NULL;
+			}
+			else if (pSection != NULL)
 			{
-				fprintf(ftemp,"%c",c);
+				std::string::size_type Equal = m_Text.find('=', KeyBegin);
+				if (Equal < LineEnd)
+				{
+					std::string::size_type KeyEnd = Equal;
+					while (KeyEnd > KeyBegin && m_Text[KeyEnd - 1] == ' ')
+						KeyEnd--;
+					if (KeyEnd > KeyBegin)
+					{
+						KeyEntry Entry;
+						Entry.ValueBegin = Equal + 1;
+						Entry.LineEnd = LineEnd;
+						pSection->Keys.insert(std::make_pair(m_Text.substr(KeyBegin, KeyEnd - KeyBegin), Entry));
+						pSection->InsertPos = NextLine;
+					}
+				}
 			}
 		}
+
+		LineBegin = NextLine;
 	}
-	fpos = ftell(ftemp);
-	fclose(f);
+}
+//--------------------------------------------------------------------------------
+const IniFile::KeyEntry* IniFile::FindKey(const char* sect, const char* skey, bool bWarnIfNotfound)
+{
+	if (!m_bFileOK) return NULL;
+	if (strlen(sect) * strlen(skey) == 0) return NULL;
+	if (Refresh() != 0) return NULL;
 
+	SectionMap::const_iterator itSect = m_Sections.find(sect);
+	if (itSect == m_Sections.end())
+	{
+		if(bWarnIfNotfound)
+		{
+			std::cout << "Section [" << sect << "] in IniFile " << m_fileName.c_str() << " used by "
+				<< m_strIniFileUsedBy << " not found" << std::endl;
+		}
+		return NULL;
+	}
+
+	KeyMap::const_iterator itKey = itSect->second.Keys.find(skey);
+	if (itKey == itSect->second.Keys.end())
+	{
+		if(bWarnIfNotfound)
+		{
+			std::cout << "Key " << skey << " in IniFile '" << m_fileName.c_str() << "' used by "
+				<< m_strIniFileUsedBy << " not found" << std::endl;
+		}
+		return NULL;
+	}
+	return &itKey->second;
+}
+//--------------------------------------------------------------------------------
+int IniFile::Flush()
+{
+	if (!m_bDirty) return 0;
+
+	FILE* f;
 	if ((f = fopen(m_fileName.c_str(),"w")) == NULL)
 	{
 		if ((f = fopen(m_fileName.c_str(),"r")) != NULL)
@@ -178,16 +257,73 @@ int IniFile::WriteKeyValue(const char* szSect,const char* szKey,const char* szVa
 		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
 		return -1;
 	}
-	fseek(ftemp,0,SEEK_SET);
-	for (i=0;i<fpos;i++)
-	{
-		fscanf(ftemp,"%c",&c);
-		fprintf(f,"%c",c);
-	};
+	size_t BytesWritten = fwrite(m_Text.data(), 1, m_Text.size(), f);
 	fclose(f);
-	fclose(ftemp);
+	if (BytesWritten != m_Text.size())
+	{
+		std::cout << "INI-File could not be written " << m_fileName.c_str() << std::endl;
+		return -1;
+	}
+
+	// the written file is the loaded one
+	struct stat st;
+	if (stat(m_fileName.c_str(), &st) == 0)
+	{
+		m_FileTime = st.st_mtim;
+		m_FileSize = st.st_size;
+	}
+	m_bDirty = false;
 	return 0;
+}
+//--------------------------------------------------------------------------------
+int IniFile::WriteKeyString(const char* pSect, const char* pKey, const std::string* pStrToWrite, bool bWarnIfNotfound)
+{
+	std::string StrWithDelimeters = '"' + *pStrToWrite + '"';
+	return WriteKeyValue(pSect, pKey, StrWithDelimeters.c_str(), bWarnIfNotfound);
+}
+//--------------------------------------------------------------------------------
+int IniFile::WriteKeyValue(const char* szSect,const char* szKey,const char* szValue, bool bWarnIfNotfound)
+{
+	if (!m_bFileOK) return -1;
+	if (strlen(szSect) * strlen(szKey) == 0) return -1;
+	if (Refresh() != 0) return -1;
+
+	SectionMap::iterator itSect = m_Sections.find(szSect);
+	if (itSect == m_Sections.end())
+	{
+		if(bWarnIfNotfound)
+		{
+			std::cout << "Section [" << szSect << "] in IniFile " << m_fileName.c_str() << " used by "
+				<< m_strIniFileUsedBy << " not found" << std::endl;
+		}
+
+		// new section at the end of the file
+		if (!m_Text.empty() && m_Text[m_Text.size() - 1] != '\n')
+			m_Text += '\n';
+		m_Text += std::string("\n[") + szSect + "]\n" + szKey + "=" + szValue + "\n";
+	}
+	else
+	{
+		KeyMap::iterator itKey = itSect->second.Keys.find(szKey);
+		if (itKey != itSect->second.Keys.end())
+		{
+			// replaces the rest of the line
+			m_Text.replace(itKey->second.ValueBegin, itKey->second.LineEnd - itKey->second.ValueBegin, szValue);
+		}
+		else
+		{
+			// new key behind the last key of the section
+			std::string::size_type InsertPos = itSect->second.InsertPos;
+			std::string Line = std::string(szKey) + "=" + szValue + "\n";
+			if (InsertPos > 0 && m_Text[InsertPos - 1] != '\n')
+				Line = "\n" + Line;
+			m_Text.insert(InsertPos, Line);
+		}
+	}
 
+	m_bDirty = true;
+	Parse();
+	return 0;
 }
 //--------------------------------------------------------------------------------
 int IniFile::WriteKeyBool(const char* pSect, const char* pKey, bool bValue, bool bWarnIfNotfound)
@@ -320,307 +456,85 @@ int IniFile::GetKeyDouble(const char* pSect,const char* pKey,double* pValue,
 int IniFile::GetKeyValue(const char* szSect,const char* szKey,char* szBuf,
 						int lenBuf,	bool bWarnIfNotfound)
 {
-	if (!m_bFileOK) return -1;
-
-	int   lS,lK;
-
-	lS = strlen(szSect);
-	lK = strlen(szKey);
-	if ((lS * lK) == 0) return -1;
-	if ((f = fopen(m_fileName.c_str(),"r")) == NULL)
-	{
-		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
-		return -1;
-	}
-	if ( FindSection(szSect, bWarnIfNotfound) )
-	{	fclose(f);
+	const KeyEntry* pEntry = FindKey(szSect, szKey, bWarnIfNotfound);
+	if (pEntry == NULL)
 		return -1;
-	}
-	if ( FindKey(szKey, bWarnIfNotfound) )
-	{	fclose(f);
-		return -1;
-	}
-
-	if (feof(f))
-	{
-		fclose(f);
-		return -1;
-	}
-
-	//----------- read szBuf bytes from file into szKey
-	int BytesRead = fread( szBuf, 1, lenBuf, f );
 
-	// terminate string
-	int StrLen;
-	if(BytesRead < lenBuf)
-	{
-		if( BytesRead == 0 && (!feof(f)) )
-		{
-			std::cout << "file read" << std::endl;
-		}
-		StrLen = BytesRead;
-	}
-	else
-	{
-		StrLen = lenBuf-1;
-	}
+	//----------- copy up to lenBuf-1 bytes behind the '='
+	int StrLen = lenBuf - 1;
+	std::string::size_type Available = m_Text.size() - pEntry->ValueBegin;
+	if (Available < (std::string::size_type)StrLen)
+		StrLen = Available;
+	memcpy(szBuf, m_Text.data() + pEntry->ValueBegin, StrLen);
 	szBuf[StrLen] = '\0';
 
-	fclose(f);
 	return StrLen;
 }
 //--------------------------------------------------------------------------------
 int IniFile::GetKeyString(const char* szSect,const char* szKey, std::string* pStrToRead,
 							bool bWarnIfNotfound)
 {
-	if (!m_bFileOK) return -1;
-
-	int   lS,lK;
-
-	lS = strlen(szSect);
-	lK = strlen(szKey);
-	if ((lS * lK) == 0) return -1;
-	if ((f = fopen(m_fileName.c_str(),"r")) == NULL)
-	{
-		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
+	const KeyEntry* pEntry = FindKey(szSect, szKey, bWarnIfNotfound);
+	if (pEntry == NULL)
 		return -1;
-	}
-	if ( FindSection(szSect, bWarnIfNotfound) )
-	{	fclose(f);
-		return -1;
-	}
-	if ( FindKey(szKey, bWarnIfNotfound) )
-	{	fclose(f);
-		return -1;
-	}
 
-	if (feof(f))
-	{
-		fclose(f);
-		return -1;
-	}
-
-	//----------- read szBuf bytes from file into szKey
-	int res = SkipLineUntil(f, '"'); // find begin of string
-	if(res == -1)
+	//----------- the string is enclosed in '"' in the same line
+	std::string::size_type Begin = m_Text.find('"', pEntry->ValueBegin); // find begin of string
+	if(Begin >= pEntry->LineEnd)
 	{	if(bWarnIfNotfound)
 		{
 			std::cout << "GetKeyString section " << szSect << " key " << szKey << " first \" not found" << std::endl;
 		}
-		fclose(f);
 		return -1;
 	}
 
-	std::string strRead;
-	res = ReadLineUntil(f, '"', strRead); // read string
-	if(res == -1)
+	std::string::size_type End = m_Text.find('"', Begin + 1); // read string
+	if(End >= pEntry->LineEnd)
 	{
 		if(bWarnIfNotfound)
 		{
 			std::cout << "GetKeyString section " << szSect << " key " << szKey << " string not found" << std::endl;
 		}
-		fclose(f);
 		return -1;
 	}
 
 	// success
-	*pStrToRead = strRead;
-	fclose(f);
+	*pStrToRead = m_Text.substr(Begin + 1, End - Begin - 1);
 	return 0;
 }
 //--------------------------------------------------------------------------------
-int IniFile::SkipLineUntil(FILE* pFile, const char EndChar)
-{
-	int CharsRead = 0;
-	while (1)
-	{
-		int Char = fgetc(pFile);
-
-		if (Char == EndChar)			// end found?
-			return CharsRead;			// read finished
-
-		if (Char == EOF || Char == '\n')
-			return -1;				// end not found
-
-		CharsRead++;
-	}
-}
-//--------------------------------------------------------------------------------
-int IniFile::ReadLineUntil(FILE* pFile, const char EndChar, std::string& ReadIntoStr)
-{
-	int CharsRead = 0;
-	while (1)
-	{
-		int Char = fgetc(pFile);
-
-		if (Char == EndChar)			// end found?
-			return CharsRead;			// read finished
-
-		if (Char == EOF || Char == '\n')
-			return -1;				// end not found
-
-		ReadIntoStr.append(1, char(Char));
-
-		CharsRead++;
-	}
-}
-//--------------------------------------------------------------------------------
-int IniFile::FindNextLine(std::vector<char>& NewLine, int& CharInd)
-{
-	if (!feof(f))
-	{
-		fgets(&NewLine[0], NewLine.size(), f); // store next line in NewLine
-		CharInd=0;        // makes CharInd reference the first char of the line
-		return 0;
-	}
-	return -1;
-}
-//--------------------------------------------------------------------------------
 int IniFile::FindNextSection(std::string* pSect, std::string prevSect, bool bWarnIfNotfound)
 {
-	std::vector<char> line;
-	//int charInd = 0;
-	//int res = -1;
-
 	if (!m_bFileOK) return -1;
 
 	// Make sure that there is no old data.
 	pSect->erase();
 
-/*--------------------- file opening */
-	f = fopen(m_fileName.c_str(),"r");
-	if (f == NULL)
-	{
-		std::cout << "INI-File not found " << m_fileName.c_str() << std::endl;
-		return -1;
-	}
-	if (feof(f)) return -1;
+	if (Refresh() != 0) return -1;
 
 /*--------------------- search the section */
-	if( prevSect != "" ) {
-		FindSection( prevSect.c_str(), bWarnIfNotfound );
-	} else {
-		fseek(f,0,SEEK_SET);
-	}
-
-	FindNextLine(m_CurLine, m_CurCharInd); //read first line of file
-	do
+	std::vector<std::string>::size_type Next = 0;
+	if( prevSect != "" )
 	{
-		if (m_CurLine[0] == '[')
-		{
-			while( m_CurCharInd < (int)m_CurLine.size() ) {
-				m_CurCharInd++;
-				if (m_CurLine[m_CurCharInd] == ']') // if found section name equals searched one
-				{
-					for( int i=1; i<m_CurCharInd; ++i )
-						pSect->append(1, char(m_CurLine[i]));
-					return 0;
-				}
-			}
-		}
-		else
-		{
-			FindNextLine(m_CurLine, m_CurCharInd);
-		}
-	}while (!feof(f));
-
-/*--------------------- file closing */
-	fclose(f);
-
-	return 0;
-}
-//--------------------------------------------------------------------------------
-int IniFile::FindSection(const char* sect,
-							bool bWarnIfNotfound)
-{
-	int   lS;
-	lS = strlen(sect);
-	if (feof(f)) return -1;
+		while( Next < m_SectionOrder.size() && m_SectionOrder[Next] != prevSect )
+			Next++;
 
-	FindNextLine(m_CurLine, m_CurCharInd); //read first line of file
-	do
-	{
-		if (m_CurLine[0] == '[')
+		if( Next == m_SectionOrder.size() )
 		{
-			m_CurCharInd++;
-			if ((strncmp(&m_CurLine[m_CurCharInd], sect, lS) == 0) && (m_CurLine[m_CurCharInd+lS] == ']')) // if found section name equals searched one
-	        {
-				return 0;
-			}
-			else
+			if(bWarnIfNotfound)
 			{
-				FindNextLine(m_CurLine, m_CurCharInd);
+				std::cout << "Section [" << prevSect << "] in IniFile " << m_fileName.c_str() << " used by "
+					<< m_strIniFileUsedBy << " not found" << std::endl;
 			}
+			return 0;
 		}
-		else if (m_CurLine[m_CurCharInd] == ' ') // if a blank is found
-		{
-			m_CurCharInd++;
-		}
-		else
-		{
-			FindNextLine(m_CurLine, m_CurCharInd);
-		}
-	}while (!feof(f));
-
-	// not found
-	if(bWarnIfNotfound)
-	{
-		std::cout << "Section [" << sect << "] in IniFile " << m_fileName.c_str() << " used by "
-			<< m_strIniFileUsedBy << " not found" << std::endl;
+		Next++;
 	}
 
-	return -1;
-}
-//--------------------------------------------------------------------------------
-int IniFile::FindKey(const char* skey,
-							bool bWarnIfNotfound)
-{
-	int   lS;
-	long  fpos = 0l;
-	lS = strlen(skey);
-	if (feof(f)) return -1;
-
-	do
-	{
-		fpos=ftell(f);// pointer to the begin of the last read line
-		FindNextLine(m_CurLine, m_CurCharInd);
-
-		while ( m_CurLine[m_CurCharInd] == ' ' ) // skip blanks
-			{
-				m_CurCharInd++;
-				fpos++;
-			}
-
-		if (m_CurLine[m_CurCharInd] == '[') // next section?
-			break; // not found
-
-		if (strncmp(&m_CurLine[m_CurCharInd], skey, lS) == 0) //Found
-		{
-			m_CurCharInd+=lS;
-			fpos+=lS; // set file pointer to end of found key
-            while ( m_CurLine[m_CurCharInd] == ' ' ) // skip blanks
-			{
-				m_CurCharInd++;
-				fpos++;
-			}
-			if ( m_CurLine[m_CurCharInd] == '=' )
-			{
-				m_CurCharInd++; // set index to first char after the =
-				fpos++;
-				fseek(f,fpos,SEEK_SET);// set file pointer to first char after the =
-				return 0;
-			}
-
-		}
-
-	}while (!feof(f));
+	if( Next < m_SectionOrder.size() )
+		*pSect = m_SectionOrder[Next];
 
-	if(bWarnIfNotfound)
-	{
-		std::cout << "Key " << skey << " in IniFile '" << m_fileName.c_str() << "' used by "
-			<< m_strIniFileUsedBy << " not found" << std::endl;
-	}
-	return -1;
+	return 0;
 }
 //-----------------------------------------------
 int IniFile::GetKey(const char* pSect,const char* pKey, std::string* pStrToRead, bool bWarnIfNotfound)
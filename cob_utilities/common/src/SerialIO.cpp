@@ -0,0 +1,606 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_utilities/SerialIO.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+#include <unistd.h>
+#include <termios.h>
+
+
+// Kernel termios with explicit speeds. The definition of <asm/termbits.h> collides
+// with the one of <termios.h>, so it is declared here (generic Linux layout).
+struct SerialTermios2
+{
+	tcflag_t c_iflag;
+	tcflag_t c_oflag;
+	tcflag_t c_cflag;
+	tcflag_t c_lflag;
+	cc_t c_line;
+	cc_t c_cc[19];
+	speed_t c_ispeed;
+	speed_t c_ospeed;
+};
+
+#define SERIALIO_TCGETS2 _IOR('T', 0x2A, SerialTermios2)
+#define SERIALIO_TCSETS2 _IOW('T', 0x2B, SerialTermios2)
+#define SERIALIO_BOTHER 0010000
+
+
+static bool getBaudrateCode(int iBaudrate, int* iBaudrateCode)
+{
+	// baudrate codes are defined in termios.h
+	// currently upto B1000000
+	const int baudTable[] = {
+		0, 50, 75, 110, 134, 150, 200, 300, 600,
+		1200, 1800, 2400, 4800,
+		9600, 19200, 38400, 57600, 115200, 230400,
+		460800, 500000, 576000, 921600, 1000000
+	};
+	const int baudCodes[] = {
+		B0, B50, B75, B110, B134, B150, B200, B300, B600,
+		B1200, B1800, B2400, B4800,
+		B9600, B19200, B38400, B57600, B115200, B230400,
+		B460800, B500000, B576000, B921600, B1000000
+	};
+	const int iBaudsLen = sizeof(baudTable) / sizeof(int);
+
+	*iBaudrateCode = B38400;
+	for(int i=0; i<iBaudsLen; i++ ) {
+		if( baudTable[i] == iBaudrate ) {
+			*iBaudrateCode = baudCodes[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static double monotonicNow()
+{
+	timespec Ts;
+	clock_gettime(CLOCK_MONOTONIC, &Ts);
+	return Ts.tv_sec + Ts.tv_nsec * 1e-9;
+}
+
+static void sleepSeconds(double Seconds)
+{
+	if (Seconds <= 0)
+		return;
+	timespec Ts;
+	Ts.tv_sec = time_t(Seconds);
+	Ts.tv_nsec = long((Seconds - Ts.tv_sec) * 1e9);
+	while (nanosleep(&Ts, &Ts) == -1 && errno == EINTR) {}
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// Konstruktion/Destruktion
+//////////////////////////////////////////////////////////////////////
+
+SerialIO::SerialIO()
+	: m_DeviceName(""),
+	  m_Device(-1),
+	  m_BaudRate(9600),
+	  m_Multiplier(1.0),
+	  m_ByteSize(8),
+	  m_StopBits(SB_ONE),
+	  m_Parity(PA_NONE),
+	  m_Handshake(HS_NONE),
+	  m_ReadBufSize(1024),
+	  m_WriteBufSize(m_ReadBufSize),
+	  m_Timeout(0),
+	  m_MinBytes(1),
+	  m_NonBlocking(false),
+	  m_LowLatency(false),
+	  m_BytePeriod(0),
+	  m_PacingChunk(16),
+	  m_RxHead(0),
+	  m_RxTail(0)
+{
+}
+
+SerialIO::~SerialIO()
+{
+	closeIO();
+}
+
+int SerialIO::openIO()
+{
+	int Res;
+
+	// open device
+	int Flags = O_RDWR | O_NOCTTY;
+	if (m_NonBlocking)
+		Flags |= O_NONBLOCK;
+	m_Device = open(m_DeviceName.c_str(), Flags);
+
+	if(m_Device < 0)
+	{
+		std::cerr << "Trying to open " << m_DeviceName << " failed: "
+			<< strerror(errno) << " (Error code " << errno << ")" << std::endl;
+
+		return -1;
+	}
+
+	// set parameters
+	Res = tcgetattr(m_Device, &m_tio);
+	if (Res == -1)
+	{
+		std::cerr << "tcgetattr of " << m_DeviceName << " failed: "
+			<< strerror(errno) << " (Error code " << errno << ")" << std::endl;
+
+		close(m_Device);
+		m_Device = -1;
+
+		return -1;
+	}
+
+	// Default values
+	m_tio.c_iflag = 0;
+	m_tio.c_oflag = 0;
+	m_tio.c_cflag = B9600 | CS8 | CREAD | HUPCL | CLOCAL;
+	m_tio.c_lflag = 0;
+	cfsetispeed(&m_tio, B9600);
+	cfsetospeed(&m_tio, B9600);
+
+	m_tio.c_cc[VINTR] = 3;	// Interrupt
+	m_tio.c_cc[VQUIT] = 28;	// Quit
+	m_tio.c_cc[VERASE] = 127;	// Erase
+	m_tio.c_cc[VKILL] = 21;	// Kill-line
+	m_tio.c_cc[VEOF] = 4;	// End-of-file
+	m_tio.c_cc[VTIME] = 0;	// Time to wait for data (tenths of seconds)
+	m_tio.c_cc[VMIN] = 1;	// Minimum number of characters to read
+	m_tio.c_cc[VSWTC] = 0;
+	m_tio.c_cc[VSTART] = 17;
+	m_tio.c_cc[VSTOP] = 19;
+	m_tio.c_cc[VSUSP] = 26;
+	m_tio.c_cc[VEOL] = 0;	// End-of-line
+	m_tio.c_cc[VREPRINT] = 18;
+	m_tio.c_cc[VDISCARD] = 15;
+	m_tio.c_cc[VWERASE] = 23;
+	m_tio.c_cc[VLNEXT] = 22;
+	m_tio.c_cc[VEOL2] = 0;	// Second end-of-line
+
+	// set data format
+	m_tio.c_cflag &= ~CSIZE;
+	switch (m_ByteSize)
+	{
+		case 5:
+			m_tio.c_cflag |= CS5;
+			break;
+		case 6:
+			m_tio.c_cflag |= CS6;
+			break;
+		case 7:
+			m_tio.c_cflag |= CS7;
+			break;
+		case 8:
+		default:
+			m_tio.c_cflag |= CS8;
+	}
+
+	m_tio.c_cflag &= ~ (PARENB | PARODD);
+
+	switch (m_Parity)
+	{
+		case PA_ODD:
+			m_tio.c_cflag |= PARODD;
+			//break;  // break must not be active here as we need the combination of PARODD and PARENB on odd parity.
+
+		case PA_EVEN:
+			m_tio.c_cflag |= PARENB;
+			break;
+
+		case PA_NONE:
+		default: {}
+	}
+
+	switch (m_StopBits)
+	{
+		case SB_TWO:
+			m_tio.c_cflag |= CSTOPB;
+			break;
+
+		case SB_ONE:
+		default:
+			m_tio.c_cflag &= ~CSTOPB;
+	}
+
+	// hardware handshake
+	switch (m_Handshake)
+	{
+		case HS_NONE:
+			m_tio.c_cflag &= ~CRTSCTS;
+			m_tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+			break;
+		case HS_HARDWARE:
+			m_tio.c_cflag |= CRTSCTS;
+			m_tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+			break;
+		case HS_XONXOFF:
+			m_tio.c_cflag &= ~CRTSCTS;
+			m_tio.c_iflag |= (IXON | IXOFF | IXANY);
+			break;
+	}
+
+	m_tio.c_oflag &= ~OPOST;
+	m_tio.c_lflag &= ~ICANON;
+
+	// write parameters
+	Res = tcsetattr(m_Device, TCSANOW, &m_tio);
+
+	if (Res == -1)
+	{
+		std::cerr << "tcsetattr " << m_DeviceName << " failed: "
+			<< strerror(errno) << " (Error code " << errno << ")" << std::endl;
+
+		close(m_Device);
+		m_Device = -1;
+
+		return -1;
+	}
+
+	// set baud rate
+	int iNewBaudrate = int(m_BaudRate * m_Multiplier + 0.5);
+	if (!setDeviceBaudRate(iNewBaudrate))
+	{
+		std::cerr << "Setting baudrate " << iNewBaudrate << " of " << m_DeviceName << " failed: "
+			<< strerror(errno) << " (Error code " << errno << ")" << std::endl;
+	}
+
+	// the UART driver forwards received bytes immediately
+	if (m_LowLatency)
+	{
+		struct serial_struct ss;
+		if (ioctl(m_Device, TIOCGSERIAL, &ss) == -1 ||
+			(ss.flags |= ASYNC_LOW_LATENCY, ioctl(m_Device, TIOCSSERIAL, &ss)) == -1)
+		{
+			std::cerr << "Low latency mode not available for " << m_DeviceName << std::endl;
+		}
+	}
+
+	// set buffer sizes
+	m_RxBuffer.resize(m_ReadBufSize > 0 ? m_ReadBufSize : 1);
+	m_RxHead = m_RxTail = 0;
+
+	// set timeout
+	setTimeout(m_Timeout);
+	setMinBytes(m_MinBytes);
+
+	return 0;
+}
+
+bool SerialIO::setDeviceBaudRate(int BaudRate)
+{
+	int iBaudrateCode = 0;
+	if (getBaudrateCode(BaudRate, &iBaudrateCode))
+	{
+		cfsetispeed(&m_tio, iBaudrateCode);
+		cfsetospeed(&m_tio, iBaudrateCode);
+		return tcsetattr(m_Device, TCSANOW, &m_tio) != -1;
+	}
+
+	// arbitrary baudrate
+	SerialTermios2 tio2;
+	if (ioctl(m_Device, SERIALIO_TCGETS2, &tio2) == -1)
+		return false;
+	tio2.c_cflag &= ~CBAUD;
+	tio2.c_cflag |= SERIALIO_BOTHER;
+	tio2.c_ispeed = BaudRate;
+	tio2.c_ospeed = BaudRate;
+	if (ioctl(m_Device, SERIALIO_TCSETS2, &tio2) == -1)
+		return false;
+
+	// later tcsetattr() calls keep BOTHER and the speeds
+	tcgetattr(m_Device, &m_tio);
+	return true;
+}
+
+void SerialIO::closeIO()
+{
+	if (m_Device != -1)
+	{
+		close(m_Device);
+		m_Device = -1;
+	}
+	m_RxHead = m_RxTail = 0;
+}
+
+void SerialIO::setTimeout(double Timeout)
+{
+	m_Timeout = Timeout;
+	if (m_Device != -1)
+	{
+		m_tio.c_cc[VTIME] = cc_t(ceil(m_Timeout * 10.0));
+		tcsetattr(m_Device, TCSANOW, &m_tio);
+	}
+
+}
+
+void SerialIO::setMinBytes(int MinBytes)
+{
+	m_MinBytes = MinBytes < 0 ? 0 : (MinBytes > 255 ? 255 : MinBytes);
+	if (m_Device != -1)
+	{
+		m_tio.c_cc[VMIN] = cc_t(m_MinBytes);
+		tcsetattr(m_Device, TCSANOW, &m_tio);
+	}
+}
+
+void SerialIO::setBytePeriod(double Period)
+{
+	m_BytePeriod = Period;
+}
+
+double SerialIO::getByteTime() const
+{
+	int Bits = 1 + m_ByteSize + (m_Parity != PA_NONE ? 1 : 0) + (m_StopBits == SB_TWO ? 2 : 1);
+	double BaudRate = m_BaudRate * m_Multiplier;
+	return BaudRate > 0 ? Bits / BaudRate : 0;
+}
+
+//-----------------------------------------------
+void SerialIO::changeBaudRate(int iBaudRate)
+{
+	m_BaudRate = iBaudRate;
+	if (m_Device == -1)
+		return;
+
+	int iNewBaudrate = int(m_BaudRate * m_Multiplier + 0.5);
+	if (!setDeviceBaudRate(iNewBaudrate))
+	{
+		std::cerr << "error in SerialIO::changeBaudRate()" << std::endl;
+	}
+}
+
+int SerialIO::addToEpoll(int EpollFd, uint32_t Events, void *Data)
+{
+	epoll_event Event;
+	Event.events = Events;
+	Event.data.ptr = Data;
+	return epoll_ctl(EpollFd, EPOLL_CTL_ADD, m_Device, &Event);
+}
+
+int SerialIO::removeFromEpoll(int EpollFd)
+{
+	epoll_event Event;
+	return epoll_ctl(EpollFd, EPOLL_CTL_DEL, m_Device, &Event);
+}
+
+
+int SerialIO::readBlocking(char *Buffer, int Length)
+{
+	ssize_t BytesRead;
+	BytesRead = read(m_Device, Buffer, Length);
+#ifdef PRINT_BYTES
+	printf("%2d Bytes read:", BytesRead);
+	for(int i=0; i<BytesRead; i++)
+		printf(" %.2x", (unsigned char)Buffer[i]);
+	printf("\n");
+#endif
+	return BytesRead;
+}
+
+int SerialIO::readNonBlocking(char *Buffer, int Length)
+{
+	int iAvaibleBytes = getSizeRXQueue();
+	int iBytesToRead = (Length < iAvaibleBytes) ? Length : iAvaibleBytes;
+	if (iBytesToRead == 0)
+		return 0;
+
+	return read(m_Device, Buffer, iBytesToRead);
+}
+
+int SerialIO::readBuffered(char *Buffer, int Length)
+{
+	if (m_Device == -1)
+		return -1;
+
+	int Size = m_RxBuffer.size();
+	int Available = m_RxTail - m_RxHead;
+
+	// an empty buffer may block, a partly filled one only takes what is there
+	if (Available == 0 || (Available < Length && getSizeRXQueue() > 0))
+	{
+		if (Available == 0)
+		{
+			m_RxHead = m_RxTail = 0;
+		}
+		else if (m_RxTail == Size)
+		{
+			memmove(&m_RxBuffer[0], &m_RxBuffer[m_RxHead], Available);
+			m_RxHead = 0;
+			m_RxTail = Available;
+		}
+
+		ssize_t BytesRead = read(m_Device, &m_RxBuffer[m_RxTail], Size - m_RxTail);
+		if (BytesRead > 0)
+		{
+			m_RxTail += BytesRead;
+		}
+		else if (BytesRead < 0 && Available == 0)
+		{
+			return (errno == EAGAIN) ? 0 : -1;
+		}
+		Available = m_RxTail - m_RxHead;
+	}
+
+	int BytesToCopy = (Length < Available) ? Length : Available;
+	memcpy(Buffer, &m_RxBuffer[m_RxHead], BytesToCopy);
+	m_RxHead += BytesToCopy;
+	return BytesToCopy;
+}
+
+int SerialIO::readTimestamped(char *Buffer, int Length, double *Stamp)
+{
+	int iAvaibleBytes = getSizeRXQueue();
+	double Now = monotonicNow();
+
+	// the queued bytes arrived back to back until now
+	*Stamp = Now - iAvaibleBytes * getByteTime();
+
+	int iBytesToRead = (Length < iAvaibleBytes) ? Length : iAvaibleBytes;
+	if (iBytesToRead == 0)
+		return 0;
+	return read(m_Device, Buffer, iBytesToRead);
+}
+
+bool SerialIO::waitForWrite(double Timeout)
+{
+	pollfd Fd;
+	Fd.fd = m_Device;
+	Fd.events = POLLOUT;
+	Fd.revents = 0;
+	return poll(&Fd, 1, int(Timeout * 1000.0) + 1) > 0;
+}
+
+int SerialIO::writeIO(const char *Buffer, int Length)
+{
+	int BytesWritten = 0;
+	int ChunkSize = (m_BytePeriod > 0) ? m_PacingChunk : Length;
+	double Start = monotonicNow();
+
+	while (BytesWritten < Length)
+	{
+		int BytesToWrite = Length - BytesWritten;
+		if (BytesToWrite > ChunkSize)
+			BytesToWrite = ChunkSize;
+
+		ssize_t Res = write(m_Device, Buffer + BytesWritten, BytesToWrite);
+		if (Res < 0)
+		{
+			if ((errno == EAGAIN || errno == EINTR) && waitForWrite(m_Timeout > 0 ? m_Timeout : 0.1))
+				continue;
+			break;
+		}
+		BytesWritten += Res;
+
+		if (m_BytePeriod > 0)
+		{
+			// one system call per chunk instead of per byte
+			tcdrain(m_Device);
+			sleepSeconds(Start + BytesWritten * m_BytePeriod - monotonicNow());
+		}
+	}
+#ifdef PRINT_BYTES
+	printf("%2d Bytes sent:", BytesWritten);
+	for(int i=0; i<BytesWritten; i++)
+		printf(" %.2x", (unsigned char)Buffer[i]);
+	printf("\n");
+#endif
+
+	return BytesWritten;
+}
+
+int SerialIO::getSizeRXQueue()
+{
+	int cbInQue;
+	int Res = ioctl(m_Device, FIONREAD, &cbInQue);
+	if (Res == -1) {
+		return 0;
+	}
+	return cbInQue;
+}
+
+int SerialIO::waitForData(double Timeout)
+{
+	if (m_Device == -1)
+		return -1;
+
+	if (m_RxTail > m_RxHead)
+		return 1;
+
+	pollfd Fd;
+	Fd.fd = m_Device;
+	Fd.events = POLLIN;
+	Fd.revents = 0;
+
+	int Res = poll(&Fd, 1, int(Timeout * 1000.0 + 0.5));
+	if (Res == -1 && errno == EINTR)
+		return 0;
+	return Res;
+}
+
+//-----------------------------------------------
+int SerialIO::openPort(const std::string& DeviceName, int BaudRate)
+{
+	if (m_Device != -1)
+		return m_Device;
+
+	m_DeviceName = DeviceName;
+	m_BaudRate = BaudRate;
+	openIO();
+	return m_Device;
+}
+
+int SerialIO::sendData(const std::string& Value)
+{
+	return sendData(Value.c_str(), Value.length());
+}
+
+int SerialIO::sendData(const char *Data, size_t Length)
+{
+	int BytesWritten = -1;
+	m_Mutex.lock();
+	if (m_Device != -1)
+		BytesWritten = writeIO(Data, Length);
+	m_Mutex.unlock();
+	return BytesWritten;
+}
+
+int SerialIO::readData(std::string& Value, size_t Bytes)
+{
+	int BytesRead = -1;
+	m_Mutex.lock();
+	if (m_Device != -1 && waitForData(0.1) > 0)
+	{
+		std::vector<char> Buffer(Bytes > 0 ? Bytes : 1);
+		BytesRead = readNonBlocking(&Buffer[0], Bytes);
+		if (BytesRead > 0)
+			Value.assign(&Buffer[0], BytesRead);
+		else
+			BytesRead = -1;
+	}
+	m_Mutex.unlock();
+	return BytesRead;
+}
+
+bool SerialIO::recover()
+{
+	m_Mutex.lock();
+	closeIO();
+	bool Ok = (openIO() == 0);
+	if (Ok)
+	{
+		usleep(50000);
+		purge();
+	}
+	m_Mutex.unlock();
+	return Ok;
+}
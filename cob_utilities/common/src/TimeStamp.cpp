@@ -23,11 +23,40 @@ TimeStamp::TimeStamp()
 {
 	m_TimeStamp.tv_sec = 0;
 	m_TimeStamp.tv_nsec = 0;
+	SetClock(CLOCK_TYPE_REALTIME);
+}
+
+TimeStamp::TimeStamp(ClockType Clock)
+{
+	m_TimeStamp.tv_sec = 0;
+	m_TimeStamp.tv_nsec = 0;
+	SetClock(Clock);
 }
 
 void TimeStamp::SetNow()
 {
-	::clock_gettime(CLOCK_REALTIME, &m_TimeStamp);
+	::clock_gettime(m_ClockId, &m_TimeStamp);
+}
+
+void TimeStamp::SetClock(ClockType Clock)
+{
+	m_Clock = Clock;
+	switch (Clock)
+	{
+		case CLOCK_TYPE_MONOTONIC:
+			m_ClockId = CLOCK_MONOTONIC;
+			break;
+		case CLOCK_TYPE_MONOTONIC_COARSE:
+#ifdef CLOCK_MONOTONIC_COARSE
+			m_ClockId = CLOCK_MONOTONIC_COARSE;
+#else
+			m_ClockId = CLOCK_MONOTONIC;
+#endif
+			break;
+		default:
+			m_ClockId = CLOCK_REALTIME;
+			break;
+	}
 }
 
 double TimeStamp::TimespecToDouble(const ::timespec& LargeInt)
@@ -54,17 +83,18 @@ double TimeStamp::TimespecToDouble(const ::timespec& LargeInt)
 
 double TimeStamp::operator-(const TimeStamp& EarlierTime) const
 {
-	::timespec Res;
-
-	Res.tv_sec = m_TimeStamp.tv_sec - EarlierTime.m_TimeStamp.tv_sec;
-	Res.tv_nsec = m_TimeStamp.tv_nsec - EarlierTime.m_TimeStamp.tv_nsec;
+	return double(NanoSecSince(EarlierTime)) / 1e9;
+}
 
-	if (Res.tv_nsec < 0) {
-		Res.tv_sec--;
-		Res.tv_nsec += 1000000000;
-	}
+long long TimeStamp::NanoSecSince(const TimeStamp& EarlierTime) const
+{
+	return (long long)(m_TimeStamp.tv_sec - EarlierTime.m_TimeStamp.tv_sec) * 1000000000LL
+		+ (m_TimeStamp.tv_nsec - EarlierTime.m_TimeStamp.tv_nsec);
+}
 
-	return TimespecToDouble(Res);
+long long TimeStamp::GetNanoSec() const
+{
+	return (long long)m_TimeStamp.tv_sec * 1000000000LL + m_TimeStamp.tv_nsec;
 }
 
 void TimeStamp::operator+=(double TimeS)
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_utilities/IniFile.h>
+#include <cob_utilities/TimeStamp.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <iostream>
+
+// Measures reading all keys of an ini file the size of CanCtrl.ini, as the base nodes do
+// at startup, and writing keys.
+
+static const int c_iSections = 12;
+static const int c_iKeys = 14;
+
+static bool writeFile(const std::string& sFileName)
+{
+	FILE* f = fopen(sFileName.c_str(), "w");
+	if(f == NULL)
+		return false;
+	for(int s = 0; s < c_iSections; s++)
+	{
+		fprintf(f, "[Section%d]\n", s);
+		for(int k = 0; k < c_iKeys; k++)
+			fprintf(f, "Key%d=%d.%d\n", k, s, k);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	int iRuns = 200;
+
+	if(argc > 1)
+		iRuns = atoi(argv[1]);
+	if(iRuns <= 0)
+		iRuns = 200;
+
+	char cFileName[] = "/tmp/inifile_benchmark_XXXXXX";
+	int fd = mkstemp(cFileName);
+	if(fd == -1 || !writeFile(cFileName))
+	{
+		std::cerr << "ERROR - Could not create " << cFileName << std::endl;
+		return 1;
+	}
+	close(fd);
+
+	TimeStamp Start, End;
+	char cSect[20], cKey[20];
+	double dSum = 0;
+
+	// open and read every key, like a node at startup
+	Start.SetNow();
+	for(int i = 0; i < iRuns; i++)
+	{
+		IniFile iniFile;
+		iniFile.SetFileName(cFileName, "inifile_benchmark.cpp");
+		for(int s = 0; s < c_iSections; s++)
+		{
+			for(int k = 0; k < c_iKeys; k++)
+			{
+				double dValue = 0;
+				snprintf(cSect, sizeof(cSect), "Section%d", s);
+				snprintf(cKey, sizeof(cKey), "Key%d", k);
+				iniFile.GetKeyDouble(cSect, cKey, &dValue);
+				dSum += dValue;
+			}
+		}
+	}
+	End.SetNow();
+	std::cout << "Open and read " << c_iSections*c_iKeys << " keys: " << (End - Start) / iRuns * 1e6
+		<< " us, " << (End - Start) / iRuns / (c_iSections*c_iKeys) * 1e6 << " us/key" << std::endl;
+
+	// write every key of one section
+	Start.SetNow();
+	for(int i = 0; i < iRuns; i++)
+	{
+		IniFile iniFile;
+		iniFile.SetFileName(cFileName, "inifile_benchmark.cpp");
+		for(int k = 0; k < c_iKeys; k++)
+		{
+			snprintf(cKey, sizeof(cKey), "Key%d", k);
+			iniFile.WriteKeyDouble("Section0", cKey, i + 0.5*k);
+		}
+		iniFile.Flush();
+	}
+	End.SetNow();
+	std::cout << "Write " << c_iKeys << " keys: " << (End - Start) / iRuns * 1e6 << " us"
+		<< " (checksum " << (long long)dSum % 1000 << ")" << std::endl;
+
+	unlink(cFileName);
+	return 0;
+}
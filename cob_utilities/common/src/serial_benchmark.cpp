@@ -0,0 +1,230 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cob_utilities/SerialIO.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Measures SerialIO on a pseudo terminal: paced writes per byte against paced chunks,
+// small reads with readNonBlocking() against readBuffered() and the round trip time
+// of a short message to an echoing peer.
+
+static double nowS()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static int openMaster(std::string& sSlaveName)
+{
+	int iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+	if(iMaster < 0 || grantpt(iMaster) != 0 || unlockpt(iMaster) != 0)
+	{
+		std::cerr << "ERROR - Could not create a pseudo terminal" << std::endl;
+		exit(1);
+	}
+	sSlaveName = ptsname(iMaster);
+	return iMaster;
+}
+
+static bool openSlave(SerialIO& serial, const std::string& sSlaveName, bool bNonBlocking)
+{
+	serial.setDeviceName(sSlaveName.c_str());
+	serial.setBaudRate(115200);
+	serial.setBufferSize(4096, 4096);
+	serial.setNonBlocking(bNonBlocking);
+	return serial.openIO() == 0;
+}
+
+// The peer of the slave: discards or echoes everything it receives.
+struct Peer
+{
+	int iMaster;
+	bool bEcho;
+	volatile bool bStop;
+	long lBytes;
+};
+
+static void* runPeer(void* pArg)
+{
+	Peer* pPeer = (Peer*)pArg;
+	char cBuffer[4096];
+	while(!pPeer->bStop)
+	{
+		pollfd fd = {pPeer->iMaster, POLLIN, 0};
+		if(poll(&fd, 1, 10) <= 0)
+			continue;
+		int iNrBytes = read(pPeer->iMaster, cBuffer, sizeof(cBuffer));
+		if(iNrBytes <= 0)
+			continue;
+		pPeer->lBytes += iNrBytes;
+		if(pPeer->bEcho && write(pPeer->iMaster, cBuffer, iNrBytes) != iNrBytes)
+			std::cerr << "ERROR - Echo failed" << std::endl;
+	}
+	return NULL;
+}
+
+static void runPacedWrite(int iBytes, double dBytePeriod)
+{
+	std::string sSlaveName;
+	int iMaster = openMaster(sSlaveName);
+	Peer peer = {iMaster, false, false, 0};
+	pthread_t thread;
+	pthread_create(&thread, NULL, runPeer, &peer);
+
+	SerialIO serial;
+	openSlave(serial, sSlaveName, false);
+	std::vector<char> data(iBytes, 'x');
+
+	// former writeIO(): write, drain and sleep the period for every byte
+	double dStart = nowS();
+	for(int i = 0; i < iBytes; i++)
+	{
+		if(write(serial.getFileDescriptor(), &data[i], 1) != 1)
+			break;
+		tcdrain(serial.getFileDescriptor());
+		usleep((useconds_t)(dBytePeriod * 1e6));
+	}
+	double dPerByteS = nowS() - dStart;
+
+	serial.setBytePeriod(dBytePeriod);
+	serial.setPacingChunk(16);
+	dStart = nowS();
+	serial.writeIO(&data[0], iBytes);
+	double dChunkedS = nowS() - dStart;
+
+	peer.bStop = true;
+	pthread_join(thread, NULL);
+	close(iMaster);
+
+	std::cout << "Paced write of " << iBytes << " bytes at " << dBytePeriod*1e6 << " us/byte (nominal "
+		<< iBytes*dBytePeriod*1e3 << " ms): per byte " << dPerByteS*1e3 << " ms, chunks of 16 "
+		<< dChunkedS*1e3 << " ms" << std::endl;
+}
+
+static void runReads(int iBytes, int iReadSize)
+{
+	std::string sSlaveName;
+	int iMaster = openMaster(sSlaveName);
+	SerialIO serialA, serialB;
+	std::vector<char> data(iBytes, 'x');
+	std::vector<char> buffer(iReadSize);
+	double dTimes[2];
+
+	for(int iMode = 0; iMode < 2; iMode++)
+	{
+		SerialIO& serial = (iMode == 0) ? serialA : serialB;
+		openSlave(serial, sSlaveName, true);
+
+		int iReceived = 0;
+		double dStart = nowS();
+		for(int iSent = 0; iSent < iBytes; iSent += 1024)
+		{
+			// the peer sends bursts of 1 kB, the reader parses small pieces
+			int iBurst = std::min(1024, iBytes - iSent);
+			if(write(iMaster, &data[iSent], iBurst) != iBurst)
+				break;
+			while(iReceived < iSent + iBurst)
+			{
+				int iNrBytes = (iMode == 0) ? serial.readNonBlocking(&buffer[0], iReadSize)
+					: serial.readBuffered(&buffer[0], iReadSize);
+				if(iNrBytes > 0)
+					iReceived += iNrBytes;
+				else if(serial.waitForData(1.0) <= 0)
+					break;
+			}
+		}
+		dTimes[iMode] = nowS() - dStart;
+		serial.closeIO();
+
+		if(iReceived != iBytes)
+			std::cerr << "ERROR - Received " << iReceived << " of " << iBytes << " bytes" << std::endl;
+	}
+	close(iMaster);
+
+	std::cout << "Reads of " << iReadSize << " bytes: readNonBlocking " << iBytes/dTimes[0]/1e6
+		<< " MB/s, readBuffered " << iBytes/dTimes[1]/1e6 << " MB/s" << std::endl;
+}
+
+static void runRoundTrip(int iTrials)
+{
+	std::string sSlaveName;
+	int iMaster = openMaster(sSlaveName);
+	Peer peer = {iMaster, true, false, 0};
+	pthread_t thread;
+	pthread_create(&thread, NULL, runPeer, &peer);
+
+	SerialIO serial;
+	openSlave(serial, sSlaveName, true);
+	char cMsg[16] = "0123456789abcde";
+	char cBuffer[16];
+	std::vector<double> latencies;
+
+	for(int i = 0; i < iTrials; i++)
+	{
+		double dStart = nowS();
+		serial.writeIO(cMsg, sizeof(cMsg));
+		int iReceived = 0;
+		while(iReceived < (int)sizeof(cMsg) && serial.waitForData(1.0) > 0)
+		{
+			int iNrBytes = serial.readBuffered(cBuffer, sizeof(cBuffer) - iReceived);
+			iReceived += (iNrBytes > 0) ? iNrBytes : 0;
+		}
+		if(iReceived == (int)sizeof(cMsg))
+			latencies.push_back(nowS() - dStart);
+	}
+
+	peer.bStop = true;
+	pthread_join(thread, NULL);
+	close(iMaster);
+
+	if(latencies.empty())
+	{
+		std::cout << "Round trip: no answer" << std::endl;
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	std::cout << "Round trip of " << sizeof(cMsg) << " bytes: median " << latencies[latencies.size()/2]*1e6
+		<< " us, max " << latencies.back()*1e6 << " us" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int iBytes = 1000000;
+
+	if(argc > 1)
+		iBytes = atoi(argv[1]);
+	if(iBytes <= 0)
+		iBytes = 1000000;
+
+	runPacedWrite(500, 1.0/11520);
+	runReads(iBytes, 8);
+	runReads(iBytes, 64);
+	runRoundTrip(1000);
+
+	return 0;
+}
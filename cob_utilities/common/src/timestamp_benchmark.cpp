@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 Fraunhofer Institute for Manufacturing Engineering and Automation (IPA)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+ 
+
+#include <cob_utilities/TimeStamp.h>
+
+#include <stdlib.h>
+#include <iostream>
+
+// Measures the cost of SetNow() for every clock and of the difference of two time stamps.
+void runBenchmark(const char* pcName, TimeStamp::ClockType Clock, int iCalls)
+{
+	TimeStamp Start(TimeStamp::CLOCK_TYPE_MONOTONIC), End(TimeStamp::CLOCK_TYPE_MONOTONIC);
+	TimeStamp Stamp(Clock), Last(Clock);
+	long long llChecksum = 0;
+	double dChecksum = 0;
+
+	Last.SetNow();
+	Start.SetNow();
+	for(int i = 0; i < iCalls; i++)
+	{
+		Stamp.SetNow();
+		llChecksum += Stamp.NanoSecSince(Last);
+	}
+	End.SetNow();
+
+	std::cout << pcName << ": SetNow + NanoSecSince " << double(End.NanoSecSince(Start)) / iCalls << " ns/call";
+
+	Start.SetNow();
+	for(int i = 0; i < iCalls; i++)
+	{
+		Stamp.SetNow();
+		dChecksum += Stamp - Last;
+	}
+	End.SetNow();
+
+	std::cout << ", SetNow + operator- " << double(End.NanoSecSince(Start)) / iCalls << " ns/call"
+		<< " (checksum " << llChecksum % 1000 + (long long)dChecksum % 1000 << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int iCalls = 10000000;
+
+	if(argc > 1)
+		iCalls = atoi(argv[1]);
+	if(iCalls <= 0)
+		iCalls = 10000000;
+
+	runBenchmark("CLOCK_REALTIME", TimeStamp::CLOCK_TYPE_REALTIME, iCalls);
+	runBenchmark("CLOCK_MONOTONIC", TimeStamp::CLOCK_TYPE_MONOTONIC, iCalls);
+	runBenchmark("CLOCK_MONOTONIC_COARSE", TimeStamp::CLOCK_TYPE_MONOTONIC_COARSE, iCalls);
+
+	return 0;
+}